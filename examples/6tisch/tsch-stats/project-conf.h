@@ -73,6 +73,12 @@
 /* Enable periodic RSSI sampling for TSCH statistics */
 #define TSCH_STATS_CONF_SAMPLE_NOISE_RSSI 1
 
+/* Collect the per-channel link stats for all neighbors, not only the time source */
+#define TSCH_STATS_CONF_PER_NEIGHBOR 1
+
+/* Do not transmit to a neighbor on the channels that are persistently bad for it */
+#define TSCH_STATS_CONF_SKIP_BAD_CHANNELS 1
+
 /* Reduce the TSCH stat "decay to normal" period to get printouts more often */
 #define TSCH_STATS_CONF_DECAY_INTERVAL (60 * CLOCK_SECOND)
 
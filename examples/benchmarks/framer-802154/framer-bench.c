@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmark of the IEEE 802.15.4 framer: header creation (with or
+ *         without FRAMER_802154_CONF_TEMPLATES) and parsing (with or
+ *         without FRAMER_802154_CONF_FAST_PARSE). Every created header is
+ *         first checked against the one built by frame802154_create(),
+ *         and the parsing of the framer against frame802154_parse().
+ */
+
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/mac/framer/framer-802154.h"
+#include "net/mac/framer/frame802154.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifdef CONTIKI_TARGET_NATIVE
+#include <stdlib.h>
+#endif /* CONTIKI_TARGET_NATIVE */
+
+#ifdef BENCH_CONF_ITERATIONS
+#define BENCH_ITERATIONS BENCH_CONF_ITERATIONS
+#else /* BENCH_CONF_ITERATIONS */
+#define BENCH_ITERATIONS 1000000UL
+#endif /* BENCH_CONF_ITERATIONS */
+
+#define PAYLOAD_LEN 60
+
+static const linkaddr_t neighbors[] = {
+  { { 0x00, 0x12, 0x4b, 0x00, 0x01, 0x02, 0x03, 0x04 } },
+  { { 0x00, 0x12, 0x4b, 0x00, 0x05, 0x06, 0x07, 0x08 } },
+};
+#define NUM_NEIGHBORS (sizeof(neighbors) / sizeof(neighbors[0]))
+
+static unsigned errors;
+static rtimer_clock_t baseline;
+/*---------------------------------------------------------------------------*/
+PROCESS(framer_bench_process, "Framer benchmark");
+AUTOSTART_PROCESSES(&framer_bench_process);
+/*---------------------------------------------------------------------------*/
+static void
+prepare(const linkaddr_t *dest, uint8_t seqno)
+{
+  packetbuf_clear();
+  memset(packetbuf_dataptr(), 0x5a, PAYLOAD_LEN);
+  packetbuf_set_datalen(PAYLOAD_LEN);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest);
+  packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seqno);
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the header created by the framer against the reference */
+static void
+check_header(const linkaddr_t *dest, uint8_t seqno)
+{
+  frame802154_t params;
+  uint8_t ref[64];
+  int len;
+
+  prepare(dest, seqno);
+  memset(&params, 0, sizeof(params));
+  framer_802154_setup_params(packetbuf_attr, packetbuf_holds_broadcast(),
+                             &params);
+  if(packetbuf_holds_broadcast()) {
+    params.dest_addr[0] = 0xff;
+    params.dest_addr[1] = 0xff;
+  } else {
+    linkaddr_copy((linkaddr_t *)&params.dest_addr, dest);
+  }
+  linkaddr_copy((linkaddr_t *)&params.src_addr, &linkaddr_node_addr);
+  len = frame802154_create(&params, ref);
+
+  if(NETSTACK_FRAMER.create() != len ||
+     memcmp(packetbuf_hdrptr(), ref, len) != 0) {
+    printf("header mismatch, seqno %u\n", seqno);
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *name, rtimer_clock_t start)
+{
+  rtimer_clock_t ticks = RTIMER_NOW() - start;
+
+  /* Leave out the time taken to prepare packetbuf */
+  ticks = ticks > baseline ? ticks - baseline : 0;
+  printf("%-28s %8lu ns/frame\n", name,
+         (unsigned long)((uint64_t)ticks * 1000000000 /
+                         ((uint64_t)RTIMER_SECOND * BENCH_ITERATIONS)));
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_create(const char *name, const linkaddr_t *dests, unsigned num_dests)
+{
+  unsigned long i;
+  rtimer_clock_t start;
+
+  /* Time packetbuf preparation alone first */
+  start = RTIMER_NOW();
+  for(i = 0; i < BENCH_ITERATIONS; i++) {
+    prepare(&dests[i % num_dests], i);
+  }
+  baseline = RTIMER_NOW() - start;
+
+  start = RTIMER_NOW();
+  for(i = 0; i < BENCH_ITERATIONS; i++) {
+    prepare(&dests[i % num_dests], i);
+    NETSTACK_FRAMER.create();
+  }
+  report(name, start);
+  baseline = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks the framer parsing a frame against frame802154_parse() */
+static void
+check_parse(const linkaddr_t *dest)
+{
+  frame802154_t frame;
+  uint8_t buf[PACKETBUF_SIZE];
+  int len;
+  int hdr_len;
+
+  prepare(dest, 7);
+  NETSTACK_FRAMER.create();
+  len = packetbuf_totlen();
+  memcpy(buf, packetbuf_hdrptr(), len);
+  hdr_len = frame802154_parse(buf, len, &frame);
+
+  packetbuf_copyfrom(buf, len);
+  if(NETSTACK_FRAMER.parse() != hdr_len ||
+     packetbuf_datalen() != frame.payload_len ||
+     packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO) !=
+     (frame.fcf.sequence_number_suppression ? 0xffff : frame.seq) ||
+     packetbuf_attr(PACKETBUF_ATTR_MAC_ACK) != frame.fcf.ack_required ||
+     !linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_SENDER),
+                   (linkaddr_t *)frame.src_addr) ||
+     !linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+                   packetbuf_holds_broadcast() ? &linkaddr_null : dest)) {
+    printf("parse mismatch\n");
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Parses a frame with frame802154_parse(), or with the framer, which sets
+ * up packetbuf as well and may take the FRAMER_802154_CONF_FAST_PARSE
+ * path */
+static void
+bench_parse(const char *name, const linkaddr_t *dest, int use_framer)
+{
+  frame802154_t frame;
+  uint8_t buf[PACKETBUF_SIZE];
+  unsigned long i;
+  rtimer_clock_t start;
+  int len;
+
+  prepare(dest, 1);
+  NETSTACK_FRAMER.create();
+  len = packetbuf_totlen();
+  memcpy(buf, packetbuf_hdrptr(), len);
+
+  if(use_framer) {
+    /* Time copying the frame to packetbuf alone first */
+    start = RTIMER_NOW();
+    for(i = 0; i < BENCH_ITERATIONS; i++) {
+      packetbuf_copyfrom(buf, len);
+    }
+    baseline = RTIMER_NOW() - start;
+  }
+
+  start = RTIMER_NOW();
+  for(i = 0; i < BENCH_ITERATIONS; i++) {
+    if(use_framer) {
+      packetbuf_copyfrom(buf, len);
+      if(NETSTACK_FRAMER.parse() <= 0) {
+        errors++;
+      }
+    } else if(frame802154_parse(buf, len, &frame) == 0) {
+      errors++;
+    }
+  }
+  report(name, start);
+  baseline = 0;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(framer_bench_process, ev, data)
+{
+  unsigned i;
+
+  PROCESS_BEGIN();
+
+  printf("802.15.4 framer benchmark, %lu iterations\n", BENCH_ITERATIONS);
+  printf("templates: %u, fast parse: %u, frame version: %u\n",
+         FRAMER_802154_TEMPLATES, FRAMER_802154_FAST_PARSE,
+         FRAME802154_VERSION);
+
+  /* Twice each, to go through cached templates as well */
+  for(i = 0; i < 2 * NUM_NEIGHBORS; i++) {
+    check_header(&neighbors[i % NUM_NEIGHBORS], i + 1);
+    check_header(&linkaddr_null, i + 1);
+  }
+  check_parse(&neighbors[0]);
+  check_parse(&linkaddr_null);
+
+  bench_create("create unicast", neighbors, 1);
+  bench_create("create unicast, 2 neighbors", neighbors, NUM_NEIGHBORS);
+  bench_create("create broadcast", &linkaddr_null, 1);
+  bench_parse("parse unicast", &neighbors[0], 0);
+  bench_parse("parse broadcast", &linkaddr_null, 0);
+  bench_parse("framer parse unicast", &neighbors[0], 1);
+  bench_parse("framer parse broadcast", &linkaddr_null, 1);
+
+  printf("%u errors\n", errors);
+#ifdef CONTIKI_TARGET_NATIVE
+  exit(errors ? EXIT_FAILURE : EXIT_SUCCESS);
+#endif /* CONTIKI_TARGET_NATIVE */
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
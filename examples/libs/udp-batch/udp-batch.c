@@ -0,0 +1,79 @@
+#include "contiki.h"
+#include "net/routing/routing.h"
+#include "random.h"
+#include "net/netstack.h"
+#include "net/ipv6/simple-udp.h"
+#include "net/ipv6/tcpip.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#define UDP_CLIENT_PORT	8765
+#define UDP_SERVER_PORT	5678
+
+#define SEND_INTERVAL		  (60 * CLOCK_SECOND)
+#define NUM_READINGS      4
+
+static struct simple_udp_connection udp_conn;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(udp_batch_process, "UDP batch");
+AUTOSTART_PROCESSES(&udp_batch_process);
+/*---------------------------------------------------------------------------*/
+static void
+batch_callback(struct simple_udp_connection *c,
+               struct uip_udp_batch_entry *entries, int count)
+{
+  int i;
+
+  for(i = 0; i < count; i++) {
+    LOG_INFO("Reading %d: %s\n", i,
+             entries[i].status == TCPIP_OUTPUT_SENT ? "sent" :
+             entries[i].status == TCPIP_OUTPUT_QUEUED ? "queued" : "dropped");
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(udp_batch_process, ev, data)
+{
+  static struct etimer periodic_timer;
+  static uint16_t readings[NUM_READINGS];
+  static struct uip_udp_batch_entry entries[NUM_READINGS];
+  static uip_ipaddr_t dest_ipaddr;
+  int i;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp_conn, UDP_CLIENT_PORT, NULL,
+                      UDP_SERVER_PORT, NULL);
+
+  etimer_set(&periodic_timer, random_rand() % SEND_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+
+    if(NETSTACK_ROUTING.node_is_reachable() &&
+       NETSTACK_ROUTING.get_root_ipaddr(&dest_ipaddr)) {
+      for(i = 0; i < NUM_READINGS; i++) {
+        readings[i] = random_rand();
+        entries[i].addr = &dest_ipaddr;
+        entries[i].port = 0;
+        entries[i].data = &readings[i];
+        entries[i].datalen = sizeof(readings[i]);
+      }
+      LOG_INFO("Sending %d readings to ", NUM_READINGS);
+      LOG_INFO_6ADDR(&dest_ipaddr);
+      LOG_INFO_("\n");
+      simple_udp_sendto_batch(&udp_conn, entries, NUM_READINGS,
+                              batch_callback);
+    } else {
+      LOG_INFO("Not reachable yet\n");
+    }
+
+    /* Add some jitter */
+    etimer_set(&periodic_timer, SEND_INTERVAL
+      - CLOCK_SECOND + (random_rand() % (2 * CLOCK_SECOND)));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
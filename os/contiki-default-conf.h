@@ -149,13 +149,15 @@
    we never receive any DIO from them. This may happen if the link from the
    neighbor to us is weak, if DIO transmissions are suppressed (Trickle
    timer) or if the neighbor chooses not to transmit DIOs because it is
-   a leaf node or for any reason. */
+   a leaf node or for any reason.
+   With UIP_CONF_ND6_6LOWPAN_ND, NSs are only sent in unicast, for address
+   registration and NUD, so we enable them with RPL too. */
 #ifndef UIP_CONF_ND6_SEND_NS
-#if (NETSTACK_CONF_WITH_IPV6 && !UIP_CONF_IPV6_RPL)
+#if (NETSTACK_CONF_WITH_IPV6 && (!UIP_CONF_IPV6_RPL || UIP_CONF_ND6_6LOWPAN_ND))
 #define UIP_CONF_ND6_SEND_NS 1
-#else /* (NETSTACK_CONF_WITH_IPV6 && !UIP_CONF_IPV6_RPL) */
+#else /* (NETSTACK_CONF_WITH_IPV6 && (!UIP_CONF_IPV6_RPL || UIP_CONF_ND6_6LOWPAN_ND)) */
 #define UIP_CONF_ND6_SEND_NS 0
-#endif /* (NETSTACK_CONF_WITH_IPV6 && !UIP_CONF_IPV6_RPL) */
+#endif /* (NETSTACK_CONF_WITH_IPV6 && (!UIP_CONF_IPV6_RPL || UIP_CONF_ND6_6LOWPAN_ND)) */
 #endif /* UIP_CONF_ND6_SEND_NS */
 /* To speed up the neighbor cache construction,
    enable UIP_CONF_ND6_AUTOFILL_NBR_CACHE. When a node does not the link-layer
@@ -53,6 +53,7 @@
 #include "net/app-layer/snmp/snmp.h"
 #include "services/rpl-border-router/rpl-border-router.h"
 #include "services/orchestra/orchestra.h"
+#include "services/msf/msf.h"
 #include "services/shell/serial-shell.h"
 #include "services/simple-energest/simple-energest.h"
 #include "services/tsch-cs/tsch-cs.h"
@@ -80,6 +81,12 @@ main(void)
   rtimer_init();
   process_init();
   process_start(&etimer_process, NULL);
+#if LOG_DEFERRED
+  log_deferred_init();
+#endif /* LOG_DEFERRED */
+#if TRACE_ENABLED
+  trace_init();
+#endif /* TRACE_ENABLED */
   ctimer_init();
   watchdog_init();
 
@@ -143,6 +150,11 @@ main(void)
   LOG_DBG("With Orchestra\n");
 #endif /* BUILD_WITH_ORCHESTRA */
 
+#if BUILD_WITH_MSF
+  msf_init();
+  LOG_DBG("With MSF\n");
+#endif /* BUILD_WITH_MSF */
+
 #if BUILD_WITH_SHELL
   serial_shell_init();
   LOG_DBG("With Shell\n");
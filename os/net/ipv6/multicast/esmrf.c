@@ -44,6 +44,7 @@
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/esmrf.h"
 #include "net/routing/routing.h"
@@ -306,6 +307,14 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  /* Loops and re-receptions: don't forward or deliver the same one twice */
+  if(uip_mcast6_dup_check()) {
+    PRINTF("ESMRF: Duplicate, dropping\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -371,6 +380,7 @@ init()
   UIP_MCAST6_STATS_INIT(&stats);
 
   uip_mcast6_route_init();
+  uip_mcast6_dup_init();
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&esmrf_icmp_handler);
   c = udp_new(NULL, 0, NULL);
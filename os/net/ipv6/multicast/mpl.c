@@ -50,7 +50,6 @@
 #include "net/ipv6/multicast/mpl.h"
 #include "dev/watchdog.h"
 #include "os/lib/trickle-timer.h"
-#include "os/lib/list.h"
 #include "sys/ctimer.h"
 #include <string.h>
 
@@ -77,6 +76,13 @@
 #if MPL_SEED_ID_TYPE == 2 && MPL_SEED_ID_H > 0x00
 #warning MPL Seed ID upper 64 bits set yet not used due to Seed ID type setting
 #endif
+/* Set sizes: hash chains and windows use 8 bit indices */
+#if MPL_SEED_SET_SIZE > 255 || MPL_DOMAIN_SET_SIZE > 255
+#error MPL_SEED_SET_SIZE and MPL_DOMAIN_SET_SIZE must not exceed 255
+#endif
+#if MPL_SEED_WINDOW_SIZE < 1 || MPL_SEED_WINDOW_SIZE > 128
+#error MPL_SEED_WINDOW_SIZE must be between 1 and 128
+#endif
 /*---------------------------------------------------------------------------*/
 /* Data Representation */
 /*---------------------------------------------------------------------------*/
@@ -146,11 +152,14 @@ typedef struct seed_id_s {
 #define seed_id_clr(a) (memset((a), 0, sizeof(seed_id_t)))
 /*---------------------------------------------------------------------------*/
 /* Buffered message set
- *  This is implemented as a linked list since the majority of operations
- *  involve finding the minimum sequence number and iterating up the list.
+ *  Each message sits in the window of its seed, which is sorted by
+ *  sequence number. All buffered messages are also linked in order of
+ *  arrival, so that the oldest one can be found without searching when
+ *  a buffer has to be reclaimed.
  */
 struct mpl_msg {
-  struct mpl_msg *next; /* Next message in the set, or NULL if this is largest */
+  struct mpl_msg *older; /* Previous message in order of arrival */
+  struct mpl_msg *newer; /* Next message in order of arrival */
   struct mpl_seed *seed; /* The seed set this message belongs to */
   struct trickle_timer tt; /* The trickle timer associated with this msg */
   uip_ip6addr_t srcipaddr; /* The original ip this message was sent from */
@@ -205,10 +214,26 @@ struct mpl_seed {
   seed_id_t seed_id;
   uint8_t min_seqno; /* Used when the seed set is empty */
   uint8_t lifetime; /* Decrements by one every minute */
-  uint8_t count; /* Only used for determining largest msg set during reclaim */
-  LIST_STRUCT(min_seq); /* Pointer to the first msg in this seed's set */
+  uint8_t count; /* Number of messages in the window */
+  uint8_t head; /* Position of the message with the lowest seq in window */
+  uint8_t hash_next; /* Index + 1 of the next seed in the hash bucket */
+  struct mpl_msg *window[MPL_SEED_WINDOW_SIZE]; /* Ring sorted by seq */
   struct mpl_domain *domain; /* The domain this seed belongs to */
 };
+/**
+ * \brief Get the i-th message of a seed's window, lowest sequence first
+ * s: pointer to the seed set entry
+ * i: position in the window, which must be below the count
+ */
+#define SEED_WINDOW_GET(s, i) ((s)->window[((s)->head + (i)) % MPL_SEED_WINDOW_SIZE])
+/**
+ * \brief Get the i-th message of a seed's window, or NULL past its end
+ */
+#define SEED_WINDOW_AT(s, i) ((i) < (s)->count ? SEED_WINDOW_GET(s, i) : NULL)
+/**
+ * \brief Get the message with the largest sequence number, or NULL
+ */
+#define SEED_WINDOW_LAST(s) ((s)->count > 0 ? SEED_WINDOW_GET(s, (s)->count - 1) : NULL)
 /**
  * \brief Get the state of the used flag in the buffered message set entry
  * h: pointer to the message set entry
@@ -226,6 +251,10 @@ struct mpl_domain {
   uip_ip6addr_t ctrl_addr; /* Link-local scoped version of data address */
   struct trickle_timer tt;
   uint8_t e; /* Expiration count for trickle timer */
+  uint8_t hash_next; /* Index + 1 of the next domain in the hash bucket */
+#if UIP_MCAST6_STATS
+  struct mpl_domain_stats stats;
+#endif
 };
 /**
  * \brief Get the state of the used flag in the buffered message set entry
@@ -389,9 +418,11 @@ static struct mpl_stats stats;
 
 #define MPL_STATS_ADD(x) stats.x++
 #define MPL_STATS_INIT() do { memset(&stats, 0, sizeof(stats)); } while(0)
+#define MPL_DOMAIN_STATS_ADD(d, x) (d)->stats.x++
 #else /* UIP_MCAST6_STATS */
 #define MPL_STATS_ADD(x)
 #define MPL_STATS_INIT()
+#define MPL_DOMAIN_STATS_ADD(d, x)
 #endif
 /*---------------------------------------------------------------------------*/
 /* Internal Data Structures */
@@ -399,6 +430,12 @@ static struct mpl_stats stats;
 static struct mpl_msg buffered_message_set[MPL_BUFFERED_MESSAGE_SET_SIZE];
 static struct mpl_seed seed_set[MPL_SEED_SET_SIZE];
 static struct mpl_domain domain_set[MPL_DOMAIN_SET_SIZE];
+/* Hash buckets, holding the index + 1 of their first entry (0 if empty) */
+static uint8_t seed_hash[MPL_SEED_HASH_SIZE];
+static uint8_t domain_hash[MPL_DOMAIN_HASH_SIZE];
+/* Buffered messages in order of arrival */
+static struct mpl_msg *oldest_msg;
+static struct mpl_msg *newest_msg;
 static uint16_t last_seq;
 static seed_id_t local_seed_id;
 #if MPL_SUB_TO_ALL_FORWARDERS
@@ -466,12 +503,41 @@ extern uint16_t uip_slen;
 static void icmp_in(void);
 UIP_ICMP6_HANDLER(mpl_icmp_handler, ICMP6_MPL, 0, icmp_in);
 
+static void
+buffer_age_append(struct mpl_msg *msg)
+{
+  msg->older = newest_msg;
+  msg->newer = NULL;
+  if(newest_msg != NULL) {
+    newest_msg->newer = msg;
+  } else {
+    oldest_msg = msg;
+  }
+  newest_msg = msg;
+}
+static void
+buffer_age_remove(struct mpl_msg *msg)
+{
+  if(msg->older != NULL) {
+    msg->older->newer = msg->newer;
+  } else {
+    oldest_msg = msg->newer;
+  }
+  if(msg->newer != NULL) {
+    msg->newer->older = msg->older;
+  } else {
+    newest_msg = msg->older;
+  }
+  msg->older = NULL;
+  msg->newer = NULL;
+}
 static struct mpl_msg *
 buffer_allocate(void)
 {
   for(locmmptr = &buffered_message_set[MPL_BUFFERED_MESSAGE_SET_SIZE - 1]; locmmptr >= buffered_message_set; locmmptr--) {
     if(!MSG_SET_IS_USED(locmmptr)) {
       memset(locmmptr, 0, sizeof(struct mpl_msg));
+      buffer_age_append(locmmptr);
       return locmmptr;
     }
   }
@@ -483,46 +549,121 @@ buffer_free(struct mpl_msg *msg)
   if(trickle_timer_is_running(&msg->tt)) {
     trickle_timer_stop(&msg->tt);
   }
+  buffer_age_remove(msg);
   MSG_SET_CLEAR_USED(msg);
 }
+/**
+ * Find a sequence number in the window of a seed by binary search.
+ * Returns 1 if it is there, with its position in pos. Otherwise returns 0,
+ * with the position where it would have to be inserted in pos.
+ */
+static uint8_t
+seed_window_find(struct mpl_seed *s, uint8_t seq, uint8_t *pos)
+{
+  uint8_t lo;
+  uint8_t hi;
+  uint8_t mid;
+
+  lo = 0;
+  hi = s->count;
+  while(lo < hi) {
+    mid = (lo + hi) / 2;
+    if(SEQ_VAL_IS_LT(SEED_WINDOW_GET(s, mid)->seq, seq)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *pos = lo;
+  return lo < s->count && SEQ_VAL_IS_EQ(SEED_WINDOW_GET(s, lo)->seq, seq);
+}
+static void
+seed_window_insert(struct mpl_seed *s, uint8_t pos, struct mpl_msg *msg)
+{
+  uint8_t i;
+
+  /* Messages mostly arrive in order, in which case nothing moves */
+  for(i = s->count; i > pos; i--) {
+    SEED_WINDOW_GET(s, i) = SEED_WINDOW_GET(s, i - 1);
+  }
+  SEED_WINDOW_GET(s, pos) = msg;
+  s->count++;
+  if(pos == 0) {
+    s->min_seqno = msg->seq;
+  }
+}
+/* Remove the message with the lowest sequence number from a non-empty window */
+static struct mpl_msg *
+seed_window_pop(struct mpl_seed *s)
+{
+  struct mpl_msg *msg;
+
+  msg = SEED_WINDOW_GET(s, 0);
+  s->head = (s->head + 1) % MPL_SEED_WINDOW_SIZE;
+  s->count--;
+  /**
+   * MPL does not require sequence numbers to be sequential, so the new
+   *   minimum is that of the next message in the window. If there is none,
+   *   anything above the one we drop is still new.
+   */
+  s->min_seqno = s->count > 0 ? SEED_WINDOW_GET(s, 0)->seq : SEQ_VAL_ADD(msg->seq, 1);
+  return msg;
+}
 static struct mpl_msg *
 buffer_reclaim(void)
 {
-  static struct mpl_seed *ssptr; /* Can't use locssptr since it's used by calling function */
-  static struct mpl_seed *largest;
   static struct mpl_msg *reclaim;
 
-  /* Reclaim the message with min_seq in the largest seed set */
-  largest = NULL;
-  reclaim = NULL;
-  for(ssptr = &seed_set[MPL_SEED_SET_SIZE]; ssptr >= seed_set; ssptr--) {
-    if(SEED_SET_IS_USED(ssptr) && (largest == NULL || ssptr->count > largest->count)) {
-      largest = ssptr;
-    }
-  }
   /**
-   * To reclaim this, we need to increment the min seq number to
-   *   the next largest sequence number in the set.
-   * This won't necessarily be min_seq + 1 because MPL does not require or
-   *   ensure that sequence number are sequential, it just denotes the
-   *   order messages are sent.
-   * We've already worked out what this new value is.
+   * Reclaim the message with min_seq in the seed set holding the message
+   *   that arrived first. Only the lowest message of a seed can go without
+   *   opening a gap in its window, which neighbours would fill again.
    */
-  if(largest != NULL) {
-    reclaim = list_pop(largest->min_seq);
-    largest->min_seqno = list_item_next(reclaim) == NULL ? reclaim->seq : ((struct mpl_msg *)list_item_next(reclaim))->seq;
-    largest->count--;
-    trickle_timer_stop(&reclaim->tt);
-    mpl_trickle_timer_reset(reclaim->seed->domain);
-    memset(reclaim, 0, sizeof(struct mpl_msg));
+  if(oldest_msg == NULL) {
+    return NULL;
   }
+  reclaim = seed_window_pop(oldest_msg->seed);
+  trickle_timer_stop(&reclaim->tt);
+  mpl_trickle_timer_reset(reclaim->seed->domain);
+  MPL_DOMAIN_STATS_ADD(reclaim->seed->domain, reclaimed);
+  buffer_age_remove(reclaim);
+  memset(reclaim, 0, sizeof(struct mpl_msg));
+  buffer_age_append(reclaim);
   return reclaim;
 }
+static uint8_t
+domain_hash_key(const uip_ip6addr_t *address)
+{
+  uint8_t i;
+  uint16_t h = 0;
+
+  /* Byte 1 holds the flags and scope, the only part in which the data and
+   * the control address of a domain differ. Leave it out so that both
+   * land in the same bucket */
+  for(i = 0; i < sizeof(uip_ip6addr_t); i++) {
+    if(i != 1) {
+      h = (h << 3) ^ (h >> 13) ^ address->u8[i];
+    }
+  }
+  return h % MPL_DOMAIN_HASH_SIZE;
+}
+static uint8_t
+seed_hash_key(const seed_id_t *seed_id, const struct mpl_domain *domain)
+{
+  uint8_t i;
+  uint16_t h = domain - domain_set;
+
+  for(i = 0; i < sizeof(seed_id->id); i++) {
+    h = (h << 3) ^ (h >> 13) ^ seed_id->id[i];
+  }
+  return h % MPL_SEED_HASH_SIZE;
+}
 static struct mpl_domain *
 domain_set_allocate(uip_ip6addr_t *address)
 {
   uip_ip6addr_t data_addr;
   uip_ip6addr_t ctrl_addr;
+  uint8_t key;
   /* Determine the two addresses for this domain */
   if(uip_mcast6_get_address_scope(address) == UIP_MCAST6_SCOPE_LINK_LOCAL) {
     LOG_DBG("Domain Set Allocate has a local scoped address\n");
@@ -564,6 +705,9 @@ domain_set_allocate(uip_ip6addr_t *address)
         DOMAIN_SET_CLEAR_USED(locdsptr);
         return NULL;
       }
+      key = domain_hash_key(&data_addr);
+      locdsptr->hash_next = domain_hash[key];
+      domain_hash[key] = locdsptr - domain_set + 1;
       return locdsptr;
     }
   }
@@ -573,20 +717,29 @@ domain_set_allocate(uip_ip6addr_t *address)
 static struct mpl_seed *
 seed_set_lookup(seed_id_t *seed_id, struct mpl_domain *domain)
 {
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
-    if(SEED_SET_IS_USED(locssptr) && seed_id_cmp(seed_id, &locssptr->seed_id) && locssptr->domain == domain) {
+  uint8_t i;
+
+  for(i = seed_hash[seed_hash_key(seed_id, domain)]; i != 0; i = locssptr->hash_next) {
+    locssptr = &seed_set[i - 1];
+    if(seed_id_cmp(seed_id, &locssptr->seed_id) && locssptr->domain == domain) {
       return locssptr;
     }
   }
   return NULL;
 }
 static struct mpl_seed *
-seed_set_allocate(void)
+seed_set_allocate(seed_id_t *seed_id, struct mpl_domain *domain)
 {
+  uint8_t key;
+
   for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
     if(!SEED_SET_IS_USED(locssptr)) {
-      locssptr->count = 0;
-      LIST_STRUCT_INIT(locssptr, min_seq);
+      memset(locssptr, 0, sizeof(struct mpl_seed));
+      seed_id_cpy(&locssptr->seed_id, seed_id);
+      locssptr->domain = domain;
+      key = seed_hash_key(seed_id, domain);
+      locssptr->hash_next = seed_hash[key];
+      seed_hash[key] = locssptr - seed_set + 1;
       return locssptr;
     }
   }
@@ -595,20 +748,30 @@ seed_set_allocate(void)
 static void
 seed_set_free(struct mpl_seed *s)
 {
-  while((locmmptr = list_pop(s->min_seq)) != NULL) {
-    buffer_free(locmmptr);
+  uint8_t *ip;
+
+  while(s->count > 0) {
+    buffer_free(seed_window_pop(s));
+  }
+  for(ip = &seed_hash[seed_hash_key(&s->seed_id, s->domain)]; *ip != 0;
+      ip = &seed_set[*ip - 1].hash_next) {
+    if(&seed_set[*ip - 1] == s) {
+      *ip = s->hash_next;
+      break;
+    }
   }
   SEED_SET_CLEAR_USED(s);
 }
 static struct mpl_domain *
-domain_set_lookup(uip_ip6addr_t *domain)
+domain_set_lookup(const uip_ip6addr_t *domain)
 {
-  for(locdsptr = &domain_set[MPL_DOMAIN_SET_SIZE - 1]; locdsptr >= domain_set; locdsptr--) {
-    if(DOMAIN_SET_IS_USED(locdsptr)) {
-      if(uip_ip6addr_cmp(domain, &locdsptr->data_addr)
-         || uip_ip6addr_cmp(domain, &locdsptr->ctrl_addr)) {
-        return locdsptr;
-      }
+  uint8_t i;
+
+  for(i = domain_hash[domain_hash_key(domain)]; i != 0; i = locdsptr->hash_next) {
+    locdsptr = &domain_set[i - 1];
+    if(uip_ip6addr_cmp(domain, &locdsptr->data_addr)
+       || uip_ip6addr_cmp(domain, &locdsptr->ctrl_addr)) {
+      return locdsptr;
     }
   }
   return NULL;
@@ -617,8 +780,9 @@ static void
 domain_set_free(struct mpl_domain *domain)
 {
   uip_ds6_maddr_t *addr;
+  uint8_t *ip;
   /* Must include freeing seeds otherwise we leak memory */
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE]; locssptr >= seed_set; locssptr--) {
+  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
     if(SEED_SET_IS_USED(locssptr) && locssptr->domain == domain) {
       seed_set_free(locssptr);
     }
@@ -634,6 +798,13 @@ domain_set_free(struct mpl_domain *domain)
   if(trickle_timer_is_running(&domain->tt)) {
     trickle_timer_stop(&domain->tt);
   }
+  for(ip = &domain_hash[domain_hash_key(&domain->data_addr)]; *ip != 0;
+      ip = &domain_set[*ip - 1].hash_next) {
+    if(&domain_set[*ip - 1] == domain) {
+      *ip = domain->hash_next;
+      break;
+    }
+  }
   DOMAIN_SET_CLEAR_USED(domain);
 }
 static void
@@ -763,6 +934,7 @@ icmp_out(struct mpl_domain *dom)
   uint16_t payload_len;
   uip_ds6_addr_t *addr;
   size_t seed_info_len;
+  uint8_t i;
 
   LOG_INFO("MPL Control Message Out\n");
 
@@ -829,7 +1001,8 @@ icmp_out(struct mpl_domain *dom)
       LOG_INFO("\nBuffer for seed: ");
       LOG_INFO_SEED(locssptr->seed_id);
       LOG_INFO_("\n");
-      for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
+      for(i = 0; i < locssptr->count; i++) {
+        locmmptr = SEED_WINDOW_GET(locssptr, i);
         LOG_INFO("%d -- %x\n", locmmptr->seq, locmmptr->data[locmmptr->size - 1]);
         cur_seq = SEQ_VAL_ADD(locssptr->min_seqno, vec_len);
         if(locmmptr->seq == SEQ_VAL_ADD(locssptr->min_seqno, vec_len)) {
@@ -912,6 +1085,7 @@ data_message_expiration(void *ptr, uint8_t suppress)
     return;
   }
   if(suppress == TRICKLE_TIMER_TX_OK) { /* Only transmit if not suppressed */
+    MPL_DOMAIN_STATS_ADD(locmmptr->seed->domain, data_tx);
     LOG_DBG("Data message TX\n");
     LOG_DBG("Seed ID=");
     LOG_DBG_SEED(locmmptr->seed->seed_id);
@@ -973,7 +1147,7 @@ data_message_expiration(void *ptr, uint8_t suppress)
       break;
     }
     lochbhmptr->seq = locmmptr->seq;
-    if(list_item_next(locmmptr) == NULL) {
+    if(locmmptr == SEED_WINDOW_LAST(locmmptr->seed)) {
       HBH_SET_M(lochbhmptr);
     }
     /* Now insert payload */
@@ -984,6 +1158,8 @@ data_message_expiration(void *ptr, uint8_t suppress)
     tcpip_output(NULL);
     uipbuf_clear();
     UIP_MCAST6_STATS_ADD(mcast_out);
+  } else {
+    MPL_DOMAIN_STATS_ADD(locmmptr->seed->domain, data_suppressed);
   }
 
   locmmptr->e++;
@@ -1000,7 +1176,10 @@ control_message_expiration(void *ptr, uint8_t suppress)
   }
   if(suppress == TRICKLE_TIMER_TX_OK) {
     /* Send an MPL Control Message */
+    MPL_DOMAIN_STATS_ADD(locdsptr, ctrl_tx);
     icmp_out(locdsptr);
+  } else {
+    MPL_DOMAIN_STATS_ADD(locdsptr, ctrl_suppressed);
   }
   locdsptr->e++;
 }
@@ -1032,19 +1211,19 @@ mpl_maddr_check(void)
 static void
 lifetime_timer_expiration(void *ptr)
 {
+  uint8_t i;
+
   /* Called once per minute to decrement seed lifetime counters */
   for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; seed_set <= locssptr; locssptr--) {
     if(SEED_SET_IS_USED(locssptr) && locssptr->lifetime == 0) {
       /* Check no timers are running */
-      locmmptr = list_head(locssptr->min_seq);
-      while(locmmptr != NULL) {
-        if(trickle_timer_is_running(&locmmptr->tt)) {
+      for(i = 0; i < locssptr->count; i++) {
+        if(trickle_timer_is_running(&SEED_WINDOW_GET(locssptr, i)->tt)) {
           /* We must keep this seed */
           break;
         }
-        locmmptr = list_item_next(locmmptr);
       }
-      if(locmmptr == NULL) {
+      if(i == locssptr->count) {
         /* We can now free this seed set */
         LOG_INFO("Seed ");
         LOG_INFO_SEED(locssptr->seed_id);
@@ -1064,6 +1243,7 @@ icmp_in(void)
 {
   static seed_id_t seed_id;
   static uint8_t r;
+  static uint8_t m;
   static uint8_t *vector;
   static uint8_t vector_len;
   static uint8_t r_missing;
@@ -1115,7 +1295,7 @@ icmp_in(void)
     locdsptr = domain_set_allocate(&UIP_IP_BUF->destipaddr);
     if(!locdsptr) {
       LOG_ERR("Couldn't allocate new domain. Dropping.\n");
-      UIP_MCAST6_STATS_ADD(icmp_bad);
+      MPL_STATS_ADD(icmp_bad);
       goto discard;
     }
     mpl_control_trickle_timer_start(locdsptr);
@@ -1168,15 +1348,14 @@ icmp_in(void)
       LOG_DBG_SEED(locssptr->seed_id);
       LOG_DBG_("\n");
       r_missing = 1;
-      if(list_head(locssptr->min_seq) != NULL) {
-        for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-          LOG_DBG("Resetting timer for messages\n");
-          if(!trickle_timer_is_running(&locmmptr->tt)) {
-            LOG_DBG("Starting timer for messages\n");
-            mpl_data_trickle_timer_start(locmmptr);
-          }
-          mpl_trickle_timer_inconsistency(locmmptr);
+      for(m = 0; m < locssptr->count; m++) {
+        locmmptr = SEED_WINDOW_GET(locssptr, m);
+        LOG_DBG("Resetting timer for messages\n");
+        if(!trickle_timer_is_running(&locmmptr->tt)) {
+          LOG_DBG("Starting timer for messages\n");
+          mpl_data_trickle_timer_start(locmmptr);
         }
+        mpl_trickle_timer_inconsistency(locmmptr);
       }
       /* Otherwise we jump here and continute */
 seed_present:
@@ -1227,7 +1406,8 @@ seed_present:
     }
 
     /* Potential quick resolution here */
-    locmmptr = list_head(locssptr->min_seq);
+    m = 0;
+    locmmptr = SEED_WINDOW_AT(locssptr, m);
     if(locmmptr == NULL) {
       /* We have nothing! */
       if(vector[0] > 0) {
@@ -1247,8 +1427,11 @@ seed_present:
           r++;
         }
       } else {
-        while(locmmptr != NULL && locmmptr->seq != locsiptr->min_seqno) {
-          locmmptr = list_item_next(locmmptr);
+        /* The window is sorted, look the remote minimum up in it */
+        if(seed_window_find(locssptr, locsiptr->min_seqno, &m)) {
+          locmmptr = SEED_WINDOW_GET(locssptr, m);
+        } else {
+          locmmptr = NULL;
         }
       }
 
@@ -1256,10 +1439,7 @@ seed_present:
       if(r > vector_len || locmmptr == NULL) {
         LOG_WARN("Seed sets of local and remote have no overlap.\n");
         /* Work out who is behind who */
-        locmmptr = list_head(locssptr->min_seq);
-        while(list_item_next(locmmptr) != NULL) {
-          locmmptr = list_item_next(locmmptr);
-        }
+        locmmptr = SEED_WINDOW_LAST(locssptr);
         r = vector_len;
         while(!BIT_VECTOR_GET_BIT(vector, r)) {
           r--;
@@ -1269,13 +1449,12 @@ seed_present:
           LOG_DBG("Our max sequence number is greater than their max sequence number\n");
           r_missing = 1;
           /* Additionally all data message timers in set if r is behind us */
-          if(list_head(locssptr->min_seq) != NULL) {
-            for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-              if(!trickle_timer_is_running(&locmmptr->tt)) {
-                mpl_data_trickle_timer_start(locmmptr);
-              }
-              mpl_trickle_timer_inconsistency(locmmptr);
+          for(m = 0; m < locssptr->count; m++) {
+            locmmptr = SEED_WINDOW_GET(locssptr, m);
+            if(!trickle_timer_is_running(&locmmptr->tt)) {
+              mpl_data_trickle_timer_start(locmmptr);
             }
+            mpl_trickle_timer_inconsistency(locmmptr);
           }
         } else {
           l_missing = 1;
@@ -1318,7 +1497,8 @@ seed_present:
 
       /* Now increment our pointers */
       r++;
-      locmmptr = list_item_next(locmmptr);
+      m++;
+      locmmptr = SEED_WINDOW_AT(locssptr, m);
       /* These are then resyncronised at the top of the loop */
     } while(locmmptr != NULL && r <= vector_len);
 
@@ -1347,7 +1527,8 @@ seed_present:
         }
         mpl_trickle_timer_inconsistency(locmmptr);
         r_missing = 1;
-        locmmptr = list_item_next(locmmptr);
+        m++;
+        locmmptr = SEED_WINDOW_AT(locssptr, m);
       }
     }
     /* Now point to next seed info */
@@ -1374,11 +1555,13 @@ next:
   }
   if(l_missing || r_missing) {
     LOG_INFO("Inconsistency detected l=%u, r=%u\n", l_missing, r_missing);
+    MPL_DOMAIN_STATS_ADD(locdsptr, ctrl_inconsistent);
     if(trickle_timer_is_running(&locdsptr->tt)) {
       mpl_trickle_timer_inconsistency(locdsptr);
     }
   } else {
     LOG_INFO("Domain is consistent \n");
+    MPL_DOMAIN_STATS_ADD(locdsptr, ctrl_consistent);
     trickle_timer_consistency(&locdsptr->tt);
   }
 
@@ -1393,7 +1576,7 @@ accept(uint8_t in)
   static seed_id_t seed_id;
   static uint16_t seq_val;
   static uint8_t S;
-  static struct mpl_msg *mmiterptr;
+  static uint8_t pos;
   static struct uip_ext_hdr *hptr;
 
   LOG_INFO("Multicast I/O\n");
@@ -1509,27 +1692,25 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    if(list_head(locssptr->min_seq) != NULL) {
-      for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-        if(SEQ_VAL_IS_EQ(seq_val, locmmptr->seq)) {
-          /* Seen before , drop */
-          LOG_INFO("Seen before\n");
-          if(HBH_GET_M(lochbhmptr) && list_item_next(locmmptr) != NULL) {
-            mpl_trickle_timer_inconsistency(locmmptr);
-          } else {
-            trickle_timer_consistency(&locmmptr->tt);
-          }
-          UIP_MCAST6_STATS_ADD(mcast_dropped);
-          return UIP_MCAST6_DROP;
-        }
+    if(seed_window_find(locssptr, seq_val, &pos)) {
+      /* Seen before , drop */
+      LOG_INFO("Seen before\n");
+      locmmptr = SEED_WINDOW_GET(locssptr, pos);
+      if(HBH_GET_M(lochbhmptr) && locmmptr != SEED_WINDOW_LAST(locssptr)) {
+        mpl_trickle_timer_inconsistency(locmmptr);
+      } else {
+        trickle_timer_consistency(&locmmptr->tt);
       }
+      MPL_DOMAIN_STATS_ADD(locdsptr, data_dup);
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
     }
   }
   /* We have not seen this message before */
 
   /* Allocate a seed set if we have to */
   if(!locssptr) {
-    locssptr = seed_set_allocate();
+    locssptr = seed_set_allocate(&seed_id, locdsptr);
     LOG_INFO("New seed\n");
     if(!locssptr) {
       /* Couldn't allocate seed set, drop */
@@ -1537,10 +1718,14 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    memset(locssptr, 0, sizeof(struct mpl_seed));
-    LIST_STRUCT_INIT(locssptr, min_seq);
-    seed_id_cpy(&locssptr->seed_id, &seed_id);
-    locssptr->domain = locdsptr;
+  }
+
+  /* A full window makes room by dropping the seed's lowest message */
+  if(locssptr->count == MPL_SEED_WINDOW_SIZE) {
+    LOG_INFO("Seed window full. Dropping seq=%u\n", locssptr->min_seqno);
+    buffer_free(seed_window_pop(locssptr));
+    mpl_trickle_timer_reset(locdsptr);
+    MPL_DOMAIN_STATS_ADD(locdsptr, reclaimed);
   }
 
   /* Allocate a buffer */
@@ -1588,20 +1773,9 @@ accept(uint8_t in)
     return UIP_MCAST6_DROP;
   }
 
-  /* Place the message into the buffered message linked list */
-  if(list_head(locssptr->min_seq) == NULL) {
-    list_push(locssptr->min_seq, locmmptr);
-    locssptr->min_seqno = locmmptr->seq;
-  } else {
-    for(mmiterptr = list_head(locssptr->min_seq); mmiterptr != NULL; mmiterptr = list_item_next(mmiterptr)) {
-      if(list_item_next(mmiterptr) == NULL
-         || (SEQ_VAL_IS_GT(locmmptr->seq, mmiterptr->seq) && SEQ_VAL_IS_LT(locmmptr->seq, ((struct mpl_msg *)list_item_next(mmiterptr))->seq))) {
-        list_insert(locssptr->min_seq, mmiterptr, locmmptr);
-        break;
-      }
-    }
-  }
-  locssptr->count++;
+  /* Place the message into the seed's window. Reclaiming may have changed it */
+  seed_window_find(locssptr, locmmptr->seq, &pos);
+  seed_window_insert(locssptr, pos, locmmptr);
 
 #if MPL_PROACTIVE_FORWARDING
   /* Start Forwarding the message */
@@ -1630,7 +1804,7 @@ accept(uint8_t in)
    *  now check the rest.
    */
 #if MPL_PROACTIVE_FORWARDING
-  if(HBH_GET_M(lochbhmptr) == 1 && list_item_next(locmmptr) != NULL) {
+  if(HBH_GET_M(lochbhmptr) == 1 && locmmptr != SEED_WINDOW_LAST(locssptr)) {
     LOG_DBG("MPL Domain is inconsistent\n");
     mpl_trickle_timer_inconsistency(locmmptr);
   } else {
@@ -1772,6 +1946,10 @@ init(void)
   memset(domain_set, 0, sizeof(struct mpl_domain) * MPL_DOMAIN_SET_SIZE);
   memset(seed_set, 0, sizeof(struct mpl_seed) * MPL_SEED_SET_SIZE);
   memset(buffered_message_set, 0, sizeof(struct mpl_msg) * MPL_BUFFERED_MESSAGE_SET_SIZE);
+  memset(seed_hash, 0, sizeof(seed_hash));
+  memset(domain_hash, 0, sizeof(domain_hash));
+  oldest_msg = NULL;
+  newest_msg = NULL;
 
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&mpl_icmp_handler);
@@ -1780,6 +1958,7 @@ init(void)
 
   /* Init MPL Stats */
   MPL_STATS_INIT();
+  UIP_MCAST6_STATS_INIT(&stats);
 
 #if MPL_SUB_TO_ALL_FORWARDERS
   /* Subscribe to the All MPL Forwarders Address by default */
@@ -1794,6 +1973,15 @@ init(void)
   ctimer_set(&lifetime_timer, CLOCK_SECOND * 60, lifetime_timer_expiration, NULL);
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_STATS
+const struct mpl_domain_stats *
+mpl_domain_stats(const uip_ip6addr_t *domain)
+{
+  locdsptr = domain_set_lookup(domain);
+  return locdsptr != NULL ? &locdsptr->stats : NULL;
+}
+#endif /* UIP_MCAST6_STATS */
+/*---------------------------------------------------------------------------*/
 /**
  * \brief The MPL engine driver
  */
@@ -216,6 +216,45 @@
 #define MPL_BUFFERED_MESSAGE_SET_SIZE MPL_CONF_BUFFERED_MESSAGE_SET_SIZE
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * Seed Window Size
+ * The buffered messages of each seed are kept in a window sorted by
+ * sequence number. When a seed's window is full, its oldest message is
+ * dropped to make room for a new one. A seed can never hold more messages
+ * than the buffered message set, which is also the default.
+ */
+#ifndef MPL_CONF_SEED_WINDOW_SIZE
+#define MPL_SEED_WINDOW_SIZE                MPL_BUFFERED_MESSAGE_SET_SIZE
+#else
+#define MPL_SEED_WINDOW_SIZE MPL_CONF_SEED_WINDOW_SIZE
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Seed and Domain Set Hash Sizes
+ * Seeds are looked up by seed ID and domain, and domains by address, for
+ * every data and control message received. Both sets are indexed by
+ * hash tables with the number of buckets below.
+ */
+#ifndef MPL_CONF_SEED_HASH_SIZE
+#if MPL_SEED_SET_SIZE < 8
+#define MPL_SEED_HASH_SIZE                  MPL_SEED_SET_SIZE
+#else
+#define MPL_SEED_HASH_SIZE                  8
+#endif
+#else
+#define MPL_SEED_HASH_SIZE MPL_CONF_SEED_HASH_SIZE
+#endif
+
+#ifndef MPL_CONF_DOMAIN_HASH_SIZE
+#if MPL_DOMAIN_SET_SIZE < 4
+#define MPL_DOMAIN_HASH_SIZE                MPL_DOMAIN_SET_SIZE
+#else
+#define MPL_DOMAIN_HASH_SIZE                4
+#endif
+#else
+#define MPL_DOMAIN_HASH_SIZE MPL_CONF_DOMAIN_HASH_SIZE
+#endif
+/*---------------------------------------------------------------------------*/
 /**
  * MPL Forwarding Strategy
  * Two forwarding strategies are defined for MPL. With Proactive forwarding
@@ -291,6 +330,47 @@ struct mpl_stats {
   /** Number of malformed ICMP datagrams seen by us */
   UIP_MCAST6_STATS_DATATYPE icmp_bad;
 };
+
+/**
+ * \brief Per-domain statistics of the MPL engine
+ *
+ * The share of suppressed transmissions tells how well trickle
+ * suppression works in the domain.
+ */
+struct mpl_domain_stats {
+  /** Data messages sent when their trickle timer fired */
+  UIP_MCAST6_STATS_DATATYPE data_tx;
+
+  /** Data message transmissions suppressed by trickle */
+  UIP_MCAST6_STATS_DATATYPE data_suppressed;
+
+  /** Control messages sent when the domain trickle timer fired */
+  UIP_MCAST6_STATS_DATATYPE ctrl_tx;
+
+  /** Control message transmissions suppressed by trickle */
+  UIP_MCAST6_STATS_DATATYPE ctrl_suppressed;
+
+  /** Data messages received again */
+  UIP_MCAST6_STATS_DATATYPE data_dup;
+
+  /** Control messages received that showed an inconsistency */
+  UIP_MCAST6_STATS_DATATYPE ctrl_inconsistent;
+
+  /** Control messages received that were consistent */
+  UIP_MCAST6_STATS_DATATYPE ctrl_consistent;
+
+  /** Buffered messages dropped to make room for new ones */
+  UIP_MCAST6_STATS_DATATYPE reclaimed;
+};
+
+#if UIP_MCAST6_STATS
+/**
+ * \brief Get the statistics of an MPL domain
+ * \param domain The data or control address of the domain
+ * \return A pointer to the statistics, or NULL if the domain is unknown
+ */
+const struct mpl_domain_stats *mpl_domain_stats(const uip_ip6addr_t *domain);
+#endif /* UIP_MCAST6_STATS */
 #endif
 /*---------------------------------------------------------------------------*/
 /** @} */
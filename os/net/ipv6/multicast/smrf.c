@@ -45,6 +45,7 @@
 #include "contiki-net.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
 #include "net/ipv6/multicast/uip-mcast6-stats.h"
 #include "net/ipv6/multicast/smrf.h"
 #include "net/routing/routing.h"
@@ -137,6 +138,14 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  /* Loops and re-receptions: don't forward or deliver the same one twice */
+  if(uip_mcast6_dup_check()) {
+    PRINTF("SMRF: Duplicate, dropping\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -201,6 +210,7 @@ init()
   UIP_MCAST6_STATS_INIT(NULL);
 
   uip_mcast6_route_init();
+  uip_mcast6_dup_init();
 }
 /*---------------------------------------------------------------------------*/
 static void
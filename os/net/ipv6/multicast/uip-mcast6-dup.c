@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Duplicate datagram cache for the stateless multicast forwarding
+ *    engines
+ */
+#include "contiki.h"
+#include "lib/crc16.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
+
+#include <stdint.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_DUP_ENTRIES
+struct dup_entry {
+  clock_time_t seen;  /* When the datagram was last seen */
+  uint16_t src;       /* Hash of the source address */
+  uint16_t data;      /* Hash of destination, next header and payload */
+  uint8_t used;
+};
+
+static struct dup_entry dup_cache[UIP_MCAST6_DUP_ENTRIES];
+#endif /* UIP_MCAST6_DUP_ENTRIES */
+/*---------------------------------------------------------------------------*/
+void
+uip_mcast6_dup_init(void)
+{
+#if UIP_MCAST6_DUP_ENTRIES
+  memset(dup_cache, 0, sizeof(dup_cache));
+#endif /* UIP_MCAST6_DUP_ENTRIES */
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_mcast6_dup_check(void)
+{
+#if UIP_MCAST6_DUP_ENTRIES
+  struct dup_entry *e;
+  struct dup_entry *oldest;
+  clock_time_t now;
+  uint16_t src;
+  uint16_t data;
+  uint16_t len;
+
+  if(uip_len < UIP_IPH_LEN + uip_ext_len) {
+    return 0;
+  }
+  len = uip_len - UIP_IPH_LEN - uip_ext_len;
+
+  src = crc16_data(UIP_IP_BUF->srcipaddr.u8, sizeof(uip_ipaddr_t), 0);
+  data = crc16_data(UIP_IP_BUF->destipaddr.u8, sizeof(uip_ipaddr_t), 0);
+  data = crc16_add(uip_last_proto, data);
+  data = crc16_data(UIP_IP_PAYLOAD(uip_ext_len), len, data);
+
+  now = clock_time();
+  oldest = NULL;
+  for(e = dup_cache; e < &dup_cache[UIP_MCAST6_DUP_ENTRIES]; e++) {
+    if(e->used && now - e->seen >= UIP_MCAST6_DUP_LIFETIME) {
+      e->used = 0;
+    }
+    if(!e->used) {
+      /* A free entry is always preferred for the new fingerprint */
+      if(oldest == NULL || oldest->used) {
+        oldest = e;
+      }
+      continue;
+    }
+    if(e->src == src && e->data == data) {
+      return 1;
+    }
+    /* Otherwise, the least recently seen one is replaced */
+    if(oldest == NULL ||
+       (oldest->used && now - e->seen > now - oldest->seen)) {
+      oldest = e;
+    }
+  }
+
+  oldest->seen = now;
+  oldest->src = src;
+  oldest->data = data;
+  oldest->used = 1;
+#endif /* UIP_MCAST6_DUP_ENTRIES */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup uip-multicast
+ * @{
+ */
+/**
+ * \file
+ *    Header file for the duplicate datagram cache shared by the
+ *    stateless multicast forwarding engines (SMRF, ESMRF)
+ *
+ *    SMRF and ESMRF datagrams carry no sequence number. A datagram is
+ *    instead identified by a fingerprint made of a hash of its source
+ *    address and a hash of its destination, next header and upper layer
+ *    payload. The hop limit and extension headers change hop by hop and
+ *    are left out. Fingerprints are remembered for
+ *    UIP_MCAST6_DUP_LIFETIME, after which an identical datagram is
+ *    considered new again.
+ *
+ *    Without a sequence number, the cache has false positives, which is
+ *    why it is off by default:
+ *    - A source that sends the same payload to the same group again
+ *      within UIP_MCAST6_DUP_LIFETIME (a periodic reading that did not
+ *      change, a retransmission by the application) has the second
+ *      datagram dropped as a duplicate.
+ *    - Two different datagrams of the same source with colliding 16-bit
+ *      payload hashes within UIP_MCAST6_DUP_LIFETIME have the second one
+ *      dropped as well.
+ *    Only enable it for applications that never repeat a datagram within
+ *    the lifetime, e.g. that carry their own counter in the payload.
+ */
+#ifndef UIP_MCAST6_DUP_H_
+#define UIP_MCAST6_DUP_H_
+
+#include "contiki.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Configuration */
+/*---------------------------------------------------------------------------*/
+/* Number of remembered fingerprints. 0 (default) disables duplicate
+ * detection, see the false positives above */
+#ifdef UIP_MCAST6_CONF_DUP_ENTRIES
+#define UIP_MCAST6_DUP_ENTRIES UIP_MCAST6_CONF_DUP_ENTRIES
+#else
+#define UIP_MCAST6_DUP_ENTRIES 0
+#endif
+
+/* How long a fingerprint is remembered, in clock ticks */
+#ifdef UIP_MCAST6_CONF_DUP_LIFETIME
+#define UIP_MCAST6_DUP_LIFETIME UIP_MCAST6_CONF_DUP_LIFETIME
+#else
+#define UIP_MCAST6_DUP_LIFETIME (2 * CLOCK_SECOND)
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Initialise the duplicate cache
+ */
+void uip_mcast6_dup_init(void);
+
+/**
+ * \brief Check the datagram in uip_buf against the duplicate cache
+ * \retval 1 The datagram has been seen recently
+ * \retval 0 The datagram is new. It has been added to the cache
+ *
+ * uip_ext_len must hold the length of the extension headers, as it does
+ * when the engine's in() is called.
+ */
+int uip_mcast6_dup_check(void);
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_MCAST6_DUP_H_ */
+/*---------------------------------------------------------------------------*/
+/** @} */
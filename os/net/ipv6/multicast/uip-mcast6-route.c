@@ -56,19 +56,47 @@
 #else
 #define UIP_MCAST6_ROUTE_ROUTES 1
 #endif /* UIP_CONF_DS6_MCAST_ROUTES */
+
+/*
+ * Number of hash buckets used to index the table by group address. Lookups
+ * happen for every multicast datagram we receive, so they should not have
+ * to walk the entire table.
+ */
+#ifdef UIP_MCAST6_ROUTE_CONF_HASH_SIZE
+#define UIP_MCAST6_ROUTE_HASH_SIZE UIP_MCAST6_ROUTE_CONF_HASH_SIZE
+#elif UIP_MCAST6_ROUTE_ROUTES < 8
+#define UIP_MCAST6_ROUTE_HASH_SIZE UIP_MCAST6_ROUTE_ROUTES
+#else
+#define UIP_MCAST6_ROUTE_HASH_SIZE 8
+#endif /* UIP_MCAST6_ROUTE_CONF_HASH_SIZE */
 /*---------------------------------------------------------------------------*/
 LIST(mcast_route_list);
 MEMB(mcast_route_memb, uip_mcast6_route_t, UIP_MCAST6_ROUTE_ROUTES);
 
+static uip_mcast6_route_t *mcast_route_hash[UIP_MCAST6_ROUTE_HASH_SIZE];
+
 static uip_mcast6_route_t *locmcastrt;
 /*---------------------------------------------------------------------------*/
+static uint8_t
+group_hash(const uip_ipaddr_t *group)
+{
+  uint8_t i;
+  uint16_t h = 0;
+
+  /* Groups usually differ in their last bytes (the group ID), but the
+   * scope and flags are folded in as well */
+  for(i = 0; i < sizeof(uip_ipaddr_t); i++) {
+    h = (h << 3) ^ (h >> 13) ^ group->u8[i];
+  }
+  return h % UIP_MCAST6_ROUTE_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
 uip_mcast6_route_t *
 uip_mcast6_route_lookup(uip_ipaddr_t *group)
 {
-  locmcastrt = NULL;
-  for(locmcastrt = list_head(mcast_route_list);
+  for(locmcastrt = mcast_route_hash[group_hash(group)];
       locmcastrt != NULL;
-      locmcastrt = list_item_next(locmcastrt)) {
+      locmcastrt = locmcastrt->hash_next) {
     if(uip_ipaddr_cmp(&locmcastrt->group, group)) {
       return locmcastrt;
     }
@@ -89,23 +117,28 @@ uip_mcast6_route_add(uip_ipaddr_t *group)
       return NULL;
     }
     list_add(mcast_route_list, locmcastrt);
+
+    uip_ipaddr_copy(&(locmcastrt->group), group);
+    locmcastrt->hash_next = mcast_route_hash[group_hash(group)];
+    mcast_route_hash[group_hash(group)] = locmcastrt;
   }
 
   /* Reaching here means we either found the prefix or allocated a new one */
 
-  uip_ipaddr_copy(&(locmcastrt->group), group);
-
   return locmcastrt;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_mcast6_route_rm(uip_mcast6_route_t *route)
 {
-  /* Make sure it's actually in the list */
-  for(locmcastrt = list_head(mcast_route_list);
-      locmcastrt != NULL;
-      locmcastrt = list_item_next(locmcastrt)) {
-    if(locmcastrt == route) {
+  uip_mcast6_route_t **rp;
+
+  /* Make sure it's actually in the table */
+  for(rp = &mcast_route_hash[group_hash(&route->group)];
+      *rp != NULL;
+      rp = &(*rp)->hash_next) {
+    if(*rp == route) {
+      *rp = route->hash_next;
       list_remove(mcast_route_list, route);
       memb_free(&mcast_route_memb, route);
       return;
@@ -130,6 +163,7 @@ uip_mcast6_route_init()
 {
   memb_init(&mcast_route_memb);
   list_init(mcast_route_list);
+  memset(mcast_route_hash, 0, sizeof(mcast_route_hash));
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
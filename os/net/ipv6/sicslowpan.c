@@ -69,10 +69,13 @@
 #include "net/ipv6/uip.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/uipbuf.h"
+#include "net/ipv6/uip-icmp6.h"
 #include "net/ipv6/sicslowpan.h"
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
+#include "lib/memb.h"
+#include "sys/trace.h"
 
 #include "net/routing/routing.h"
 
@@ -213,9 +216,8 @@ static uint16_t my_tag;
 #endif
 
 /* REASS_CONTEXTS corresponds to the number of simultaneous
- * reassemblies that can be made. NOTE: the first buffer for each
- * reassembly is stored in the context since it can be larger than the
- * rest of the fragments due to header compression.
+ * reassemblies that can be made. The fragments of all the contexts
+ * are stored in a shared pool.
  **/
 #ifdef SICSLOWPAN_CONF_REASS_CONTEXTS
 #define SICSLOWPAN_REASS_CONTEXTS SICSLOWPAN_CONF_REASS_CONTEXTS
@@ -223,6 +225,96 @@ static uint16_t my_tag;
 #define SICSLOWPAN_REASS_CONTEXTS 2
 #endif
 
+#if SICSLOWPAN_REASS_CONTEXTS > 127
+#error Too large SICSLOWPAN_REASS_CONTEXTS set.
+#endif
+
+/* The number of hash buckets used to look up the reassembly context
+   of a fragment from its sender and tag */
+#ifdef SICSLOWPAN_CONF_REASS_HASH_SIZE
+#define SICSLOWPAN_REASS_HASH_SIZE SICSLOWPAN_CONF_REASS_HASH_SIZE
+#else
+#define SICSLOWPAN_REASS_HASH_SIZE 8
+#endif
+
+/* Fragments are stored in blocks of this size, at offsets of the
+   packet that are multiples of it */
+#ifdef SICSLOWPAN_CONF_REASS_BLOCK_SIZE
+#define SICSLOWPAN_REASS_BLOCK_SIZE SICSLOWPAN_CONF_REASS_BLOCK_SIZE
+#else
+#define SICSLOWPAN_REASS_BLOCK_SIZE 64
+#endif
+
+/* The size in bytes of the pool that stores the fragments of all
+   contexts. By default, the same memory as SICSLOWPAN_FRAGMENT_BUFFERS
+   fragments plus a first fragment per context. */
+#ifdef SICSLOWPAN_CONF_REASS_POOL_SIZE
+#define SICSLOWPAN_REASS_POOL_SIZE SICSLOWPAN_CONF_REASS_POOL_SIZE
+#else
+#define SICSLOWPAN_REASS_POOL_SIZE \
+  (SICSLOWPAN_FRAGMENT_BUFFERS * SICSLOWPAN_FRAGMENT_SIZE + \
+   SICSLOWPAN_REASS_CONTEXTS * SICSLOWPAN_FIRST_FRAGMENT_SIZE)
+#endif
+
+/* Fragment forwarding (RFC 8930): a router relays the fragments of a
+ * packet that is not destined to itself as they arrive, instead of
+ * reassembling the packet first. A Virtual Reassembly Buffer (VRB)
+ * entry maps the (sender, tag) of the incoming fragments to the
+ * (next hop, tag) used for the outgoing ones. */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING (SICSLOWPAN_CONF_FRAG_FORWARDING && UIP_CONF_ROUTER)
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+/* The number of packets that can be forwarded concurrently */
+#ifdef SICSLOWPAN_CONF_VRB_ENTRIES
+#define SICSLOWPAN_VRB_ENTRIES SICSLOWPAN_CONF_VRB_ENTRIES
+#else
+#define SICSLOWPAN_VRB_ENTRIES 4
+#endif
+
+/* Selective Fragment Recovery (RFC 8931): fragmented packets are sent
+ * as RFRAG fragments that carry a sequence number. The receiver
+ * acknowledges them with a bitmap, and only the missing fragments are
+ * sent again. All nodes of a network must use the same setting. */
+#ifdef SICSLOWPAN_CONF_SFR
+#define SICSLOWPAN_SFR SICSLOWPAN_CONF_SFR
+#else
+#define SICSLOWPAN_SFR 0
+#endif
+
+/* The number of fragments sent before an acknowledgment is requested
+   and awaited. 32, the maximum, disables pacing. */
+#ifdef SICSLOWPAN_CONF_SFR_WINDOW
+#define SICSLOWPAN_SFR_WINDOW SICSLOWPAN_CONF_SFR_WINDOW
+#else
+#define SICSLOWPAN_SFR_WINDOW 32
+#endif
+
+/* The time to wait for an acknowledgment before requesting it again */
+#ifdef SICSLOWPAN_CONF_SFR_ACK_TIMEOUT
+#define SICSLOWPAN_SFR_ACK_TIMEOUT SICSLOWPAN_CONF_SFR_ACK_TIMEOUT
+#else
+#define SICSLOWPAN_SFR_ACK_TIMEOUT (CLOCK_SECOND / 4)
+#endif
+
+/* The number of acknowledgment requests without progress before the
+   packet is dropped */
+#ifdef SICSLOWPAN_CONF_SFR_MAX_RETRIES
+#define SICSLOWPAN_SFR_MAX_RETRIES SICSLOWPAN_CONF_SFR_MAX_RETRIES
+#else
+#define SICSLOWPAN_SFR_MAX_RETRIES 3
+#endif
+
+/* The number of packets that can be sent concurrently. Each one keeps
+   a copy of the packet until it is acknowledged. */
+#ifdef SICSLOWPAN_CONF_SFR_TX_BUFFERS
+#define SICSLOWPAN_SFR_TX_BUFFERS SICSLOWPAN_CONF_SFR_TX_BUFFERS
+#else
+#define SICSLOWPAN_SFR_TX_BUFFERS 1
+#endif
+
 /* The size of each fragment (IP payload) for the 6lowpan fragmentation */
 #ifdef SICSLOWPAN_CONF_FRAGMENT_SIZE
 #define SICSLOWPAN_FRAGMENT_SIZE SICSLOWPAN_CONF_FRAGMENT_SIZE
@@ -239,6 +331,18 @@ static uint16_t my_tag;
 /* Assuming that the worst growth for uncompression is 38 bytes */
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
 
+/* A block of the fragment pool */
+struct sicslowpan_frag_block {
+  struct sicslowpan_frag_block *next;
+  /** Offset of the block in the packet */
+  uint16_t offset;
+  uint8_t data[SICSLOWPAN_REASS_BLOCK_SIZE];
+};
+
+MEMB(frag_blocks, struct sicslowpan_frag_block,
+     (SICSLOWPAN_REASS_POOL_SIZE + SICSLOWPAN_REASS_BLOCK_SIZE - 1) /
+     SICSLOWPAN_REASS_BLOCK_SIZE);
+
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
   /** When reassembling, the source address of the fragments being merged */
@@ -256,39 +360,137 @@ struct sicslowpan_frag_info {
 
   /** Fragment size of first fragment */
   uint16_t first_frag_len;
-  /** First fragment - needs a larger buffer since the size is uncompressed size
-   and we need to know total size to know when we have received last fragment. */
-  uint8_t first_frag[SICSLOWPAN_FIRST_FRAGMENT_SIZE];
+  /** The blocks holding the fragments received so far */
+  struct sicslowpan_frag_block *blocks;
+  /** The next context in the same hash bucket, or in the free list */
+  int8_t next;
+  /** The 8-byte units of the packet received so far */
+  uint8_t bitmap[UIP_BUFSIZE / 64 + 1];
+#if SICSLOWPAN_SFR
+  /** Sequence numbers of the RFRAG fragments received */
+  uint32_t rfrag_bitmap;
+  /** Non-zero if the fragments are RFRAG fragments */
+  uint8_t rfrag;
+#endif /* SICSLOWPAN_SFR */
 };
 
 static struct sicslowpan_frag_info frag_info[SICSLOWPAN_REASS_CONTEXTS];
 
-struct sicslowpan_frag_buf {
-  /* the index of the frag_info */
-  uint8_t index;
-  /* Fragment offset */
-  uint8_t offset;
-  /* Length of this fragment (if zero this buffer is not allocated) */
-  uint8_t len;
-  uint8_t data[SICSLOWPAN_FRAGMENT_SIZE];
+/* Heads of the hash chains of the contexts in use, and of the list of
+   free contexts */
+static int8_t frag_hash[SICSLOWPAN_REASS_HASH_SIZE];
+static int8_t frag_free;
+
+/* The first fragment, while it is uncompressed. It is larger than the
+   others due to header compression, and copied to the pool after. */
+static uint8_t first_frag_buf[SICSLOWPAN_FIRST_FRAGMENT_SIZE];
+
+#define FRAG_DUPLICATE -2
+
+#if SICSLOWPAN_STATS
+struct sicslowpan_reass_stats sicslowpan_reass_stats;
+#endif /* SICSLOWPAN_STATS */
+
+#if SICSLOWPAN_FRAG_FORWARDING
+/* One bit per 8-byte offset of a datagram that fits in uip_buf */
+#define VRB_OFFSETS_LEN ((UIP_BUFSIZE + 63) / 64)
+
+/* A Virtual Reassembly Buffer entry */
+struct sicslowpan_vrb {
+  /** The link-layer sender of the incoming fragments */
+  linkaddr_t sender;
+  /** The next hop the fragments are relayed to (null until the first
+      fragment is sent on, the fragments are dropped if it is not) */
+  linkaddr_t next_hop;
+  /** The tag of the incoming fragments */
+  uint16_t tag;
+  /** The tag of the outgoing fragments */
+  uint16_t out_tag;
+  /** Datagram size of the incoming fragments (if zero the entry is free) */
+  uint16_t size;
+  /** Number of bytes of the datagram relayed so far */
+  uint16_t relayed_len;
+  /** Change of the datagram size at this hop, e.g. when the routing
+      protocol inserts an extension header. A multiple of 8 bytes. */
+  int16_t delta;
+  /** The offsets of the FRAGN fragments relayed so far, in units of 8
+      bytes, to tell duplicates */
+  uint8_t relayed[VRB_OFFSETS_LEN];
+  /** Expiration timer of the entry */
+  struct timer timer;
 };
 
-static struct sicslowpan_frag_buf frag_buf[SICSLOWPAN_FRAGMENT_BUFFERS];
+static struct sicslowpan_vrb vrb[SICSLOWPAN_VRB_ENTRIES];
+
+/* The first fragment of a packet to relay, while it is being routed
+   by the IP layer */
+static struct {
+  struct sicslowpan_vrb *vrb;
+  uip_ipaddr_t srcipaddr;
+  uint16_t first_frag_len;
+} frag_fwd;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
+/*---------------------------------------------------------------------------*/
+static unsigned
+frag_hash_index(const linkaddr_t *sender, uint16_t tag)
+{
+  unsigned h = tag;
+  int i;
+
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h << 3) ^ (h >> 13) ^ sender->u8[i];
+  }
+  return h % SICSLOWPAN_REASS_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_fragments(void)
+{
+  int i;
 
+  memb_init(&frag_blocks);
+  for(i = 0; i < SICSLOWPAN_REASS_HASH_SIZE; i++) {
+    frag_hash[i] = -1;
+  }
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    frag_info[i].next = i + 1 < SICSLOWPAN_REASS_CONTEXTS ? i + 1 : -1;
+  }
+  frag_free = 0;
+}
 /*---------------------------------------------------------------------------*/
 static int
 clear_fragments(uint8_t frag_info_index)
 {
-  int i, clear_count;
-  clear_count = 0;
-  frag_info[frag_info_index].len = 0;
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len > 0 && frag_buf[i].index == frag_info_index) {
-      /* deallocate the buffer */
-      frag_buf[i].len = 0;
-      clear_count++;
+  struct sicslowpan_frag_info *info = &frag_info[frag_info_index];
+  struct sicslowpan_frag_block *b;
+  int8_t *p;
+  int clear_count;
+
+  if(info->len == 0) {
+    return 0;
+  }
+
+  /* unlink the context from its hash chain */
+  for(p = &frag_hash[frag_hash_index(&info->sender, info->tag)];
+      *p >= 0; p = &frag_info[*p].next) {
+    if(*p == frag_info_index) {
+      *p = info->next;
+      break;
     }
   }
+  info->next = frag_free;
+  frag_free = frag_info_index;
+  info->len = 0;
+
+  /* deallocate the blocks */
+  clear_count = 0;
+  while(info->blocks != NULL) {
+    b = info->blocks;
+    info->blocks = b->next;
+    memb_free(&frag_blocks, b);
+    clear_count++;
+  }
   return clear_count;
 }
 /*---------------------------------------------------------------------------*/
@@ -301,109 +503,255 @@ timeout_fragments(int not_context)
     if(frag_info[i].len > 0 && i != not_context &&
        timer_expired(&frag_info[i].reass_timer)) {
       /* This context can be freed */
+      LOG_INFO("reassembly: timeout - tag: %d\n", frag_info[i].tag);
+      SICSLOWPAN_STAT(sicslowpan_reass_stats.timeouts++);
       count += clear_fragments(i);
     }
   }
   return count;
 }
 /*---------------------------------------------------------------------------*/
+/* find the context of the fragments with this tag from the sender of
+   the packet in packetbuf */
+static int8_t
+lookup_context(uint16_t tag)
+{
+  const linkaddr_t *sender = packetbuf_addr(PACKETBUF_ADDR_SENDER);
+  int8_t i;
+
+  for(i = frag_hash[frag_hash_index(sender, tag)]; i >= 0; i = frag_info[i].next) {
+    if(frag_info[i].tag == tag && linkaddr_cmp(&frag_info[i].sender, sender)) {
+      if(timer_expired(&frag_info[i].reass_timer)) {
+        LOG_INFO("reassembly: timeout - tag: %d\n", tag);
+        SICSLOWPAN_STAT(sicslowpan_reass_stats.timeouts++);
+        clear_fragments(i);
+        return -1;
+      }
+      return i;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Mark the 8-byte units of the packet that a fragment fully covers as
+   received. Returns FRAG_DUPLICATE if they were all received already,
+   -1 if some of them were (the fragments overlap), 0 otherwise. */
 static int
-store_fragment(uint8_t index, uint8_t offset)
+mark_fragment(uint8_t index, uint16_t offset, uint16_t len)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+  uint16_t first, end, unit;
+  uint16_t set = 0;
+
+  if(offset + len > info->len) {
+    return -1;
+  }
+
+  first = (offset + 7) / 8;
+  end = (offset + len) / 8;
+  if(offset + len == info->len) {
+    /* the last fragment covers the end of the packet */
+    end = (info->len + 7) / 8;
+  }
+  if(end > sizeof(info->bitmap) * 8) {
+    return -1;
+  }
+
+  for(unit = first; unit < end; unit++) {
+    if(info->bitmap[unit / 8] & (0x80 >> (unit % 8))) {
+      set++;
+    }
+  }
+  if(set > 0) {
+    return set == end - first ? FRAG_DUPLICATE : -1;
+  }
+
+  for(unit = first; unit < end; unit++) {
+    info->bitmap[unit / 8] |= 0x80 >> (unit % 8);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Copy data of the packet at the given offset to the pool */
+static bool
+write_fragment(uint8_t index, uint16_t offset, const uint8_t *data, uint16_t len)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+  struct sicslowpan_frag_block *b;
+  uint16_t block_offset;
+  uint16_t n;
+
+  while(len > 0) {
+    block_offset = offset - offset % SICSLOWPAN_REASS_BLOCK_SIZE;
+    for(b = info->blocks; b != NULL && b->offset != block_offset; b = b->next);
+    if(b == NULL) {
+      b = memb_alloc(&frag_blocks);
+      if(b == NULL && timeout_fragments(index) > 0) {
+        b = memb_alloc(&frag_blocks);
+      }
+      if(b == NULL) {
+        return false;
+      }
+      b->offset = block_offset;
+      b->next = info->blocks;
+      info->blocks = b;
+    }
+    n = MIN(len, SICSLOWPAN_REASS_BLOCK_SIZE - (offset - block_offset));
+    memcpy(b->data + (offset - block_offset), data, n);
+    offset += n;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+static int
+store_fragment(uint8_t index, uint16_t offset)
 {
-  int i;
   int len;
 
   len = packetbuf_datalen() - packetbuf_hdr_len;
 
-  if(len <= 0 || len > SICSLOWPAN_FRAGMENT_SIZE) {
+  if(len <= 0 || offset + len > UIP_BUFSIZE) {
     /* Unacceptable fragment size. */
     return -1;
   }
 
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len == 0) {
-      /* copy over the data from packetbuf into the fragment buffer,
-         and store offset and len */
-      frag_buf[i].offset = offset; /* frag offset */
-      frag_buf[i].len = len;
-      frag_buf[i].index = index;
-      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len, len);
-      /* return the length of the stored fragment */
-      return len;
-    }
+  if(!write_fragment(index, offset, packetbuf_ptr + packetbuf_hdr_len, len)) {
+    /* failed */
+    return -1;
   }
-  /* failed */
-  return -1;
+  /* return the length of the stored fragment */
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* store the first fragment, from first_frag_buf, once uncompressed */
+static bool
+store_first_fragment(uint8_t index)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+
+  if(info->first_frag_len > info->len ||
+     !write_fragment(index, 0, first_frag_buf, info->first_frag_len)) {
+    LOG_WARN("reassembly: failed to store first fragment - tag: %d\n", info->tag);
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
+    clear_fragments(index);
+    return false;
+  }
+#if SICSLOWPAN_SFR
+  if(info->rfrag) {
+    return true;
+  }
+#endif /* SICSLOWPAN_SFR */
+  mark_fragment(index, 0, info->first_frag_len);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* allocate a reassembly context for a new packet */
+static int8_t
+new_context(uint16_t tag, uint16_t frag_size)
+{
+  struct sicslowpan_frag_info *info;
+  unsigned h;
+  int8_t found;
+
+  if(frag_free < 0) {
+    /* free the contexts with expired timer */
+    timeout_fragments(-1);
+  }
+
+  found = frag_free;
+  if(found < 0) {
+    LOG_WARN("reassembly: failed to store new fragment session - tag: %d\n", tag);
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
+    return -1;
+  }
+
+  /* Found a free fragment info to store data in */
+  info = &frag_info[found];
+  frag_free = info->next;
+  h = frag_hash_index(packetbuf_addr(PACKETBUF_ADDR_SENDER), tag);
+  info->next = frag_hash[h];
+  frag_hash[h] = found;
+
+  info->len = frag_size;
+  info->tag = tag;
+  info->reassembled_len = 0;
+  info->first_frag_len = 0;
+  info->blocks = NULL;
+  memset(info->bitmap, 0, sizeof(info->bitmap));
+  linkaddr_copy(&info->sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  timer_set(&info->reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+#if SICSLOWPAN_SFR
+  info->rfrag = 0;
+  info->rfrag_bitmap = 0;
+#endif /* SICSLOWPAN_SFR */
+  return found;
 }
 /*---------------------------------------------------------------------------*/
 /* add a new fragment to the buffer */
 static int8_t
-add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
+add_fragment(uint16_t tag, uint16_t frag_size, uint16_t offset)
 {
-  int i;
   int len;
-  int8_t found = -1;
+  int8_t found;
+  int ret;
+
+  found = lookup_context(tag);
+#if SICSLOWPAN_SFR
+  if(found >= 0 && frag_info[found].rfrag) {
+    found = -1;
+  }
+#endif /* SICSLOWPAN_SFR */
 
   if(offset == 0) {
     /* This is a first fragment - check if we can add this */
-    for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-      /* clear all fragment info with expired timer to free all fragment buffers */
-      if(frag_info[i].len > 0 && timer_expired(&frag_info[i].reass_timer)) {
-        clear_fragments(i);
-      }
-
-      /* We use len as indication on used or not used */
-      if(found < 0 && frag_info[i].len == 0) {
-        /* We remember the first free fragment info but must continue
-           the loop to free any other expired fragment buffers. */
-        found = i;
-      }
+    if(found >= 0) {
+      LOG_INFO("reassembly: duplicate first fragment - tag: %d\n", tag);
+      SICSLOWPAN_STAT(sicslowpan_reass_stats.duplicates++);
+      return FRAG_DUPLICATE;
     }
-
-    if(found < 0) {
-      LOG_WARN("reassembly: failed to store new fragment session - tag: %d\n", tag);
+    if(frag_size == 0 || frag_size > UIP_BUFSIZE) {
+      LOG_WARN("reassembly: packet too large - tag: %d len: %d\n", tag, frag_size);
+      SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
       return -1;
     }
-
-    /* Found a free fragment info to store data in */
-    frag_info[found].len = frag_size;
-    frag_info[found].tag = tag;
-    linkaddr_copy(&frag_info[found].sender,
-                  packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
     /* first fragment can not be stored immediately but is moved into
        the buffer while uncompressing */
-    return found;
+    return new_context(tag, frag_size);
   }
 
   /* This is a N-fragment - should find the info */
-  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-    if(frag_info[i].tag == tag && frag_info[i].len > 0 &&
-       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
-      /* Tag and Sender match - this must be the correct info to store in */
-      found = i;
-      break;
-    }
-  }
-
   if(found < 0) {
     /* no entry found for storing the new fragment */
     LOG_WARN("reassembly: failed to store N-fragment - could not find session - tag: %d offset: %d\n", tag, offset);
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
     return -1;
   }
 
-  /* i is the index of the reassembly context */
-  len = store_fragment(i, offset);
-  if(len < 0 && timeout_fragments(i) > 0) {
-    len = store_fragment(i, offset);
+  len = packetbuf_datalen() - packetbuf_hdr_len;
+  ret = mark_fragment(found, offset, len);
+  if(ret == FRAG_DUPLICATE) {
+    LOG_INFO("reassembly: duplicate fragment - tag: %d offset: %d\n", tag, offset);
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.duplicates++);
+    return FRAG_DUPLICATE;
+  }
+
+  /* found is the index of the reassembly context */
+  if(ret == 0) {
+    len = store_fragment(found, offset);
+  } else {
+    /* RFC 4944: overlapping fragments make the whole packet invalid */
+    LOG_WARN("reassembly: overlapping fragment - tag: %d offset: %d\n", tag, offset);
+    len = -1;
   }
   if(len > 0) {
-    frag_info[i].reassembled_len += len;
-    return i;
+    frag_info[found].reassembled_len += len;
+    return found;
   } else {
-    /* should we also clear all fragments since we failed to store
-       this fragment? */
-    LOG_WARN("reassembly: failed to store fragment - packet reassembly will fail tag:%d l\n", frag_info[i].tag);
+    LOG_WARN("reassembly: failed to store fragment - dropping packet tag:%d\n", frag_info[found].tag);
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
+    clear_fragments(found);
     return -1;
   }
 }
@@ -413,34 +761,25 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 static bool
 copy_frags2uip(int context)
 {
-  int i;
+  struct sicslowpan_frag_block *b;
 
   /* Check length fields before proceeding. */
   if(frag_info[context].len < frag_info[context].first_frag_len ||
      frag_info[context].len > sizeof(uip_buf)) {
     LOG_WARN("input: invalid total size of fragments\n");
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
     clear_fragments(context);
     return false;
   }
 
-  /* Copy from the fragment context info buffer first */
-  memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)frag_info[context].first_frag,
-         frag_info[context].first_frag_len);
-
   /* Ensure that no previous data is used for reassembly in case of missing fragments. */
-  memset((uint8_t *)UIP_IP_BUF + frag_info[context].first_frag_len, 0,
-         frag_info[context].len - frag_info[context].first_frag_len);
-
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    /* And also copy all matching fragments */
-    if(frag_buf[i].len > 0 && frag_buf[i].index == context) {
-      if((frag_buf[i].offset << 3) + frag_buf[i].len > sizeof(uip_buf)) {
-        LOG_WARN("input: invalid fragment offset\n");
-        clear_fragments(context);
-        return false;
-      }
-      memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(frag_buf[i].offset << 3),
-             (uint8_t *)frag_buf[i].data, frag_buf[i].len);
+  memset((uint8_t *)UIP_IP_BUF, 0, frag_info[context].len);
+
+  for(b = frag_info[context].blocks; b != NULL; b = b->next) {
+    /* And also copy all the blocks within the packet */
+    if(b->offset < frag_info[context].len) {
+      memcpy((uint8_t *)UIP_IP_BUF + b->offset, b->data,
+             MIN(SICSLOWPAN_REASS_BLOCK_SIZE, frag_info[context].len - b->offset));
     }
   }
   /* deallocate all the fragments for this context */
@@ -448,6 +787,200 @@ copy_frags2uip(int context)
 
   return true;
 }
+#if SICSLOWPAN_SFR
+/*---------------------------------------------------------------------------*/
+#define RFRAG_BIT(seq)     (UINT32_C(0x80000000) >> (seq))
+#define RFRAG_BITMAP_NULL  UINT32_C(0)
+#define RFRAG_BITMAP_FULL  UINT32_C(0xffffffff)
+#define RFRAG_MAX_FRAGMENTS 32
+
+/* Recently reassembled packets, to acknowledge their fragments again
+   when the sender did not get the acknowledgment */
+#define RFRAG_DONE_ENTRIES 2
+static struct {
+  linkaddr_t sender;
+  uint8_t tag;
+  uint8_t valid;
+} rfrag_done[RFRAG_DONE_ENTRIES];
+static uint8_t rfrag_done_next;
+
+static void
+rfrag_done_add(int context)
+{
+  linkaddr_copy(&rfrag_done[rfrag_done_next].sender, &frag_info[context].sender);
+  rfrag_done[rfrag_done_next].tag = frag_info[context].tag;
+  rfrag_done[rfrag_done_next].valid = 1;
+  rfrag_done_next = (rfrag_done_next + 1) % RFRAG_DONE_ENTRIES;
+}
+/*---------------------------------------------------------------------------*/
+/* The bitmap to acknowledge a fragment for which we have no context */
+static uint32_t
+rfrag_unknown_bitmap(uint8_t tag)
+{
+  int i;
+
+  for(i = 0; i < RFRAG_DONE_ENTRIES; i++) {
+    if(rfrag_done[i].valid && rfrag_done[i].tag == tag &&
+       linkaddr_cmp(&rfrag_done[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      return RFRAG_BITMAP_FULL;
+    }
+  }
+  /* Tell the sender to abort */
+  return RFRAG_BITMAP_NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* add a RFRAG fragment. Unlike with RFC 4944 fragments, any fragment may
+   open the context since the first one may be lost and sent again. */
+static int8_t
+add_rfrag(uint8_t tag, uint8_t seq, uint16_t offset, uint16_t datagram_size,
+          bool *duplicate)
+{
+  int len;
+  int8_t found;
+
+  *duplicate = false;
+  found = lookup_context(tag);
+  if(found >= 0 && !frag_info[found].rfrag) {
+    found = -1;
+  }
+
+  if(found < 0) {
+    if(rfrag_unknown_bitmap(tag) == RFRAG_BITMAP_FULL) {
+      /* A late fragment of a packet that was reassembled already */
+      return -1;
+    }
+    /* The size of the packet is only known from the first fragment */
+    found = new_context(tag, seq == 0 ? datagram_size : UINT16_MAX);
+    if(found < 0) {
+      return -1;
+    }
+    frag_info[found].rfrag = 1;
+  } else {
+    /* Keep the context while the sender makes progress */
+    timer_restart(&frag_info[found].reass_timer);
+  }
+
+  if(frag_info[found].rfrag_bitmap & RFRAG_BIT(seq)) {
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.duplicates++);
+    *duplicate = true;
+    return found;
+  }
+
+  if(seq == 0) {
+    /* first fragment is moved into the buffer while uncompressing */
+    frag_info[found].len = datagram_size;
+    return found;
+  }
+
+  len = store_fragment(found, offset);
+  if(len < 0) {
+    LOG_WARN("reassembly: failed to store RFRAG fragment - tag: %d seq: %d\n",
+             tag, seq);
+    SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
+    clear_fragments(found);
+    return -1;
+  }
+  frag_info[found].reassembled_len += len;
+  frag_info[found].rfrag_bitmap |= RFRAG_BIT(seq);
+  return found;
+}
+#endif /* SICSLOWPAN_SFR */
+#if SICSLOWPAN_FRAG_FORWARDING
+/*---------------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_lookup(uint16_t tag, const linkaddr_t *sender)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb[i].size > 0 && vrb[i].tag == tag &&
+       linkaddr_cmp(&vrb[i].sender, sender)) {
+      if(timer_expired(&vrb[i].timer)) {
+        vrb[i].size = 0;
+        return NULL;
+      }
+      return &vrb[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_alloc(void)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb[i].size == 0 || timer_expired(&vrb[i].timer)) {
+      return &vrb[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Prepare to relay the packet of a context that only holds the first
+   fragment, if the packet is not for us. The first fragment, still in
+   first_frag_buf, is copied to uip so that the IP layer can route it
+   like a complete packet. The VRB entry is set up here, the fragments
+   that follow are dropped if the IP layer does not send the first one
+   on right away. */
+static bool
+vrb_start(int context)
+{
+  struct sicslowpan_frag_info *info = &frag_info[context];
+  struct uip_ip_hdr *ip = SICSLOWPAN_IP_BUF(first_frag_buf);
+  struct sicslowpan_vrb *v;
+
+#if SICSLOWPAN_SFR
+  /* RFRAG fragments are acknowledged, and reassembled at every hop */
+  if(info->rfrag) {
+    return false;
+  }
+#endif /* SICSLOWPAN_SFR */
+
+  if(uip_ds6_is_my_addr(&ip->destipaddr) ||
+     uip_is_addr_mcast(&ip->destipaddr) ||
+     uip_is_addr_linklocal(&ip->destipaddr) ||
+     info->len < info->first_frag_len ||
+     info->len > sizeof(uip_buf)) {
+    return false;
+  }
+
+  /* Without a VRB entry, the packet is reassembled */
+  v = vrb_alloc();
+  if(v == NULL) {
+    LOG_WARN("input: no VRB entry to relay fragments (tag %d)\n",
+             info->tag);
+    return false;
+  }
+
+  memcpy((uint8_t *)UIP_IP_BUF, first_frag_buf, info->first_frag_len);
+  /* The rest of the packet is not here, make sure no previous data is
+     included in case the IP layer uses it, e.g. for an ICMP error */
+  memset((uint8_t *)UIP_IP_BUF + info->first_frag_len, 0,
+         info->len - info->first_frag_len);
+  /* The padding must never be sent: the packet is dropped rather than
+     queued if the next hop is not resolved yet */
+  uipbuf_set_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_PARTIAL);
+
+  linkaddr_copy(&v->sender, &info->sender);
+  linkaddr_copy(&v->next_hop, &linkaddr_null);
+  v->tag = info->tag;
+  v->size = info->len;
+  v->relayed_len = info->first_frag_len;
+  v->delta = 0;
+  memset(v->relayed, 0, sizeof(v->relayed));
+  timer_set(&v->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+
+  frag_fwd.vrb = v;
+  uip_ipaddr_copy(&frag_fwd.srcipaddr, &ip->srcipaddr);
+  frag_fwd.first_frag_len = info->first_frag_len;
+
+  clear_fragments(context);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 #endif /* SICSLOWPAN_CONF_FRAG */
 
 /* -------------------------------------------------------------------------- */
@@ -518,6 +1051,49 @@ static struct sicslowpan_addr_context *context;
 /** pointer to the byte where to write next inline field. */
 static uint8_t *hc06_ptr;
 
+/* IPHC template cache: the compressed IPv6 headers of the last flows
+ * sent are kept, so that the next packets of a flow get their header
+ * copied instead of looking up contexts and compressing the addresses
+ * again. Only the traffic class, flow label and hop limit are encoded
+ * per packet. A template ends with the IPv6 header: the UDP header and
+ * the extension headers, ports included, are compressed for every
+ * packet, so the ports are not part of the key. The templates hold
+ * addresses compressed against the address contexts and the link-layer
+ * address of the node, so sicslowpan_iphc_cache_flush() must be called
+ * when either of them changes. */
+#ifdef SICSLOWPAN_CONF_IPHC_CACHE
+#define SICSLOWPAN_IPHC_CACHE SICSLOWPAN_CONF_IPHC_CACHE
+#else
+#define SICSLOWPAN_IPHC_CACHE 0
+#endif
+
+#if SICSLOWPAN_IPHC_CACHE
+/* The longest compressed IPv6 header: IPHC, CID, TC/FL, next header,
+   hop limit and two inline addresses */
+#define IPHC_TEMPLATE_MAX_LEN (2 + 1 + 4 + 1 + 1 + 16 + 16)
+
+/* Set in the shape of the entries in use */
+#define IPHC_TEMPLATE_USED 0x80
+
+struct iphc_template {
+  uip_ipaddr_t srcipaddr;
+  uip_ipaddr_t destipaddr;
+  linkaddr_t link_destaddr;
+  uint8_t proto;
+  /** The TF and HLIM bits of the IPHC encoding, and IPHC_TEMPLATE_USED */
+  uint8_t shape;
+  uint8_t len;
+  uint8_t hdr[IPHC_TEMPLATE_MAX_LEN];
+};
+
+static struct iphc_template iphc_templates[SICSLOWPAN_IPHC_CACHE];
+static uint8_t iphc_template_next;
+#endif /* SICSLOWPAN_IPHC_CACHE */
+
+#if SICSLOWPAN_STATS
+struct sicslowpan_iphc_stats sicslowpan_iphc_stats;
+#endif /* SICSLOWPAN_STATS */
+
 /* Uncompression of linklocal */
 /*   0 -> 16 bytes from packet  */
 /*   1 -> 2 bytes from prefix - bunch of zeroes and 8 from packet */
@@ -645,6 +1221,167 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
   LOG_DBG_("\n");
 }
 
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Compress the traffic class and flow label
+ *
+ * Writes the inline TC/FL bytes at hc06_ptr and sets the TF bits of
+ * iphc0. The number of bytes written only depends on which of the
+ * traffic class and flow label are zero.
+ */
+static void
+compress_tf(uint8_t *iphc0)
+{
+  uint8_t tmp;
+
+  /*
+   * Traffic class, flow label
+   * If flow label is 0, compress it. If traffic class is 0, compress it
+   * We have to process both in the same time as the offset of traffic class
+   * depends on the presence of version and flow label
+   */
+
+  /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
+
+  tmp = (UIP_IP_BUF->vtc << 4) | (UIP_IP_BUF->tcflow >> 4);
+  tmp = ((tmp & 0x03) << 6) | (tmp >> 2);
+
+  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) &&
+     (UIP_IP_BUF->flow == 0)) {
+    /* flow label can be compressed */
+    *iphc0 |= SICSLOWPAN_IPHC_FL_C;
+    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
+       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+      /* compress (elide) all */
+      *iphc0 |= SICSLOWPAN_IPHC_TC_C;
+    } else {
+      /* compress only the flow label */
+     *hc06_ptr = tmp;
+      hc06_ptr += 1;
+    }
+  } else {
+    /* Flow label cannot be compressed */
+    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
+       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+      /* compress only traffic class */
+      *iphc0 |= SICSLOWPAN_IPHC_TC_C;
+      *hc06_ptr = (tmp & 0xc0) |
+        (UIP_IP_BUF->tcflow & 0x0F);
+      memcpy(hc06_ptr + 1, &UIP_IP_BUF->flow, 2);
+      hc06_ptr += 3;
+    } else {
+      /* compress nothing */
+      memcpy(hc06_ptr, &UIP_IP_BUF->vtc, 4);
+      /* but replace the top byte with the new ECN | DSCP format*/
+      *hc06_ptr = tmp;
+      hc06_ptr += 4;
+   }
+  }
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_iphc_cache_flush(void)
+{
+#if SICSLOWPAN_IPHC_CACHE
+  memset(iphc_templates, 0, sizeof(iphc_templates));
+  iphc_template_next = 0;
+#endif /* SICSLOWPAN_IPHC_CACHE */
+}
+#if SICSLOWPAN_IPHC_CACHE
+/*--------------------------------------------------------------------*/
+/** \brief The TF and HLIM bits the IPHC encoding of the packet in
+    uip_buf will have */
+static uint8_t
+iphc_template_shape(void)
+{
+  uint8_t shape = IPHC_TEMPLATE_USED;
+
+  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) && (UIP_IP_BUF->flow == 0)) {
+    shape |= SICSLOWPAN_IPHC_FL_C;
+  }
+  if(((UIP_IP_BUF->vtc & 0x0F) == 0) && ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
+    shape |= SICSLOWPAN_IPHC_TC_C;
+  }
+  switch(UIP_IP_BUF->ttl) {
+  case 1:
+    shape |= SICSLOWPAN_IPHC_TTL_1;
+    break;
+  case 64:
+    shape |= SICSLOWPAN_IPHC_TTL_64;
+    break;
+  case 255:
+    shape |= SICSLOWPAN_IPHC_TTL_255;
+    break;
+  }
+  return shape;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Compress the IPv6 header from the template of its flow
+ *
+ * Copies the template to PACKETBUF_IPHC_BUF and encodes the traffic
+ * class, flow label and hop limit of the packet in it.
+ * \return 1 if the flow has a template, else 0
+ */
+static int
+iphc_template_apply(const linkaddr_t *link_destaddr,
+                    uint8_t *iphc0, uint8_t *iphc1)
+{
+  struct iphc_template *t;
+  uint8_t shape;
+
+  shape = iphc_template_shape();
+  for(t = iphc_templates; t < &iphc_templates[SICSLOWPAN_IPHC_CACHE]; t++) {
+    if(t->shape == shape && t->proto == UIP_IP_BUF->proto &&
+       uip_ipaddr_cmp(&t->destipaddr, &UIP_IP_BUF->destipaddr) &&
+       uip_ipaddr_cmp(&t->srcipaddr, &UIP_IP_BUF->srcipaddr) &&
+       linkaddr_cmp(&t->link_destaddr, link_destaddr)) {
+      memcpy(PACKETBUF_IPHC_BUF, t->hdr, t->len);
+      *iphc0 = t->hdr[0];
+      *iphc1 = t->hdr[1];
+      /* The TC/FL bytes follow the IPHC encoding and the CID */
+      hc06_ptr = PACKETBUF_IPHC_BUF +
+        ((*iphc1 & SICSLOWPAN_IPHC_CID) ? 3 : 2);
+      compress_tf(iphc0);
+      if((*iphc0 & SICSLOWPAN_IPHC_TTL_255) == SICSLOWPAN_IPHC_TTL_I) {
+        if((*iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
+          hc06_ptr++;
+        }
+        *hc06_ptr = UIP_IP_BUF->ttl;
+      }
+      hc06_ptr = PACKETBUF_IPHC_BUF + t->len;
+      SICSLOWPAN_STAT(sicslowpan_iphc_stats.hits++);
+      return 1;
+    }
+  }
+  SICSLOWPAN_STAT(sicslowpan_iphc_stats.misses++);
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+/** \brief Keep the IPv6 header just compressed as the template of
+    its flow, replacing the oldest one */
+static void
+iphc_template_store(const linkaddr_t *link_destaddr,
+                    uint8_t iphc0, uint8_t iphc1)
+{
+  struct iphc_template *t;
+
+  t = &iphc_templates[iphc_template_next];
+  iphc_template_next = (iphc_template_next + 1) % SICSLOWPAN_IPHC_CACHE;
+
+  uip_ipaddr_copy(&t->srcipaddr, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&t->destipaddr, &UIP_IP_BUF->destipaddr);
+  linkaddr_copy(&t->link_destaddr, link_destaddr);
+  t->proto = UIP_IP_BUF->proto;
+  t->shape = IPHC_TEMPLATE_USED |
+    (iphc0 & (SICSLOWPAN_IPHC_FL_C | SICSLOWPAN_IPHC_TC_C |
+              SICSLOWPAN_IPHC_TTL_255));
+  t->len = hc06_ptr - PACKETBUF_IPHC_BUF;
+  t->hdr[0] = iphc0;
+  t->hdr[1] = iphc1;
+  memcpy(&t->hdr[2], PACKETBUF_IPHC_BUF + 2, t->len - 2);
+}
+#endif /* SICSLOWPAN_IPHC_CACHE */
 /*--------------------------------------------------------------------*/
 /**
  * \brief Compress IP/UDP header
@@ -684,7 +1421,7 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
 static int
 compress_hdr_iphc(linkaddr_t *link_destaddr)
 {
-  uint8_t tmp, iphc0, iphc1, *next_hdr, *next_nhc;
+  uint8_t iphc0, iphc1, *next_hdr, *next_nhc;
   int ext_hdr_len;
   struct uip_udp_hdr *udp_buf;
 
@@ -715,6 +1452,13 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
    * layer will be checked when they are compressed. */
   CHECK_BUFFER_SPACE(38);
 
+#if SICSLOWPAN_IPHC_CACHE
+  if(iphc_template_apply(link_destaddr, &iphc0, &iphc1)) {
+    LOG_DBG("compression: IPv6 header from the template cache\n");
+    goto compress_next_hdr;
+  }
+#endif /* SICSLOWPAN_IPHC_CACHE */
+
   /*
    * As we copy some bit-length fields, in the IPHC encoding bytes,
    * we sometimes use |=
@@ -746,47 +1490,8 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 
   /*
    * Traffic class, flow label
-   * If flow label is 0, compress it. If traffic class is 0, compress it
-   * We have to process both in the same time as the offset of traffic class
-   * depends on the presence of version and flow label
    */
-
-  /* IPHC format of tc is ECN | DSCP , original is DSCP | ECN */
-
-  tmp = (UIP_IP_BUF->vtc << 4) | (UIP_IP_BUF->tcflow >> 4);
-  tmp = ((tmp & 0x03) << 6) | (tmp >> 2);
-
-  if(((UIP_IP_BUF->tcflow & 0x0F) == 0) &&
-     (UIP_IP_BUF->flow == 0)) {
-    /* flow label can be compressed */
-    iphc0 |= SICSLOWPAN_IPHC_FL_C;
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
-      /* compress (elide) all */
-      iphc0 |= SICSLOWPAN_IPHC_TC_C;
-    } else {
-      /* compress only the flow label */
-     *hc06_ptr = tmp;
-      hc06_ptr += 1;
-    }
-  } else {
-    /* Flow label cannot be compressed */
-    if(((UIP_IP_BUF->vtc & 0x0F) == 0) &&
-       ((UIP_IP_BUF->tcflow & 0xF0) == 0)) {
-      /* compress only traffic class */
-      iphc0 |= SICSLOWPAN_IPHC_TC_C;
-      *hc06_ptr = (tmp & 0xc0) |
-        (UIP_IP_BUF->tcflow & 0x0F);
-      memcpy(hc06_ptr + 1, &UIP_IP_BUF->flow, 2);
-      hc06_ptr += 3;
-    } else {
-      /* compress nothing */
-      memcpy(hc06_ptr, &UIP_IP_BUF->vtc, 4);
-      /* but replace the top byte with the new ECN | DSCP format*/
-      *hc06_ptr = tmp;
-      hc06_ptr += 4;
-   }
-  }
+  compress_tf(&iphc0);
 
   /* Note that the payload length is always compressed */
 
@@ -907,6 +1612,11 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   }
 
+#if SICSLOWPAN_IPHC_CACHE
+  iphc_template_store(link_destaddr, iphc0, iphc1);
+
+compress_next_hdr:
+#endif /* SICSLOWPAN_IPHC_CACHE */
   uncomp_hdr_len = UIP_IPH_LEN;
 
   /* Start of ext hdr compression or UDP compression */
@@ -1501,6 +2211,9 @@ send_packet(linkaddr_t *dest)
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER,(void*)&uip_lladdr);
 #endif
 
+  /* Tag the frame, to trace it through the MAC layer */
+  TRACE_FRAME_BEGIN();
+
   /* Provide a callback function to receive the result of
      a packet transmission. */
   NETSTACK_MAC.send(&packet_sent, NULL);
@@ -1510,6 +2223,7 @@ send_packet(linkaddr_t *dest)
   watchdog_periodic();
 }
 #if SICSLOWPAN_CONF_FRAG
+#if !SICSLOWPAN_SFR || SICSLOWPAN_FRAG_FORWARDING
 /*--------------------------------------------------------------------*/
 /**
  * \brief This function is called by the 6lowpan code to copy a fragment's
@@ -1550,8 +2264,431 @@ fragment_copy_payload_and_send(uint16_t uip_offset, linkaddr_t *dest) {
   }
   return 1;
 }
+#endif /* !SICSLOWPAN_SFR || SICSLOWPAN_FRAG_FORWARDING */
+#if SICSLOWPAN_FRAG_FORWARDING
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Send the first fragment of a relayed packet, once the IP
+ * layer has routed it, and complete its VRB entry for the fragments
+ * that follow. The compressed header is in packetbuf already.
+ * \param v the VRB entry of the packet
+ * \param dest the link layer destination address of the packet
+ * \return 1 if success, 0 otherwise
+ */
+static int
+vrb_send_first_fragment(struct sicslowpan_vrb *v, linkaddr_t *dest)
+{
+  int delta;
+  int first_frag_len;
+
+  /* The IP layer may have changed the size of the header, which moves
+     the rest of the packet */
+  delta = (int)uip_len - (int)v->size;
+  first_frag_len = (int)frag_fwd.first_frag_len + delta;
+  if(delta % 8 != 0 || first_frag_len < uncomp_hdr_len ||
+     packetbuf_hdr_len + SICSLOWPAN_FRAG1_HDR_LEN +
+     first_frag_len - uncomp_hdr_len > mac_max_payload) {
+    LOG_WARN("output: first fragment can not be relayed (tag %d)\n",
+             v->tag);
+    return 0;
+  }
+
+  /* Move IPHC/IPv6 header to make room for FRAG1 header */
+  memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+  packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+
+  v->out_tag = my_tag++;
+  v->delta = delta;
+
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, v->out_tag);
+  packetbuf_payload_len = first_frag_len - uncomp_hdr_len;
+
+  LOG_INFO("output: relaying first fragment (tag %d -> %d, payload %d)\n",
+           v->tag, v->out_tag, packetbuf_payload_len);
+  if(fragment_copy_payload_and_send(uncomp_hdr_len, dest) == 0) {
+    return 0;
+  }
+  linkaddr_copy(&v->next_hop, dest);
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Relay a received FRAGN fragment, if it belongs to a packet
+ * that has a VRB entry.
+ * \return 1 if the fragment was handled, 0 if it is to be reassembled
+ */
+static int
+vrb_forward_fragment(uint16_t tag, uint16_t frag_size, uint16_t frag_offset)
+{
+  struct sicslowpan_vrb *v;
+  uint8_t *data;
+  uint16_t datalen;
+  int offset;
+#if LLSEC802154_USES_AUX_HEADER
+  uint8_t security_level;
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  v = vrb_lookup(tag, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  if(v == NULL) {
+    return 0;
+  }
+
+  if(linkaddr_cmp(&v->next_hop, &linkaddr_null)) {
+    LOG_WARN("input: dropping fragment, the first one was not relayed (tag %d)\n",
+             tag);
+    return 1;
+  }
+
+  datalen = packetbuf_datalen();
+  offset = (frag_offset + v->delta) >> 3;
+  if(frag_size != v->size || frag_offset >= v->size ||
+     offset < 0 || offset > 0xff ||
+     datalen <= SICSLOWPAN_FRAGN_HDR_LEN) {
+    LOG_WARN("input: invalid fragment to relay (tag %d)\n", tag);
+    return 1;
+  }
+
+  if(v->relayed[frag_offset >> 6] & (1 << ((frag_offset >> 3) & 7))) {
+    LOG_WARN("input: duplicate fragment to relay (tag %d, offset %d)\n",
+             tag, frag_offset);
+    return 1;
+  }
+  v->relayed[frag_offset >> 6] |= 1 << ((frag_offset >> 3) & 7);
+
+  /* Rewrite the FRAGN header for the next hop */
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAGN << 8) | (v->size + v->delta)));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, v->out_tag);
+  PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = offset;
+
+  LOG_INFO("input: relaying fragment (tag %d -> %d, offset %d)\n",
+           v->tag, v->out_tag, frag_offset);
+
+  /* The VRB entry is released once the whole datagram is relayed */
+  v->relayed_len += datalen - SICSLOWPAN_FRAGN_HDR_LEN;
+  if(v->relayed_len >= v->size) {
+    v->size = 0;
+  }
+
+  /* Send the fragment from packetbuf, with fresh attributes */
+#if LLSEC802154_USES_AUX_HEADER
+  security_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
+#endif /* LLSEC802154_USES_AUX_HEADER */
+  data = packetbuf_dataptr();
+  packetbuf_clear();
+  memmove(packetbuf_dataptr(), data, datalen);
+  packetbuf_set_datalen(datalen);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL, security_level);
+#endif /* LLSEC802154_USES_AUX_HEADER */
+  send_packet(&v->next_hop);
+  return 1;
+}
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+#if SICSLOWPAN_SFR
+/*--------------------------------------------------------------------*/
+/* A packet being sent with RFRAG fragments */
+struct sicslowpan_sfr_tx {
+  /** Acknowledgment timer */
+  struct ctimer timer;
+  /** The link layer destination of the fragments */
+  linkaddr_t dest;
+  /** Fragments acknowledged by the receiver */
+  uint32_t acked;
+  /** Length of the compressed packet in buf (if zero this buffer is free) */
+  uint16_t len;
+  /** Size of the uncompressed packet */
+  uint16_t datagram_size;
+  /** Length of the compressed header, and of the uncompressed one */
+  uint8_t hdr_len;
+  uint8_t uncomp_hdr_len;
+  /** Number of bytes of buf carried by each fragment */
+  uint8_t frag_len;
+  /** Number of fragments */
+  uint8_t count;
+  uint8_t tag;
+  /** The fragment that last requested an acknowledgment */
+  uint8_t ack_req_seq;
+  uint8_t retries;
+  uint8_t max_mac_transmissions;
+  uint8_t priority;
+#if LLSEC802154_USES_AUX_HEADER
+  uint8_t security_level;
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  uint8_t key_index;
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+  /** Compressed header followed by the rest of the packet */
+  uint8_t buf[UIP_BUFSIZE + 8];
+};
+
+static struct sicslowpan_sfr_tx sfr_tx[SICSLOWPAN_SFR_TX_BUFFERS];
+
+#define SFR_NO_SEQ 0xff
+
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Send an RFRAG-ACK.
+ * \param dest the link layer address of the sender of the fragments
+ * \param tag the tag of the fragments
+ * \param bitmap the fragments received
+ *
+ * The packetbuf is preserved, since this is called while processing
+ * a received fragment.
+ */
+static void
+rfrag_send_ack(const linkaddr_t *dest, uint8_t tag, uint32_t bitmap)
+{
+  struct queuebuf *q;
+  linkaddr_t addr;
+  uint8_t *ptr;
+
+  q = queuebuf_new_from_packetbuf();
+  if(q == NULL) {
+    LOG_WARN("input: could not allocate queuebuf, not sending RFRAG-ACK\n");
+    return;
+  }
+  linkaddr_copy(&addr, dest);
+
+  packetbuf_clear();
+  ptr = packetbuf_dataptr();
+  ptr[0] = SICSLOWPAN_DISPATCH_RFRAG_ACK;
+  ptr[1] = tag;
+  SET16(ptr, 2, bitmap >> 16);
+  SET16(ptr, 4, bitmap & 0xffff);
+  packetbuf_set_datalen(SICSLOWPAN_RFRAG_ACK_HDR_LEN);
+
+  LOG_INFO("input: sending RFRAG-ACK (tag %d, bitmap %08lx)\n",
+           tag, (unsigned long)bitmap);
+  send_packet(&addr);
+
+  queuebuf_to_packetbuf(q);
+  queuebuf_free(q);
+}
+/*--------------------------------------------------------------------*/
+static void
+sfr_send_fragment(struct sicslowpan_sfr_tx *tx, uint8_t seq, int ack_req)
+{
+  uint16_t start;
+  uint16_t len;
+  uint8_t *ptr;
+
+  start = seq * tx->frag_len;
+  len = MIN(tx->frag_len, tx->len - start);
+
+  packetbuf_clear();
+  ptr = packetbuf_dataptr();
+  ptr[0] = SICSLOWPAN_DISPATCH_RFRAG;
+  ptr[1] = tx->tag;
+  SET16(ptr, 2, (ack_req ? 0x8000 : 0) | (seq << 10) | len);
+  /* The first fragment carries the size of the packet instead of an
+     offset. The others have the offset in the uncompressed packet. */
+  SET16(ptr, 4, seq == 0 ? tx->datagram_size :
+        start - tx->hdr_len + tx->uncomp_hdr_len);
+  memcpy(ptr + SICSLOWPAN_RFRAG_HDR_LEN, tx->buf + start, len);
+  packetbuf_set_datalen(SICSLOWPAN_RFRAG_HDR_LEN + len);
+
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     tx->max_mac_transmissions);
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, tx->priority);
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL, tx->security_level);
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX, tx->key_index);
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  LOG_INFO("output: RFRAG %d/%d (tag %d, payload %d%s)\n",
+           seq + 1, tx->count, tx->tag, len, ack_req ? ", ack req" : "");
+  send_packet(&tx->dest);
+}
+/*--------------------------------------------------------------------*/
+static void sfr_timeout(void *ptr);
+/*--------------------------------------------------------------------*/
+/* Send the next window of fragments that are not acknowledged yet,
+   requesting an acknowledgment with the last one */
+static void
+sfr_send_window(struct sicslowpan_sfr_tx *tx)
+{
+  int budget;
+  int seq;
+  int last = SFR_NO_SEQ;
+
+  /* Do not send more than the MAC can queue */
+  budget = MIN(SICSLOWPAN_SFR_WINDOW, queuebuf_numfree());
+  for(seq = 0; seq < tx->count && budget > 0; seq++) {
+    if(!(tx->acked & RFRAG_BIT(seq))) {
+      last = seq;
+      budget--;
+    }
+  }
+
+  for(seq = 0; last != SFR_NO_SEQ && seq <= last; seq++) {
+    if(!(tx->acked & RFRAG_BIT(seq))) {
+      sfr_send_fragment(tx, seq, seq == last);
+    }
+  }
+
+  tx->ack_req_seq = last;
+  ctimer_set(&tx->timer, SICSLOWPAN_SFR_ACK_TIMEOUT, sfr_timeout, tx);
+}
+/*--------------------------------------------------------------------*/
+static void
+sfr_timeout(void *ptr)
+{
+  struct sicslowpan_sfr_tx *tx = ptr;
+
+  if(tx->retries++ >= SICSLOWPAN_SFR_MAX_RETRIES) {
+    LOG_WARN("output: no RFRAG-ACK, dropping packet (tag %d)\n", tx->tag);
+    tx->len = 0;
+    return;
+  }
+
+  if(tx->ack_req_seq == SFR_NO_SEQ) {
+    sfr_send_window(tx);
+  } else {
+    /* Request the acknowledgment again */
+    sfr_send_fragment(tx, tx->ack_req_seq, 1);
+    ctimer_restart(&tx->timer);
+  }
+}
+/*--------------------------------------------------------------------*/
+/* Process a received RFRAG-ACK */
+static void
+sfr_ack_input(void)
+{
+  struct sicslowpan_sfr_tx *tx;
+  uint32_t bitmap;
+  uint32_t all;
+  uint8_t tag;
+
+  if(packetbuf_datalen() < SICSLOWPAN_RFRAG_ACK_HDR_LEN) {
+    return;
+  }
+  tag = PACKETBUF_FRAG_PTR[1];
+  bitmap = ((uint32_t)GET16(PACKETBUF_FRAG_PTR, 2) << 16) |
+    GET16(PACKETBUF_FRAG_PTR, 4);
+
+  for(tx = sfr_tx; tx < &sfr_tx[SICSLOWPAN_SFR_TX_BUFFERS]; tx++) {
+    if(tx->len > 0 && tx->tag == tag &&
+       linkaddr_cmp(&tx->dest, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      break;
+    }
+  }
+  if(tx == &sfr_tx[SICSLOWPAN_SFR_TX_BUFFERS]) {
+    return;
+  }
+
+  LOG_INFO("input: RFRAG-ACK (tag %d, bitmap %08lx)\n",
+           tag, (unsigned long)bitmap);
+
+  if(bitmap == RFRAG_BITMAP_NULL) {
+    LOG_WARN("output: packet aborted by receiver (tag %d)\n", tag);
+    ctimer_stop(&tx->timer);
+    tx->len = 0;
+    return;
+  }
+
+  all = RFRAG_BITMAP_FULL << (RFRAG_MAX_FRAGMENTS - tx->count);
+  if(bitmap == RFRAG_BITMAP_FULL || ((tx->acked | bitmap) & all) == all) {
+    LOG_INFO("output: packet acknowledged (tag %d)\n", tag);
+    ctimer_stop(&tx->timer);
+    tx->len = 0;
+    return;
+  }
+
+  if(bitmap & ~tx->acked) {
+    tx->retries = 0;
+  }
+  tx->acked |= bitmap & all;
+  sfr_send_window(tx);
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Send the packet in uip_buf with RFRAG fragments. The
+ * compressed header is in packetbuf already.
+ * \param dest the link layer destination address of the packet
+ * \return 1 if success, 0 otherwise
+ */
+static int
+sfr_output(linkaddr_t *dest)
+{
+  struct sicslowpan_sfr_tx *tx;
+  int frag_len;
+  int len;
+
+  for(tx = sfr_tx; tx < &sfr_tx[SICSLOWPAN_SFR_TX_BUFFERS]; tx++) {
+    if(tx->len == 0) {
+      break;
+    }
+  }
+  if(tx == &sfr_tx[SICSLOWPAN_SFR_TX_BUFFERS]) {
+    LOG_WARN("output: no free RFRAG buffer, dropping packet\n");
+    return 0;
+  }
+
+  frag_len = MIN(mac_max_payload - SICSLOWPAN_RFRAG_HDR_LEN,
+                 SICSLOWPAN_FRAGMENT_SIZE);
+  len = packetbuf_hdr_len + uip_len - uncomp_hdr_len;
+  if(frag_len < packetbuf_hdr_len || len > sizeof(tx->buf) ||
+     (len + frag_len - 1) / frag_len > RFRAG_MAX_FRAGMENTS) {
+    LOG_WARN("output: packet can not be sent with RFRAG fragments\n");
+    return 0;
+  }
+
+  memcpy(tx->buf, packetbuf_ptr, packetbuf_hdr_len);
+  memcpy(tx->buf + packetbuf_hdr_len, (uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
+         uip_len - uncomp_hdr_len);
+  linkaddr_copy(&tx->dest, dest);
+  tx->len = len;
+  tx->datagram_size = uip_len;
+  tx->hdr_len = packetbuf_hdr_len;
+  tx->uncomp_hdr_len = uncomp_hdr_len;
+  tx->frag_len = frag_len;
+  tx->count = (len + frag_len - 1) / frag_len;
+  tx->tag = my_tag++;
+  tx->acked = 0;
+  tx->retries = 0;
+  tx->max_mac_transmissions = uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS);
+  tx->priority = packetbuf_attr(PACKETBUF_ATTR_PRIORITY);
+#if LLSEC802154_USES_AUX_HEADER
+  tx->security_level = uipbuf_get_attr(UIPBUF_ATTR_LLSEC_LEVEL);
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  tx->key_index = uipbuf_get_attr(UIPBUF_ATTR_LLSEC_KEY_ID);
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  LOG_INFO("output: sending packet with %d RFRAG fragments (tag %d)\n",
+           tx->count, tx->tag);
+  sfr_send_window(tx);
+  return 1;
+}
+#endif /* SICSLOWPAN_SFR */
 #endif /* SICSLOWPAN_CONF_FRAG */
 /*--------------------------------------------------------------------*/
+/**
+ * \brief The MAC priority of the packet in uip_buf: ICMPv6 control
+ * messages (ND, RPL, errors) go before data, echo messages count as data.
+ * Other packets get their UIPBUF_ATTR_PRIORITY attribute.
+ */
+static uint16_t
+packet_priority(void)
+{
+  uint8_t *hdr;
+  uint8_t proto;
+
+  hdr = uipbuf_get_last_header(uip_buf, uip_len, &proto);
+  if(hdr != NULL && proto == UIP_PROTO_ICMP6 &&
+     hdr[0] != ICMP6_ECHO_REQUEST && hdr[0] != ICMP6_ECHO_REPLY) {
+    return PACKETBUF_PRIORITY_CONTROL;
+  }
+  return uipbuf_get_attr(UIPBUF_ATTR_PRIORITY);
+}
+/*--------------------------------------------------------------------*/
 /** \brief Take an IP packet and format it to be sent on an 802.15.4
  *  network using 6lowpan.
  *  \param localdest The MAC address of the destination
@@ -1599,6 +2736,7 @@ output(const linkaddr_t *localdest)
   /* copy over the retransmission count from uipbuf attributes */
   packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
                      uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, packet_priority());
 
 /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_MAC */
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
@@ -1645,6 +2783,17 @@ output(const linkaddr_t *localdest)
 
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  /* The first fragment of a packet we relay: only send what we have */
+  if(frag_fwd.vrb != NULL &&
+     uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &frag_fwd.srcipaddr)) {
+    struct sicslowpan_vrb *v = frag_fwd.vrb;
+
+    frag_fwd.vrb = NULL;
+    return vrb_send_first_fragment(v, &dest);
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   frag_needed = (int)uip_len - (int)uncomp_hdr_len + (int)packetbuf_hdr_len > mac_max_payload;
   LOG_INFO("output: header len %d -> %d, total len %d -> %d, MAC max payload %d, frag_needed %d\n",
             uncomp_hdr_len, packetbuf_hdr_len,
@@ -1652,7 +2801,9 @@ output(const linkaddr_t *localdest)
             mac_max_payload, frag_needed);
 
   if(frag_needed) {
-#if SICSLOWPAN_CONF_FRAG
+#if SICSLOWPAN_SFR
+    return sfr_output(&dest);
+#elif SICSLOWPAN_CONF_FRAG
     /* Number of bytes processed. */
     uint16_t processed_ip_out_len;
     uint16_t frag_tag;
@@ -1803,8 +2954,8 @@ input(void)
 {
   /* size of the IP packet (read from fragment) */
   uint16_t frag_size = 0;
-  /* offset of the fragment in the IP packet */
-  uint8_t frag_offset = 0;
+  /* offset of the fragment in the IP packet, in bytes */
+  uint16_t frag_offset = 0;
   uint8_t *buffer;
 
 #if SICSLOWPAN_CONF_FRAG
@@ -1815,6 +2966,11 @@ input(void)
   uint16_t frag_tag = 0;
   uint8_t first_fragment = 0, last_fragment = 0;
 #endif /*SICSLOWPAN_CONF_FRAG*/
+#if SICSLOWPAN_SFR
+  uint8_t rfrag_seq;
+  uint8_t rfrag_ack_req = 0;
+  bool rfrag_duplicate;
+#endif /* SICSLOWPAN_SFR */
 
   /* Update link statistics */
   link_stats_input_callback(packetbuf_addr(PACKETBUF_ADDR_SENDER));
@@ -1859,30 +3015,52 @@ input(void)
       LOG_INFO("input: received first element of a fragmented packet (tag %d, len %d)\n",
              frag_tag, frag_size);
 
+#if SICSLOWPAN_FRAG_FORWARDING
+      /* A copy of the first fragment of a packet that we relay */
+      if(vrb_lookup(frag_tag, packetbuf_addr(PACKETBUF_ADDR_SENDER)) != NULL) {
+        LOG_WARN("input: duplicate first fragment to relay (tag %d)\n",
+                 frag_tag);
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
       /* Add the fragment to the fragmentation context */
       frag_context = add_fragment(frag_tag, frag_size, frag_offset);
 
+      if(frag_context == FRAG_DUPLICATE) {
+        return;
+      }
       if(frag_context == -1) {
         LOG_ERR("input: failed to allocate new reassembly context\n");
         return;
       }
 
-      buffer = frag_info[frag_context].first_frag;
+      buffer = first_frag_buf;
       break;
     case SICSLOWPAN_DISPATCH_FRAGN:
       /*
        * set offset, tag, size
        * Offset is in units of 8 bytes
        */
-      frag_offset = PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET];
+      frag_offset = PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] << 3;
       frag_tag = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG);
       frag_size = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE) & 0x07ff;
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
 
+#if SICSLOWPAN_FRAG_FORWARDING
+      /* Fragments of packets that we relay are sent on right away */
+      if(vrb_forward_fragment(frag_tag, frag_size, frag_offset)) {
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
       /* Add the fragment to the fragmentation context (this will also
          copy the payload) */
       frag_context = add_fragment(frag_tag, frag_size, frag_offset);
 
+      if(frag_context == FRAG_DUPLICATE) {
+        return;
+      }
       if(frag_context == -1) {
         LOG_ERR("input: reassembly context not found (tag %d)\n", frag_tag);
         return;
@@ -1897,6 +3075,61 @@ input(void)
       }
       is_fragment = 1;
       break;
+#if SICSLOWPAN_SFR
+    case SICSLOWPAN_DISPATCH_RFRAG:
+      if((PACKETBUF_FRAG_PTR[0] & SICSLOWPAN_DISPATCH_RFRAG_MASK) ==
+         SICSLOWPAN_DISPATCH_RFRAG_ACK) {
+        sfr_ack_input();
+        return;
+      }
+      if(packetbuf_datalen() <= SICSLOWPAN_RFRAG_HDR_LEN ||
+         (GET16(PACKETBUF_FRAG_PTR, 2) & 0x03ff) !=
+         packetbuf_datalen() - SICSLOWPAN_RFRAG_HDR_LEN) {
+        LOG_ERR("input: invalid RFRAG fragment\n");
+        return;
+      }
+      frag_tag = PACKETBUF_FRAG_PTR[1];
+      rfrag_ack_req = PACKETBUF_FRAG_PTR[2] & 0x80;
+      rfrag_seq = (PACKETBUF_FRAG_PTR[2] >> 2) & 0x1f;
+      packetbuf_hdr_len += SICSLOWPAN_RFRAG_HDR_LEN;
+      is_fragment = 1;
+      if(rfrag_seq == 0) {
+        /* The first fragment carries the size of the packet */
+        frag_size = GET16(PACKETBUF_FRAG_PTR, 4) & 0x07ff;
+        first_fragment = 1;
+      } else {
+        frag_offset = GET16(PACKETBUF_FRAG_PTR, 4);
+      }
+
+      LOG_INFO("input: received RFRAG fragment (tag %d, seq %d%s)\n",
+               frag_tag, rfrag_seq, rfrag_ack_req ? ", ack req" : "");
+
+      if(first_fragment && frag_size == 0) {
+        return;
+      }
+      frag_context = add_rfrag(frag_tag, rfrag_seq, frag_offset, frag_size,
+                               &rfrag_duplicate);
+      if(frag_context == -1 || rfrag_duplicate) {
+        if(rfrag_ack_req) {
+          rfrag_send_ack(packetbuf_addr(PACKETBUF_ADDR_SENDER), frag_tag,
+                         frag_context == -1 ? rfrag_unknown_bitmap(frag_tag) :
+                         frag_info[frag_context].rfrag_bitmap);
+        }
+        return;
+      }
+
+      if(first_fragment) {
+        buffer = first_frag_buf;
+      } else {
+        /* add_rfrag has stored the fragment already */
+        buffer = NULL;
+        frag_size = frag_info[frag_context].len;
+        if(frag_info[frag_context].reassembled_len >= frag_size) {
+          last_fragment = 1;
+        }
+      }
+      break;
+#endif /* SICSLOWPAN_SFR */
     default:
       break;
   }
@@ -1958,24 +3191,31 @@ input(void)
 #if SICSLOWPAN_CONF_FRAG
   if(is_fragment) {
     LOG_INFO("input: fragment (tag %d, payload %d, offset %d) -- %u %u\n",
-         frag_tag, packetbuf_payload_len, frag_offset << 3, packetbuf_datalen(), packetbuf_hdr_len);
+         frag_tag, packetbuf_payload_len, frag_offset, packetbuf_datalen(), packetbuf_hdr_len);
   }
 #endif /*SICSLOWPAN_CONF_FRAG*/
 
   /* Sanity-check size of incoming packet to avoid buffer overflow */
   {
-    int req_size = uncomp_hdr_len + (uint16_t)(frag_offset << 3)
+    int req_size = uncomp_hdr_len + frag_offset
         + packetbuf_payload_len;
-    if(req_size > sizeof(uip_buf)) {
+    if(req_size > sizeof(uip_buf)
+#if SICSLOWPAN_CONF_FRAG
+       || (first_fragment && req_size > sizeof(first_frag_buf))
+#endif /* SICSLOWPAN_CONF_FRAG */
+       ) {
 #if SICSLOWPAN_CONF_FRAG
       LOG_ERR(
           "input: packet and fragment context %u dropped, minimum required IP_BUF size: %d+%d+%d=%d (current size: %u)\n",
           frag_context,
-          uncomp_hdr_len, (uint16_t)(frag_offset << 3),
+          uncomp_hdr_len, frag_offset,
           packetbuf_payload_len, req_size, (unsigned)sizeof(uip_buf));
       /* Discard all fragments for this contex, as reassembling this particular fragment would
        * cause an overflow in uipbuf */
-      clear_fragments(frag_context);
+      if(is_fragment) {
+        SICSLOWPAN_STAT(sicslowpan_reass_stats.drops++);
+        clear_fragments(frag_context);
+      }
 #endif /* SICSLOWPAN_CONF_FRAG */
       return;
     }
@@ -1993,18 +3233,52 @@ input(void)
   if(frag_size > 0) {
     /* Add the size of the header only for the first fragment. */
     if(first_fragment != 0) {
-      frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
       frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+      if(!store_first_fragment(frag_context)) {
+        return;
+      }
+      frag_info[frag_context].reassembled_len += frag_info[frag_context].first_frag_len;
+#if SICSLOWPAN_SFR
+      frag_info[frag_context].rfrag_bitmap |= RFRAG_BIT(0);
+#endif /* SICSLOWPAN_SFR */
+      /* The first fragment completes the packet if the others are
+         already there, which happens when RFRAG fragments are reordered,
+         or if it holds the whole packet. An RFC 4944 FRAGN is dropped
+         when no FRAG1 opened its context, so a late FRAG1 is only
+         useful with RFRAG. store_first_fragment() has already dropped
+         a first fragment longer than the packet. */
+      if(frag_info[frag_context].reassembled_len >= frag_info[frag_context].len) {
+        last_fragment = 1;
+      }
     }
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
     if(last_fragment != 0) {
+#if SICSLOWPAN_SFR
+      if(frag_info[frag_context].rfrag) {
+        rfrag_done_add(frag_context);
+      }
+#endif /* SICSLOWPAN_SFR */
       frag_info[frag_context].reassembled_len = frag_size;
       /* copy to uip */
       if(!copy_frags2uip(frag_context)) {
         return;
       }
     }
+#if SICSLOWPAN_FRAG_FORWARDING
+    else if(first_fragment != 0 && vrb_start(frag_context)) {
+      /* Let the IP layer route the first fragment now, as if the
+         packet was complete, rather than waiting for the others */
+      last_fragment = 1;
+    }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+#if SICSLOWPAN_SFR
+    if(rfrag_ack_req) {
+      rfrag_send_ack(packetbuf_addr(PACKETBUF_ADDR_SENDER), frag_tag,
+                     last_fragment ? RFRAG_BITMAP_FULL :
+                     frag_info[frag_context].rfrag_bitmap);
+    }
+#endif /* SICSLOWPAN_SFR */
   }
 
   /*
@@ -2054,6 +3328,11 @@ input(void)
 #endif /*  LLSEC802154_USES_AUX_HEADER */
 
     tcpip_input();
+#if SICSLOWPAN_FRAG_FORWARDING
+    /* If the first fragment was not sent on by now, its VRB entry
+       drops the fragments that follow until it expires */
+    frag_fwd.vrb = NULL;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 #if SICSLOWPAN_CONF_FRAG
   }
 #endif /* SICSLOWPAN_CONF_FRAG */
@@ -2109,7 +3388,13 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+  /* The contexts may have changed since the templates were made */
+  sicslowpan_iphc_cache_flush();
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPHC */
+
+#if SICSLOWPAN_CONF_FRAG
+  init_fragments();
+#endif /* SICSLOWPAN_CONF_FRAG */
 }
 /*--------------------------------------------------------------------*/
 int
@@ -2118,11 +3403,37 @@ sicslowpan_get_last_rssi(void)
   return last_rssi;
 }
 /*--------------------------------------------------------------------*/
+#if TRACE_ENABLED
+static void
+traced_input(void)
+{
+  TRACE_BEGIN(SICSLOWPAN_INPUT, packetbuf_datalen());
+  input();
+  TRACE_END(SICSLOWPAN_INPUT, 0);
+}
+/*--------------------------------------------------------------------*/
+static uint8_t
+traced_output(const linkaddr_t *localdest)
+{
+  uint8_t ret;
+
+  TRACE_BEGIN(SICSLOWPAN_OUTPUT, uip_len);
+  ret = output(localdest);
+  TRACE_END(SICSLOWPAN_OUTPUT, ret);
+  return ret;
+}
+/*--------------------------------------------------------------------*/
+#endif /* TRACE_ENABLED */
 const struct network_driver sicslowpan_driver = {
   "sicslowpan",
   sicslowpan_init,
+#if TRACE_ENABLED
+  traced_input,
+  traced_output
+#else /* TRACE_ENABLED */
   input,
   output
+#endif /* TRACE_ENABLED */
 };
 /*--------------------------------------------------------------------*/
 /** @} */
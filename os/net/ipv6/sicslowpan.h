@@ -88,6 +88,9 @@
 #define SICSLOWPAN_DISPATCH_FRAG1                   0xc0 /* 11000xxx */
 #define SICSLOWPAN_DISPATCH_FRAGN                   0xe0 /* 11100xxx */
 #define SICSLOWPAN_DISPATCH_FRAG_MASK               0xf8
+#define SICSLOWPAN_DISPATCH_RFRAG                   0xe8 /* 1110100x */
+#define SICSLOWPAN_DISPATCH_RFRAG_ACK               0xea /* 1110101x */
+#define SICSLOWPAN_DISPATCH_RFRAG_MASK              0xfe
 #define SICSLOWPAN_DISPATCH_PAGING                  0xf0 /* 1111xxxx */
 #define SICSLOWPAN_DISPATCH_PAGING_MASK             0xf0
 /** @} */
@@ -192,6 +195,8 @@
 #define SICSLOWPAN_HC1_HC_UDP_HDR_LEN               7
 #define SICSLOWPAN_FRAG1_HDR_LEN                    4
 #define SICSLOWPAN_FRAGN_HDR_LEN                    5
+#define SICSLOWPAN_RFRAG_HDR_LEN                    6
+#define SICSLOWPAN_RFRAG_ACK_HDR_LEN                6
 /** @} */
 
 /**
@@ -338,6 +343,45 @@ struct sicslowpan_nh_compressor {
 
 int sicslowpan_get_last_rssi(void);
 
+/**
+ * \brief Drop the templates of the IPHC template cache
+ * (SICSLOWPAN_CONF_IPHC_CACHE)
+ *
+ * The templates hold addresses compressed against the address contexts
+ * and the link-layer address of the node. This must be called after
+ * changing either of them.
+ */
+void sicslowpan_iphc_cache_flush(void);
+
+#if SICSLOWPAN_STATS
+/** Statistics of the fragment reassembly */
+struct sicslowpan_reass_stats {
+  /** Packets dropped since their fragments did not all arrive in time */
+  uint16_t timeouts;
+  /** Packets dropped for lack of memory, or invalid fragments */
+  uint16_t drops;
+  /** Fragments received more than once */
+  uint16_t duplicates;
+};
+
+extern struct sicslowpan_reass_stats sicslowpan_reass_stats;
+
+/** Statistics of the IPHC template cache (SICSLOWPAN_CONF_IPHC_CACHE).
+    The hit rate is hits / (hits + misses). */
+struct sicslowpan_iphc_stats {
+  /** Headers compressed from the template of their flow */
+  uint16_t hits;
+  /** Headers compressed in full */
+  uint16_t misses;
+};
+
+extern struct sicslowpan_iphc_stats sicslowpan_iphc_stats;
+
+#define SICSLOWPAN_STAT(code) (code)
+#else
+#define SICSLOWPAN_STAT(code)
+#endif /* SICSLOWPAN_STATS */
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
@@ -99,6 +99,35 @@ simple_udp_sendto_port(struct simple_udp_connection *c,
 }
 /*---------------------------------------------------------------------------*/
 int
+simple_udp_sendto_batch(struct simple_udp_connection *c,
+                        struct uip_udp_batch_entry *entries, int count,
+                        simple_udp_batch_callback callback)
+{
+  uip_ipaddr_t curaddr;
+  uint16_t curport;
+  int sent = 0;
+
+  if(c->udp_conn != NULL) {
+    /* The connection may have been registered without a remote
+       address and port, use those of the simple-udp connection */
+    uip_ipaddr_copy(&curaddr, &c->udp_conn->ripaddr);
+    curport = c->udp_conn->rport;
+    uip_ipaddr_copy(&c->udp_conn->ripaddr, &c->remote_addr);
+    c->udp_conn->rport = UIP_HTONS(c->remote_port);
+
+    sent = uip_udp_packet_send_batch(c->udp_conn, entries, count);
+
+    uip_ipaddr_copy(&c->udp_conn->ripaddr, &curaddr);
+    c->udp_conn->rport = curport;
+
+    if(callback != NULL) {
+      callback(c, entries, count);
+    }
+  }
+  return sent;
+}
+/*---------------------------------------------------------------------------*/
+int
 simple_udp_register(struct simple_udp_connection *c,
                     uint16_t local_port,
                     uip_ipaddr_t *remote_addr,
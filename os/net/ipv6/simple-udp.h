@@ -56,6 +56,7 @@
 #define SIMPLE_UDP_H
 
 #include "net/ipv6/uip.h"
+#include "net/ipv6/uip-udp-packet.h"
 
 struct simple_udp_connection;
 
@@ -67,6 +68,11 @@ typedef void (* simple_udp_callback)(struct simple_udp_connection *c,
                                      uint16_t dest_port,
                                      const uint8_t *data, uint16_t datalen);
 
+/** Simple UDP batch callback function type. */
+typedef void (* simple_udp_batch_callback)(struct simple_udp_connection *c,
+                                           struct uip_udp_batch_entry *entries,
+                                           int count);
+
 /** Simple UDP connection */
 struct simple_udp_connection {
   struct simple_udp_connection *next;
@@ -155,6 +161,27 @@ int simple_udp_sendto_port(struct simple_udp_connection *c,
 			   const void *data, uint16_t datalen,
 			   const uip_ipaddr_t *to, uint16_t to_port);
 
+/**
+ * \brief      Send a batch of UDP packets
+ * \param c    A pointer to a struct simple_udp_connection
+ * \param entries The datagrams to be sent
+ * \param count The number of datagrams
+ * \param callback A function called with the status of each datagram once the batch is sent, or NULL
+ * \return     The number of datagrams sent
+ *
+ *     This function sends several UDP packets in a row, with the
+ *     UDP ports that were specified when the connection was
+ *     registered with simple_udp_register(). A datagram with a
+ *     NULL address or a zero port is sent to the remote address
+ *     or port of the connection. Consecutive datagrams through the
+ *     same next hop share its neighbor lookup.
+ *
+ * \sa simple_udp_sendto_port()
+ */
+int simple_udp_sendto_batch(struct simple_udp_connection *c,
+                            struct uip_udp_batch_entry *entries, int count,
+                            simple_udp_batch_callback callback);
+
 void simple_udp_init(void);
 
 #endif /* SIMPLE_UDP_H */
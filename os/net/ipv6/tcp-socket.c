@@ -61,16 +61,50 @@ senddata(struct tcp_socket *s)
 {
   int len = MIN(s->output_data_max_seg, uip_mss());
 
+#if UIP_TCP_SLIDING_WINDOW
+  /* With the sliding window, uIP keeps the data in flight for
+     retransmission, so we send the next unsent part of the output
+     buffer whenever the window has room for it. */
+  if(s->output_data_len > s->output_data_send_nxt && len > 0) {
+    len = MIN(s->output_data_len - s->output_data_send_nxt, len);
+    uip_send(&s->output_data_ptr[s->output_data_send_nxt], len);
+    s->output_data_send_nxt += len;
+  }
+#else /* UIP_TCP_SLIDING_WINDOW */
   if(s->output_senddata_len > 0) {
     len = MIN(s->output_senddata_len, len);
     s->output_data_send_nxt = len;
     uip_send(s->output_data_ptr, len);
   }
+#endif /* UIP_TCP_SLIDING_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
 static void
 acked(struct tcp_socket *s)
 {
+#if UIP_TCP_SLIDING_WINDOW
+  uint16_t len = uip_acked_len();
+
+  if(len > s->output_data_send_nxt) {
+    PRINTF("tcp: acked assertion failed acked (%d) > s->output_data_send_nxt (%d)\n",
+           len, s->output_data_send_nxt);
+    tcp_markconn(uip_conn, NULL);
+    uip_abort();
+    call_event(s, TCP_SOCKET_ABORTED);
+    relisten(s);
+    return;
+  }
+  if(len > 0) {
+    memmove(&s->output_data_ptr[0],
+            &s->output_data_ptr[len],
+            s->output_data_maxlen - len);
+    s->output_data_len -= len;
+    s->output_senddata_len = s->output_data_len;
+    s->output_data_send_nxt -= len;
+
+    call_event(s, TCP_SOCKET_DATA_SENT);
+  }
+#else /* UIP_TCP_SLIDING_WINDOW */
   if(s->output_senddata_len > 0) {
     /* Copy the data in the outputbuf down and update outputbufptr and
        outputbuf_lastsent */
@@ -96,6 +130,7 @@ acked(struct tcp_socket *s)
 
     call_event(s, TCP_SOCKET_DATA_SENT);
   }
+#endif /* UIP_TCP_SLIDING_WINDOW */
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -163,6 +198,10 @@ appcall(void *state)
 	   s->listen_port == uip_htons(uip_conn->lport)) {
 	  s->flags &= ~TCP_SOCKET_FLAGS_LISTENING;
           s->output_data_max_seg = uip_mss();
+#if UIP_TCP_SLIDING_WINDOW
+          s->output_data_send_nxt = 0;
+          uip_window_enable(uip_conn);
+#endif /* UIP_TCP_SLIDING_WINDOW */
 	  tcp_markconn(uip_conn, s);
 	  call_event(s, TCP_SOCKET_CONNECTED);
 	  break;
@@ -170,6 +209,10 @@ appcall(void *state)
       }
     } else {
       s->output_data_max_seg = uip_mss();
+#if UIP_TCP_SLIDING_WINDOW
+      s->output_data_send_nxt = 0;
+      uip_window_enable(uip_conn);
+#endif /* UIP_TCP_SLIDING_WINDOW */
       call_event(s, TCP_SOCKET_CONNECTED);
     }
 
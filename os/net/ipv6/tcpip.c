@@ -47,6 +47,7 @@
 #include "net/ipv6/uip-ds6-nbr.h"
 #include "net/linkaddr.h"
 #include "net/routing/routing.h"
+#include "sys/trace.h"
 
 #include <string.h>
 
@@ -72,6 +73,48 @@ static struct etimer periodic;
 extern struct etimer uip_reass_timer;
 #endif
 
+/* The number of destinations for which the next hop neighbor is cached,
+   so that the packets that follow skip the on-link check, the route and
+   default router lookups and the neighbor lookup. The cache is flushed
+   on route, default router and neighbor changes, so it needs route
+   notifications. */
+#ifdef TCPIP_CONF_NEXTHOP_CACHE_SIZE
+#define TCPIP_NEXTHOP_CACHE_SIZE TCPIP_CONF_NEXTHOP_CACHE_SIZE
+#else
+#define TCPIP_NEXTHOP_CACHE_SIZE 0
+#endif
+
+#if TCPIP_NEXTHOP_CACHE_SIZE > 0 && !UIP_DS6_NOTIFICATIONS
+#error "TCPIP_CONF_NEXTHOP_CACHE_SIZE needs route notifications (UIP_DS6_NOTIFICATIONS)"
+#endif
+
+#define TCPIP_NEXTHOP_CACHE (TCPIP_NEXTHOP_CACHE_SIZE > 0)
+
+#if TCPIP_NEXTHOP_CACHE
+static struct nexthop_cache_entry {
+  uip_ipaddr_t destipaddr;
+  /* The next hop, or NULL if the entry is free */
+  uip_ds6_nbr_t *nbr;
+  /* The route the next hop comes from, if any, still marked as used
+     when the entry is hit */
+  uip_ds6_route_t *route;
+} nexthop_cache[TCPIP_NEXTHOP_CACHE_SIZE];
+static uint8_t nexthop_cache_next;
+static struct uip_ds6_notification nexthop_cache_notification;
+#endif /* TCPIP_NEXTHOP_CACHE */
+
+/* While a batch of datagrams is sent, the next hop neighbor of the
+   last datagram is kept, so that the datagrams that follow through the
+   same next hop skip the neighbor lookup */
+static struct {
+  uint8_t active;
+  /* The next hop, or NULL if unknown */
+  uip_ds6_nbr_t *nbr;
+} batch;
+
+/* The result of the packet being sent by tcpip_ipv6_output() */
+static uint8_t output_status;
+
 #if UIP_TCP
 /**
  * \internal Structure for holding a TCP port and a process ID.
@@ -141,6 +184,20 @@ start_periodic_tcp_timer(void)
     etimer_restart(&periodic);
   }
 }
+/*---------------------------------------------------------------------------*/
+static void
+check_for_tcp_repoll(void)
+{
+#if UIP_TCP_SLIDING_WINDOW
+  /* A connection that has just sent a segment and still has room in
+     its sliding window is polled again, so that the application can
+     keep several segments in flight. */
+  if(uip_conn != NULL && uip_window_repoll(uip_conn)) {
+    uip_conn->wflags &= ~UIP_TCP_WINDOW_REPOLL;
+    tcpip_poll_tcp(uip_conn);
+  }
+#endif /* UIP_TCP_SLIDING_WINDOW */
+}
 #endif /* UIP_TCP */
 /*---------------------------------------------------------------------------*/
 static void
@@ -184,6 +241,9 @@ packet_input(void)
     if(uip_len > 0) {
       tcpip_ipv6_output();
     }
+#if UIP_TCP
+    check_for_tcp_repoll();
+#endif /* UIP_TCP */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -377,6 +437,7 @@ eventhandler(process_event_t ev, process_data_t data)
           etimer_restart(&periodic);
           uip_periodic(i);
           tcpip_ipv6_output();
+          check_for_tcp_repoll();
         }
       }
 #endif /* UIP_TCP */
@@ -421,6 +482,7 @@ eventhandler(process_event_t ev, process_data_t data)
     if(data != NULL) {
       uip_poll_conn(data);
       tcpip_ipv6_output();
+      check_for_tcp_repoll();
       /* Start the periodic polling, if it isn't already active. */
       start_periodic_tcp_timer();
     }
@@ -444,11 +506,13 @@ eventhandler(process_event_t ev, process_data_t data)
 void
 tcpip_input(void)
 {
+  TRACE_BEGIN(TCPIP_INPUT, uip_len);
   if(netstack_process_ip_callback(NETSTACK_IP_INPUT, NULL) ==
      NETSTACK_IP_PROCESS) {
     process_post_synch(&tcpip_process, PACKET_INPUT, NULL);
   } /* else - do nothing and drop */
   uipbuf_clear();
+  TRACE_END(TCPIP_INPUT, 0);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -490,11 +554,76 @@ annotate_transmission(const uip_ipaddr_t *nexthop)
 #endif /* TCPIP_CONF_ANNOTATE_TRANSMISSIONS */
 }
 /*---------------------------------------------------------------------------*/
+void
+tcpip_nexthop_cache_flush(void)
+{
+#if TCPIP_NEXTHOP_CACHE
+  int i;
+
+  for(i = 0; i < TCPIP_NEXTHOP_CACHE_SIZE; i++) {
+    nexthop_cache[i].nbr = NULL;
+  }
+#endif /* TCPIP_NEXTHOP_CACHE */
+  batch.nbr = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+tcpip_batch_begin(void)
+{
+  batch.active = 1;
+  batch.nbr = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+tcpip_batch_end(void)
+{
+  batch.active = 0;
+  batch.nbr = NULL;
+}
+#if TCPIP_NEXTHOP_CACHE
+/*---------------------------------------------------------------------------*/
+static void
+nexthop_cache_route_callback(int event, const uip_ipaddr_t *route,
+                             const uip_ipaddr_t *nexthop, int num_routes)
+{
+  tcpip_nexthop_cache_flush();
+}
+/*---------------------------------------------------------------------------*/
+static struct nexthop_cache_entry *
+nexthop_cache_lookup(const uip_ipaddr_t *destipaddr)
+{
+  int i;
+
+  for(i = 0; i < TCPIP_NEXTHOP_CACHE_SIZE; i++) {
+    if(nexthop_cache[i].nbr != NULL &&
+       uip_ipaddr_cmp(&nexthop_cache[i].destipaddr, destipaddr)) {
+      return &nexthop_cache[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+nexthop_cache_add(const uip_ipaddr_t *destipaddr, uip_ds6_nbr_t *nbr,
+                  uip_ds6_route_t *route)
+{
+  if(nexthop_cache_lookup(destipaddr) != NULL) {
+    return;
+  }
+  uip_ipaddr_copy(&nexthop_cache[nexthop_cache_next].destipaddr, destipaddr);
+  nexthop_cache[nexthop_cache_next].nbr = nbr;
+  nexthop_cache[nexthop_cache_next].route = route;
+  nexthop_cache_next = (nexthop_cache_next + 1) % TCPIP_NEXTHOP_CACHE_SIZE;
+}
+#endif /* TCPIP_NEXTHOP_CACHE */
+/*---------------------------------------------------------------------------*/
 static const uip_ipaddr_t*
-get_nexthop(uip_ipaddr_t *addr)
+get_nexthop(uip_ipaddr_t *addr, uip_ds6_nbr_t **nbr, uip_ds6_route_t **route)
 {
   const uip_ipaddr_t *nexthop;
-  uip_ds6_route_t *route;
+#if TCPIP_NEXTHOP_CACHE
+  struct nexthop_cache_entry *e;
+#endif /* TCPIP_NEXTHOP_CACHE */
 
   LOG_INFO("output: processing %u bytes packet from ", uip_len);
   LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
@@ -509,6 +638,19 @@ get_nexthop(uip_ipaddr_t *addr)
     return addr;
   }
 
+#if TCPIP_NEXTHOP_CACHE
+  e = nexthop_cache_lookup(&UIP_IP_BUF->destipaddr);
+  if(e != NULL) {
+    *nbr = e->nbr;
+    /* Keep the route in the LRU order of uip_ds6_route_lookup() */
+    uip_ds6_route_touch(e->route);
+    LOG_INFO("output: found next hop in cache: ");
+    LOG_INFO_6ADDR(uip_ds6_nbr_get_ipaddr(*nbr));
+    LOG_INFO_("\n");
+    return uip_ds6_nbr_get_ipaddr(*nbr);
+  }
+#endif /* TCPIP_NEXTHOP_CACHE */
+
   /* We first check if the destination address is on our immediate
      link. If so, we simply use the destination address as our
      nexthop address. */
@@ -518,13 +660,15 @@ get_nexthop(uip_ipaddr_t *addr)
   }
 
   /* Check if we have a route to the destination address. */
-  route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
+  *route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
 
   /* No route was found - we send to the default route instead. */
-  if(route == NULL) {
+  if(*route == NULL) {
     nexthop = uip_ds6_defrt_choose();
     if(nexthop == NULL) {
-      output_fallback();
+      if(!uipbuf_is_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_PARTIAL)) {
+        output_fallback();
+      }
     } else {
       LOG_INFO("output: no route found, using default route: ");
       LOG_INFO_6ADDR(nexthop);
@@ -534,16 +678,17 @@ get_nexthop(uip_ipaddr_t *addr)
   } else {
     /* A route was found, so we look up the nexthop neighbor for
        the route. */
-    nexthop = uip_ds6_route_nexthop(route);
+    nexthop = uip_ds6_route_nexthop(*route);
 
     /* If the nexthop is dead, for example because the neighbor
        never responded to link-layer acks, we drop its route. */
     if(nexthop == NULL) {
       LOG_ERR("output: found dead route\n");
       /* Notifiy the routing protocol that we are about to remove the route */
-      NETSTACK_ROUTING.drop_route(route);
+      NETSTACK_ROUTING.drop_route(*route);
       /* Remove the route */
-      uip_ds6_route_rm(route);
+      uip_ds6_route_rm(*route);
+      *route = NULL;
       /* We don't have a nexthop to send the packet to, so we drop it. */
     } else {
       LOG_INFO("output: found next hop from routing table: ");
@@ -561,9 +706,9 @@ queue_packet(uip_ds6_nbr_t *nbr)
 {
   /* Copy outgoing pkt in the queuing buffer for later transmit. */
 #if UIP_CONF_IPV6_QUEUE_PKT
-  if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-    memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-    uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
+  if(uip_packetqueue_enqueue(&nbr->packethandle, (uint8_t *)UIP_IP_BUF,
+                             uip_len, UIP_DS6_NBR_PACKET_LIFETIME)) {
+    output_status = TCPIP_OUTPUT_QUEUED;
     return 0;
   }
 #endif
@@ -582,11 +727,12 @@ send_queued(uip_ds6_nbr_t *nbr)
    * NA after sendiong a NS, you receive a NS with SLLAO: the entry moves
    * to STALE, and you must both send a NA and the queued packet.
    */
-  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
-    tcpip_output(uip_ds6_nbr_get_ll(nbr));
+  while(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
+    uip_len = uip_packetqueue_dequeue(&nbr->packethandle,
+                                      (uint8_t *)UIP_IP_BUF, UIP_BUFSIZE);
+    if(uip_len > 0) {
+      tcpip_output(uip_ds6_nbr_get_ll(nbr));
+    }
   }
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
 }
@@ -596,7 +742,7 @@ send_nd6_ns(const uip_ipaddr_t *nexthop)
 {
   int err = 1;
 
-#if UIP_ND6_SEND_NS
+#if UIP_ND6_SEND_NS && !UIP_ND6_6LOWPAN_ND
    uip_ds6_nbr_t *nbr = NULL;
   if((nbr = uip_ds6_nbr_add(nexthop, NULL, 0, NBR_INCOMPLETE, NBR_TABLE_REASON_IPV6_ND, NULL)) != NULL) {
     err = 0;
@@ -619,6 +765,8 @@ send_nd6_ns(const uip_ipaddr_t *nexthop)
     /* Send the first NS try from here (multicast destination IP address). */
   }
 #else
+  /* With 6LoWPAN-ND, there is no multicast address resolution: neighbors
+     are known once they registered with us */
   LOG_ERR("output: neighbor not in cache: ");
   LOG_ERR_6ADDR(nexthop);
   LOG_ERR_("\n");
@@ -627,18 +775,23 @@ send_nd6_ns(const uip_ipaddr_t *nexthop)
   return err;
 }
 /*---------------------------------------------------------------------------*/
-void
+int
 tcpip_ipv6_output(void)
 {
   uip_ipaddr_t ipaddr;
   uip_ds6_nbr_t *nbr = NULL;
+  uip_ds6_route_t *route = NULL;
   const uip_lladdr_t *linkaddr;
   const uip_ipaddr_t *nexthop;
 
+  output_status = TCPIP_OUTPUT_DROPPED;
+
   if(uip_len == 0) {
-    return;
+    return output_status;
   }
 
+  TRACE_BEGIN(TCPIP_OUTPUT, TRACE_PACKET_NEW());
+
   if(uip_len > UIP_LINK_MTU) {
     LOG_ERR("output: Packet too big");
     goto exit;
@@ -654,7 +807,8 @@ tcpip_ipv6_output(void)
     /* Packet can not be forwarded */
     LOG_ERR("output: routing protocol extension header update error\n");
     uipbuf_clear();
-    return;
+    TRACE_END(TCPIP_OUTPUT, output_status);
+    return output_status;
   }
 
   if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
@@ -667,16 +821,25 @@ tcpip_ipv6_output(void)
   if(uip_ds6_is_my_addr(&UIP_IP_BUF->destipaddr)) {
     LOG_INFO("output: sending to ourself\n");
     packet_input();
-    return;
+    TRACE_END(TCPIP_OUTPUT, TCPIP_OUTPUT_SENT);
+    return TCPIP_OUTPUT_SENT;
   }
 
   /* Look for a next hop */
-  if((nexthop = get_nexthop(&ipaddr)) == NULL) {
+  if((nexthop = get_nexthop(&ipaddr, &nbr, &route)) == NULL) {
     goto exit;
   }
   annotate_transmission(nexthop);
 
-  nbr = uip_ds6_nbr_lookup(nexthop);
+  if(nbr == NULL) {
+    if(batch.nbr != NULL &&
+       uip_ipaddr_cmp(nexthop, uip_ds6_nbr_get_ipaddr(batch.nbr))) {
+      LOG_INFO("output: same next hop as the previous datagram\n");
+      nbr = batch.nbr;
+    } else {
+      nbr = uip_ds6_nbr_lookup(nexthop);
+    }
+  }
 
 #if UIP_ND6_AUTOFILL_NBR_CACHE
   if(nbr == NULL) {
@@ -698,20 +861,50 @@ tcpip_ipv6_output(void)
    }
 #endif /* UIP_ND6_AUTOFILL_NBR_CACHE */
 
+#if UIP_ND6_6LOWPAN_ND
+  if(nbr == NULL && uip_is_addr_linklocal(nexthop)) {
+    /* 6LoWPAN-ND: link-local addresses are derived from the link-layer
+       address, there is no need to resolve them (RFC 6775, section 5.2) */
+    uip_lladdr_t lladdr;
+    uip_ds6_set_lladdr_from_iid(&lladdr, nexthop);
+    if((nbr = uip_ds6_nbr_add(nexthop, &lladdr,
+        0, NBR_STALE, NBR_TABLE_REASON_IPV6_ND, NULL)) == NULL) {
+      LOG_ERR("output: failed to add link-local neighbor ");
+      LOG_ERR_6ADDR(nexthop);
+      LOG_ERR_("\n");
+      goto exit;
+    }
+  }
+#endif /* UIP_ND6_6LOWPAN_ND */
+
   if(nbr == NULL) {
     if(send_nd6_ns(nexthop)) {
       LOG_ERR("output: failed to add neighbor to cache\n");
       goto exit;
     } else {
       /* We're sending NS here instead of original packet */
-      goto send_packet;
+      tcpip_output(NULL);
+      goto exit;
     }
   }
 
+#if TCPIP_NEXTHOP_CACHE
+  /* The next hop from an SRH depends on the packet, not only on its
+     destination */
+  if(nexthop != &ipaddr && nbr->state != NBR_INCOMPLETE) {
+    nexthop_cache_add(&UIP_IP_BUF->destipaddr, nbr, route);
+  }
+#endif /* TCPIP_NEXTHOP_CACHE */
+  if(batch.active && nbr->state != NBR_INCOMPLETE) {
+    batch.nbr = nbr;
+  }
+
 #if UIP_ND6_SEND_NS
   if(nbr->state == NBR_INCOMPLETE) {
     LOG_ERR("output: nbr cache entry incomplete\n");
-    queue_packet(nbr);
+    if(!uipbuf_is_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_PARTIAL)) {
+      queue_packet(nbr);
+    }
     goto exit;
   }
   /* Send in parallel if we are running NUD (nbc state is either STALE,
@@ -734,7 +927,9 @@ send_packet:
   LOG_INFO("output: sending to ");
   LOG_INFO_LLADDR((linkaddr_t *)linkaddr);
   LOG_INFO_("\n");
-  tcpip_output(linkaddr);
+  if(tcpip_output(linkaddr)) {
+    output_status = TCPIP_OUTPUT_SENT;
+  }
 
   if(nbr) {
     send_queued(nbr);
@@ -742,7 +937,8 @@ send_packet:
 
 exit:
   uipbuf_clear();
-  return;
+  TRACE_END(TCPIP_OUTPUT, output_status);
+  return output_status;
 }
 /*---------------------------------------------------------------------------*/
 #if UIP_UDP
@@ -822,6 +1018,10 @@ PROCESS_THREAD(tcpip_process, ev, data)
   etimer_set(&periodic, CLOCK_SECOND / 2);
 
   uip_init();
+#if TCPIP_NEXTHOP_CACHE
+  uip_ds6_notification_add(&nexthop_cache_notification,
+                           nexthop_cache_route_callback);
+#endif /* TCPIP_NEXTHOP_CACHE */
 #ifdef UIP_FALLBACK_INTERFACE
   UIP_FALLBACK_INTERFACE.init();
 #endif
@@ -342,10 +342,42 @@ void tcpip_input(void);
  */
 uint8_t tcpip_output(const uip_lladdr_t *);
 
+/** \name Results of tcpip_ipv6_output() */
+/** @{ */
+/** The packet was passed to the network layer */
+#define TCPIP_OUTPUT_SENT    0
+/** The packet waits for the address resolution of its next hop */
+#define TCPIP_OUTPUT_QUEUED  1
+/** The packet was dropped */
+#define TCPIP_OUTPUT_DROPPED 2
+/** @} */
+
 /**
  * \brief This function does address resolution and then calls tcpip_output
+ * \return TCPIP_OUTPUT_SENT, TCPIP_OUTPUT_QUEUED or TCPIP_OUTPUT_DROPPED
+ */
+int tcpip_ipv6_output(void);
+
+/**
+ * \brief Start sending a batch of packets
+ *
+ * Until tcpip_batch_end(), tcpip_ipv6_output() keeps the next hop
+ * neighbor of the last packet, so that the packets that follow
+ * through the same next hop, e.g. to several nodes behind one
+ * parent, skip the neighbor lookup.
+ */
+void tcpip_batch_begin(void);
+
+/**
+ * \brief Stop sending a batch of packets
+ */
+void tcpip_batch_end(void);
+
+/**
+ * \brief Forget the next hops cached by tcpip_ipv6_output(), e.g.
+ * when the neighbor they refer to is removed.
  */
-void tcpip_ipv6_output(void);
+void tcpip_nexthop_cache_flush(void);
 
 /**
  * \brief Is forwarding generally enabled?
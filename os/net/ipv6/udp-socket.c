@@ -144,6 +144,24 @@ udp_socket_sendto(struct udp_socket *c,
   return -1;
 }
 /*---------------------------------------------------------------------------*/
+int
+udp_socket_sendto_batch(struct udp_socket *c,
+                        struct uip_udp_batch_entry *entries, int count,
+                        udp_socket_batch_callback_t callback)
+{
+  int sent;
+
+  if(c == NULL || c->udp_conn == NULL) {
+    return -1;
+  }
+
+  sent = uip_udp_packet_send_batch(c->udp_conn, entries, count);
+  if(callback != NULL) {
+    callback(c, c->ptr, entries, count);
+  }
+  return sent;
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(udp_socket_process, ev, data)
 {
   struct udp_socket *c;
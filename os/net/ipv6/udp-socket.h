@@ -33,6 +33,7 @@
 #define UDP_SOCKET_H
 
 #include "net/ipv6/uip.h"
+#include "net/ipv6/uip-udp-packet.h"
 
 struct udp_socket;
 
@@ -61,6 +62,21 @@ typedef void (* udp_socket_input_callback_t)(struct udp_socket *c,
                                              const uint8_t *data,
                                              uint16_t datalen);
 
+/**
+ * \brief      A UDP socket batch callback function
+ * \param c    A pointer to the struct udp_socket the batch was sent on
+ * \param ptr  An opaque pointer that was specified when the UDP socket was registered with udp_socket_register()
+ * \param entries The datagrams of the batch, with their status set
+ * \param count The number of datagrams
+ *
+ *             This function is called by udp_socket_sendto_batch()
+ *             once all the datagrams of the batch are sent.
+ */
+typedef void (* udp_socket_batch_callback_t)(struct udp_socket *c,
+                                             void *ptr,
+                                             struct uip_udp_batch_entry *entries,
+                                             int count);
+
 struct udp_socket {
   udp_socket_input_callback_t input_callback;
   void *ptr;
@@ -175,6 +191,24 @@ int udp_socket_sendto(struct udp_socket *c,
                       const void *data, uint16_t datalen,
                       const uip_ipaddr_t *addr, uint16_t port);
 
+/**
+ * \brief      Send a batch of datagrams on a UDP socket
+ * \param c    A pointer to the struct udp_socket on which the data should be sent
+ * \param entries The datagrams to be sent
+ * \param count The number of datagrams
+ * \param callback A function called with the status of each datagram once the batch is sent, or NULL
+ * \return     The number of datagrams sent, or -1 if an error occurred
+ *
+ *             This function sends several datagrams in a row over a
+ *             UDP socket. A datagram with a NULL address or a zero
+ *             port is sent to the address or port the socket is
+ *             connected to. Consecutive datagrams through the
+ *             same next hop share its neighbor lookup.
+ */
+int udp_socket_sendto_batch(struct udp_socket *c,
+                            struct uip_udp_batch_entry *entries, int count,
+                            udp_socket_batch_callback_t callback);
+
 /**
  * \brief      Close a UDP socket
  * \param c    A pointer to the struct udp_socket to be closed
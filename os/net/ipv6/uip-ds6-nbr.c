@@ -53,6 +53,7 @@
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/uip-ds6-nbr.h"
 #include "net/ipv6/uip-nd6.h"
+#include "net/ipv6/tcpip.h"
 #include "net/routing/routing.h"
 
 #if UIP_DS6_NBR_MULTI_IPV6_ADDRS
@@ -204,6 +205,8 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
     LOG_INFO_(" link addr ");
     LOG_INFO_LLADDR((linkaddr_t*)lladdr);
     LOG_INFO_(" state %u\n", state);
+    /* A resolved neighbor may change the default router to use */
+    tcpip_nexthop_cache_flush();
     NETSTACK_ROUTING.neighbor_state_changed(nbr);
     return nbr;
   } else {
@@ -249,6 +252,25 @@ remove_nbr_entry(uip_ds6_nbr_entry_t *nbr_entry)
           __func__, nbr_entry);
   (void)nbr_table_remove(uip_ds6_nbr_entries, nbr_entry);
 }
+#if UIP_ND6_6LOWPAN_ND
+/*---------------------------------------------------------------------------*/
+/* Keep the nbr_entry locked as long as one of its addresses is registered */
+static void
+update_nbr_entry_lock(uip_ds6_nbr_entry_t *nbr_entry)
+{
+  uip_ds6_nbr_t *nbr;
+
+  for(nbr = (uip_ds6_nbr_t *)list_head(nbr_entry->uip_ds6_nbrs);
+      nbr != NULL;
+      nbr = (uip_ds6_nbr_t *)list_item_next(nbr)) {
+    if(nbr->state == NBR_REGISTERED) {
+      nbr_table_lock(uip_ds6_nbr_entries, nbr_entry);
+      return;
+    }
+  }
+  nbr_table_unlock(uip_ds6_nbr_entries, nbr_entry);
+}
+#endif /* UIP_ND6_6LOWPAN_ND */
 /*---------------------------------------------------------------------------*/
 static void
 free_uip_ds6_nbr(uip_ds6_nbr_t *nbr)
@@ -259,6 +281,7 @@ free_uip_ds6_nbr(uip_ds6_nbr_t *nbr)
 #if UIP_CONF_IPV6_QUEUE_PKT
   uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
+  tcpip_nexthop_cache_flush();
   NETSTACK_ROUTING.neighbor_state_changed(nbr);
   assert(nbr->nbr_entry != NULL);
   if(nbr->nbr_entry == NULL) {
@@ -267,6 +290,10 @@ free_uip_ds6_nbr(uip_ds6_nbr_t *nbr)
     remove_uip_ds6_nbr_from_nbr_entry(nbr);
     if(list_length(nbr->nbr_entry->uip_ds6_nbrs) == 0) {
       remove_nbr_entry(nbr->nbr_entry);
+#if UIP_ND6_6LOWPAN_ND
+    } else if(nbr->state == NBR_REGISTERED) {
+      update_nbr_entry_lock(nbr->nbr_entry);
+#endif /* UIP_ND6_6LOWPAN_ND */
     }
   }
   LOG_DBG("%s: free memory for nbr(%p)\n", __func__, nbr);
@@ -305,6 +332,7 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
 #if UIP_CONF_IPV6_QUEUE_PKT
     uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
+    tcpip_nexthop_cache_flush();
     NETSTACK_ROUTING.neighbor_state_changed(nbr);
     return nbr_table_remove(ds6_neighbors, nbr);
   }
@@ -312,6 +340,23 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
 #endif /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
 }
 
+#if UIP_ND6_6LOWPAN_ND
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_nbr_register(uip_ds6_nbr_t *nbr, unsigned long lifetime)
+{
+  nbr->state = NBR_REGISTERED;
+  stimer_set(&nbr->reachable, lifetime);
+#if UIP_DS6_NBR_MULTI_IPV6_ADDRS
+  update_nbr_entry_lock(nbr->nbr_entry);
+#else /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
+  nbr_table_lock(ds6_neighbors, nbr);
+#endif /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
+  LOG_INFO("Registered ");
+  LOG_INFO_6ADDR(&nbr->ipaddr);
+  LOG_INFO_(" for %lu seconds\n", lifetime);
+}
+#endif /* UIP_ND6_6LOWPAN_ND */
 /*---------------------------------------------------------------------------*/
 int
 uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
@@ -321,6 +366,9 @@ uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
   uip_ds6_nbr_t *nbr;
 #else
   uip_ds6_nbr_t nbr_backup;
+#if UIP_CONF_IPV6_QUEUE_PKT
+  struct uip_packetqueue_handle queue_backup;
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
 #endif /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
 
   if(nbr_pp == NULL || new_ll_addr == NULL) {
@@ -350,8 +398,17 @@ uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
   remove_uip_ds6_nbr_from_nbr_entry(nbr);
   if(list_length(nbr->nbr_entry->uip_ds6_nbrs) == 0) {
     remove_nbr_entry(nbr->nbr_entry);
+#if UIP_ND6_6LOWPAN_ND
+  } else if(nbr->state == NBR_REGISTERED) {
+    update_nbr_entry_lock(nbr->nbr_entry);
+#endif /* UIP_ND6_6LOWPAN_ND */
   }
   add_uip_ds6_nbr_to_nbr_entry(nbr, nbr_entry);
+#if UIP_ND6_6LOWPAN_ND
+  if(nbr->state == NBR_REGISTERED) {
+    update_nbr_entry_lock(nbr_entry);
+  }
+#endif /* UIP_ND6_6LOWPAN_ND */
 
 #else /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
 
@@ -363,9 +420,16 @@ uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
     return -1;
   }
 
+#if UIP_CONF_IPV6_QUEUE_PKT
+  /* keep the queued packets, which uip_ds6_nbr_rm() would drop */
+  uip_packetqueue_move(&queue_backup, &(*nbr_pp)->packethandle);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
   memcpy(&nbr_backup, *nbr_pp, sizeof(uip_ds6_nbr_t));
   if(uip_ds6_nbr_rm(*nbr_pp) == 0) {
     LOG_ERR("%s: input nbr cannot be removed\n", __func__);
+#if UIP_CONF_IPV6_QUEUE_PKT
+    uip_packetqueue_move(&(*nbr_pp)->packethandle, &queue_backup);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
     return -1;
   }
 
@@ -373,9 +437,20 @@ uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
                                 nbr_backup.isrouter, nbr_backup.state,
                                 NBR_TABLE_REASON_IPV6_ND, NULL)) == NULL) {
     LOG_ERR("%s: cannot allocate a new nbr for new_ll_addr\n", __func__);
+#if UIP_CONF_IPV6_QUEUE_PKT
+    uip_packetqueue_free(&queue_backup);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
     return -1;
   }
   memcpy(*nbr_pp, &nbr_backup, sizeof(uip_ds6_nbr_t));
+#if UIP_ND6_6LOWPAN_ND
+  if(nbr_backup.state == NBR_REGISTERED) {
+    nbr_table_lock(ds6_neighbors, *nbr_pp);
+  }
+#endif /* UIP_ND6_6LOWPAN_ND */
+#if UIP_CONF_IPV6_QUEUE_PKT
+  uip_packetqueue_move(&(*nbr_pp)->packethandle, &queue_backup);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
 #endif /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
 
   return 0;
@@ -520,7 +595,8 @@ uip_ds6_nbr_lladdr_from_ipaddr(const uip_ipaddr_t *ipaddr)
 static void
 update_nbr_reachable_state_by_ack(uip_ds6_nbr_t *nbr, const linkaddr_t *lladdr)
 {
-  if(nbr != NULL && nbr->state != NBR_INCOMPLETE) {
+  if(nbr != NULL && nbr->state != NBR_INCOMPLETE &&
+     nbr->state != NBR_REGISTERED) {
     nbr->state = NBR_REACHABLE;
     stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
     LOG_INFO("received a link layer ACK : ");
@@ -614,6 +690,16 @@ uip_ds6_neighbor_periodic(void)
 #endif /* UIP_CONF_ROUTER */
       }
       break;
+#if UIP_ND6_6LOWPAN_ND
+    case NBR_REGISTERED:
+      if(stimer_expired(&nbr->reachable)) {
+        LOG_INFO("REGISTERED: registration of ");
+        LOG_INFO_6ADDR(&nbr->ipaddr);
+        LOG_INFO_(" expired\n");
+        uip_ds6_nbr_rm(nbr);
+      }
+      break;
+#endif /* UIP_ND6_6LOWPAN_ND */
     case NBR_INCOMPLETE:
       if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
         uip_ds6_nbr_rm(nbr);
@@ -661,7 +747,10 @@ uip_ds6_nbr_refresh_reachable_state(const uip_ipaddr_t *ipaddr)
 {
   uip_ds6_nbr_t *nbr;
   nbr = uip_ds6_nbr_lookup(ipaddr);
-  if(nbr != NULL) {
+  if(nbr != NULL && nbr->state != NBR_REGISTERED) {
+    if(nbr->state == NBR_INCOMPLETE) {
+      tcpip_nexthop_cache_flush();
+    }
     nbr->state = NBR_REACHABLE;
     nbr->nscount = 0;
     stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
@@ -54,10 +54,6 @@
 #if UIP_CONF_IPV6_QUEUE_PKT
 #include "net/ipv6/uip-packetqueue.h"
 #endif                          /*UIP_CONF_QUEUE_PKT */
-#if UIP_DS6_NBR_CONF_MULTI_IPV6_ADDRS
-#include "lib/assert.h"
-#include "lib/list.h"
-#endif
 
 /*--------------------------------------------------*/
 /** \brief Possible states for the nbr cache entries */
@@ -66,15 +62,25 @@
 #define  NBR_STALE 2
 #define  NBR_DELAY 3
 #define  NBR_PROBE 4
+/** \brief The neighbor registered its address with us (6LoWPAN-ND): the
+ * entry is kept until the registration expires */
+#define  NBR_REGISTERED 5
 
 /** \brief Set non-zero (1) to enable multiple IPv6 addresses to be
  * associated with a link-layer address */
 #ifdef UIP_DS6_NBR_CONF_MULTI_IPV6_ADDRS
 #define UIP_DS6_NBR_MULTI_IPV6_ADDRS UIP_DS6_NBR_CONF_MULTI_IPV6_ADDRS
 #else
-#define UIP_DS6_NBR_MULTI_IPV6_ADDRS 0
+/* 6LoWPAN-ND routers cache the registered addresses of their neighbors
+   next to their link-local addresses */
+#define UIP_DS6_NBR_MULTI_IPV6_ADDRS (UIP_ND6_6LOWPAN_ND && UIP_CONF_ROUTER)
 #endif /* UIP_DS6_NBR_CONF_MULTI_IPV6_ADDRS */
 
+#if UIP_DS6_NBR_MULTI_IPV6_ADDRS
+#include "lib/assert.h"
+#include "lib/list.h"
+#endif
+
 /** \brief Set the maximum number of IPv6 addresses per link-layer
  * address */
 #ifdef UIP_DS6_NBR_CONF_MAX_6ADDRS_PER_NBR
@@ -149,6 +155,17 @@ uip_ds6_nbr_t *uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr,
  */
 int uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr);
 
+#if UIP_ND6_6LOWPAN_ND
+/**
+ * Register the address of a neighbor cache (6LoWPAN-ND). The entry is
+ * locked in the neighbor table and moves to NBR_REGISTERED until the
+ * registration expires or is removed
+ * \param nbr the address of a neighbor cache to register
+ * \param lifetime the registration lifetime in seconds
+ */
+void uip_ds6_nbr_register(uip_ds6_nbr_t *nbr, unsigned long lifetime);
+#endif /* UIP_ND6_6LOWPAN_ND */
+
 /**
  * Get the link-layer address associated with a specified nbr cache
  * \param nbr the address of a neighbor cache
@@ -42,6 +42,7 @@
 #include "net/ipv6/uip-ds6-route.h"
 #include "net/ipv6/uip.h"
 
+#include "net/ipv6/tcpip.h"
 #include "lib/list.h"
 #include "lib/memb.h"
 #include "net/nbr-table.h"
@@ -304,19 +305,27 @@ uip_ds6_route_lookup(const uip_ipaddr_t *addr)
     LOG_WARN("No route found\n");
   }
 
-  if(found_route != NULL && found_route != list_head(routelist)) {
+  uip_ds6_route_touch(found_route);
+
+  return found_route;
+#else /* (UIP_MAX_ROUTES != 0) */
+  return NULL;
+#endif /* (UIP_MAX_ROUTES != 0) */
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_route_touch(uip_ds6_route_t *route)
+{
+#if (UIP_MAX_ROUTES != 0)
+  if(route != NULL && route != list_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
        the least recently used route will be at the end of the
        list - for fast lookups (assuming multiple packets to the same node). */
 
-    list_remove(routelist, found_route);
-    list_push(routelist, found_route);
+    list_remove(routelist, route);
+    list_push(routelist, route);
   }
-
-  return found_route;
-#else /* (UIP_MAX_ROUTES != 0) */
-  return NULL;
 #endif /* (UIP_MAX_ROUTES != 0) */
 }
 /*---------------------------------------------------------------------------*/
@@ -628,6 +637,13 @@ uip_ds6_defrt_add(const uip_ipaddr_t *ipaddr, unsigned long interval)
     }
 
     list_push(defaultrouterlist, d);
+    /* The new router may be chosen over the one cached as next hop */
+    tcpip_nexthop_cache_flush();
+#if UIP_ND6_6LOWPAN_ND
+    /* Register our addresses with the new router, e.g. a new RPL
+       preferred parent */
+    uip_ds6_addr_register_all();
+#endif /* UIP_ND6_6LOWPAN_ND */
   }
   else {
     LOG_INFO("Refreshing default\n");
@@ -671,6 +687,7 @@ uip_ds6_defrt_rm(uip_ds6_defrt_t *defrt)
       LOG_INFO("Removing default\n");
       list_remove(defaultrouterlist, defrt);
       memb_free(&defaultroutermemb, defrt);
+      tcpip_nexthop_cache_flush();
       LOG_ANNOTATE("#L %u 0\n", defrt->ipaddr.u8[sizeof(uip_ipaddr_t) - 1]);
 #if UIP_DS6_NOTIFICATIONS
       call_route_callback(UIP_DS6_NOTIFICATION_DEFRT_RM,
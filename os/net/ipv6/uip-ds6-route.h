@@ -214,6 +214,7 @@ void uip_ds6_defrt_periodic(void);
 /** \name Routing Table basic routines */
 /** @{ */
 uip_ds6_route_t *uip_ds6_route_lookup(const uip_ipaddr_t *destipaddr);
+void uip_ds6_route_touch(uip_ds6_route_t *route);
 uip_ds6_route_t *uip_ds6_route_add(const uip_ipaddr_t *ipaddr, uint8_t length,
                                    const uip_ipaddr_t *next_hop);
 void uip_ds6_route_rm(uip_ds6_route_t *route);
@@ -51,6 +51,7 @@
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/ipv6/uip-packetqueue.h"
+#include "net/ipv6/tcpip.h"
 
 /* Log configuration */
 #include "sys/log.h"
@@ -190,6 +191,12 @@ uip_ds6_periodic(void)
                 && (uip_len == 0)) {
         uip_ds6_dad(locaddr);
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+#if UIP_ND6_6LOWPAN_ND
+      } else if(!uip_is_addr_linklocal(&locaddr->ipaddr)
+                && stimer_expired(&locaddr->regtimer)
+                && (uip_len == 0)) {
+        uip_ds6_addr_register(locaddr);
+#endif /* UIP_ND6_6LOWPAN_ND */
       }
     }
   }
@@ -226,7 +233,7 @@ uip_ds6_periodic(void)
     uip_ds6_send_ra_periodic();
   }
 #endif /* UIP_CONF_ROUTER && UIP_ND6_SEND_RA */
-  etimer_reset(&uip_ds6_timer_periodic);
+  etimer_reset_with_new_interval(&uip_ds6_timer_periodic, UIP_DS6_PERIOD);
   return;
 }
 
@@ -273,6 +280,8 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
      ((uip_ds6_element_t *)uip_ds6_prefix_list, UIP_DS6_PREFIX_NB,
       sizeof(uip_ds6_prefix_t), ipaddr, ipaddrlen,
       (uip_ds6_element_t **)&locprefix) == FREESPACE) {
+    /* The prefix changes which destinations are on-link */
+    tcpip_nexthop_cache_flush();
     locprefix->isused = 1;
     uip_ipaddr_copy(&locprefix->ipaddr, ipaddr);
     locprefix->length = ipaddrlen;
@@ -301,6 +310,8 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
      ((uip_ds6_element_t *)uip_ds6_prefix_list, UIP_DS6_PREFIX_NB,
       sizeof(uip_ds6_prefix_t), ipaddr, ipaddrlen,
       (uip_ds6_element_t **)&locprefix) == FREESPACE) {
+    /* The prefix changes which destinations are on-link */
+    tcpip_nexthop_cache_flush();
     locprefix->isused = 1;
     uip_ipaddr_copy(&locprefix->ipaddr, ipaddr);
     locprefix->length = ipaddrlen;
@@ -325,6 +336,7 @@ uip_ds6_prefix_rm(uip_ds6_prefix_t *prefix)
 {
   if(prefix != NULL) {
     prefix->isused = 0;
+    tcpip_nexthop_cache_flush();
   }
   return;
 }
@@ -381,6 +393,12 @@ uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
 #else /* UIP_ND6_DEF_MAXDADNS > 0 */
     locaddr->state = ADDR_PREFERRED;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+#if UIP_ND6_6LOWPAN_ND
+    stimer_set(&locaddr->regtimer, 0);
+    locaddr->regnscount = 0;
+    locaddr->regtid = random_rand();
+    uip_create_unspecified(&locaddr->regrouter);
+#endif /* UIP_ND6_6LOWPAN_ND */
     uip_create_solicited_node(ipaddr, &loc_fipaddr);
     uip_ds6_maddr_add(&loc_fipaddr);
     return locaddr;
@@ -674,6 +692,84 @@ uip_ds6_dad_failed(uip_ds6_addr_t *addr)
 }
 #endif /*UIP_ND6_DEF_MAXDADNS > 0 */
 
+#if UIP_ND6_6LOWPAN_ND
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_addr_register(uip_ds6_addr_t *addr)
+{
+  const uip_ipaddr_t *router = uip_ds6_defrt_choose();
+
+  if(router == NULL) {
+    /* Try again at the next period */
+    return;
+  }
+  if(addr->regnscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
+    LOG_WARN("Registration of ");
+    LOG_WARN_6ADDR(&addr->ipaddr);
+    LOG_WARN_(" not answered, retrying in %u seconds\n",
+              UIP_ND6_REGISTRATION_BACKOFF);
+    addr->regnscount = 0;
+    stimer_set(&addr->regtimer, UIP_ND6_REGISTRATION_BACKOFF);
+    return;
+  }
+  if(addr->regnscount == 0) {
+    /* A new registration, not a retransmission */
+    addr->regtid++;
+  }
+  uip_ipaddr_copy(&addr->regrouter, router);
+  uip_nd6_ns_aro_output(router, &addr->ipaddr, addr->regtid,
+                        UIP_ND6_REGISTRATION_LIFETIME);
+  addr->regnscount++;
+  stimer_set(&addr->regtimer, uip_ds6_if.retrans_timer / 1000);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_addr_registered(uip_ds6_addr_t *addr, uint8_t status,
+                        uint16_t lifetime)
+{
+  addr->regnscount = 0;
+  switch(status) {
+  case UIP_ND6_ARO_STATUS_SUCCESS:
+    /* Refresh the registration when three quarters of it elapsed */
+    LOG_INFO("Registered ");
+    LOG_INFO_6ADDR(&addr->ipaddr);
+    LOG_INFO_(" for %u minutes\n", lifetime);
+    stimer_set(&addr->regtimer, lifetime > 0 ?
+               (unsigned long)lifetime * 45 : UIP_ND6_REGISTRATION_BACKOFF);
+    break;
+  case UIP_ND6_ARO_STATUS_DUPLICATE:
+    LOG_ERR("Registration failed, duplicate address ");
+    LOG_ERR_6ADDR(&addr->ipaddr);
+    LOG_ERR_("\n");
+    uip_ds6_addr_rm(addr);
+    break;
+  default:
+    LOG_WARN("Registration of ");
+    LOG_WARN_6ADDR(&addr->ipaddr);
+    LOG_WARN_(" refused with status %u\n", status);
+    stimer_set(&addr->regtimer, UIP_ND6_REGISTRATION_BACKOFF);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_addr_register_all(void)
+{
+  for(locaddr = uip_ds6_if.addr_list;
+      locaddr < uip_ds6_if.addr_list + UIP_DS6_ADDR_NB; locaddr++) {
+    if(locaddr->isused) {
+      locaddr->regnscount = 0;
+      stimer_set(&locaddr->regtimer, 0);
+    }
+  }
+  /* Do not wait for the next period, with some jitter as all the
+     children of a new parent may do the same */
+  PROCESS_CONTEXT_BEGIN(&tcpip_process);
+  etimer_set(&uip_ds6_timer_periodic, random_rand() % CLOCK_SECOND + 1);
+  PROCESS_CONTEXT_END(&tcpip_process);
+}
+#endif /* UIP_ND6_6LOWPAN_ND */
+
 /*---------------------------------------------------------------------------*/
 #if UIP_CONF_ROUTER
 #if UIP_ND6_SEND_RA
@@ -213,6 +213,13 @@ typedef struct uip_ds6_addr {
   struct timer dadtimer;
   uint8_t dadnscount;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+#if UIP_ND6_6LOWPAN_ND
+  struct stimer regtimer;
+  uint8_t regnscount;
+  uint8_t regtid;
+  /* The router the last registration was sent to */
+  uip_ipaddr_t regrouter;
+#endif /* UIP_ND6_6LOWPAN_ND */
 } uip_ds6_addr_t;
 
 /** \brief Anycast address  */
@@ -361,6 +368,18 @@ void uip_ds6_dad(uip_ds6_addr_t *ifaddr);
 int uip_ds6_dad_failed(uip_ds6_addr_t *ifaddr);
 #endif /* UIP_ND6_DEF_MAXDADNS */
 
+#if UIP_ND6_6LOWPAN_ND
+/** \brief Register one address with the default router (6LoWPAN-ND) */
+void uip_ds6_addr_register(uip_ds6_addr_t *addr);
+
+/** \brief Callback when a router answered a registration */
+void uip_ds6_addr_registered(uip_ds6_addr_t *addr, uint8_t status,
+                             uint16_t lifetime);
+
+/** \brief Register all addresses again, e.g. with a new default router */
+void uip_ds6_addr_register_all(void);
+#endif /* UIP_ND6_6LOWPAN_ND */
+
 /** \brief Source address selection, see RFC 3484 */
 void uip_ds6_select_src(uip_ipaddr_t *src, uip_ipaddr_t *dst);
 
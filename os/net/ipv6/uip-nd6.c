@@ -74,6 +74,7 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/uip-nameserver.h"
+#include "net/ipv6/tcpip.h"
 #include "lib/random.h"
 
 /* Log configuration */
@@ -98,6 +99,7 @@
 #define ND6_OPT_PREFIX_BUF(opt)    ((uip_nd6_opt_prefix_info *)ND6_OPT(opt))
 #define ND6_OPT_MTU_BUF(opt)               ((uip_nd6_opt_mtu *)ND6_OPT(opt))
 #define ND6_OPT_RDNSS_BUF(opt)             ((uip_nd6_opt_dns *)ND6_OPT(opt))
+#define ND6_OPT_ARO_BUF(opt)               ((uip_nd6_opt_aro *)ND6_OPT(opt))
 /** @} */
 
 #if UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
@@ -107,6 +109,10 @@ static uip_ds6_nbr_t *nbr; /**  Pointer to a nbr cache entry*/
 static uip_ds6_addr_t *addr; /**  Pointer to an interface address */
 #endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
 
+#if UIP_ND6_6LOWPAN_ND
+static uip_nd6_opt_aro *nd6_opt_aro; /**  Pointer to ARO option in uip_buf */
+#endif /* UIP_ND6_6LOWPAN_ND */
+
 #if UIP_ND6_SEND_NS || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
 static uip_ds6_defrt_t *defrt; /**  Pointer to a router list entry */
 #endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
@@ -144,6 +150,98 @@ create_llao(uint8_t *llao, uint8_t type) {
          UIP_ND6_OPT_LLAO_LEN - 2 - UIP_LLADDR_LEN);
 }
 #endif /* UIP_ND6_SEND_NA */
+#if UIP_ND6_6LOWPAN_ND && UIP_CONF_ROUTER
+/*------------------------------------------------------------------*/
+/**
+ * Address registration processing (RFC 6775 section 6.5)
+ *
+ * The registered address is the target of the NS and the SLLAO gives its
+ * link-layer address. The owner of a registration is identified by its
+ * link-layer address, which is also the EUI-64 or ROVR of the ARO on
+ * 802.15.4: a registration from another owner is a duplicate. A zero
+ * lifetime removes the registration.
+ */
+static uint8_t
+aro_input(uip_ipaddr_t *tgt, uint16_t lifetime)
+{
+  uip_lladdr_t lladdr_aligned;
+  const uip_lladdr_t *lladdr;
+
+  if(uip_ds6_is_my_addr(tgt)) {
+    return UIP_ND6_ARO_STATUS_DUPLICATE;
+  }
+  extract_lladdr_from_llao_aligned(&lladdr_aligned);
+  nbr = uip_ds6_nbr_lookup(tgt);
+  if(nbr != NULL) {
+    lladdr = uip_ds6_nbr_get_ll(nbr);
+    if(lladdr == NULL) {
+      return UIP_ND6_ARO_STATUS_CACHE_FULL;
+    }
+    if(memcmp(lladdr, &lladdr_aligned, UIP_LLADDR_LEN) != 0) {
+      if(nbr->state == NBR_REGISTERED) {
+        return UIP_ND6_ARO_STATUS_DUPLICATE;
+      }
+      if(uip_ds6_nbr_update_ll(&nbr, &lladdr_aligned) < 0) {
+        return UIP_ND6_ARO_STATUS_CACHE_FULL;
+      }
+    }
+  }
+
+  if(lifetime == 0) {
+    LOG_INFO("Removing registration of ");
+    LOG_INFO_6ADDR(tgt);
+    LOG_INFO_("\n");
+    uip_ds6_nbr_rm(nbr);
+    return UIP_ND6_ARO_STATUS_SUCCESS;
+  }
+
+  if(nbr == NULL) {
+    nbr = uip_ds6_nbr_add(tgt, &lladdr_aligned, 0, NBR_STALE,
+                          NBR_TABLE_REASON_IPV6_ND, NULL);
+    if(nbr == NULL) {
+      return UIP_ND6_ARO_STATUS_CACHE_FULL;
+    }
+  }
+  uip_ds6_nbr_register(nbr, (unsigned long)lifetime * 60);
+  return UIP_ND6_ARO_STATUS_SUCCESS;
+}
+/*------------------------------------------------------------------*/
+/* Answer a registration with a NA carrying the ARO with its status */
+static void
+aro_na_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *tgt,
+              const uip_nd6_opt_aro *aro)
+{
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + UIP_ND6_NA_LEN + UIP_ND6_OPT_ARO_LEN);
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = UIP_ND6_HOP_LIMIT;
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dest);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+
+  UIP_ICMP_BUF->type = ICMP6_NA;
+  UIP_ICMP_BUF->icode = 0;
+
+  UIP_ND6_NA_BUF->flagsreserved = UIP_ND6_NA_FLAG_ROUTER | UIP_ND6_NA_FLAG_SOLICITED;
+  memset(UIP_ND6_NA_BUF->reserved, 0, sizeof(UIP_ND6_NA_BUF->reserved));
+  uip_ipaddr_copy(&UIP_ND6_NA_BUF->tgtipaddr, tgt);
+  memcpy(ND6_OPT_ARO_BUF(UIP_ND6_NA_LEN), aro, UIP_ND6_OPT_ARO_LEN);
+
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  uipbuf_set_len(UIP_IPH_LEN + UIP_ICMPH_LEN + UIP_ND6_NA_LEN + UIP_ND6_OPT_ARO_LEN);
+
+  UIP_STAT(++uip_stat.nd6.sent);
+  LOG_INFO("Sending NA to ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->destipaddr);
+  LOG_INFO_(" with ARO status %u for ", aro->status);
+  LOG_INFO_6ADDR(&UIP_ND6_NA_BUF->tgtipaddr);
+  LOG_INFO_("\n");
+}
+#endif /* UIP_ND6_6LOWPAN_ND && UIP_CONF_ROUTER */
 /*------------------------------------------------------------------*/
  /**
  * Neighbor Solicitation Processing
@@ -191,6 +289,9 @@ ns_input(void)
 
   /* Options processing */
   nd6_opt_llao = NULL;
+#if UIP_ND6_6LOWPAN_ND
+  nd6_opt_aro = NULL;
+#endif /* UIP_ND6_6LOWPAN_ND */
   nd6_opt_offset = UIP_ND6_NS_LEN;
   while(uip_l3_icmp_hdr_len + nd6_opt_offset < uip_len) {
 #if UIP_CONF_IPV6_CHECKS
@@ -222,6 +323,12 @@ ns_input(void)
           }
           if(memcmp(&nd6_opt_llao[UIP_ND6_OPT_DATA_OFFSET],
               lladdr, UIP_LLADDR_LEN) != 0) {
+#if UIP_ND6_6LOWPAN_ND
+            if(nbr->state == NBR_REGISTERED) {
+              /* Only a registration can change a registered entry */
+              break;
+            }
+#endif /* UIP_ND6_6LOWPAN_ND */
             if(uip_ds6_nbr_update_ll(&nbr,
                                      (const uip_lladdr_t *)&lladdr_aligned)
                < 0) {
@@ -232,6 +339,7 @@ ns_input(void)
           } else {
             if(nbr->state == NBR_INCOMPLETE) {
               nbr->state = NBR_STALE;
+              tcpip_nexthop_cache_flush();
             }
           }
         }
@@ -239,6 +347,11 @@ ns_input(void)
       }
 #endif /*UIP_CONF_IPV6_CHECKS */
       break;
+#if UIP_ND6_6LOWPAN_ND
+    case UIP_ND6_OPT_ARO:
+      nd6_opt_aro = ND6_OPT_ARO_BUF(nd6_opt_offset);
+      break;
+#endif /* UIP_ND6_6LOWPAN_ND */
     default:
       LOG_WARN("ND option not supported in NS");
       break;
@@ -246,6 +359,39 @@ ns_input(void)
     nd6_opt_offset += (ND6_OPT_HDR_BUF(nd6_opt_offset)->len << 3);
   }
 
+#if UIP_ND6_6LOWPAN_ND
+  if(nd6_opt_aro != NULL) {
+#if UIP_CONF_ROUTER
+    uip_ipaddr_t dest;
+    uip_ipaddr_t tgt;
+    uip_nd6_opt_aro aro;
+
+    /* A registration must come from a unicast address, with a SLLAO */
+    if(nd6_opt_aro->len != UIP_ND6_OPT_ARO_LEN >> 3 ||
+       nd6_opt_llao == NULL ||
+       uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr) ||
+       uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+      LOG_ERR("NS with ARO received is bad\n");
+      goto discard;
+    }
+    uip_ipaddr_copy(&dest, &UIP_IP_BUF->srcipaddr);
+    uip_ipaddr_copy(&tgt, &UIP_ND6_NS_BUF->tgtipaddr);
+    memcpy(&aro, nd6_opt_aro, sizeof(aro));
+    aro.status = aro_input(&tgt, uip_ntohs(aro.lifetime));
+    if(aro.status != UIP_ND6_ARO_STATUS_SUCCESS) {
+      LOG_WARN("Registration of ");
+      LOG_WARN_6ADDR(&tgt);
+      LOG_WARN_(" refused with status %u\n", aro.status);
+    }
+    aro_na_output(&dest, &tgt, &aro);
+    return;
+#else /* UIP_CONF_ROUTER */
+    /* Only routers accept registrations */
+    goto discard;
+#endif /* UIP_CONF_ROUTER */
+  }
+#endif /* UIP_ND6_6LOWPAN_ND */
+
   addr = uip_ds6_addr_lookup(&UIP_ND6_NS_BUF->tgtipaddr);
   if(addr != NULL) {
     if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
@@ -417,6 +563,65 @@ uip_nd6_ns_output(uip_ipaddr_t * src, uip_ipaddr_t * dest, uip_ipaddr_t * tgt)
 }
 #endif /* UIP_ND6_SEND_NS */
 
+#if UIP_ND6_6LOWPAN_ND
+/*------------------------------------------------------------------*/
+void
+uip_nd6_ns_aro_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *tgt,
+                      uint8_t tid, uint16_t lifetime)
+{
+  uip_nd6_opt_aro *aro;
+
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = UIP_ND6_HOP_LIMIT;
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dest);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    LOG_ERR("Dropping NS due to no suitable source address\n");
+    uipbuf_clear();
+    return;
+  }
+
+  UIP_ICMP_BUF->type = ICMP6_NS;
+  UIP_ICMP_BUF->icode = 0;
+  UIP_ND6_NS_BUF->reserved = 0;
+  uip_ipaddr_copy((uip_ipaddr_t *) &UIP_ND6_NS_BUF->tgtipaddr, tgt);
+
+  create_llao(&uip_buf[uip_l3_icmp_hdr_len + UIP_ND6_NS_LEN],
+              UIP_ND6_OPT_SLLAO);
+
+  /* The EUI-64, or ROVR, is our link-layer address */
+  aro = ND6_OPT_ARO_BUF(UIP_ND6_NS_LEN + UIP_ND6_OPT_LLAO_LEN);
+  memset(aro, 0, UIP_ND6_OPT_ARO_LEN);
+  aro->type = UIP_ND6_OPT_ARO;
+  aro->len = UIP_ND6_OPT_ARO_LEN >> 3;
+  aro->flags = UIP_ND6_ARO_FLAG_T;
+  aro->tid = tid;
+  aro->lifetime = uip_htons(lifetime);
+  memcpy(aro->rovr, &uip_lladdr, MIN(UIP_LLADDR_LEN, sizeof(aro->rovr)));
+
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + UIP_ND6_NS_LEN +
+                       UIP_ND6_OPT_LLAO_LEN + UIP_ND6_OPT_ARO_LEN);
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + UIP_ND6_NS_LEN +
+    UIP_ND6_OPT_LLAO_LEN + UIP_ND6_OPT_ARO_LEN;
+
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  UIP_STAT(++uip_stat.nd6.sent);
+  LOG_INFO("Sending NS with ARO to ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->destipaddr);
+  LOG_INFO_(" from ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
+  LOG_INFO_(" with target address ");
+  LOG_INFO_6ADDR(tgt);
+  LOG_INFO_("\n");
+}
+#endif /* UIP_ND6_6LOWPAN_ND */
+
 #if UIP_ND6_SEND_NS
 /*------------------------------------------------------------------*/
 /**
@@ -478,6 +683,9 @@ na_input(void)
   /* Options processing: we handle TLLAO, and must ignore others */
   nd6_opt_offset = UIP_ND6_NA_LEN;
   nd6_opt_llao = NULL;
+#if UIP_ND6_6LOWPAN_ND
+  nd6_opt_aro = NULL;
+#endif /* UIP_ND6_6LOWPAN_ND */
   while(uip_l3_icmp_hdr_len + nd6_opt_offset < uip_len) {
 #if UIP_CONF_IPV6_CHECKS
     if(ND6_OPT_HDR_BUF(nd6_opt_offset)->len == 0) {
@@ -489,6 +697,11 @@ na_input(void)
     case UIP_ND6_OPT_TLLAO:
       nd6_opt_llao = (uint8_t *)ND6_OPT_HDR_BUF(nd6_opt_offset);
       break;
+#if UIP_ND6_6LOWPAN_ND
+    case UIP_ND6_OPT_ARO:
+      nd6_opt_aro = ND6_OPT_ARO_BUF(nd6_opt_offset);
+      break;
+#endif /* UIP_ND6_6LOWPAN_ND */
     default:
       LOG_WARN("ND option not supported in NA\n");
       break;
@@ -498,6 +711,28 @@ na_input(void)
   addr = uip_ds6_addr_lookup(&UIP_ND6_NA_BUF->tgtipaddr);
   /* Message processing, including TLLAO if any */
   if(addr != NULL) {
+#if UIP_ND6_6LOWPAN_ND
+    /* The answer of a router to one of our registrations. It must come
+       from the router the registration was sent to, and a failure, which
+       may remove the address, must also carry our ROVR. */
+    if(nd6_opt_aro != NULL) {
+      if(nd6_opt_aro->len == UIP_ND6_OPT_ARO_LEN >> 3 &&
+         uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &addr->regrouter) &&
+         (nd6_opt_aro->status == UIP_ND6_ARO_STATUS_SUCCESS ||
+          memcmp(nd6_opt_aro->rovr, &uip_lladdr,
+                 MIN(UIP_LLADDR_LEN, sizeof(nd6_opt_aro->rovr))) == 0) &&
+         (!(nd6_opt_aro->flags & UIP_ND6_ARO_FLAG_T) ||
+          nd6_opt_aro->tid == addr->regtid)) {
+        uip_ds6_addr_registered(addr, nd6_opt_aro->status,
+                                uip_ntohs(nd6_opt_aro->lifetime));
+      } else {
+        LOG_WARN("Ignoring a registration answer from ");
+        LOG_WARN_6ADDR(&UIP_IP_BUF->srcipaddr);
+        LOG_WARN_("\n");
+      }
+      goto discard;
+    }
+#endif /* UIP_ND6_6LOWPAN_ND */
 #if UIP_ND6_DEF_MAXDADNS > 0
     if(addr->state == ADDR_TENTATIVE) {
       uip_ds6_dad_failed(addr);
@@ -538,6 +773,8 @@ na_input(void)
         nbr->state = NBR_STALE;
       }
       nbr->isrouter = is_router;
+      /* The neighbor is resolved, it may be the default router to use */
+      tcpip_nexthop_cache_flush();
     } else { /* NBR is not INCOMPLETE */
       if(!is_override && is_llchange) {
         if(nbr->state == NBR_REACHABLE) {
@@ -583,9 +820,10 @@ na_input(void)
     return;
     }*/
   if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+    /* The other queued packets are sent after this one, by
+       tcpip_ipv6_output() */
+    uip_len = uip_packetqueue_dequeue(&nbr->packethandle,
+                                      (uint8_t *)UIP_IP_BUF, UIP_BUFSIZE);
     return;
   }
 
@@ -911,6 +1149,7 @@ ra_input(void)
         }
         if(nbr->state == NBR_INCOMPLETE) {
           nbr->state = NBR_STALE;
+          tcpip_nexthop_cache_flush();
         }
         if(memcmp(&nd6_opt_llao[UIP_ND6_OPT_DATA_OFFSET],
                   lladdr, UIP_LLADDR_LEN) != 0) {
@@ -1067,9 +1306,10 @@ ra_input(void)
     return;
     }*/
   if(nbr != NULL && uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+    /* The other queued packets are sent after this one, by
+       tcpip_ipv6_output() */
+    uip_len = uip_packetqueue_dequeue(&nbr->packethandle,
+                                      (uint8_t *)UIP_IP_BUF, UIP_BUFSIZE);
     return;
   }
 
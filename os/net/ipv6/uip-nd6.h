@@ -136,13 +136,51 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_MAX_RA_DELAY_TIME_MS        500 /*milli seconds*/
 /** @} */
 
+/** \name RFC 6775 / RFC 8505 6LoWPAN-ND */
+/** @{ */
+/**
+ * \brief Use 6LoWPAN-ND address registration instead of multicast
+ * address resolution and DAD
+ *
+ * Nodes register their non link-local addresses with their default
+ * router (the RPL preferred parent when running RPL) by sending it a
+ * unicast NS with an ARO. Routers keep the registered addresses in the
+ * neighbor cache until the registration expires. Link-local neighbors
+ * are resolved from their IID, so no multicast NS is ever sent.
+ */
+#ifdef UIP_CONF_ND6_6LOWPAN_ND
+#define UIP_ND6_6LOWPAN_ND UIP_CONF_ND6_6LOWPAN_ND
+#else
+#define UIP_ND6_6LOWPAN_ND 0
+#endif
+
+/** \brief Registration lifetime requested by hosts, in units of 60 seconds */
+#ifdef UIP_CONF_ND6_REGISTRATION_LIFETIME
+#define UIP_ND6_REGISTRATION_LIFETIME UIP_CONF_ND6_REGISTRATION_LIFETIME
+#else
+#define UIP_ND6_REGISTRATION_LIFETIME 60
+#endif
+
+/** \brief Seconds to wait before registering again after a failure */
+#ifdef UIP_CONF_ND6_REGISTRATION_BACKOFF
+#define UIP_ND6_REGISTRATION_BACKOFF UIP_CONF_ND6_REGISTRATION_BACKOFF
+#else
+#define UIP_ND6_REGISTRATION_BACKOFF 60
+#endif
+
+#if UIP_ND6_6LOWPAN_ND && !(UIP_ND6_SEND_NS && UIP_ND6_SEND_NA)
+#error "6LoWPAN-ND requires UIP_CONF_ND6_SEND_NS and UIP_CONF_ND6_SEND_NA"
+#endif
+/** @} */
+
 #ifndef UIP_CONF_ND6_DEF_MAXDADNS
-/** \brief Do not try DAD when using EUI-64 as allowed by draft-ietf-6lowpan-nd-15 section 8.2 */
-#if UIP_CONF_LL_802154
+/** \brief Do not try DAD when using EUI-64 as allowed by draft-ietf-6lowpan-nd-15 section 8.2,
+ * nor with 6LoWPAN-ND, where the registration does DAD */
+#if UIP_CONF_LL_802154 || UIP_ND6_6LOWPAN_ND
 #define UIP_ND6_DEF_MAXDADNS 0
-#else /* UIP_CONF_LL_802154 */
+#else /* UIP_CONF_LL_802154 || UIP_ND6_6LOWPAN_ND */
 #define UIP_ND6_DEF_MAXDADNS UIP_ND6_SEND_NS
-#endif /* UIP_CONF_LL_802154 */
+#endif /* UIP_CONF_LL_802154 || UIP_ND6_6LOWPAN_ND */
 #else /* UIP_CONF_ND6_DEF_MAXDADNS */
 #define UIP_ND6_DEF_MAXDADNS UIP_CONF_ND6_DEF_MAXDADNS
 #endif /* UIP_CONF_ND6_DEF_MAXDADNS */
@@ -200,6 +238,7 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_ARO                 33
 /** @} */
 
 /** \name ND6 option types */
@@ -224,6 +263,7 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_OPT_MTU_LEN            8
 #define UIP_ND6_OPT_RDNSS_LEN          1
 #define UIP_ND6_OPT_DNSSL_LEN          1
+#define UIP_ND6_OPT_ARO_LEN            16
 
 
 /* Length of TLLAO and SLLAO options, it is L2 dependant */
@@ -255,6 +295,17 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_RA_FLAG_AUTONOMOUS      0x40
 /** @} */
 
+/** \name Address Registration Option flags and status values */
+/** @{ */
+#define UIP_ND6_ARO_FLAG_T              0x01 /* the TID is valid */
+#define UIP_ND6_ARO_FLAG_R              0x02 /* a route is requested */
+#define UIP_ND6_ARO_STATUS_SUCCESS      0
+#define UIP_ND6_ARO_STATUS_DUPLICATE    1
+#define UIP_ND6_ARO_STATUS_CACHE_FULL   2
+#define UIP_ND6_ARO_STATUS_MOVED        3
+#define UIP_ND6_ARO_STATUS_REMOVED      4
+/** @} */
+
 /**
  * \name ND message structures
  * @{
@@ -355,6 +406,18 @@ typedef struct uip_nd6_opt_dns {
   uip_ipaddr_t ip;
 } uip_nd6_opt_dns;
 
+/** \brief ND option (extended) address registration, RFC 6775 and 8505 */
+typedef struct uip_nd6_opt_aro {
+  uint8_t type;
+  uint8_t len;
+  uint8_t status;
+  uint8_t opaque;
+  uint8_t flags;
+  uint8_t tid;
+  uint16_t lifetime;
+  uint8_t rovr[8];
+} uip_nd6_opt_aro;
+
 /** \struct Redirected header option */
 typedef struct uip_nd6_opt_redirected_hdr {
   uint8_t type;
@@ -390,6 +453,22 @@ typedef struct uip_nd6_opt_redirected_hdr {
 void
 uip_nd6_ns_output(uip_ipaddr_t *src, uip_ipaddr_t *dest, uip_ipaddr_t *tgt);
 
+#if UIP_ND6_6LOWPAN_ND
+/**
+ * \brief Send a NS with an ARO to register an address with a router
+ * \param dest the link-local address of the router
+ * \param tgt the address to register
+ * \param tid the transaction ID of the registration
+ * \param lifetime the registration lifetime in units of 60 seconds, 0 to
+ * remove the registration
+ *
+ * The NS is sent from our link-local address and carries a SLLAO, so
+ * that the router can reach us before the registration completes.
+ */
+void uip_nd6_ns_aro_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *tgt,
+                           uint8_t tid, uint16_t lifetime);
+#endif /* UIP_ND6_6LOWPAN_ND */
+
 #if UIP_CONF_ROUTER
 #if UIP_ND6_SEND_RA
 /**
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "net/ipv6/uip.h"
 
@@ -6,8 +7,10 @@
 
 #include "net/ipv6/uip-packetqueue.h"
 
-#define MAX_NUM_QUEUED_PACKETS 2
-MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
+MEMB(packets_memb, struct uip_packetqueue_packet, UIP_PACKETQUEUE_PACKETS);
+MEMB(blocks_memb, struct uip_packetqueue_block,
+     (UIP_PACKETQUEUE_POOL_SIZE + UIP_PACKETQUEUE_BLOCK_SIZE - 1) /
+     UIP_PACKETQUEUE_BLOCK_SIZE);
 
 #define DEBUG 0
 #if DEBUG
@@ -17,15 +20,56 @@ MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 #define PRINTF(...)
 #endif
 
+/*---------------------------------------------------------------------------*/
+static void
+packet_release(struct uip_packetqueue_packet *p)
+{
+  struct uip_packetqueue_block *b;
+
+  while(p->blocks != NULL) {
+    b = p->blocks;
+    p->blocks = b->next;
+    memb_free(&blocks_memb, b);
+  }
+  memb_free(&packets_memb, p);
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_free(struct uip_packetqueue_packet *p)
+{
+  struct uip_packetqueue_packet **pp;
+
+  for(pp = &p->handle->packet; *pp != NULL; pp = &(*pp)->next) {
+    if(*pp == p) {
+      *pp = p->next;
+      break;
+    }
+  }
+  ctimer_stop(&p->lifetimer);
+  packet_release(p);
+}
 /*---------------------------------------------------------------------------*/
 static void
 packet_timedout(void *ptr)
 {
-  struct uip_packetqueue_handle *h = ptr;
+  struct uip_packetqueue_packet *p = ptr;
 
-  PRINTF("uip_packetqueue_free timed out %p\n", h);
-  memb_free(&packets_memb, h->packet);
-  h->packet = NULL;
+  PRINTF("uip_packetqueue_free timed out %p\n", p->handle);
+  packet_free(p);
+}
+/*---------------------------------------------------------------------------*/
+/* Make room by dropping the oldest packet of the handle, if the policy
+   allows it */
+static int
+drop_oldest(struct uip_packetqueue_handle *handle)
+{
+  if(UIP_PACKETQUEUE_POLICY != UIP_PACKETQUEUE_DROP_OLDEST ||
+     handle->packet == NULL) {
+    return 0;
+  }
+  PRINTF("uip_packetqueue dropping oldest %p\n", handle);
+  packet_free(handle->packet);
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -35,39 +79,111 @@ uip_packetqueue_new(struct uip_packetqueue_handle *handle)
   handle->packet = NULL;
 }
 /*---------------------------------------------------------------------------*/
-struct uip_packetqueue_packet *
-uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime)
+int
+uip_packetqueue_enqueue(struct uip_packetqueue_handle *handle,
+                        const uint8_t *buf, uint16_t len,
+                        clock_time_t lifetime)
 {
-  PRINTF("uip_packetqueue_alloc %p\n", handle);
-  if(handle->packet != NULL) {
-    PRINTF("alloced\n");
-    return NULL;
+  struct uip_packetqueue_packet *p;
+  struct uip_packetqueue_packet **pp;
+  struct uip_packetqueue_block **bp;
+  uint16_t count;
+  uint16_t n;
+
+  PRINTF("uip_packetqueue_enqueue %p len %u\n", handle, len);
+
+  count = 0;
+  for(p = handle->packet; p != NULL; p = p->next) {
+    count++;
+  }
+  if(count >= UIP_PACKETQUEUE_PER_NBR && !drop_oldest(handle)) {
+    PRINTF("uip_packetqueue_enqueue queue full\n");
+    return 0;
   }
-  handle->packet = memb_alloc(&packets_memb);
-  if(handle->packet != NULL) {
-    ctimer_set(&handle->packet->lifetimer, lifetime,
-               packet_timedout, handle);
+
+  while((p = memb_alloc(&packets_memb)) == NULL) {
+    if(!drop_oldest(handle)) {
+      PRINTF("uip_packetqueue_enqueue failed\n");
+      return 0;
+    }
+  }
+  p->next = NULL;
+  p->blocks = NULL;
+  p->queue_buf_len = len;
+  p->handle = handle;
+
+  /* Copy the packet to blocks of the pool */
+  bp = &p->blocks;
+  while(len > 0) {
+    while((*bp = memb_alloc(&blocks_memb)) == NULL) {
+      if(!drop_oldest(handle)) {
+        PRINTF("uip_packetqueue_enqueue out of blocks\n");
+        /* the packet is not queued yet */
+        packet_release(p);
+        return 0;
+      }
+    }
+    n = MIN(len, UIP_PACKETQUEUE_BLOCK_SIZE);
+    memcpy((*bp)->data, buf, n);
+    (*bp)->next = NULL;
+    bp = &(*bp)->next;
+    buf += n;
+    len -= n;
+  }
+
+  /* Append to the queue of the handle */
+  for(pp = &handle->packet; *pp != NULL; pp = &(*pp)->next);
+  *pp = p;
+  ctimer_set(&p->lifetimer, lifetime, packet_timedout, p);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_packetqueue_dequeue(struct uip_packetqueue_handle *handle,
+                        uint8_t *buf, uint16_t size)
+{
+  struct uip_packetqueue_packet *p = handle->packet;
+  struct uip_packetqueue_block *b;
+  uint16_t len;
+  uint16_t n;
+
+  if(p == NULL) {
+    return 0;
+  }
+
+  len = p->queue_buf_len;
+  if(len > size) {
+    len = 0;
   } else {
-    PRINTF("uip_packetqueue_alloc failed\n");
+    for(b = p->blocks, n = 0; b != NULL; b = b->next) {
+      memcpy(buf + n, b->data, MIN(len - n, UIP_PACKETQUEUE_BLOCK_SIZE));
+      n += UIP_PACKETQUEUE_BLOCK_SIZE;
+    }
   }
-  return handle->packet;
+  packet_free(p);
+  return len;
 }
 /*---------------------------------------------------------------------------*/
 void
-uip_packetqueue_free(struct uip_packetqueue_handle *handle)
+uip_packetqueue_move(struct uip_packetqueue_handle *to,
+                     struct uip_packetqueue_handle *from)
 {
-  PRINTF("uip_packetqueue_free %p\n", handle);
-  if(handle->packet != NULL) {
-    ctimer_stop(&handle->packet->lifetimer);
-    memb_free(&packets_memb, handle->packet);
-    handle->packet = NULL;
+  struct uip_packetqueue_packet *p;
+
+  to->packet = from->packet;
+  from->packet = NULL;
+  for(p = to->packet; p != NULL; p = p->next) {
+    p->handle = to;
   }
 }
 /*---------------------------------------------------------------------------*/
-uint8_t *
-uip_packetqueue_buf(struct uip_packetqueue_handle *h)
+void
+uip_packetqueue_free(struct uip_packetqueue_handle *handle)
 {
-  return h->packet != NULL? h->packet->queue_buf: NULL;
+  PRINTF("uip_packetqueue_free %p\n", handle);
+  while(handle->packet != NULL) {
+    packet_free(handle->packet);
+  }
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
@@ -76,11 +192,3 @@ uip_packetqueue_buflen(struct uip_packetqueue_handle *h)
   return h->packet != NULL? h->packet->queue_buf_len: 0;
 }
 /*---------------------------------------------------------------------------*/
-void
-uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len)
-{
-  if(h->packet != NULL) {
-    h->packet->queue_buf_len = len;
-  }
-}
-/*---------------------------------------------------------------------------*/
@@ -3,33 +3,89 @@
 
 #include "sys/ctimer.h"
 
+/* What to do when a neighbor has UIP_PACKETQUEUE_PER_NBR packets
+   queued, or the pool is full: RFC 4861 7.2.2 suggests to replace the
+   oldest packet by the new one */
+#define UIP_PACKETQUEUE_DROP_OLDEST 0
+#define UIP_PACKETQUEUE_DROP_NEWEST 1
+
+#ifdef UIP_CONF_PACKETQUEUE_POLICY
+#define UIP_PACKETQUEUE_POLICY UIP_CONF_PACKETQUEUE_POLICY
+#else
+#define UIP_PACKETQUEUE_POLICY UIP_PACKETQUEUE_DROP_OLDEST
+#endif
+
+/* The maximum number of packets queued for a neighbor */
+#ifdef UIP_CONF_PACKETQUEUE_PER_NBR
+#define UIP_PACKETQUEUE_PER_NBR UIP_CONF_PACKETQUEUE_PER_NBR
+#else
+#define UIP_PACKETQUEUE_PER_NBR 4
+#endif
+
+/* The maximum number of packets queued for all neighbors */
+#ifdef UIP_CONF_PACKETQUEUE_PACKETS
+#define UIP_PACKETQUEUE_PACKETS UIP_CONF_PACKETQUEUE_PACKETS
+#else
+#define UIP_PACKETQUEUE_PACKETS 8
+#endif
+
+/* Packets are stored in blocks of this size, from a pool shared by all
+   neighbors */
+#ifdef UIP_CONF_PACKETQUEUE_BLOCK_SIZE
+#define UIP_PACKETQUEUE_BLOCK_SIZE UIP_CONF_PACKETQUEUE_BLOCK_SIZE
+#else
+#define UIP_PACKETQUEUE_BLOCK_SIZE 64
+#endif
+
+/* The size of the pool in bytes */
+#ifdef UIP_CONF_PACKETQUEUE_POOL_SIZE
+#define UIP_PACKETQUEUE_POOL_SIZE UIP_CONF_PACKETQUEUE_POOL_SIZE
+#else
+#define UIP_PACKETQUEUE_POOL_SIZE UIP_BUFSIZE
+#endif
+
 struct uip_packetqueue_handle;
 
+struct uip_packetqueue_block {
+  struct uip_packetqueue_block *next;
+  uint8_t data[UIP_PACKETQUEUE_BLOCK_SIZE];
+};
+
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
-  uint8_t queue_buf[UIP_BUFSIZE];
+  struct uip_packetqueue_packet *next;
+  struct uip_packetqueue_block *blocks;
   uint16_t queue_buf_len;
   struct ctimer lifetimer;
   struct uip_packetqueue_handle *handle;
 };
 
 struct uip_packetqueue_handle {
+  /* The queued packets, oldest first */
   struct uip_packetqueue_packet *packet;
 };
 
 void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
 
+/* Queue a copy of a packet. Returns 1 if it was queued, 0 if dropped. */
+int uip_packetqueue_enqueue(struct uip_packetqueue_handle *handle,
+                            const uint8_t *buf, uint16_t len,
+                            clock_time_t lifetime);
 
-struct uip_packetqueue_packet *
-uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
+/* Copy the oldest packet to buf and remove it from the queue. Returns
+   its length, or 0 if there is none. */
+uint16_t uip_packetqueue_dequeue(struct uip_packetqueue_handle *handle,
+                                 uint8_t *buf, uint16_t size);
 
+/* Move all the packets of a handle to another, empty one */
+void uip_packetqueue_move(struct uip_packetqueue_handle *to,
+                          struct uip_packetqueue_handle *from);
 
+/* Remove all the packets of the handle */
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
-uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
+/* The length of the oldest packet, or 0 if there is none */
 uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
-void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
 
 
 #endif /* UIP_PACKETQUEUE_H */
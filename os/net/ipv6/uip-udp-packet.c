@@ -47,9 +47,11 @@ extern uint16_t uip_slen;
 #include <string.h>
 
 /*---------------------------------------------------------------------------*/
-void
-uip_udp_packet_send(struct uip_udp_conn *c, const void *data, int len)
+static int
+udp_packet_send(struct uip_udp_conn *c, const void *data, int len)
 {
+  int status = TCPIP_OUTPUT_DROPPED;
+
 #if UIP_UDP
   if(data != NULL && len <= (UIP_BUFSIZE - UIP_IPUDPH_LEN)) {
     uip_udp_conn = c;
@@ -65,15 +67,23 @@ uip_udp_packet_send(struct uip_udp_conn *c, const void *data, int len)
 #endif /* UIP_IPV6_MULTICAST */
 
 #if NETSTACK_CONF_WITH_IPV6
-    tcpip_ipv6_output();
+    status = tcpip_ipv6_output();
 #else
     if(uip_len > 0) {
       tcpip_output();
+      status = TCPIP_OUTPUT_SENT;
     }
 #endif
   }
   uip_slen = 0;
 #endif /* UIP_UDP */
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_udp_packet_send(struct uip_udp_conn *c, const void *data, int len)
+{
+  udp_packet_send(c, data, len);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -100,3 +110,34 @@ uip_udp_packet_sendto(struct uip_udp_conn *c, const void *data, int len,
   }
 }
 /*---------------------------------------------------------------------------*/
+int
+uip_udp_packet_send_batch(struct uip_udp_conn *c,
+                          struct uip_udp_batch_entry *entries, int count)
+{
+  struct uip_udp_batch_entry *e;
+  uip_ipaddr_t curaddr;
+  uint16_t curport;
+  int sent = 0;
+
+  /* Save current IP addr/port. */
+  uip_ipaddr_copy(&curaddr, &c->ripaddr);
+  curport = c->rport;
+
+  tcpip_batch_begin();
+  for(e = entries; e < &entries[count]; e++) {
+    uip_ipaddr_copy(&c->ripaddr, e->addr != NULL ? e->addr : &curaddr);
+    c->rport = e->port != 0 ? UIP_HTONS(e->port) : curport;
+    e->status = udp_packet_send(c, e->data, e->datalen);
+    if(e->status == TCPIP_OUTPUT_SENT) {
+      sent++;
+    }
+  }
+  tcpip_batch_end();
+
+  /* Restore old IP addr/port */
+  uip_ipaddr_copy(&c->ripaddr, &curaddr);
+  c->rport = curport;
+
+  return sent;
+}
+/*---------------------------------------------------------------------------*/
@@ -46,4 +46,26 @@ void uip_udp_packet_send(struct uip_udp_conn *c, const void *data, int len);
 void uip_udp_packet_sendto(struct uip_udp_conn *c, const void *data, int len,
 			   const uip_ipaddr_t *toaddr, uint16_t toport);
 
+/* A datagram of a batch */
+struct uip_udp_batch_entry {
+  /* The destination, or NULL for the remote address of the connection */
+  const uip_ipaddr_t *addr;
+  /* The destination port in host byte order, or 0 for the remote port
+     of the connection */
+  uint16_t port;
+  const void *data;
+  uint16_t datalen;
+  /* Set when the datagram is sent: TCPIP_OUTPUT_SENT,
+     TCPIP_OUTPUT_QUEUED or TCPIP_OUTPUT_DROPPED */
+  uint8_t status;
+};
+
+/* Send a batch of datagrams in a row. Consecutive datagrams through
+   the same next hop share its neighbor lookup, and all the frames are
+   queued to the MAC layer before it gets to run. Returns the number
+   of datagrams sent; the status of each one is set in its entry. */
+int uip_udp_packet_send_batch(struct uip_udp_conn *c,
+                              struct uip_udp_batch_entry *entries,
+                              int count);
+
 #endif /* UIP_UDP_PACKET_H_ */
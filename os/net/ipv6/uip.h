@@ -700,6 +700,45 @@ void uip_send(const void *data, int len);
     uip_conn->tcpstateflags &= ~UIP_STOPPED;                    \
   } while(0)
 
+#if UIP_TCP_SLIDING_WINDOW
+/**
+ * Enable the sliding window for a connection.
+ *
+ * After this call, the application may send new data whenever
+ * uip_mss() is non-zero, even if previously sent data has not yet
+ * been acknowledged. uIP keeps a copy of every segment in flight and
+ * takes care of retransmissions itself, so the application is never
+ * invoked with the uip_rexmit() flag set. When data is acknowledged,
+ * uip_acked_len() returns how many bytes were acknowledged. A call to
+ * uip_close() is only honoured once all data has been acknowledged.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ *
+ * \hideinitializer
+ */
+#define uip_window_enable(conn) ((conn)->wflags |= UIP_TCP_WINDOW_ENABLED)
+
+/**
+ * The number of bytes acknowledged by the remote host.
+ *
+ * Only valid when uip_acked() is non-zero on a connection that has
+ * the sliding window enabled.
+ *
+ * \hideinitializer
+ */
+#define uip_acked_len()          (uip_conn->acklen)
+
+/**
+ * \internal
+ *
+ * Check if a connection with the sliding window enabled could send
+ * more data right away, in which case it should be polled again.
+ *
+ * \hideinitializer
+ */
+#define uip_window_repoll(conn) ((conn)->wflags & UIP_TCP_WINDOW_REPOLL)
+#endif /* UIP_TCP_SLIDING_WINDOW */
+
 
 /* uIP tests that can be made to determine in what state the current
    connection is, and what the application function should do. */
@@ -1311,6 +1350,17 @@ extern uint8_t uip_last_proto;
 extern uint16_t uip_urglen, uip_surglen;
 #endif /* UIP_URGDATA > 0 */
 
+#if UIP_TCP_SLIDING_WINDOW
+/**
+ * A TCP segment kept for retransmission when the sliding window is
+ * enabled.
+ */
+struct uip_tcp_segment {
+  uint16_t len;                 /**< Length of the segment data. */
+  uint8_t data[UIP_TCP_MSS];    /**< The segment data. */
+};
+#endif /* UIP_TCP_SLIDING_WINDOW */
+
 /**
  * Representation of a uIP TCP connection.
  *
@@ -1341,6 +1391,15 @@ struct uip_conn {
   uint8_t timer;         /**< The retransmission timer. */
   uint8_t nrtx;          /**< The number of retransmissions for the last
                               segment sent. */
+#if UIP_TCP_SLIDING_WINDOW
+  uint16_t snd_wnd;      /**< The window last advertised by the remote host. */
+  uint16_t acklen;       /**< Length of the data acknowledged by the last ACK. */
+  uint8_t wflags;        /**< Sliding window flags. */
+  uint8_t seg_first;     /**< Index of the oldest unacknowledged segment. */
+  uint8_t seg_count;     /**< Number of unacknowledged segments. */
+  uint8_t dupacks;       /**< Number of duplicate ACKs received in a row. */
+  struct uip_tcp_segment segs[UIP_TCP_WINDOW_SEGMENTS]; /**< Segments in flight. */
+#endif /* UIP_TCP_SLIDING_WINDOW */
   uip_tcp_appstate_t appstate; /** The application state. */
 };
 
@@ -1457,6 +1516,8 @@ struct uip_stats {
     uip_stats_t ackerr;   /**< Number of TCP segments with a bad ACK number. */
     uip_stats_t rst;      /**< Number of received TCP RST (reset) segments. */
     uip_stats_t rexmit;   /**< Number of retransmitted TCP segments. */
+    uip_stats_t fastrexmit; /**< Number of TCP segments retransmitted
+                                 after duplicate ACKs. */
     uip_stats_t syndrop;  /**< Number of dropped SYNs because too few
                                connections were available. */
     uip_stats_t synrst;   /**< Number of SYNs for closed ports,
@@ -1595,6 +1656,11 @@ void uip_process(uint8_t flag);
 
 #define UIP_STOPPED      16
 
+/* The sliding window flags used in the uip_conn->wflags. */
+#define UIP_TCP_WINDOW_ENABLED  1
+#define UIP_TCP_WINDOW_RECOVERY 2
+#define UIP_TCP_WINDOW_REPOLL   4
+
 /*
  * In IPv6 the length of the L3 headers before the transport header is
  * not fixed, due to the possibility to include extension option headers
@@ -80,6 +80,7 @@
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
 #include "net/routing/routing.h"
+#include "lib/memb.h"
 
 #if UIP_ND6_SEND_NS
 #include "net/ipv6/uip-ds6-nbr.h"
@@ -128,13 +129,6 @@ uint8_t uip_last_proto = 0;
 /*---------------------------------------------------------------------------*/
 /* Buffers                                                                   */
 /*---------------------------------------------------------------------------*/
-/**
- * \name Reassembly buffer definition
- * @{
- */
-#define FBUF                                ((struct uip_ip_hdr *)&uip_reassbuf[0])
-
-/** @} */
 /**
  * \name Buffer variables
  * @{
@@ -274,7 +268,186 @@ uip_add32(uint8_t *op32, uint16_t op16)
     }
   }
 }
+/*---------------------------------------------------------------------------*/
+static void
+uip_update_rtt(struct uip_conn *conn)
+{
+  signed char m;
+  m = conn->rto - conn->timer;
+  /* This is taken directly from VJs original code in his paper */
+  m = m - (conn->sa >> 3);
+  conn->sa += m;
+  if(m < 0) {
+    m = -m;
+  }
+  m = m - (conn->sv >> 2);
+  conn->sv += m;
+  conn->rto = (conn->sa >> 3) + conn->sv;
+}
 #endif /* UIP_TCP */
+#if UIP_TCP_SLIDING_WINDOW
+/*---------------------------------------------------------------------------*/
+static uint32_t
+tcp_seq(const uint8_t *seqno)
+{
+  return ((uint32_t)seqno[0] << 24) | ((uint32_t)seqno[1] << 16) |
+    ((uint32_t)seqno[2] << 8) | seqno[3];
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_window_reset(struct uip_conn *conn)
+{
+  conn->wflags = 0;
+  conn->seg_first = 0;
+  conn->seg_count = 0;
+  conn->dupacks = 0;
+  conn->snd_wnd = 0;
+  conn->acklen = 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Compute how much new data the connection may send right now, given
+ * the window advertised by the peer and the data already in flight,
+ * and store it as the current MSS of the connection.
+ */
+static uint8_t
+tcp_window_open(struct uip_conn *conn)
+{
+  uint16_t room;
+
+  if(conn->seg_count >= UIP_TCP_WINDOW_SEGMENTS) {
+    room = 0;
+  } else if(conn->len == 0) {
+    /* As in the single-segment case, a zero window is probed by
+       sending a full segment that gets retransmitted until the peer
+       opens its window. */
+    room = conn->snd_wnd == 0 ? conn->initialmss : conn->snd_wnd;
+  } else if(conn->snd_wnd > conn->len) {
+    room = conn->snd_wnd - conn->len;
+  } else {
+    room = 0;
+  }
+
+  conn->mss = MIN(room, conn->initialmss);
+  return conn->mss > 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Copy the len bytes of application data in uip_sappdata into the
+ * retransmission buffer of the connection. Returns the number of
+ * bytes that fit in the window.
+ */
+static uint16_t
+tcp_window_queue(struct uip_conn *conn, uint16_t len)
+{
+  struct uip_tcp_segment *seg;
+
+  if(conn->mss == 0 || conn->seg_count >= UIP_TCP_WINDOW_SEGMENTS) {
+    return 0;
+  }
+  if(len > conn->mss) {
+    len = conn->mss;
+  }
+
+  seg = &conn->segs[(conn->seg_first + conn->seg_count) %
+                    UIP_TCP_WINDOW_SEGMENTS];
+  memcpy(seg->data, uip_sappdata, len);
+  seg->len = len;
+
+  if(conn->len == 0) {
+    /* Start the retransmission timer for the first segment in flight. */
+    conn->timer = conn->rto;
+    conn->nrtx = 0;
+  }
+  conn->len += len;
+  conn->seg_count++;
+
+  if(tcp_window_open(conn)) {
+    conn->wflags |= UIP_TCP_WINDOW_REPOLL;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Process the ACK of an incoming segment on a connection that has the
+ * sliding window enabled. Returns non-zero if the oldest outstanding
+ * segment should be retransmitted right away.
+ */
+static uint8_t
+tcp_window_acked(struct uip_conn *conn)
+{
+  struct uip_tcp_segment *seg;
+  uint32_t acked;
+  uint16_t wnd;
+
+  acked = tcp_seq(UIP_TCP_BUF->ackno) - tcp_seq(conn->snd_nxt);
+
+  if(acked == 0) {
+    /* A segment without data that neither acknowledges anything new
+       nor updates the window is a duplicate ACK. */
+    wnd = ((uint16_t)UIP_TCP_BUF->wnd[0] << 8) + (uint16_t)UIP_TCP_BUF->wnd[1];
+    if(uip_len == 0 && (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN)) == 0 &&
+       wnd == conn->snd_wnd &&
+       ++conn->dupacks == UIP_TCP_DUPACK_THRESHOLD) {
+      LOG_INFO("tcp: fast retransmit after %u duplicate ACKs\n",
+               conn->dupacks);
+      UIP_STAT(++uip_stat.tcp.fastrexmit);
+      conn->wflags |= UIP_TCP_WINDOW_RECOVERY;
+      return 1;
+    }
+    return 0;
+  }
+
+  if((int32_t)acked < 0) {
+    /* An old or reordered ACK, below the left edge of the window. */
+    return 0;
+  }
+
+  if(acked > conn->len) {
+    /* The peer acknowledges data that we have not sent. */
+    UIP_STAT(++uip_stat.tcp.ackerr);
+    return 0;
+  }
+
+  /* Do RTT estimation, unless we have done retransmissions. */
+  if(conn->nrtx == 0) {
+    uip_update_rtt(conn);
+  }
+  conn->timer = conn->rto;
+  conn->nrtx = 0;
+  conn->dupacks = 0;
+
+  uip_add32(conn->snd_nxt, (uint16_t)acked);
+  memcpy(conn->snd_nxt, uip_acc32, sizeof(conn->snd_nxt));
+  conn->len -= acked;
+  conn->acklen = acked;
+
+  /* Release the segments that have been acknowledged, trimming the
+     oldest remaining one if it was only partly acknowledged. */
+  while(acked > 0 && conn->seg_count > 0) {
+    seg = &conn->segs[conn->seg_first];
+    if(acked >= seg->len) {
+      acked -= seg->len;
+      conn->seg_first = (conn->seg_first + 1) % UIP_TCP_WINDOW_SEGMENTS;
+      conn->seg_count--;
+    } else {
+      memmove(seg->data, &seg->data[acked], seg->len - acked);
+      seg->len -= acked;
+      acked = 0;
+    }
+  }
+
+  uip_flags = UIP_ACKDATA;
+
+  if(conn->len == 0) {
+    conn->wflags &= ~UIP_TCP_WINDOW_RECOVERY;
+    return 0;
+  }
+  /* A partial ACK during recovery means that the next segment was
+     lost as well. */
+  return (conn->wflags & UIP_TCP_WINDOW_RECOVERY) != 0;
+}
+#endif /* UIP_TCP_SLIDING_WINDOW */
 
 #if ! UIP_ARCH_CHKSUM
 /*---------------------------------------------------------------------------*/
@@ -476,6 +649,9 @@ uip_connect(const uip_ipaddr_t *ripaddr, uint16_t rport)
   conn->initialmss = conn->mss = UIP_TCP_MSS;
 
   conn->len = 1;   /* TCP length of the SYN is one. */
+#if UIP_TCP_SLIDING_WINDOW
+  tcp_window_reset(conn);
+#endif /* UIP_TCP_SLIDING_WINDOW */
   conn->nrtx = 0;
   conn->timer = 1; /* Send the SYN next time around. */
   conn->rto = UIP_RTO;
@@ -593,20 +769,48 @@ uip_listen(uint16_t port)
 #if UIP_CONF_IPV6_REASSEMBLY
 #define UIP_REASS_BUFSIZE (UIP_BUFSIZE)
 
-static uint8_t uip_reassbuf[UIP_REASS_BUFSIZE];
+#define UIP_REASS_BLOCK_SIZE   (UIP_CONF_IPV6_REASS_BLOCK_SIZE)
+#define UIP_REASS_CTX_BLOCKS   ((UIP_REASS_BUFSIZE + UIP_REASS_BLOCK_SIZE - 1) / \
+                                UIP_REASS_BLOCK_SIZE)
+#define UIP_REASS_POOL_BLOCKS  ((UIP_CONF_IPV6_REASS_POOL_SIZE) / \
+                                UIP_REASS_BLOCK_SIZE)
 
-static uint8_t uip_reassbitmap[UIP_REASS_BUFSIZE / (8 * 8)];
 /*the first byte of an IP fragment is aligned on an 8-byte boundary */
 
 static const uint8_t bitmap_bits[8] = {0xff, 0x7f, 0x3f, 0x1f,
                                     0x0f, 0x07, 0x03, 0x01};
-static uint16_t uip_reasslen;
-static uint8_t uip_reassflags;
 
 #define UIP_REASS_FLAG_LASTFRAG 0x01
 #define UIP_REASS_FLAG_FIRSTFRAG 0x02
 #define UIP_REASS_FLAG_ERROR_MSG 0x04
 
+/*
+ * A reassembly context holds one IPv6 packet being reassembled,
+ * identified by its source and destination addresses and the
+ * Identification of its Fragment headers. The packet is kept as it
+ * will eventually appear in uip_buf (unfragmentable part followed by
+ * the fragmentable part), but stored in blocks that are allocated
+ * from a pool shared by all contexts as fragments arrive.
+ */
+struct uip_reass_block {
+  uint8_t data[UIP_REASS_BLOCK_SIZE];
+};
+
+struct uip_reass_ctx {
+  uip_ipaddr_t srcipaddr;
+  uip_ipaddr_t destipaddr;
+  uint32_t id;
+  struct timer timer;
+  uint16_t len;
+  uint8_t flags;
+  uint8_t used;
+  uint8_t bitmap[UIP_REASS_BUFSIZE / (8 * 8) + 1];
+  struct uip_reass_block *blocks[UIP_REASS_CTX_BLOCKS];
+};
+
+MEMB(uip_reass_blocks, struct uip_reass_block, UIP_REASS_POOL_BLOCKS);
+static struct uip_reass_ctx uip_reass_ctxs[UIP_CONF_IPV6_REASS_CONTEXTS];
+static uint8_t uip_reassflags;
 
 /*
  * See RFC 2460 for a description of fragmentation in IPv6
@@ -618,155 +822,272 @@ static uint8_t uip_reassflags;
  */
 
 
-struct etimer uip_reass_timer; /**< Timer for reassembly */
-uint8_t uip_reass_on; /* equal to 1 if we are currently reassembling a packet */
+struct etimer uip_reass_timer; /**< Timer for the earliest expiring context */
 
-static uint32_t uip_id; /* For every packet that is to be fragmented, the source
-                        node generates an Identification value that is present
-                        in all the fragments */
 #define IP_MF   0x0001
 
+/*---------------------------------------------------------------------------*/
+static void
+reass_free(struct uip_reass_ctx *ctx)
+{
+  int i;
+
+  for(i = 0; i < UIP_REASS_CTX_BLOCKS; i++) {
+    if(ctx->blocks[i] != NULL) {
+      memb_free(&uip_reass_blocks, ctx->blocks[i]);
+      ctx->blocks[i] = NULL;
+    }
+  }
+  ctx->used = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Arm uip_reass_timer for the context that expires first, if any. */
+static void
+reass_set_timer(void)
+{
+  struct uip_reass_ctx *ctx;
+  struct uip_reass_ctx *first = NULL;
+  clock_time_t left;
+
+  for(ctx = uip_reass_ctxs;
+      ctx < &uip_reass_ctxs[UIP_CONF_IPV6_REASS_CONTEXTS]; ctx++) {
+    if(ctx->used && (first == NULL ||
+                     timer_remaining(&ctx->timer) <
+                     timer_remaining(&first->timer))) {
+      first = ctx;
+    }
+  }
+
+  if(first == NULL) {
+    etimer_stop(&uip_reass_timer);
+  } else {
+    left = timer_expired(&first->timer) ? 0 : timer_remaining(&first->timer);
+    etimer_set(&uip_reass_timer, left);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Copy data into the packet image of a context, at offset pos. */
+static bool
+reass_write(struct uip_reass_ctx *ctx, uint16_t pos, const uint8_t *data,
+            uint16_t len)
+{
+  struct uip_reass_block **block;
+  uint16_t chunk;
+
+  while(len > 0) {
+    block = &ctx->blocks[pos / UIP_REASS_BLOCK_SIZE];
+    if(*block == NULL) {
+      *block = memb_alloc(&uip_reass_blocks);
+      if(*block == NULL) {
+        return false;
+      }
+    }
+    chunk = MIN(len, UIP_REASS_BLOCK_SIZE - pos % UIP_REASS_BLOCK_SIZE);
+    memcpy(&(*block)->data[pos % UIP_REASS_BLOCK_SIZE], data, chunk);
+    pos += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Copy the first len bytes of the packet image of a context to buf. */
+static void
+reass_read(struct uip_reass_ctx *ctx, uint8_t *buf, uint16_t len)
+{
+  uint16_t pos;
+  uint16_t chunk;
+
+  for(pos = 0; pos < len; pos += chunk) {
+    chunk = MIN(len - pos, UIP_REASS_BLOCK_SIZE);
+    if(ctx->blocks[pos / UIP_REASS_BLOCK_SIZE] != NULL) {
+      memcpy(buf + pos, ctx->blocks[pos / UIP_REASS_BLOCK_SIZE]->data, chunk);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct uip_reass_ctx *
+reass_lookup(uint32_t id)
+{
+  struct uip_reass_ctx *ctx;
+  struct uip_reass_ctx *free_ctx = NULL;
+
+  for(ctx = uip_reass_ctxs;
+      ctx < &uip_reass_ctxs[UIP_CONF_IPV6_REASS_CONTEXTS]; ctx++) {
+    if(!ctx->used) {
+      if(free_ctx == NULL) {
+        free_ctx = ctx;
+      }
+    } else if(ctx->id == id &&
+              uip_ipaddr_cmp(&ctx->srcipaddr, &UIP_IP_BUF->srcipaddr) &&
+              uip_ipaddr_cmp(&ctx->destipaddr, &UIP_IP_BUF->destipaddr)) {
+      return ctx;
+    }
+  }
+
+  if(free_ctx == NULL) {
+    LOG_WARN("No free reassembly context, dropping fragment\n");
+    return NULL;
+  }
+
+  /* We first write the unfragmentable part of IP header into the
+     reassembly context. The reset the other reassembly variables. */
+  LOG_INFO("Starting reassembly\n");
+  ctx = free_ctx;
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->used = 1;
+  ctx->id = id;
+  uip_ipaddr_copy(&ctx->srcipaddr, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&ctx->destipaddr, &UIP_IP_BUF->destipaddr);
+  /* temporary in case we do not receive the fragment with offset 0 first */
+  if(!reass_write(ctx, 0, (uint8_t *)UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN)) {
+    reass_free(ctx);
+    return NULL;
+  }
+  timer_set(&ctx->timer, UIP_REASS_MAXAGE * CLOCK_SECOND);
+  reass_set_timer();
+  return ctx;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reass_discard(struct uip_reass_ctx *ctx)
+{
+  reass_free(ctx);
+  reass_set_timer();
+}
+/*---------------------------------------------------------------------------*/
 static uint16_t
 uip_reass(uint8_t *prev_proto_ptr)
 {
   uint16_t offset=0;
   uint16_t len;
   uint16_t i;
+  struct uip_reass_ctx *ctx;
   struct uip_frag_hdr *frag_buf = (struct uip_frag_hdr *)UIP_IP_PAYLOAD(uip_ext_len);
 
-  /* If ip_reasstmr is zero, no packet is present in the buffer */
-  /* We first write the unfragmentable part of IP header into the reassembly
-     buffer. The reset the other reassembly variables. */
-  if(uip_reass_on == 0) {
-    LOG_INFO("Starting reassembly\n");
-    memcpy(FBUF, UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN);
-    /* temporary in case we do not receive the fragment with offset 0 first */
-    etimer_set(&uip_reass_timer, UIP_REASS_MAXAGE*CLOCK_SECOND);
-    uip_reass_on = 1;
-    uip_reassflags = 0;
-    uip_id = frag_buf->id;
-    /* Clear the bitmap. */
-    memset(uip_reassbitmap, 0, sizeof(uip_reassbitmap));
-  }
+  uip_reassflags = 0;
+
   /*
-   * Check if the incoming fragment matches the one currently present
-   * in the reasembly buffer. If so, we proceed with copying the fragment
-   * into the buffer.
+   * Find the context of the packet this fragment belongs to, or start
+   * reassembling a new packet if there is a free context.
    */
-  if(uip_ipaddr_cmp(&FBUF->srcipaddr, &UIP_IP_BUF->srcipaddr) &&
-     uip_ipaddr_cmp(&FBUF->destipaddr, &UIP_IP_BUF->destipaddr) &&
-     frag_buf->id == uip_id) {
-    len = uip_len - uip_ext_len - UIP_IPH_LEN - UIP_FRAGH_LEN;
-    offset = (uip_ntohs(frag_buf->offsetresmore) & 0xfff8);
-    /* in byte, originaly in multiple of 8 bytes*/
-    LOG_INFO("len %d\n", len);
-    LOG_INFO("offset %d\n", offset);
-    if(offset == 0){
-      uip_reassflags |= UIP_REASS_FLAG_FIRSTFRAG;
-      /*
-       * The Next Header field of the last header of the Unfragmentable
-       * Part is obtained from the Next Header field of the first
-       * fragment's Fragment header.
-       */
-      *prev_proto_ptr = frag_buf->next;
-      memcpy(FBUF, UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN);
-      LOG_INFO("src ");
-      LOG_INFO_6ADDR(&FBUF->srcipaddr);
-      LOG_INFO_("dest ");
-      LOG_INFO_6ADDR(&FBUF->destipaddr);
-      LOG_INFO_("next %d\n", UIP_IP_BUF->proto);
-
-    }
-
-    /* If the offset or the offset + fragment length overflows the
-       reassembly buffer, we discard the entire packet. */
-    if(offset > UIP_REASS_BUFSIZE ||
-       offset + len > UIP_REASS_BUFSIZE) {
-      uip_reass_on = 0;
-      etimer_stop(&uip_reass_timer);
+  ctx = reass_lookup(frag_buf->id);
+  if(ctx == NULL) {
+    return 0;
+  }
+
+  len = uip_len - uip_ext_len - UIP_IPH_LEN - UIP_FRAGH_LEN;
+  offset = (uip_ntohs(frag_buf->offsetresmore) & 0xfff8);
+  /* in byte, originaly in multiple of 8 bytes*/
+  LOG_INFO("len %d\n", len);
+  LOG_INFO("offset %d\n", offset);
+  if(offset == 0){
+    ctx->flags |= UIP_REASS_FLAG_FIRSTFRAG;
+    /*
+     * The Next Header field of the last header of the Unfragmentable
+     * Part is obtained from the Next Header field of the first
+     * fragment's Fragment header.
+     */
+    *prev_proto_ptr = frag_buf->next;
+    if(!reass_write(ctx, 0, (uint8_t *)UIP_IP_BUF,
+                    uip_ext_len + UIP_IPH_LEN)) {
+      reass_discard(ctx);
       return 0;
     }
+    LOG_INFO("src ");
+    LOG_INFO_6ADDR(&ctx->srcipaddr);
+    LOG_INFO_("dest ");
+    LOG_INFO_6ADDR(&ctx->destipaddr);
+    LOG_INFO_("next %d\n", UIP_IP_BUF->proto);
 
-    /* If this fragment has the More Fragments flag set to zero, it is the
-       last fragment*/
-    if((uip_ntohs(frag_buf->offsetresmore) & IP_MF) == 0) {
-      uip_reassflags |= UIP_REASS_FLAG_LASTFRAG;
-      /*calculate the size of the entire packet*/
-      uip_reasslen = offset + len;
-      LOG_INFO("last fragment reasslen %d\n", uip_reasslen);
-    } else {
-      /* If len is not a multiple of 8 octets and the M flag of that fragment
-         is 1, then that fragment must be discarded and an ICMP Parameter
-         Problem, Code 0, message should be sent to the source of the fragment,
-         pointing to the Payload Length field of the fragment packet. */
-      if(len % 8 != 0){
-        uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER, 4);
-        uip_reassflags |= UIP_REASS_FLAG_ERROR_MSG;
-        /* not clear if we should interrupt reassembly, but it seems so from
-           the conformance tests */
-        uip_reass_on = 0;
-        etimer_stop(&uip_reass_timer);
-        return uip_len;
-      }
+  }
+
+  /* If the offset or the offset + fragment length overflows the
+     reassembly buffer, we discard the entire packet. */
+  if(offset > UIP_REASS_BUFSIZE ||
+     UIP_IPH_LEN + uip_ext_len + offset + len > UIP_REASS_BUFSIZE) {
+    reass_discard(ctx);
+    return 0;
+  }
+
+  /* If this fragment has the More Fragments flag set to zero, it is the
+     last fragment*/
+  if((uip_ntohs(frag_buf->offsetresmore) & IP_MF) == 0) {
+    ctx->flags |= UIP_REASS_FLAG_LASTFRAG;
+    /*calculate the size of the entire packet*/
+    ctx->len = offset + len;
+    LOG_INFO("last fragment reasslen %d\n", ctx->len);
+  } else {
+    /* If len is not a multiple of 8 octets and the M flag of that fragment
+       is 1, then that fragment must be discarded and an ICMP Parameter
+       Problem, Code 0, message should be sent to the source of the fragment,
+       pointing to the Payload Length field of the fragment packet. */
+    if(len % 8 != 0){
+      uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER, 4);
+      uip_reassflags |= UIP_REASS_FLAG_ERROR_MSG;
+      /* not clear if we should interrupt reassembly, but it seems so from
+         the conformance tests */
+      reass_discard(ctx);
+      return uip_len;
     }
+  }
 
-    /* Copy the fragment into the reassembly buffer, at the right
-       offset. */
-    memcpy((uint8_t *)FBUF + UIP_IPH_LEN + uip_ext_len + offset,
-           (uint8_t *)frag_buf + UIP_FRAGH_LEN, len);
+  /* Copy the fragment into the reassembly context, at the right
+     offset. If the shared pool is exhausted, the packet can not be
+     completed and is discarded. */
+  if(!reass_write(ctx, UIP_IPH_LEN + uip_ext_len + offset,
+                  (uint8_t *)frag_buf + UIP_FRAGH_LEN, len)) {
+    LOG_WARN("Reassembly pool full, dropping packet\n");
+    reass_discard(ctx);
+    return 0;
+  }
 
-    /* Update the bitmap. */
-    if(offset >> 6 == (offset + len) >> 6) {
-      uip_reassbitmap[offset >> 6] |=
-        bitmap_bits[(offset >> 3) & 7] &
-        ~bitmap_bits[((offset + len) >> 3)  & 7];
-    } else {
-      /* If the two endpoints are in different bytes, we update the
-         bytes in the endpoints and fill the stuff inbetween with
-         0xff. */
-      uip_reassbitmap[offset >> 6] |= bitmap_bits[(offset >> 3) & 7];
+  /* Update the bitmap. */
+  if(offset >> 6 == (offset + len) >> 6) {
+    ctx->bitmap[offset >> 6] |=
+      bitmap_bits[(offset >> 3) & 7] &
+      ~bitmap_bits[((offset + len) >> 3)  & 7];
+  } else {
+    /* If the two endpoints are in different bytes, we update the
+       bytes in the endpoints and fill the stuff inbetween with
+       0xff. */
+    ctx->bitmap[offset >> 6] |= bitmap_bits[(offset >> 3) & 7];
 
-      for(i = (1 + (offset >> 6)); i < ((offset + len) >> 6); ++i) {
-        uip_reassbitmap[i] = 0xff;
-      }
-      uip_reassbitmap[(offset + len) >> 6] |=
-        ~bitmap_bits[((offset + len) >> 3) & 7];
+    for(i = (1 + (offset >> 6)); i < ((offset + len) >> 6); ++i) {
+      ctx->bitmap[i] = 0xff;
     }
+    ctx->bitmap[(offset + len) >> 6] |=
+      ~bitmap_bits[((offset + len) >> 3) & 7];
+  }
 
-    /* Finally, we check if we have a full packet in the buffer. We do
-       this by checking if we have the last fragment and if all bits
-       in the bitmap are set. */
+  /* Finally, we check if we have a full packet in the context. We do
+     this by checking if we have the last fragment and if all bits
+     in the bitmap are set. */
 
-    if(uip_reassflags & UIP_REASS_FLAG_LASTFRAG) {
-      /* Check all bytes up to and including all but the last byte in
-         the bitmap. */
-      for(i = 0; i < (uip_reasslen >> 6); ++i) {
-        if(uip_reassbitmap[i] != 0xff) {
-          return 0;
-        }
-      }
-      /* Check the last byte in the bitmap. It should contain just the
-         right amount of bits. */
-      if(uip_reassbitmap[uip_reasslen >> 6] !=
-         (uint8_t)~bitmap_bits[(uip_reasslen >> 3) & 7]) {
+  if(ctx->flags & UIP_REASS_FLAG_LASTFRAG) {
+    /* Check all bytes up to and including all but the last byte in
+       the bitmap. */
+    for(i = 0; i < (ctx->len >> 6); ++i) {
+      if(ctx->bitmap[i] != 0xff) {
         return 0;
       }
+    }
+    /* Check the last byte in the bitmap. It should contain just the
+       right amount of bits. */
+    if(ctx->bitmap[ctx->len >> 6] !=
+       (uint8_t)~bitmap_bits[(ctx->len >> 3) & 7]) {
+      return 0;
+    }
 
-      /* If we have come this far, we have a full packet in the
-         buffer, so we copy it to uip_buf. We also reset the timer. */
-      uip_reass_on = 0;
-      etimer_stop(&uip_reass_timer);
-
-      uip_reasslen += UIP_IPH_LEN + uip_ext_len;
-      memcpy(UIP_IP_BUF, FBUF, uip_reasslen);
-      uipbuf_set_len_field(UIP_IP_BUF, uip_reasslen - UIP_IPH_LEN);
-      LOG_INFO("reassembled packet %d (%d)\n", uip_reasslen, uipbuf_get_len_field(UIP_IP_BUF));
-
-      return uip_reasslen;
+    /* If we have come this far, we have a full packet in the
+       context, so we copy it to uip_buf. We also free the context. */
+    len = ctx->len + UIP_IPH_LEN + uip_ext_len;
+    reass_read(ctx, (uint8_t *)UIP_IP_BUF, len);
+    reass_discard(ctx);
+    uipbuf_set_len_field(UIP_IP_BUF, len - UIP_IPH_LEN);
+    LOG_INFO("reassembled packet %d (%d)\n", len, uipbuf_get_len_field(UIP_IP_BUF));
 
-    }
-  } else {
-    LOG_WARN("Already reassembling another paquet\n");
+    return len;
   }
   return 0;
 }
@@ -774,12 +1095,23 @@ uip_reass(uint8_t *prev_proto_ptr)
 void
 uip_reass_over(void)
 {
-  /* to late, we abandon the reassembly of the packet */
-
-  uip_reass_on = 0;
-  etimer_stop(&uip_reass_timer);
+  struct uip_reass_ctx *ctx;
+
+  /* Abandon the reassembly of the first packet that timed out. Only
+     one ICMP error can be sent at a time, so the timer is set again
+     for any other context that has expired as well. */
+  for(ctx = uip_reass_ctxs;
+      ctx < &uip_reass_ctxs[UIP_CONF_IPV6_REASS_CONTEXTS]; ctx++) {
+    if(ctx->used && timer_expired(&ctx->timer)) {
+      break;
+    }
+  }
+  if(ctx == &uip_reass_ctxs[UIP_CONF_IPV6_REASS_CONTEXTS]) {
+    reass_set_timer();
+    return;
+  }
 
-  if(uip_reassflags & UIP_REASS_FLAG_FIRSTFRAG){
+  if(ctx->flags & UIP_REASS_FLAG_FIRSTFRAG){
     LOG_ERR("fragmentation timeout\n");
     /* If the first fragment has been received, an ICMP Time Exceeded
        -- Fragment Reassembly Time Exceeded message should be sent to the
@@ -791,12 +1123,17 @@ uip_reass_over(void)
      * the packet.
      */
     uipbuf_clear();
-    memcpy(UIP_IP_BUF, FBUF, UIP_IPH_LEN); /* copy the header for src
-                                              and dest address*/
+    reass_read(ctx, (uint8_t *)UIP_IP_BUF, UIP_IPH_LEN); /* copy the header
+                                                            for src and dest
+                                                            address */
+    reass_discard(ctx);
     uip_icmp6_error_output(ICMP6_TIME_EXCEEDED, ICMP6_TIME_EXCEED_REASSEMBLY, 0);
 
     UIP_STAT(++uip_stat.ip.sent);
     uip_flags = 0;
+  } else {
+    reass_discard(ctx);
+    uipbuf_clear();
   }
 }
 
@@ -951,12 +1288,20 @@ uip_process(uint8_t flag)
   uint8_t protocol;
   uint8_t *next_header;
   struct uip_ext_hdr *ext_ptr;
+#if UIP_CONF_IPV6_REASSEMBLY
+  uint8_t *prev_proto_ptr;
+#endif /* UIP_CONF_IPV6_REASSEMBLY */
 #if UIP_TCP
   int c;
   uint16_t tmp16;
   uint8_t opt;
   register struct uip_conn *uip_connr = uip_conn;
 #endif /* UIP_TCP */
+#if UIP_TCP_SLIDING_WINDOW
+  uint16_t seqoff = 0;
+  uint8_t rexmit_head = 0;
+  struct uip_tcp_segment *seg;
+#endif /* UIP_TCP_SLIDING_WINDOW */
 #if UIP_UDP
   if(flag == UIP_UDP_SEND_CONN) {
     goto udp_send;
@@ -968,6 +1313,20 @@ uip_process(uint8_t flag)
      particular connection. */
   if(flag == UIP_POLL_REQUEST) {
 #if UIP_TCP
+#if UIP_TCP_SLIDING_WINDOW
+    if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+       (uip_connr->wflags & UIP_TCP_WINDOW_ENABLED)) {
+      /* With the sliding window, the application is polled whenever
+         the window has room for more data. */
+      uip_connr->wflags &= ~UIP_TCP_WINDOW_REPOLL;
+      if(tcp_window_open(uip_connr)) {
+        uip_flags = UIP_POLL;
+        UIP_APPCALL();
+        goto appsend;
+      }
+      goto drop;
+    }
+#endif /* UIP_TCP_SLIDING_WINDOW */
     if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
        !uip_outstanding(uip_connr)) {
       uip_flags = UIP_POLL;
@@ -1065,6 +1424,17 @@ uip_process(uint8_t flag)
 #endif /* UIP_ACTIVE_OPEN */
 
           case UIP_ESTABLISHED:
+#if UIP_TCP_SLIDING_WINDOW
+            /*
+             * With the sliding window, the oldest outstanding segment
+             * is retransmitted from the retransmission buffer.
+             */
+            if(uip_connr->wflags & UIP_TCP_WINDOW_ENABLED) {
+              uip_connr->wflags |= UIP_TCP_WINDOW_RECOVERY;
+              uip_connr->dupacks = 0;
+              goto tcp_window_rexmit;
+            }
+#endif /* UIP_TCP_SLIDING_WINDOW */
             /*
              * In the ESTABLISHED state, we call upon the application
              * to do the actual retransmit after which we jump into
@@ -1081,12 +1451,30 @@ uip_process(uint8_t flag)
             /* In all these states we should retransmit a FINACK. */
             goto tcp_send_finack;
           }
+#if UIP_TCP_SLIDING_WINDOW
+        } else if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+                  (uip_connr->wflags & UIP_TCP_WINDOW_ENABLED) &&
+                  tcp_window_open(uip_connr)) {
+          /*
+           * The window still has room for more data, so we poll the
+           * application even though data is outstanding.
+           */
+          uip_connr->wflags &= ~UIP_TCP_WINDOW_REPOLL;
+          uip_flags = UIP_POLL;
+          UIP_APPCALL();
+          goto appsend;
+#endif /* UIP_TCP_SLIDING_WINDOW */
         }
       } else if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
         /*
          * If there was no need for a retransmission, we poll the
          * application for new data.
          */
+#if UIP_TCP_SLIDING_WINDOW
+        if(uip_connr->wflags & UIP_TCP_WINDOW_ENABLED) {
+          tcp_window_open(uip_connr);
+        }
+#endif /* UIP_TCP_SLIDING_WINDOW */
         uip_flags = UIP_POLL;
         UIP_APPCALL();
         goto appsend;
@@ -1286,6 +1674,9 @@ uip_process(uint8_t flag)
 #endif /* UIP_IPV6_MULTICAST && UIP_CONF_ROUTER */
 
   /* IPv6 extension header processing: loop until reaching upper-layer protocol */
+#if UIP_CONF_IPV6_REASSEMBLY
+  ext_hdr_process:
+#endif /* UIP_CONF_IPV6_REASSEMBLY */
   uip_ext_bitmap = 0;
   for(next_header = uipbuf_get_next_header(uip_buf, uip_len, &protocol, true);
       next_header != NULL && uip_is_proto_ext_hdr(protocol);
@@ -1384,7 +1775,17 @@ uip_process(uint8_t flag)
       /* Fragmentation header:call the reassembly function, then leave */
 #if UIP_CONF_IPV6_REASSEMBLY
       LOG_INFO("Processing fragmentation header\n");
-      uip_len = uip_reass(&ext_ptr->next);
+      /* The unfragmentable part ends where the fragment header starts */
+      uip_ext_len = next_header - UIP_IP_PAYLOAD(0);
+      /* Find the Next Header field that refers to the fragment header */
+      prev_proto_ptr = &UIP_IP_BUF->proto;
+      for(ext_ptr = (struct uip_ext_hdr *)UIP_IP_PAYLOAD(0);
+          (uint8_t *)ext_ptr < next_header;
+          ext_ptr = (struct uip_ext_hdr *)((uint8_t *)ext_ptr +
+                                           (ext_ptr->len + 1) * 8)) {
+        prev_proto_ptr = &ext_ptr->next;
+      }
+      uip_len = uip_reass(prev_proto_ptr);
       if(uip_len == 0) {
         goto drop;
       }
@@ -1394,9 +1795,14 @@ uip_process(uint8_t flag)
       }
       /* packet is reassembled. Restart the parsing of the reassembled pkt */
       LOG_INFO("Processing reassembled packet\n");
-      uip_ext_bitmap = 0;
-      next_header = uipbuf_get_next_header(uip_buf, uip_len, &protocol, true);
-      break;
+      uip_last_proto = 0;
+      last_header = uipbuf_get_last_header(uip_buf, uip_len, &uip_last_proto);
+      if(last_header == NULL) {
+        LOG_ERR("invalid extension header chain\n");
+        goto drop;
+      }
+      uip_ext_len = last_header - UIP_IP_PAYLOAD(0);
+      goto ext_hdr_process;
 #else /* UIP_CONF_IPV6_REASSEMBLY */
       UIP_STAT(++uip_stat.ip.drop);
       UIP_STAT(++uip_stat.ip.fragerr);
@@ -1758,6 +2164,9 @@ uip_process(uint8_t flag)
   uip_connr->snd_nxt[2] = iss[2];
   uip_connr->snd_nxt[3] = iss[3];
   uip_connr->len = 1;
+#if UIP_TCP_SLIDING_WINDOW
+  tcp_window_reset(uip_connr);
+#endif /* UIP_TCP_SLIDING_WINDOW */
 
   /* rcv_nxt should be the seqno from the incoming packet + 1. */
   uip_connr->rcv_nxt[0] = UIP_TCP_BUF->seqno[0];
@@ -1877,6 +2286,13 @@ uip_process(uint8_t flag)
      data. If so, we update the sequence number, reset the length of
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
+#if UIP_TCP_SLIDING_WINDOW
+  if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr) &&
+     (uip_connr->wflags & UIP_TCP_WINDOW_ENABLED) &&
+     (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+    rexmit_head = tcp_window_acked(uip_connr);
+  } else
+#endif /* UIP_TCP_SLIDING_WINDOW */
   if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
@@ -1892,18 +2308,7 @@ uip_process(uint8_t flag)
 
       /* Do RTT estimation, unless we have done retransmissions. */
       if(uip_connr->nrtx == 0) {
-        signed char m;
-        m = uip_connr->rto - uip_connr->timer;
-        /* This is taken directly from VJs original code in his paper */
-        m = m - (uip_connr->sa >> 3);
-        uip_connr->sa += m;
-        if(m < 0) {
-          m = -m;
-        }
-        m = m - (uip_connr->sv >> 2);
-        uip_connr->sv += m;
-        uip_connr->rto = (uip_connr->sa >> 3) + uip_connr->sv;
-
+        uip_update_rtt(uip_connr);
       }
       /* Set the acknowledged flag. */
       uip_flags = UIP_ACKDATA;
@@ -2084,11 +2489,28 @@ uip_process(uint8_t flag)
          "persistent timer" and uses the retransmission mechanim.
      */
     tmp16 = ((uint16_t)UIP_TCP_BUF->wnd[0] << 8) + (uint16_t)UIP_TCP_BUF->wnd[1];
-    if(tmp16 > uip_connr->initialmss ||
-        tmp16 == 0) {
-      tmp16 = uip_connr->initialmss;
+#if UIP_TCP_SLIDING_WINDOW
+    if(uip_connr->wflags & UIP_TCP_WINDOW_ENABLED) {
+      /* With the sliding window, the MSS is the amount of new data
+         that fits in the peer's window. No new data is accepted from
+         the application while a retransmission is pending. */
+      uip_connr->snd_wnd = tmp16;
+      tcp_window_open(uip_connr);
+      if(rexmit_head) {
+        uip_connr->mss = 0;
+        if(!(uip_flags & (UIP_NEWDATA | UIP_ACKDATA))) {
+          goto tcp_window_rexmit;
+        }
+      }
+    } else
+#endif /* UIP_TCP_SLIDING_WINDOW */
+    {
+      if(tmp16 > uip_connr->initialmss ||
+         tmp16 == 0) {
+        tmp16 = uip_connr->initialmss;
+      }
+      uip_connr->mss = tmp16;
     }
-    uip_connr->mss = tmp16;
 
     /* If this packet constitutes an ACK for outstanding data (flagged
          by the UIP_ACKDATA flag, we should call the application since it
@@ -2119,6 +2541,13 @@ uip_process(uint8_t flag)
         goto tcp_send_nodata;
       }
 
+#if UIP_TCP_SLIDING_WINDOW
+      if((uip_flags & UIP_CLOSE) && uip_connr->seg_count > 0) {
+        /* The FIN can only be sent once all data has been acknowledged. */
+        uip_flags &= ~UIP_CLOSE;
+      }
+#endif /* UIP_TCP_SLIDING_WINDOW */
+
       if(uip_flags & UIP_CLOSE) {
         uip_slen = 0;
         uip_connr->len = 1;
@@ -2128,6 +2557,31 @@ uip_process(uint8_t flag)
         goto tcp_send_nodata;
       }
 
+#if UIP_TCP_SLIDING_WINDOW
+      if(uip_connr->wflags & UIP_TCP_WINDOW_ENABLED) {
+        /* With the sliding window, new data is queued behind the data
+           already in flight, and retransmissions are served from the
+           retransmission buffer. */
+        if(rexmit_head) {
+          goto tcp_window_rexmit;
+        }
+        uip_appdata = uip_sappdata;
+        if(uip_slen > 0) {
+          seqoff = uip_connr->len;
+          uip_slen = tcp_window_queue(uip_connr, uip_slen);
+        }
+        if(uip_slen > 0) {
+          uip_len = uip_slen + UIP_IPTCPH_LEN;
+          UIP_TCP_BUF->flags = TCP_ACK | TCP_PSH;
+          goto tcp_send_noopts;
+        }
+        if(uip_flags & UIP_NEWDATA) {
+          goto tcp_send_ack;
+        }
+        goto drop;
+      }
+#endif /* UIP_TCP_SLIDING_WINDOW */
+
       /* If uip_slen > 0, the application has data to be sent. */
       if(uip_slen > 0) {
 
@@ -2250,6 +2704,22 @@ uip_process(uint8_t flag)
   }
   goto drop;
 
+#if UIP_TCP_SLIDING_WINDOW
+  /* We jump here to retransmit the oldest unacknowledged segment from
+     the retransmission buffer of a connection, without involving the
+     application. */
+  tcp_window_rexmit:
+  if(uip_connr->seg_count == 0) {
+    goto drop;
+  }
+  seg = &uip_connr->segs[uip_connr->seg_first];
+  memcpy(&uip_buf[UIP_IPTCPH_LEN], seg->data, seg->len);
+  uip_len = seg->len + UIP_IPTCPH_LEN;
+  seqoff = 0;
+  UIP_TCP_BUF->flags = TCP_ACK | TCP_PSH;
+  goto tcp_send_noopts;
+#endif /* UIP_TCP_SLIDING_WINDOW */
+
   /* We jump here when we are ready to send the packet, and just want
      to set the appropriate TCP sequence numbers in the TCP header. */
   tcp_send_ack:
@@ -2277,6 +2747,13 @@ uip_process(uint8_t flag)
   UIP_TCP_BUF->seqno[1] = uip_connr->snd_nxt[1];
   UIP_TCP_BUF->seqno[2] = uip_connr->snd_nxt[2];
   UIP_TCP_BUF->seqno[3] = uip_connr->snd_nxt[3];
+#if UIP_TCP_SLIDING_WINDOW
+  if(seqoff > 0) {
+    /* New data is sent after the data that is already in flight. */
+    uip_add32(UIP_TCP_BUF->seqno, seqoff);
+    memcpy(UIP_TCP_BUF->seqno, uip_acc32, sizeof(UIP_TCP_BUF->seqno));
+  }
+#endif /* UIP_TCP_SLIDING_WINDOW */
 
   UIP_TCP_BUF->srcport  = uip_connr->lport;
   UIP_TCP_BUF->destport = uip_connr->rport;
@@ -186,6 +186,9 @@ void uipbuf_init(void);
 #define UIPBUF_ATTR_FLAGS_6LOWPAN_NO_NHC_COMPRESSION      0x01
 /* Avoid using prefix compression on the packet (6LoWPAN) */
 #define UIPBUF_ATTR_FLAGS_6LOWPAN_NO_PREFIX_COMPRESSION   0x02
+/* Only the first fragment of the packet is there, 6LoWPAN relays the
+   rest: send it right away or drop it, never queue it (6LoWPAN) */
+#define UIPBUF_ATTR_FLAGS_6LOWPAN_PARTIAL                 0x04
 
 /* MAC will set the default for this packet */
 #define UIPBUF_ATTR_LLSEC_LEVEL_MAC_DEFAULT               0xffff
@@ -201,6 +204,7 @@ enum {
   UIPBUF_ATTR_PHYSICAL_NETWORK_ID, /**< Physical network ID (mapped to PAN ID)*/
   UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS, /**< MAX transmissions of the packet MAC */
   UIPBUF_ATTR_FLAGS,   /**< Flags that can control lower layers.  see above. */
+  UIPBUF_ATTR_PRIORITY, /**< MAC priority, see PACKETBUF_ATTR_PRIORITY */
   UIPBUF_ATTR_MAX
 };
 
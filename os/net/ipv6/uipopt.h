@@ -242,6 +242,23 @@ void uip_log(char *msg);
 #define UIP_CONF_IPV6_REASSEMBLY      0
 #endif
 
+#ifndef UIP_CONF_IPV6_REASS_CONTEXTS
+/** Number of IPv6 packets that can be reassembled concurrently, each
+    identified by its source, destination and fragment Identification */
+#define UIP_CONF_IPV6_REASS_CONTEXTS  2
+#endif
+
+#ifndef UIP_CONF_IPV6_REASS_BLOCK_SIZE
+/** Size of the blocks in which reassembly contexts store fragments */
+#define UIP_CONF_IPV6_REASS_BLOCK_SIZE 128
+#endif
+
+#ifndef UIP_CONF_IPV6_REASS_POOL_SIZE
+/** Total number of bytes shared by all reassembly contexts; a packet
+    whose fragments do not fit in the pool is discarded */
+#define UIP_CONF_IPV6_REASS_POOL_SIZE (2 * UIP_BUFSIZE)
+#endif
+
 #ifndef UIP_CONF_NETIF_MAX_ADDRESSES
 /** Default number of IPv6 addresses associated to the node's interface */
 #define UIP_CONF_NETIF_MAX_ADDRESSES  3
@@ -440,6 +457,45 @@ void uip_log(char *msg);
 #define UIP_RECEIVE_WINDOW (UIP_CONF_RECEIVE_WINDOW)
 #endif
 
+/**
+ * The maximum number of unacknowledged segments per TCP connection.
+ *
+ * By default, uIP only has a single segment in flight per connection,
+ * which limits the throughput to one MSS per round-trip time. Setting
+ * this to a value larger than one compiles in a sliding window: each
+ * segment sent on a connection that has called uip_window_enable() is
+ * kept in a per-connection retransmission buffer, so that several
+ * segments can be outstanding and retransmissions no longer involve
+ * the application.
+ *
+ * Each TCP connection requires UIP_TCP_WINDOW_SEGMENTS * UIP_TCP_MSS
+ * additional bytes of memory, so UIP_CONF_TCP_CONNS should typically
+ * be reduced when this is enabled.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_WINDOW_SEGMENTS
+#define UIP_TCP_WINDOW_SEGMENTS (UIP_CONF_TCP_WINDOW_SEGMENTS)
+#else
+#define UIP_TCP_WINDOW_SEGMENTS 1
+#endif
+
+/**
+ * Set to 1 when the sliding window is compiled in.
+ */
+#define UIP_TCP_SLIDING_WINDOW (UIP_TCP && UIP_TCP_WINDOW_SEGMENTS > 1)
+
+/**
+ * The number of duplicate ACKs after which the oldest outstanding
+ * segment is retransmitted without waiting for the retransmission
+ * timer (fast retransmit). Only used with the sliding window.
+ */
+#ifdef UIP_CONF_TCP_DUPACK_THRESHOLD
+#define UIP_TCP_DUPACK_THRESHOLD (UIP_CONF_TCP_DUPACK_THRESHOLD)
+#else
+#define UIP_TCP_DUPACK_THRESHOLD 3
+#endif
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
@@ -559,6 +615,15 @@ void uip_log(char *msg);
 #define SICSLOWPAN_CONF_FRAG  1
 #endif
 
+/**
+ * Do we keep statistics of the fragment reassembly and header compression
+ */
+#ifdef SICSLOWPAN_CONF_STATS
+#define SICSLOWPAN_STATS SICSLOWPAN_CONF_STATS
+#else
+#define SICSLOWPAN_STATS 0
+#endif /* SICSLOWPAN_CONF_STATS */
+
 /** @} */
 
 /*------------------------------------------------------------------------------*/
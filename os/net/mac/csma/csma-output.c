@@ -51,6 +51,8 @@
 #include "lib/list.h"
 #include "lib/memb.h"
 #include "lib/assert.h"
+#include "sys/trace.h"
+#include <string.h>
 
 /* Log configuration */
 #include "sys/log.h"
@@ -91,19 +93,31 @@
 struct qbuf_metadata {
   mac_callback_t sent;
   void *cptr;
+#if CSMA_CONF_STATS
+  clock_time_t queued_at;
+#endif /* CSMA_CONF_STATS */
   uint8_t max_transmissions;
 };
 
-/* Every neighbor has its own packet queue */
+/*
+ * Every neighbor has its own packet queues, one per priority class. The
+ * storage of the lists is kept in packet_queue_list, as with LIST_STRUCT.
+ */
 struct neighbor_queue {
   struct neighbor_queue *next;
   linkaddr_t addr;
   struct ctimer transmit_timer;
+  /* The packet being transmitted, which the counters below refer to */
+  struct packet_queue *current;
   uint8_t transmissions;
   uint8_t collisions;
-  LIST_STRUCT(packet_queue);
+  /* Number of packets in all the queues */
+  uint8_t queued;
+  void *packet_queue_list[CSMA_PRIORITY_CLASSES];
 };
 
+#define PACKET_QUEUE(n, class) ((list_t)&(n)->packet_queue_list[class])
+
 /* The maximum number of co-existing neighbor queues */
 #ifdef CSMA_CONF_MAX_NEIGHBOR_QUEUES
 #define CSMA_MAX_NEIGHBOR_QUEUES CSMA_CONF_MAX_NEIGHBOR_QUEUES
@@ -120,17 +134,46 @@ struct neighbor_queue {
 
 #define MAX_QUEUED_PACKETS QUEUEBUF_NUM
 
+/*
+ * Number of buckets of the hash table indexing the neighbor queues by
+ * link-layer address.
+ */
+#ifdef CSMA_CONF_NEIGHBOR_HASH_SIZE
+#define CSMA_NEIGHBOR_HASH_SIZE CSMA_CONF_NEIGHBOR_HASH_SIZE
+#elif CSMA_MAX_NEIGHBOR_QUEUES < 8
+#define CSMA_NEIGHBOR_HASH_SIZE CSMA_MAX_NEIGHBOR_QUEUES
+#else
+#define CSMA_NEIGHBOR_HASH_SIZE 8
+#endif /* CSMA_CONF_NEIGHBOR_HASH_SIZE */
+
+/*
+ * Number of packets of the pool that only the highest priority class may
+ * use, with several priority classes. This keeps room for control traffic
+ * when bulk traffic fills the queues.
+ */
+#ifdef CSMA_CONF_PRIORITY_RESERVE
+#define CSMA_PRIORITY_RESERVE CSMA_CONF_PRIORITY_RESERVE
+#else
+#define CSMA_PRIORITY_RESERVE 0
+#endif /* CSMA_CONF_PRIORITY_RESERVE */
+
 /* Neighbor packet queue */
 struct packet_queue {
   struct packet_queue *next;
   struct queuebuf *buf;
   void *ptr;
+  uint8_t class;
 };
 
 MEMB(neighbor_memb, struct neighbor_queue, CSMA_MAX_NEIGHBOR_QUEUES);
 MEMB(packet_memb, struct packet_queue, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
-LIST(neighbor_list);
+
+static struct neighbor_queue *neighbor_hash[CSMA_NEIGHBOR_HASH_SIZE];
+
+#if CSMA_CONF_STATS
+struct csma_class_stats csma_class_stats[CSMA_PRIORITY_CLASSES];
+#endif /* CSMA_CONF_STATS */
 
 static void packet_sent(struct neighbor_queue *n,
     struct packet_queue *q,
@@ -138,19 +181,81 @@ static void packet_sent(struct neighbor_queue *n,
     int num_transmissions);
 static void transmit_from_queue(void *ptr);
 /*---------------------------------------------------------------------------*/
+static uint8_t
+addr_hash(const linkaddr_t *addr)
+{
+  uint8_t i;
+  uint16_t h = 0;
+
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h << 3) ^ (h >> 13) ^ addr->u8[i];
+  }
+  return h % CSMA_NEIGHBOR_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
 static struct neighbor_queue *
 neighbor_queue_from_addr(const linkaddr_t *addr)
 {
-  struct neighbor_queue *n = list_head(neighbor_list);
-  while(n != NULL) {
+  struct neighbor_queue *n;
+
+  for(n = neighbor_hash[addr_hash(addr)]; n != NULL; n = n->next) {
     if(linkaddr_cmp(&n->addr, addr)) {
       return n;
     }
-    n = list_item_next(n);
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static void
+neighbor_queue_free(struct neighbor_queue *n)
+{
+  struct neighbor_queue **np;
+
+  for(np = &neighbor_hash[addr_hash(&n->addr)]; *np != NULL; np = &(*np)->next) {
+    if(*np == n) {
+      *np = n->next;
+      break;
+    }
+  }
+  memb_free(&neighbor_memb, n);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+priority_class(void)
+{
+  uint16_t priority = packetbuf_attr(PACKETBUF_ATTR_PRIORITY);
+
+  return MIN(priority, CSMA_PRIORITY_CLASSES - 1);
+}
+/*---------------------------------------------------------------------------*/
+/* The packet to send next: the one being retried if any, or the first
+ * packet of the highest priority class */
+static struct packet_queue *
+next_packet(struct neighbor_queue *n)
+{
+  int class;
+
+  if(n->current == NULL) {
+    for(class = CSMA_PRIORITY_CLASSES - 1; class >= 0; class--) {
+      n->current = list_head(PACKET_QUEUE(n, class));
+      if(n->current != NULL) {
+#if CSMA_CONF_STATS
+        struct qbuf_metadata *metadata = n->current->ptr;
+        struct csma_class_stats *stats = &csma_class_stats[class];
+        clock_time_t delay = clock_time() - metadata->queued_at;
+
+        stats->queue_delay_total += delay;
+        if(delay > stats->queue_delay_max) {
+          stats->queue_delay_max = delay;
+        }
+#endif /* CSMA_CONF_STATS */
+        break;
+      }
+    }
+  }
+  return n->current;
+}
+/*---------------------------------------------------------------------------*/
 static clock_time_t
 backoff_period(void)
 {
@@ -171,6 +276,8 @@ send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
   int ret;
   int last_sent_ok = 0;
 
+  TRACE_BEGIN(CSMA_TX, packetbuf_attr(PACKETBUF_ATTR_TRACE_ID));
+
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
 
@@ -249,6 +356,7 @@ send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
     last_sent_ok = 1;
   }
 
+  TRACE_END(CSMA_TX, ret);
   packet_sent(n, q, ret, 1);
   return last_sent_ok;
 }
@@ -257,18 +365,49 @@ static void
 transmit_from_queue(void *ptr)
 {
   struct neighbor_queue *n = ptr;
-  if(n) {
-    struct packet_queue *q = list_head(n->packet_queue);
-    if(q != NULL) {
-      LOG_INFO("preparing packet for ");
-      LOG_INFO_LLADDR(&n->addr);
-      LOG_INFO_(", seqno %u, tx %u, queue %d\n",
-        queuebuf_attr(q->buf, PACKETBUF_ATTR_MAC_SEQNO),
-        n->transmissions, list_length(n->packet_queue));
-      /* Send first packet in the neighbor queue */
-      queuebuf_to_packetbuf(q->buf);
-      send_one_packet(n, q);
+  struct packet_queue *q;
+#if CSMA_BURST_MAX_FRAMES > 1
+  uint8_t burst = 1;
+  linkaddr_t addr;
+  rtimer_clock_t ifs;
+  int pending;
+#endif /* CSMA_BURST_MAX_FRAMES > 1 */
+
+  while(n != NULL && (q = next_packet(n)) != NULL) {
+    LOG_INFO("preparing packet for ");
+    LOG_INFO_LLADDR(&n->addr);
+    LOG_INFO_(", seqno %u, class %u, tx %u, queue %d\n",
+      queuebuf_attr(q->buf, PACKETBUF_ATTR_MAC_SEQNO), q->class,
+      n->transmissions, n->queued);
+    /* Send first packet in the neighbor queue */
+    queuebuf_to_packetbuf(q->buf);
+#if CSMA_BURST_MAX_FRAMES > 1
+    /* Announce the next frame of the burst, if any */
+    pending = burst < CSMA_BURST_MAX_FRAMES && n->queued > 1 &&
+      !packetbuf_holds_broadcast();
+    packetbuf_set_attr(PACKETBUF_ATTR_PENDING, pending);
+    ifs = packetbuf_datalen() + NETSTACK_FRAMER.length() > CSMA_MAX_SIFS_FRAME_SIZE ?
+      CSMA_LIFS_TIME : CSMA_SIFS_TIME;
+    linkaddr_copy(&addr, &n->addr);
+
+    if(!send_one_packet(n, q) || !pending) {
+      return;
     }
+
+    /* The frame was acknowledged, we still hold the channel. The sent
+       callback may have freed the neighbor queue, look it up again. */
+    n = neighbor_queue_from_addr(&addr);
+    if(n != NULL) {
+      /* Skip the backoff scheduled for the next frame */
+      ctimer_stop(&n->transmit_timer);
+      RTIMER_BUSYWAIT(ifs);
+      burst++;
+      LOG_DBG("burst: frame %u\n", burst);
+    }
+#else /* CSMA_BURST_MAX_FRAMES > 1 */
+    send_one_packet(n, q);
+    return;
+#endif /* CSMA_BURST_MAX_FRAMES > 1 */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -297,14 +436,26 @@ free_packet(struct neighbor_queue *n, struct packet_queue *p, int status)
 {
   if(p != NULL) {
     /* Remove packet from queue and deallocate */
-    list_remove(n->packet_queue, p);
+    list_remove(PACKET_QUEUE(n, p->class), p);
+    n->queued--;
+    if(n->current == p) {
+      n->current = NULL;
+    }
+
+#if CSMA_CONF_STATS
+    if(status == MAC_TX_OK) {
+      csma_class_stats[p->class].sent++;
+    } else {
+      csma_class_stats[p->class].failed++;
+    }
+#endif /* CSMA_CONF_STATS */
 
     queuebuf_free(p->buf);
     memb_free(&metadata_memb, p->ptr);
     memb_free(&packet_memb, p);
     LOG_DBG("free_queued_packet, queue length %d, free packets %d\n",
-           list_length(n->packet_queue), memb_numfree(&packet_memb));
-    if(list_head(n->packet_queue) != NULL) {
+           n->queued, memb_numfree(&packet_memb));
+    if(n->queued > 0) {
       /* There is a next packet. We reset current tx information */
       n->transmissions = 0;
       n->collisions = 0;
@@ -313,8 +464,7 @@ free_packet(struct neighbor_queue *n, struct packet_queue *p, int status)
     } else {
       /* This was the last packet in the queue, we free the neighbor */
       ctimer_stop(&n->transmit_timer);
-      list_remove(neighbor_list, n);
-      memb_free(&neighbor_memb, n);
+      neighbor_queue_free(n);
     }
   }
 }
@@ -338,6 +488,7 @@ tx_done(int status, struct packet_queue *q, struct neighbor_queue *n)
               packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO),
               status, n->transmissions, n->collisions);
 
+  TRACE_ASYNC_END(FRAME, queuebuf_attr(q->buf, PACKETBUF_ATTR_TRACE_ID), status);
   free_packet(n, q, status);
   mac_call_sent_callback(sent, cptr, status, ntx);
 }
@@ -442,6 +593,9 @@ csma_output_packet(mac_callback_t sent, void *ptr)
 {
   struct packet_queue *q;
   struct neighbor_queue *n;
+  uint8_t class;
+  uint8_t reserve;
+  int i;
   static uint8_t initialized = 0;
   static uint8_t seqno;
   const linkaddr_t *addr = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
@@ -460,6 +614,10 @@ csma_output_packet(mac_callback_t sent, void *ptr)
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seqno++);
   packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
 
+  /* Lower priority classes leave some room for the highest one */
+  class = priority_class();
+  reserve = class < CSMA_PRIORITY_CLASSES - 1 ? CSMA_PRIORITY_RESERVE : 0;
+
   /* Look for the neighbor entry */
   n = neighbor_queue_from_addr(addr);
   if(n == NULL) {
@@ -468,18 +626,27 @@ csma_output_packet(mac_callback_t sent, void *ptr)
     if(n != NULL) {
       /* Init neighbor entry */
       linkaddr_copy(&n->addr, addr);
+      n->current = NULL;
       n->transmissions = 0;
       n->collisions = 0;
-      /* Init packet queue for this neighbor */
-      LIST_STRUCT_INIT(n, packet_queue);
-      /* Add neighbor to the neighbor list */
-      list_add(neighbor_list, n);
+      n->queued = 0;
+      /* Init packet queues for this neighbor */
+      for(i = 0; i < CSMA_PRIORITY_CLASSES; i++) {
+        list_init(PACKET_QUEUE(n, i));
+      }
+      /* Add neighbor to the hash table */
+      n->next = neighbor_hash[addr_hash(addr)];
+      neighbor_hash[addr_hash(addr)] = n;
     }
   }
 
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
-    if(list_length(n->packet_queue) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+    if(n->queued >= CSMA_MAX_PACKET_PER_NEIGHBOR) {
+      LOG_WARN("Neighbor queue full\n");
+    } else if(memb_numfree(&packet_memb) <= reserve) {
+      LOG_WARN("Queues full for priority class %u\n", class);
+    } else {
       q = memb_alloc(&packet_memb);
       if(q != NULL) {
         q->ptr = memb_alloc(&metadata_memb);
@@ -495,16 +662,24 @@ csma_output_packet(mac_callback_t sent, void *ptr)
             }
             metadata->sent = sent;
             metadata->cptr = ptr;
-            list_add(n->packet_queue, q);
+#if CSMA_CONF_STATS
+            metadata->queued_at = clock_time();
+            csma_class_stats[class].queued++;
+#endif /* CSMA_CONF_STATS */
+            q->class = class;
+            list_add(PACKET_QUEUE(n, class), q);
+            n->queued++;
+            TRACE_ASYNC_STEP(CSMA_QUEUED, packetbuf_attr(PACKETBUF_ATTR_TRACE_ID),
+                             n->queued);
 
             LOG_INFO("sending to ");
             LOG_INFO_LLADDR(addr);
-            LOG_INFO_(", len %u, seqno %u, queue length %d, free packets %d\n",
+            LOG_INFO_(", len %u, seqno %u, class %u, queue length %d, free packets %d\n",
                     packetbuf_datalen(),
-                    packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO),
-                    list_length(n->packet_queue), memb_numfree(&packet_memb));
-            /* If q is the first packet in the neighbor's queue, send asap */
-            if(list_head(n->packet_queue) == q) {
+                    packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO), class,
+                    n->queued, memb_numfree(&packet_memb));
+            /* If q is the only packet of the neighbor, send asap */
+            if(n->queued == 1) {
               schedule_transmission(n);
             }
             return;
@@ -515,18 +690,17 @@ csma_output_packet(mac_callback_t sent, void *ptr)
         memb_free(&packet_memb, q);
         LOG_WARN("could not allocate queuebuf, dropping packet\n");
       }
-      /* The packet allocation failed. Remove and free neighbor entry if empty. */
-      if(list_length(n->packet_queue) == 0) {
-        list_remove(neighbor_list, n);
-        memb_free(&neighbor_memb, n);
-      }
-    } else {
-      LOG_WARN("Neighbor queue full\n");
+    }
+    /* The packet allocation failed. Remove and free neighbor entry if empty. */
+    if(n->queued == 0) {
+      neighbor_queue_free(n);
     }
     LOG_WARN("could not allocate packet, dropping packet\n");
   } else {
     LOG_WARN("could not allocate neighbor, dropping packet\n");
   }
+  CSMA_STAT(csma_class_stats[class].dropped++);
+  TRACE_ASYNC_END(FRAME, packetbuf_attr(PACKETBUF_ATTR_TRACE_ID), MAC_TX_ERR);
   mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
 }
 /*---------------------------------------------------------------------------*/
@@ -536,4 +710,5 @@ csma_output_init(void)
   memb_init(&packet_memb);
   memb_init(&metadata_memb);
   memb_init(&neighbor_memb);
+  memset(neighbor_hash, 0, sizeof(neighbor_hash));
 }
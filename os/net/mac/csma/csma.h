@@ -74,6 +74,75 @@
 
 #define CSMA_ACK_LEN 3
 
+/*
+ * Maximum number of frames sent to a neighbor in a burst: once a unicast
+ * frame is acknowledged, the next frames queued for the same neighbor
+ * follow after an interframe space instead of a new backoff, with the
+ * frame pending bit set on all but the last one. 1 disables bursts.
+ */
+#ifdef CSMA_CONF_BURST_MAX_FRAMES
+#define CSMA_BURST_MAX_FRAMES CSMA_CONF_BURST_MAX_FRAMES
+#else /* CSMA_CONF_BURST_MAX_FRAMES */
+#define CSMA_BURST_MAX_FRAMES 1
+#endif /* CSMA_CONF_BURST_MAX_FRAMES */
+
+/* Interframe spaces within a burst: macSIFSPeriod (12 symbols) after
+   frames of at most aMaxSIFSFrameSize bytes, macLIFSPeriod (40 symbols)
+   after longer ones */
+#ifdef CSMA_CONF_SIFS_TIME
+#define CSMA_SIFS_TIME CSMA_CONF_SIFS_TIME
+#else /* CSMA_CONF_SIFS_TIME */
+#define CSMA_SIFS_TIME                          RTIMER_SECOND / 5208
+#endif /* CSMA_CONF_SIFS_TIME */
+
+#ifdef CSMA_CONF_LIFS_TIME
+#define CSMA_LIFS_TIME CSMA_CONF_LIFS_TIME
+#else /* CSMA_CONF_LIFS_TIME */
+#define CSMA_LIFS_TIME                          RTIMER_SECOND / 1562
+#endif /* CSMA_CONF_LIFS_TIME */
+
+#define CSMA_MAX_SIFS_FRAME_SIZE 18
+
+/*
+ * Number of priority classes, each with its own queue per neighbor. The
+ * class of a frame is its PACKETBUF_ATTR_PRIORITY, capped to the highest
+ * class. A neighbor sends the first frame of its highest non-empty class
+ * once the frame being retried, if any, is done.
+ */
+#ifdef CSMA_CONF_PRIORITY_CLASSES
+#define CSMA_PRIORITY_CLASSES CSMA_CONF_PRIORITY_CLASSES
+#else /* CSMA_CONF_PRIORITY_CLASSES */
+#define CSMA_PRIORITY_CLASSES 1
+#endif /* CSMA_CONF_PRIORITY_CLASSES */
+
+#ifndef CSMA_CONF_STATS
+#define CSMA_CONF_STATS 0
+#endif /* CSMA_CONF_STATS */
+
+#if CSMA_CONF_STATS
+/** Statistics of the queues of a priority class */
+struct csma_class_stats {
+  /** Frames queued */
+  uint16_t queued;
+  /** Frames dropped because they could not be queued */
+  uint16_t dropped;
+  /** Frames sent and acknowledged (or broadcast) */
+  uint16_t sent;
+  /** Frames given up on after collisions, missing acks or errors */
+  uint16_t failed;
+  /** Total and maximum time from queueing to the first transmission
+      attempt, in clock ticks */
+  uint32_t queue_delay_total;
+  clock_time_t queue_delay_max;
+};
+
+extern struct csma_class_stats csma_class_stats[CSMA_PRIORITY_CLASSES];
+
+#define CSMA_STAT(code) (code)
+#else
+#define CSMA_STAT(code)
+#endif /* CSMA_CONF_STATS */
+
 /* just a default - with LLSEC, etc */
 #define CSMA_MAC_MAX_HEADER 21
 
@@ -340,163 +340,47 @@ frame80215e_create_ie_tsch_channel_hopping_sequence(uint8_t *buf, int len,
   }
 }
 
-/* Parse a header IE */
-static int
-frame802154e_parse_header_ie(const uint8_t *buf, int len,
-    uint8_t element_id, struct ieee802154_ies *ies)
-{
-  switch(element_id) {
-    case HEADER_IE_ACK_NACK_TIME_CORRECTION:
-      if(len == 2) {
-        if(ies != NULL) {
-          /* If the originator was a time source neighbor, the receiver adjust
-           * its own clock by incorporating the received drift correction */
-          uint16_t time_sync_field = 0;
-          int16_t drift_us = 0;
-          /* Extract drift correction from Sync-IE, cast from 12 to 16-bit,
-           * and convert it to RTIMER ticks.
-           * See page 88 in IEEE Std 802.15.4e-2012. */
-          READ16(buf, time_sync_field);
-          /* First extract NACK */
-          ies->ie_is_nack = (time_sync_field & (uint16_t)0x8000) ? 1 : 0;
-          /* Then cast from 12 to 16 bit signed */
-          if(time_sync_field & 0x0800) { /* Negative integer */
-            drift_us = time_sync_field | 0xf000;
-          } else { /* Positive integer */
-            drift_us = time_sync_field & 0x0fff;
-          }
-          /* Convert to RTIMER ticks */
-          ies->ie_time_correction = drift_us;
-        }
-        return len;
-      }
-      break;
-  }
-  return -1;
-}
-
-/* Parse a MLME short IE */
-static int
-frame802154e_parse_mlme_short_ie(const uint8_t *buf, int len,
-    uint8_t sub_id, struct ieee802154_ies *ies)
-{
-  switch(sub_id) {
-    case MLME_SHORT_IE_TSCH_SLOFTRAME_AND_LINK:
-      if(len >= 1) {
-        int i;
-        int num_slotframes = buf[0];
-        int num_links = buf[4];
-        if(num_slotframes == 0) {
-          return len;
-        }
-        if(num_slotframes <= 1 && num_links <= FRAME802154E_IE_MAX_LINKS
-            && len == 1 + num_slotframes * (4 + 5 * num_links)) {
-          if(ies != NULL) {
-            /* We support only 0 or 1 slotframe in this IE and a predefined maximum number of links */
-            ies->ie_tsch_slotframe_and_link.num_slotframes = buf[0];
-            ies->ie_tsch_slotframe_and_link.slotframe_handle = buf[1];
-            READ16(buf + 2, ies->ie_tsch_slotframe_and_link.slotframe_size);
-            ies->ie_tsch_slotframe_and_link.num_links = buf[4];
-            for(i = 0; i < num_links; i++) {
-              READ16(buf + 5 + i * 5, ies->ie_tsch_slotframe_and_link.links[i].timeslot);
-              READ16(buf + 5 + i * 5 + 2, ies->ie_tsch_slotframe_and_link.links[i].channel_offset);
-              ies->ie_tsch_slotframe_and_link.links[i].link_options = buf[5 + i * 5 + 4];
-            }
-          }
-          return len;
-        }
-      }
-      break;
-    case MLME_SHORT_IE_TSCH_SYNCHRONIZATION:
-      if(len == 6) {
-        if(ies != NULL) {
-          ies->ie_asn.ls4b = (uint32_t)buf[0];
-          ies->ie_asn.ls4b |= (uint32_t)buf[1] << 8;
-          ies->ie_asn.ls4b |= (uint32_t)buf[2] << 16;
-          ies->ie_asn.ls4b |= (uint32_t)buf[3] << 24;
-          ies->ie_asn.ms1b = (uint8_t)buf[4];
-          ies->ie_join_priority = (uint8_t)buf[5];
-        }
-        return len;
-      }
-      break;
-    case MLME_SHORT_IE_TSCH_TIMESLOT:
-      if(len == 1 || len == 25) {
-        if(ies != NULL) {
-          ies->ie_tsch_timeslot_id = buf[0];
-          if(len == 25) {
-            int i;
-            for(i = 0; i < tsch_ts_elements_count; i++) {
-              READ16(buf+1+2*i, ies->ie_tsch_timeslot[i]);
-            }
-          }
-        }
-        return len;
-      }
-      break;
-  }
-  return -1;
-}
+/* Walk the IEs of a frame, c.f. IEEE 802.15.4e fig 48n-48s */
+enum {
+  ITERATOR_HEADER_IE,
+  ITERATOR_PAYLOAD_IE,
+  ITERATOR_MLME_SUBIE,
+  ITERATOR_END,
+};
 
-/* Parse a MLME long IE */
-static int
-frame802154e_parse_mlme_long_ie(const uint8_t *buf, int len,
-    uint8_t sub_id, struct ieee802154_ies *ies)
+void
+frame802154e_ie_iterator_init(struct frame802154e_ie_iterator *it,
+    const uint8_t *buf, int buf_size)
 {
-  switch(sub_id) {
-    case MLME_LONG_IE_TSCH_CHANNEL_HOPPING_SEQUENCE:
-      if(len > 0) {
-        if(ies != NULL) {
-          ies->ie_channel_hopping_sequence_id = buf[0];
-          if(len > 1) {
-            READ16(buf+8, ies->ie_hopping_sequence_len); /* sequence len */
-            if(ies->ie_hopping_sequence_len <= sizeof(ies->ie_hopping_sequence_list)
-                && len == 12 + ies->ie_hopping_sequence_len) {
-              memcpy(ies->ie_hopping_sequence_list, buf+10, ies->ie_hopping_sequence_len); /* sequence list */
-            }
-          }
-        }
-        return len;
-      }
-      break;
-  }
-  return -1;
+  it->buf = buf;
+  it->size = buf_size > 0 ? buf_size : 0;
+  it->offset = 0;
+  it->mlme_end = 0;
+  it->header_len = 0;
+  /* Always look for a header IE first (at least "list termination 1") */
+  it->state = ITERATOR_HEADER_IE;
 }
 
-/* Parse all IEEE 802.15.4e Information Elements (IE) from a frame */
 int
-frame802154e_parse_information_elements(const uint8_t *buf, uint8_t buf_size,
-    struct ieee802154_ies *ies)
+frame802154e_ie_next(struct frame802154e_ie_iterator *it,
+    struct frame802154e_ie *ie)
 {
-  const uint8_t *start = buf;
   uint16_t ie_desc;
   uint8_t type;
   uint8_t id;
-  uint16_t len = 0;
-  int nested_mlme_len = 0;
-  enum {PARSING_HEADER_IE, PARSING_PAYLOAD_IE, PARSING_MLME_SUBIE} parsing_state;
+  uint16_t len;
 
-  if(ies == NULL) {
-    return -1;
-  }
-
-  /* Always look for a header IE first (at least "list termination 1") */
-  parsing_state = PARSING_HEADER_IE;
-  ies->ie_payload_ie_offset = 0;
-
-  /* Loop over all IEs */
-  while(buf_size > 0) {
-    if(buf_size < 2) { /* Not enough space for IE descriptor */
+  while(it->state != ITERATOR_END && it->offset < it->size) {
+    if(it->size - it->offset < 2) { /* Not enough space for IE descriptor */
       return -1;
     }
-    READ16(buf, ie_desc);
-    buf_size -= 2;
-    buf += 2;
+    READ16(it->buf + it->offset, ie_desc);
+    it->offset += 2;
     type = ie_desc & 0x8000 ? 1 : 0; /* b15 */
-    LOG_DBG("ie type %u, current state %u\n", type, parsing_state);
+    LOG_DBG("ie type %u, current state %u\n", type, it->state);
 
-    switch(parsing_state) {
-      case PARSING_HEADER_IE:
+    switch(it->state) {
+      case ITERATOR_HEADER_IE:
         if(type != 0) {
           LOG_ERR("header ie: wrong type %04x\n", ie_desc);
           return -1;
@@ -505,37 +389,22 @@ frame802154e_parse_information_elements(const uint8_t *buf, uint8_t buf_size,
         len = ie_desc & 0x007f; /* b0-b6 */
         id = (ie_desc & 0x7f80) >> 7; /* b7-b14 */
         LOG_DBG("header ie: len %u id %x\n", len, id);
-        switch(id) {
-          case HEADER_IE_LIST_TERMINATION_1:
-            if(len == 0) {
-              /* End of payload IE list, now expect payload IEs */
-              parsing_state = PARSING_PAYLOAD_IE;
-              ies->ie_payload_ie_offset = buf - start; /* Save IE header len */
-              LOG_DBG("list termination 1, look for payload IEs\n");
-            } else {
-              LOG_ERR("list termination 1, wrong len %u\n", len);
-              return -1;
-            }
-            break;
-          case HEADER_IE_LIST_TERMINATION_2:
-            /* End of IE parsing */
-            if(len == 0) {
-              ies->ie_payload_ie_offset = buf - start; /* Save IE header len */
-              LOG_DBG("list termination 2\n");
-              return buf + len - start;
-            } else {
-              LOG_ERR("list termination 2, wrong len %u\n", len);
-              return -1;
-            }
-          default:
-            if(len > buf_size || frame802154e_parse_header_ie(buf, len, id, ies) == -1) {
-              LOG_ERR("failed to parse\n");
-              return -1;
-            }
-            break;
+        if(id == HEADER_IE_LIST_TERMINATION_1
+           || id == HEADER_IE_LIST_TERMINATION_2) {
+          if(len != 0) {
+            LOG_ERR("list termination, wrong len %u\n", len);
+            return -1;
+          }
+          it->header_len = it->offset;
+          /* Termination 1: now expect payload IEs. Termination 2: the
+           * unformatted payload follows */
+          it->state = id == HEADER_IE_LIST_TERMINATION_1 ?
+            ITERATOR_PAYLOAD_IE : ITERATOR_END;
+          continue;
         }
+        ie->type = FRAME802154E_IE_HEADER;
         break;
-      case PARSING_PAYLOAD_IE:
+      case ITERATOR_PAYLOAD_IE:
         if(type != 1) {
           LOG_ERR("payload ie: wrong type %04x\n", ie_desc);
           return -1;
@@ -544,88 +413,355 @@ frame802154e_parse_information_elements(const uint8_t *buf, uint8_t buf_size,
         len = ie_desc & 0x7ff; /* b0-b10 */
         id = (ie_desc & 0x7800) >> 11; /* b11-b14 */
         LOG_DBG("payload ie: len %u id %x\n", len, id);
-        switch(id) {
-          case PAYLOAD_IE_MLME:
-            /* Now expect 'len' bytes of MLME sub-IEs */
-            parsing_state = PARSING_MLME_SUBIE;
-            nested_mlme_len = len;
-            len = 0; /* Reset len as we want to read subIEs and not jump over them */
-            LOG_DBG("entering MLME ie with len %u\n", nested_mlme_len);
-            break;
-#if TSCH_WITH_SIXTOP
-          case PAYLOAD_IE_IETF:
-            switch(*buf) {
-              case IETF_IE_6TOP:
-                /*
-                 * buf points to the Sub-ID field, a one-octet field, now;
-                 * advance it by one and use the result as the head pointer of
-                 * 6top IE Content.
-                 */
-                ies->sixtop_ie_content_ptr = buf + 1;
-                /*
-                 * Similarly as above, subtract 1 (one octet) from len, which
-                 * includes the length of Sub-ID field, and use the result as
-                 * the length of 6top IE Content.
-                 */
-                ies->sixtop_ie_content_len = len - 1;
-                break;
-              default:
-                LOG_ERR("frame802154e: unsupported IETF sub-IE %u\n", *buf);
-                break;
-            }
-            break;
-#endif /* TSCH_WITH_SIXTOP */
-          case PAYLOAD_IE_LIST_TERMINATION:
-            LOG_DBG("payload ie list termination %u\n", len);
-            return (len == 0) ? buf + len - start : -1;
-          default:
-            LOG_ERR("non-supported payload ie\n");
+        if(id == PAYLOAD_IE_LIST_TERMINATION) {
+          LOG_DBG("payload ie list termination %u\n", len);
+          if(len != 0) {
             return -1;
+          }
+          it->state = ITERATOR_END;
+          continue;
         }
+        if(id == PAYLOAD_IE_MLME) {
+          /* Now expect 'len' bytes of MLME sub-IEs */
+          LOG_DBG("entering MLME ie with len %u\n", len);
+          it->mlme_end = it->offset + len;
+          it->state = ITERATOR_MLME_SUBIE;
+          continue;
+        }
+        ie->type = FRAME802154E_IE_PAYLOAD;
         break;
-      case PARSING_MLME_SUBIE:
+      default: /* ITERATOR_MLME_SUBIE */
         /* MLME sub-IE: 2 bytes descriptor, c.f. fig 48q in IEEE 802.15.4e */
-        /* type == 0 means short sub-IE, type == 1 means long sub-IE */
         if(type == 0) {
           /* Short sub-IE, c.f. fig 48r in IEEE 802.15.4e */
           len = ie_desc & 0x00ff; /* b0-b7 */
           id = (ie_desc & 0x7f00) >> 8; /* b8-b14 */
-          LOG_DBG("short mlme ie len %u id %x\n", len, id);
-          if(len > buf_size || frame802154e_parse_mlme_short_ie(buf, len, id, ies) == -1) {
-            LOG_ERR("failed to parse ie\n");
-            return -1;
-          }
+          ie->type = FRAME802154E_IE_MLME_SHORT;
         } else {
           /* Long sub-IE, c.f. fig 48s in IEEE 802.15.4e */
           len = ie_desc & 0x7ff; /* b0-b10 */
           id = (ie_desc & 0x7800) >> 11; /* b11-b14 */
-          LOG_DBG("long mlme ie len %u id %x\n", len, id);
-          if(len > buf_size || frame802154e_parse_mlme_long_ie(buf, len, id, ies) == -1) {
-            LOG_ERR("failed to parse ie\n");
-            return -1;
-          }
+          ie->type = FRAME802154E_IE_MLME_LONG;
         }
-        /* Update remaining nested MLME len */
-        nested_mlme_len -= 2 + len;
-        if(nested_mlme_len < 0) {
+        LOG_DBG("mlme ie type %u len %u id %x\n", type, len, id);
+        if(it->offset + len > it->mlme_end) {
           LOG_ERR("found more sub-IEs than initially advertised\n");
-          /* We found more sub-IEs than initially advertised */
           return -1;
         }
-        if(nested_mlme_len == 0) {
-          LOG_DBG("end of MLME IE parsing\n");
-          /* End of IE parsing, look for another payload IE */
-          parsing_state = PARSING_PAYLOAD_IE;
-        }
         break;
     }
-    buf += len;
-    buf_size -= len;
+
+    if(len > it->size - it->offset) {
+      LOG_ERR("failed to parse ie\n");
+      return -1;
+    }
+    ie->content = it->buf + it->offset;
+    ie->len = len;
+    ie->id = id;
+    it->offset += len;
+    if(it->state == ITERATOR_MLME_SUBIE && it->offset == it->mlme_end) {
+      LOG_DBG("end of MLME IE parsing\n");
+      /* Look for another payload IE */
+      it->state = ITERATOR_PAYLOAD_IE;
+    }
+    return 1;
+  }
+
+  if(it->state == ITERATOR_HEADER_IE) {
+    it->header_len = it->offset;
+  }
+  it->state = ITERATOR_END;
+  return 0;
+}
+
+int
+frame802154e_ie_header_len(const uint8_t *buf, int buf_size)
+{
+  struct frame802154e_ie_iterator it;
+  struct frame802154e_ie ie;
+
+  frame802154e_ie_iterator_init(&it, buf, buf_size);
+  while(it.state == ITERATOR_HEADER_IE) {
+    if(frame802154e_ie_next(&it, &ie) < 0 && it.state == ITERATOR_HEADER_IE) {
+      return -1;
+    }
+  }
+  return it.header_len;
+}
+
+/* Header IE. ACK/NACK time correction */
+int
+frame802154e_ie_read_time_correction(const struct frame802154e_ie *ie,
+    int16_t *drift_us, uint8_t *is_nack)
+{
+  uint16_t time_sync_field;
+
+  if(ie->type != FRAME802154E_IE_HEADER
+     || ie->id != HEADER_IE_ACK_NACK_TIME_CORRECTION || ie->len != 2) {
+    return -1;
   }
+  /* If the originator was a time source neighbor, the receiver adjust
+   * its own clock by incorporating the received drift correction.
+   * Extract drift correction from Sync-IE, cast from 12 to 16-bit.
+   * See page 88 in IEEE Std 802.15.4e-2012. */
+  READ16(ie->content, time_sync_field);
+  /* First extract NACK */
+  *is_nack = (time_sync_field & (uint16_t)0x8000) ? 1 : 0;
+  /* Then cast from 12 to 16 bit signed */
+  if(time_sync_field & 0x0800) { /* Negative integer */
+    *drift_us = time_sync_field | 0xf000;
+  } else { /* Positive integer */
+    *drift_us = time_sync_field & 0x0fff;
+  }
+  return 0;
+}
+
+/* MLME sub-IE. TSCH synchronization */
+int
+frame802154e_ie_read_tsch_synchronization(const struct frame802154e_ie *ie,
+    struct tsch_asn_t *asn, uint8_t *join_priority)
+{
+  const uint8_t *buf = ie->content;
 
-  if(parsing_state == PARSING_HEADER_IE) {
-    ies->ie_payload_ie_offset = buf - start; /* Save IE header len */
+  if(ie->type != FRAME802154E_IE_MLME_SHORT
+     || ie->id != MLME_SHORT_IE_TSCH_SYNCHRONIZATION || ie->len != 6) {
+    return -1;
   }
+  asn->ls4b = (uint32_t)buf[0];
+  asn->ls4b |= (uint32_t)buf[1] << 8;
+  asn->ls4b |= (uint32_t)buf[2] << 16;
+  asn->ls4b |= (uint32_t)buf[3] << 24;
+  asn->ms1b = buf[4];
+  *join_priority = buf[5];
+  return 0;
+}
 
-  return buf - start;
+/* MLME sub-IE. TSCH timeslot */
+int
+frame802154e_ie_read_tsch_timeslot(const struct frame802154e_ie *ie,
+    uint8_t *timeslot_id, uint16_t *timeslot)
+{
+  int i;
+
+  if(ie->type != FRAME802154E_IE_MLME_SHORT
+     || ie->id != MLME_SHORT_IE_TSCH_TIMESLOT
+     || (ie->len != 1 && ie->len != 25)) {
+    return -1;
+  }
+  *timeslot_id = ie->content[0];
+  if(ie->len == 25 && timeslot != NULL) {
+    for(i = 0; i < tsch_ts_elements_count; i++) {
+      READ16(ie->content + 1 + 2 * i, timeslot[i]);
+    }
+  }
+  return 0;
+}
+
+/* MLME sub-IE. TSCH slotframe and link */
+int
+frame802154e_ie_read_tsch_slotframe_and_link(const struct frame802154e_ie *ie,
+    struct tsch_slotframe_and_links *sf)
+{
+  const uint8_t *buf = ie->content;
+  int num_links;
+  int i;
+
+  if(ie->type != FRAME802154E_IE_MLME_SHORT
+     || ie->id != MLME_SHORT_IE_TSCH_SLOFTRAME_AND_LINK || ie->len < 1) {
+    return -1;
+  }
+  if(buf[0] == 0) {
+    sf->num_slotframes = 0;
+    return 0;
+  }
+  /* We support only 0 or 1 slotframe in this IE and a predefined maximum
+   * number of links */
+  num_links = ie->len >= 5 ? buf[4] : 0;
+  if(buf[0] > 1 || num_links > FRAME802154E_IE_MAX_LINKS
+     || ie->len != 1 + 4 + 5 * num_links) {
+    return -1;
+  }
+  sf->num_slotframes = buf[0];
+  sf->slotframe_handle = buf[1];
+  READ16(buf + 2, sf->slotframe_size);
+  sf->num_links = num_links;
+  for(i = 0; i < num_links; i++) {
+    READ16(buf + 5 + i * 5, sf->links[i].timeslot);
+    READ16(buf + 5 + i * 5 + 2, sf->links[i].channel_offset);
+    sf->links[i].link_options = buf[5 + i * 5 + 4];
+  }
+  return 0;
+}
+
+/* MLME sub-IE. TSCH channel hopping sequence */
+int
+frame802154e_ie_read_tsch_channel_hopping_sequence(const struct frame802154e_ie *ie,
+    uint8_t *sequence_id, const uint8_t **list, uint16_t *list_len)
+{
+  if(ie->type != FRAME802154E_IE_MLME_LONG
+     || ie->id != MLME_LONG_IE_TSCH_CHANNEL_HOPPING_SEQUENCE || ie->len < 1) {
+    return -1;
+  }
+  *sequence_id = ie->content[0];
+  *list = NULL;
+  *list_len = 0;
+  if(ie->len > 1) {
+    if(ie->len < 12) {
+      return -1;
+    }
+    READ16(ie->content + 8, *list_len); /* sequence len */
+    /* Reject truncated IEs only; any fields past the list are ignored */
+    if(ie->len < 12 + *list_len) {
+      return -1;
+    }
+    *list = ie->content + 10; /* sequence list */
+  }
+  return 0;
+}
+
+/* Payload IE. 6top */
+int
+frame802154e_ie_read_sixtop(const struct frame802154e_ie *ie,
+    const uint8_t **content, uint16_t *content_len)
+{
+  /* The content of the IETF IE starts with the one-octet Sub-ID field,
+   * followed by the 6top IE content */
+  if(ie->type != FRAME802154E_IE_PAYLOAD || ie->id != PAYLOAD_IE_IETF
+     || ie->len < 1 || ie->content[0] != IETF_IE_6TOP) {
+    return -1;
+  }
+  *content = ie->content + 1;
+  *content_len = ie->len - 1;
+  return 0;
+}
+
+/* Decode an IE into ies */
+static int
+frame802154e_parse_ie(const struct frame802154e_ie *ie,
+    struct ieee802154_ies *ies)
+{
+  const uint8_t *list;
+  uint16_t list_len;
+
+  switch(ie->type) {
+    case FRAME802154E_IE_HEADER:
+      return frame802154e_ie_read_time_correction(ie, &ies->ie_time_correction,
+                                                  &ies->ie_is_nack);
+    case FRAME802154E_IE_MLME_SHORT:
+      switch(ie->id) {
+        case MLME_SHORT_IE_TSCH_SLOFTRAME_AND_LINK:
+          return frame802154e_ie_read_tsch_slotframe_and_link(ie,
+              &ies->ie_tsch_slotframe_and_link);
+        case MLME_SHORT_IE_TSCH_SYNCHRONIZATION:
+          return frame802154e_ie_read_tsch_synchronization(ie, &ies->ie_asn,
+              &ies->ie_join_priority);
+        case MLME_SHORT_IE_TSCH_TIMESLOT:
+          return frame802154e_ie_read_tsch_timeslot(ie, &ies->ie_tsch_timeslot_id,
+              ies->ie_tsch_timeslot);
+      }
+      break;
+    case FRAME802154E_IE_MLME_LONG:
+      if(frame802154e_ie_read_tsch_channel_hopping_sequence(ie,
+             &ies->ie_channel_hopping_sequence_id, &list, &list_len) == 0) {
+        ies->ie_hopping_sequence_len = list_len;
+        if(list_len <= sizeof(ies->ie_hopping_sequence_list)) {
+          memcpy(ies->ie_hopping_sequence_list, list, list_len);
+        }
+        return 0;
+      }
+      break;
+    case FRAME802154E_IE_PAYLOAD:
+#if TSCH_WITH_SIXTOP
+      if(ie->id == PAYLOAD_IE_IETF) {
+        if(frame802154e_ie_read_sixtop(ie, &ies->sixtop_ie_content_ptr,
+                                       &ies->sixtop_ie_content_len) < 0) {
+          LOG_ERR("frame802154e: unsupported IETF sub-IE\n");
+        }
+        return 0;
+      }
+#endif /* TSCH_WITH_SIXTOP */
+      LOG_ERR("non-supported payload ie\n");
+      break;
+  }
+  return -1;
+}
+
+/* Parse all IEEE 802.15.4e Information Elements (IE) from a frame */
+int
+frame802154e_parse_information_elements(const uint8_t *buf, uint8_t buf_size,
+    struct ieee802154_ies *ies)
+{
+  struct frame802154e_ie_iterator it;
+  struct frame802154e_ie ie;
+  int ret;
+
+  if(ies == NULL) {
+    return -1;
+  }
+
+  frame802154e_ie_iterator_init(&it, buf, buf_size);
+  ies->ie_payload_ie_offset = 0;
+  while((ret = frame802154e_ie_next(&it, &ie)) > 0) {
+    if(frame802154e_parse_ie(&ie, ies) < 0) {
+      LOG_ERR("failed to parse ie\n");
+      return -1;
+    }
+  }
+  /* Save IE header len */
+  ies->ie_payload_ie_offset = it.header_len;
+  return ret < 0 ? -1 : it.offset;
+}
+
+/* Start a list of IEs */
+void
+frame802154e_ie_builder_init(struct frame802154e_ie_builder *b,
+    uint8_t *buf, int buf_size)
+{
+  b->buf = buf;
+  b->len = 0;
+  b->size = buf_size > 0 ? buf_size : 0;
+  b->mlme_offset = -1;
+}
+
+/* Append an IE */
+int
+frame802154e_ie_builder_add(struct frame802154e_ie_builder *b,
+    int (*create)(uint8_t *buf, int len, struct ieee802154_ies *ies),
+    struct ieee802154_ies *ies)
+{
+  int ie_len;
+
+  ie_len = create(b->buf + b->len, b->size - b->len, ies);
+  if(ie_len < 0) {
+    return -1;
+  }
+  b->len += ie_len;
+  return ie_len;
+}
+
+/* Open a MLME payload IE */
+int
+frame802154e_ie_builder_begin_mlme(struct frame802154e_ie_builder *b)
+{
+  if(b->mlme_offset >= 0 || b->size - b->len < 2) {
+    return -1;
+  }
+  /* Leave room for the descriptor */
+  b->mlme_offset = b->len;
+  b->len += 2;
+  return 0;
+}
+
+/* Close the MLME payload IE */
+int
+frame802154e_ie_builder_end_mlme(struct frame802154e_ie_builder *b)
+{
+  if(b->mlme_offset < 0) {
+    return -1;
+  }
+  /* The length of the outer MLME IE is the total length of sub-IEs */
+  create_payload_ie_descriptor(b->buf + b->mlme_offset, PAYLOAD_IE_MLME,
+                               b->len - b->mlme_offset - 2);
+  b->mlme_offset = -1;
+  return 0;
 }
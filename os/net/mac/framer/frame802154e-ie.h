@@ -92,6 +92,41 @@ struct ieee802154_ies {
 #endif /* TSCH_WITH_SIXTOP */
 };
 
+/* Types of the IEs returned by frame802154e_ie_next() */
+enum frame802154e_ie_type {
+  FRAME802154E_IE_HEADER,     /* Header IE */
+  FRAME802154E_IE_PAYLOAD,    /* Payload IE, other than MLME */
+  FRAME802154E_IE_MLME_SHORT, /* Short sub-IE of a MLME payload IE */
+  FRAME802154E_IE_MLME_LONG,  /* Long sub-IE of a MLME payload IE */
+};
+
+/* An IE found in a frame. Its content is not copied, it points into the
+ * buffer being parsed */
+struct frame802154e_ie {
+  const uint8_t *content;
+  uint16_t len;
+  uint8_t type; /* enum frame802154e_ie_type */
+  uint8_t id;   /* Element ID, Group ID or Sub-ID, depending on the type */
+};
+
+/* Iterator over the IEs of a frame, see frame802154e_ie_next() */
+struct frame802154e_ie_iterator {
+  const uint8_t *buf;  /* Start of the IEs */
+  uint16_t size;       /* Length of buf */
+  uint16_t offset;     /* Offset of the next IE descriptor in buf */
+  uint16_t mlme_end;   /* End of the MLME IE being walked */
+  uint16_t header_len; /* Length of the Header IEs, once walked */
+  uint8_t state;
+};
+
+/* Builder of a list of IEs, see frame802154e_ie_builder_add() */
+struct frame802154e_ie_builder {
+  uint8_t *buf;
+  uint16_t len;        /* Length of the IEs added so far */
+  uint16_t size;       /* Size of buf */
+  int16_t mlme_offset; /* Offset of the open MLME IE, -1 if none */
+};
+
 /** Insert various Information Elements **/
 /* Header IE. ACK/NACK time correction. Used in enhanced ACKs */
 int frame80215e_create_ie_header_ack_nack_time_correction(uint8_t *buf, int len,
@@ -132,4 +167,56 @@ int frame80215e_create_ie_tsch_channel_hopping_sequence(uint8_t *buf, int len,
 int frame802154e_parse_information_elements(const uint8_t *buf, uint8_t buf_size,
     struct ieee802154_ies *ies);
 
+/** Walk the Information Elements of a frame in place **/
+/* Start walking the IEs in buf, which starts with the Header IEs */
+void frame802154e_ie_iterator_init(struct frame802154e_ie_iterator *it,
+    const uint8_t *buf, int buf_size);
+/* Get the next IE. The list termination IEs and MLME payload IEs are not
+ * returned, the sub-IEs of the latter are. Returns 1 if an IE was found,
+ * 0 at the end of the list and -1 if the list is malformed. Once the end
+ * is reached, it->offset is the length of the IE list. */
+int frame802154e_ie_next(struct frame802154e_ie_iterator *it,
+    struct frame802154e_ie *ie);
+/* Length of the Header IEs in buf, list termination included, or -1 if
+ * they are malformed. The Payload IEs are not walked. */
+int frame802154e_ie_header_len(const uint8_t *buf, int buf_size);
+
+/* Decode an IE found by frame802154e_ie_next(). Each function returns 0 if
+ * the IE is of the expected type and well-formed, -1 otherwise. */
+/* Header IE. ACK/NACK time correction */
+int frame802154e_ie_read_time_correction(const struct frame802154e_ie *ie,
+    int16_t *drift_us, uint8_t *is_nack);
+/* MLME sub-IE. TSCH synchronization */
+int frame802154e_ie_read_tsch_synchronization(const struct frame802154e_ie *ie,
+    struct tsch_asn_t *asn, uint8_t *join_priority);
+/* MLME sub-IE. TSCH timeslot. timeslot (tsch_ts_elements_count elements,
+ * may be NULL) is only written when the IE has the full timing */
+int frame802154e_ie_read_tsch_timeslot(const struct frame802154e_ie *ie,
+    uint8_t *timeslot_id, uint16_t *timeslot);
+/* MLME sub-IE. TSCH slotframe and link */
+int frame802154e_ie_read_tsch_slotframe_and_link(const struct frame802154e_ie *ie,
+    struct tsch_slotframe_and_links *sf);
+/* MLME sub-IE. TSCH channel hopping sequence. *list points into the frame,
+ * it is NULL if the IE only has the sequence ID */
+int frame802154e_ie_read_tsch_channel_hopping_sequence(const struct frame802154e_ie *ie,
+    uint8_t *sequence_id, const uint8_t **list, uint16_t *list_len);
+/* Payload IE. 6top, in an IETF IE. *content points into the frame */
+int frame802154e_ie_read_sixtop(const struct frame802154e_ie *ie,
+    const uint8_t **content, uint16_t *content_len);
+
+/** Write a list of Information Elements in place **/
+/* Start a list of IEs in buf, e.g. at packetbuf_dataptr() */
+void frame802154e_ie_builder_init(struct frame802154e_ie_builder *b,
+    uint8_t *buf, int buf_size);
+/* Append an IE, written by one of the frame80215e_create_ie_* functions
+ * above. Returns the length of the IE, or -1 if it does not fit */
+int frame802154e_ie_builder_add(struct frame802154e_ie_builder *b,
+    int (*create)(uint8_t *buf, int len, struct ieee802154_ies *ies),
+    struct ieee802154_ies *ies);
+/* Open a MLME payload IE, the sub-IEs added until
+ * frame802154e_ie_builder_end_mlme() are nested in it. Its descriptor is
+ * written when closing it, once its length is known. */
+int frame802154e_ie_builder_begin_mlme(struct frame802154e_ie_builder *b);
+int frame802154e_ie_builder_end_mlme(struct frame802154e_ie_builder *b);
+
 #endif /* FRAME_802154E_H */
@@ -55,20 +55,152 @@ static uint8_t mac_dsn;
 
 static uint8_t initialized = 0;
 
+#if FRAMER_802154_TEMPLATES
+/*
+ * A header built earlier, reused for the next frames with the same
+ * addresses and header attributes. Only the sequence number and the frame
+ * counter change from one frame to the next, they are patched in place.
+ */
+struct header_template {
+  linkaddr_t dest;
+  linkaddr_t src;
+  uint16_t pan_id;
+  uint16_t attrs;             /* TEMPLATE_ATTRS() of the frame, 0 if unused */
+  uint8_t key_index;
+  uint8_t len;
+  uint8_t seqno_pos;          /* 0 if the sequence number is suppressed */
+  uint8_t frame_counter_pos;  /* 0 if there is no frame counter */
+  uint8_t hdr[FRAMER_802154_MAX_HDR_LEN];
+};
+
+static struct header_template templates[FRAMER_802154_TEMPLATES];
+static uint8_t templates_next;
+
+#if LLSEC802154_USES_AUX_HEADER
+#define TEMPLATE_SECURITY_ATTRS() \
+  (packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL) << 9)
+#else /* LLSEC802154_USES_AUX_HEADER */
+#define TEMPLATE_SECURITY_ATTRS() 0
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+#if LLSEC802154_USES_EXPLICIT_KEYS
+#define TEMPLATE_KEY_ATTRS() \
+  (packetbuf_attr(PACKETBUF_ATTR_KEY_ID_MODE) << 12)
+#define TEMPLATE_KEY_INDEX() packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX)
+#else /* LLSEC802154_USES_EXPLICIT_KEYS */
+#define TEMPLATE_KEY_ATTRS() 0
+#define TEMPLATE_KEY_INDEX() 0
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+
+/* The attributes that framer_802154_setup_params() turns into header
+ * fields, packed into 16 bits. Bit 15 is always set in used templates. */
+#define TEMPLATE_ATTRS() \
+  ((packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) & 7) | \
+   (packetbuf_attr(PACKETBUF_ATTR_MAC_ACK) & 1) << 3 | \
+   (packetbuf_attr(PACKETBUF_ATTR_PENDING) & 1) << 4 | \
+   (packetbuf_attr(PACKETBUF_ATTR_MAC_METADATA) & 1) << 5 | \
+   (packetbuf_attr(PACKETBUF_ATTR_MAC_NO_SRC_ADDR) & 1) << 6 | \
+   (packetbuf_attr(PACKETBUF_ATTR_MAC_NO_DEST_ADDR) & 1) << 7 | \
+   TEMPLATE_SECURITY_ATTRS() | TEMPLATE_KEY_ATTRS() | 0x8000)
+/*---------------------------------------------------------------------------*/
+static struct header_template *
+template_lookup(uint16_t attrs)
+{
+  struct header_template *t;
+
+  for(t = templates; t < templates + FRAMER_802154_TEMPLATES; t++) {
+    if(t->attrs == attrs &&
+       t->pan_id == frame802154_get_pan_id() &&
+       t->key_index == TEMPLATE_KEY_INDEX() &&
+       linkaddr_cmp(&t->dest, packetbuf_addr(PACKETBUF_ADDR_RECEIVER)) &&
+       linkaddr_cmp(&t->src, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+      return t;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Builds a template from the parameters of a frame, replacing the oldest
+ * one */
+static struct header_template *
+template_add(frame802154_t *params, uint16_t attrs, int hdr_len)
+{
+  struct header_template *t;
+
+  if(hdr_len > FRAMER_802154_MAX_HDR_LEN) {
+    return NULL;
+  }
+  t = &templates[templates_next];
+  templates_next = (templates_next + 1) % FRAMER_802154_TEMPLATES;
+
+  t->attrs = attrs;
+  t->pan_id = frame802154_get_pan_id();
+  t->key_index = TEMPLATE_KEY_INDEX();
+  linkaddr_copy(&t->dest, packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  linkaddr_copy(&t->src, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  t->len = frame802154_create(params, t->hdr);
+  t->seqno_pos = params->fcf.sequence_number_suppression ? 0 : 2;
+  t->frame_counter_pos = 0;
+#if LLSEC802154_USES_FRAME_COUNTER
+  if(params->fcf.security_enabled) {
+    /* The frame counter follows the security control field, which comes
+     * right after the addressing fields */
+    params->fcf.security_enabled = 0;
+    t->frame_counter_pos = frame802154_hdrlen(params) + 1;
+    params->fcf.security_enabled = 1;
+  }
+#endif /* LLSEC802154_USES_FRAME_COUNTER */
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+/* Copies a template to the header of packetbuf, with the sequence number
+ * and frame counter of the frame */
+static int
+template_apply(struct header_template *t)
+{
+  uint8_t *hdr;
+#if LLSEC802154_USES_FRAME_COUNTER
+  frame802154_frame_counter_t frame_counter;
+#endif /* LLSEC802154_USES_FRAME_COUNTER */
+
+  if(!packetbuf_hdralloc(t->len)) {
+    LOG_ERR("Out: too large header: %u\n", t->len);
+    return FRAMER_FAILED;
+  }
+  hdr = packetbuf_hdrptr();
+  memcpy(hdr, t->hdr, t->len);
+  if(t->seqno_pos) {
+    hdr[t->seqno_pos] = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+  }
+#if LLSEC802154_USES_FRAME_COUNTER
+  if(t->frame_counter_pos) {
+    frame_counter.u16[0] = packetbuf_attr(PACKETBUF_ATTR_FRAME_COUNTER_BYTES_0_1);
+    frame_counter.u16[1] = packetbuf_attr(PACKETBUF_ATTR_FRAME_COUNTER_BYTES_2_3);
+    memcpy(hdr + t->frame_counter_pos, frame_counter.u8, 4);
+  }
+#endif /* LLSEC802154_USES_FRAME_COUNTER */
+
+  LOG_INFO("Out: %2X ", t->attrs & 7);
+  LOG_INFO_LLADDR(&t->dest);
+  LOG_INFO_(" %d %u (%u)\n", t->len, packetbuf_datalen(), packetbuf_totlen());
+  return t->len;
+}
+#endif /* FRAMER_802154_TEMPLATES */
 /*---------------------------------------------------------------------------*/
 static int
 create_frame(int do_create)
 {
   frame802154_t params;
   int hdr_len;
+#if FRAMER_802154_TEMPLATES
+  struct header_template *t;
+  uint16_t attrs;
+#endif /* FRAMER_802154_TEMPLATES */
 
   if(frame802154_get_pan_id() == 0xffff) {
     return -1;
   }
 
-  /* init to zeros */
-  memset(&params, 0, sizeof(params));
-
   if(!initialized) {
     initialized = 1;
     mac_dsn = random_rand() & 0xff;
@@ -89,6 +221,17 @@ create_frame(int do_create)
     mac_dsn++;
   }
 
+#if FRAMER_802154_TEMPLATES
+  attrs = TEMPLATE_ATTRS();
+  t = template_lookup(attrs);
+  if(t != NULL) {
+    return do_create ? template_apply(t) : t->len;
+  }
+#endif /* FRAMER_802154_TEMPLATES */
+
+  /* init to zeros */
+  memset(&params, 0, sizeof(params));
+
   framer_802154_setup_params(packetbuf_attr, packetbuf_holds_broadcast(),
                              &params);
 
@@ -106,6 +249,14 @@ create_frame(int do_create)
   params.payload = packetbuf_dataptr();
   params.payload_len = packetbuf_datalen();
   hdr_len = frame802154_hdrlen(&params);
+
+#if FRAMER_802154_TEMPLATES
+  t = template_add(&params, attrs, hdr_len);
+  if(t != NULL) {
+    return do_create ? template_apply(t) : t->len;
+  }
+#endif /* FRAMER_802154_TEMPLATES */
+
   if(!do_create) {
     /* Only calculate header length */
     return hdr_len;
@@ -139,7 +290,7 @@ framer_802154_setup_params(packetbuf_attr_t (*get_attr)(uint8_t type),
 
   /* Build the FCF. */
   params->fcf.frame_type = get_attr(PACKETBUF_ATTR_FRAME_TYPE);
-  params->fcf.frame_pending = 0;
+  params->fcf.frame_pending = get_attr(PACKETBUF_ATTR_PENDING);
   if(dest_is_broadcast) {
     params->fcf.ack_required = 0;
     /* Suppress seqno on broadcast if supported (frame v2 or more) */
@@ -230,17 +381,109 @@ create(void)
   return create_frame(1);
 }
 /*---------------------------------------------------------------------------*/
+#if FRAMER_802154_FAST_PARSE
+/* Copies a short or long address, least significant byte first on air */
+static uint8_t *
+parse_addr(uint8_t *p, uint8_t mode, uint8_t *addr)
+{
+  int c;
+
+  if(mode == FRAME802154_SHORTADDRMODE) {
+    linkaddr_copy((linkaddr_t *)addr, &linkaddr_null);
+    addr[0] = p[1];
+    addr[1] = p[0];
+    return p + 2;
+  }
+  for(c = 0; c < 8; c++) {
+    addr[c] = p[7 - c];
+  }
+  return p + 8;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Parses the header of a data frame with a sequence number, short or long
+ * addresses on both sides, a destination PAN ID, and neither security nor
+ * IEs. Returns 0 for any other frame, to be parsed by frame802154_parse().
+ */
+static int
+parse_data_frame(uint8_t *data, int len, frame802154_t *pf)
+{
+  uint8_t *p;
+  int has_src_pid;
+  int c;
+
+  /* Data frame, no security, sequence number, no IEs, both addresses,
+   * frame version up to 2015 */
+  if(len < 9
+     || (data[0] & 0x0f) != FRAME802154_DATAFRAME
+     || (data[1] & 0x03) != 0
+     || (data[1] & 0x08) == 0
+     || (data[1] & 0x80) == 0
+     || ((data[1] >> 4) & 3) > FRAME802154_IEEE802154_2015) {
+    return 0;
+  }
+
+  pf->fcf.frame_type = FRAME802154_DATAFRAME;
+  pf->fcf.security_enabled = 0;
+  pf->fcf.frame_pending = (data[0] >> 4) & 1;
+  pf->fcf.ack_required = (data[0] >> 5) & 1;
+  pf->fcf.panid_compression = (data[0] >> 6) & 1;
+  pf->fcf.sequence_number_suppression = 0;
+  pf->fcf.ie_list_present = 0;
+  pf->fcf.dest_addr_mode = (data[1] >> 2) & 3;
+  pf->fcf.frame_version = (data[1] >> 4) & 3;
+  pf->fcf.src_addr_mode = (data[1] >> 6) & 3;
+
+  has_src_pid = !pf->fcf.panid_compression;
+  if(pf->fcf.frame_version == FRAME802154_IEEE802154_2015
+     && pf->fcf.dest_addr_mode == FRAME802154_LONGADDRMODE
+     && pf->fcf.src_addr_mode == FRAME802154_LONGADDRMODE) {
+    /* Table 7-2 of IEEE 802.15.4-2015: two long addresses come with a
+     * single PAN ID without compression, and with none with it */
+    if(pf->fcf.panid_compression) {
+      return 0;
+    }
+    has_src_pid = 0;
+  }
+
+  pf->seq = data[2];
+  pf->dest_pid = data[3] + (data[4] << 8);
+  p = parse_addr(data + 5, pf->fcf.dest_addr_mode, pf->dest_addr);
+  if(has_src_pid) {
+    pf->src_pid = p[0] + (p[1] << 8);
+    p += 2;
+  } else {
+    pf->src_pid = pf->dest_pid;
+  }
+  p = parse_addr(p, pf->fcf.src_addr_mode, pf->src_addr);
+
+  c = p - data;
+  if(c > len) {
+    return 0;
+  }
+  pf->payload_len = len - c;
+  pf->payload = p;
+  return c;
+}
+#endif /* FRAMER_802154_FAST_PARSE */
+/*---------------------------------------------------------------------------*/
 static int
 parse(void)
 {
   frame802154_t frame;
-  int hdr_len;
+  int hdr_len = 0;
 
-  hdr_len = frame802154_parse(packetbuf_dataptr(), packetbuf_datalen(), &frame);
+#if FRAMER_802154_FAST_PARSE
+  hdr_len = parse_data_frame(packetbuf_dataptr(), packetbuf_datalen(), &frame);
+#endif /* FRAMER_802154_FAST_PARSE */
+  if(hdr_len == 0) {
+    hdr_len = frame802154_parse(packetbuf_dataptr(), packetbuf_datalen(), &frame);
+  }
 
   if(hdr_len && packetbuf_hdrreduce(hdr_len)) {
     packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, frame.fcf.frame_type);
     packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, frame.fcf.ack_required);
+    packetbuf_set_attr(PACKETBUF_ATTR_PENDING, frame.fcf.frame_pending);
 
     if(frame.fcf.dest_addr_mode) {
       if(frame.dest_pid != frame802154_get_pan_id() &&
@@ -41,6 +41,41 @@
 
 #include "net/packetbuf.h"
 #include "net/mac/framer/framer.h"
+#include "net/mac/framer/frame802154.h"
+
+/*
+ * Number of frame headers kept as templates for the next frames with the
+ * same addresses, PAN ID and header attributes (frame type, ack request,
+ * security level, ...). A frame that matches a template gets a copy of it
+ * with its own sequence number and frame counter, instead of having its
+ * header built field by field. 0 disables the templates.
+ */
+#ifdef FRAMER_802154_CONF_TEMPLATES
+#define FRAMER_802154_TEMPLATES FRAMER_802154_CONF_TEMPLATES
+#else /* FRAMER_802154_CONF_TEMPLATES */
+#define FRAMER_802154_TEMPLATES 0
+#endif /* FRAMER_802154_CONF_TEMPLATES */
+
+/*
+ * Parse the header of plain data frames (sequence number, short or long
+ * source and destination addresses, no security, no IEs) with straight-line
+ * code instead of frame802154_parse(), which still handles all the other
+ * frames.
+ */
+#ifdef FRAMER_802154_CONF_FAST_PARSE
+#define FRAMER_802154_FAST_PARSE FRAMER_802154_CONF_FAST_PARSE
+#else /* FRAMER_802154_CONF_FAST_PARSE */
+#define FRAMER_802154_FAST_PARSE 0
+#endif /* FRAMER_802154_CONF_FAST_PARSE */
+
+/* Longest header kept as a template: frame control, sequence number, two
+   PAN IDs and long addresses, and an auxiliary security header with a
+   frame counter and a 1-byte key identifier */
+#ifdef FRAMER_802154_CONF_MAX_HDR_LEN
+#define FRAMER_802154_MAX_HDR_LEN FRAMER_802154_CONF_MAX_HDR_LEN
+#else /* FRAMER_802154_CONF_MAX_HDR_LEN */
+#define FRAMER_802154_MAX_HDR_LEN 29
+#endif /* FRAMER_802154_CONF_MAX_HDR_LEN */
 
 /* Setup frame802154_t with use of a specified get_attr */
 void framer_802154_setup_params(packetbuf_attr_t (*get_attr)(uint8_t type),
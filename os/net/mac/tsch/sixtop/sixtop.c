@@ -193,6 +193,10 @@ sixtop_output(const linkaddr_t *dest_addr, mac_callback_t callback, void *arg)
   /* 6P packet is data frame */
   packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
 
+  /* TSCH sends 6P on shared links only; a class of its own keeps it from
+   * holding up data on the dedicated links meanwhile */
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, PACKETBUF_PRIORITY_CONTROL);
+
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest_addr);
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
 
@@ -207,7 +211,10 @@ sixtop_input(void)
   uint16_t hdr_len, payload_len;
 
   frame802154_t frame;
-  struct ieee802154_ies ies;
+  struct frame802154e_ie_iterator it;
+  struct frame802154e_ie ie;
+  const uint8_t *content;
+  uint16_t content_len;
   linkaddr_t src_addr;
 
   /*
@@ -237,23 +244,25 @@ sixtop_input(void)
    */
   assert(frame.fcf.frame_version == FRAME802154_IEEE802154_2015);
   assert(frame.fcf.frame_type == FRAME802154_DATAFRAME);
-  memset(&ies, 0, sizeof(ies));
-  if(frame.fcf.ie_list_present &&
-     frame802154e_parse_information_elements(payload_ptr,
-                                             payload_len, &ies) >= 0 &&
-     ies.sixtop_ie_content_ptr != NULL &&
-     ies.sixtop_ie_content_len > 0) {
-
-    sixp_input(ies.sixtop_ie_content_ptr, ies.sixtop_ie_content_len,
-               &src_addr);
-
-    /*
-     * move payloadbuf_dataptr() to the beginning of the next layer for further
-     * processing
-     */
-    packetbuf_hdrreduce(ies.sixtop_ie_content_ptr - payload_ptr +
-                        ies.sixtop_ie_content_len);
-    strip_payload_termination_ie();
+  if(!frame.fcf.ie_list_present) {
+    return;
+  }
+
+  /* Look for the 6top IE, without decoding the other IEs */
+  frame802154e_ie_iterator_init(&it, payload_ptr, payload_len);
+  while(frame802154e_ie_next(&it, &ie) > 0) {
+    if(frame802154e_ie_read_sixtop(&ie, &content, &content_len) == 0 &&
+       content_len > 0) {
+      sixp_input(content, content_len, &src_addr);
+
+      /*
+       * move payloadbuf_dataptr() to the beginning of the next layer for further
+       * processing
+       */
+      packetbuf_hdrreduce(content - payload_ptr + content_len);
+      strip_payload_termination_ie();
+      return;
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
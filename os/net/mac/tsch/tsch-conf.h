@@ -306,6 +306,24 @@
 #endif
 #endif
 
+/* The number of priority classes, each with its own queue per neighbor.
+ * The class of a packet is its PACKETBUF_ATTR_PRIORITY, capped to the
+ * highest class. Every class queue has TSCH_QUEUE_NUM_PER_NEIGHBOR entries */
+#ifdef TSCH_QUEUE_CONF_PRIORITY_CLASSES
+#define TSCH_QUEUE_PRIORITY_CLASSES TSCH_QUEUE_CONF_PRIORITY_CLASSES
+#else
+#define TSCH_QUEUE_PRIORITY_CLASSES 1
+#endif
+
+/* The default maximum time a packet may wait in its queue, in timeslots.
+ * Older packets are dropped before they use a slot. 0 for no limit.
+ * Can be changed per packet through the max_age field of tsch_packet */
+#ifdef TSCH_QUEUE_CONF_MAX_AGE
+#define TSCH_QUEUE_MAX_AGE TSCH_QUEUE_CONF_MAX_AGE
+#else
+#define TSCH_QUEUE_MAX_AGE 0
+#endif
+
 /* The number of neighbor queues. There are two queues allocated at all times:
  * one for EBs, one for broadcasts. Other queues are for unicast to neighbors */
 #ifdef TSCH_QUEUE_CONF_MAX_NEIGHBOR_QUEUES
@@ -353,9 +371,20 @@
 #define TSCH_SCHEDULE_MAX_LINKS 32
 #endif
 
-/* To include Sixtop Implementation */
+/* Keep the links sorted by slotframe and timeslot in an array, so that the
+ * next active link is found with a binary search per slotframe rather than
+ * by going through every link. Costs a pointer per link. */
+#ifdef TSCH_SCHEDULE_CONF_LINK_INDEX
+#define TSCH_SCHEDULE_LINK_INDEX TSCH_SCHEDULE_CONF_LINK_INDEX
+#else
+#define TSCH_SCHEDULE_LINK_INDEX 1
+#endif
+
+/* To include Sixtop Implementation. On by default with MSF, which runs on top of it */
 #ifdef TSCH_CONF_WITH_SIXTOP
 #define TSCH_WITH_SIXTOP TSCH_CONF_WITH_SIXTOP
+#elif BUILD_WITH_MSF
+#define TSCH_WITH_SIXTOP 1
 #else
 #define TSCH_WITH_SIXTOP 0
 #endif
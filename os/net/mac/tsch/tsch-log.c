@@ -49,12 +49,389 @@
 #include <stdio.h>
 #include "net/mac/tsch/tsch.h"
 #include "lib/ringbufindex.h"
+#include "sys/critical.h"
 #include "sys/log.h"
 
 #if TSCH_LOG_PER_SLOT
 
 PROCESS_NAME(tsch_pending_events_process);
 
+#if TSCH_LOG_BINARY
+
+/* Check if TSCH_LOG_BINARY_BUF_SIZE is a power of two */
+#if (TSCH_LOG_BINARY_BUF_SIZE & (TSCH_LOG_BINARY_BUF_SIZE - 1)) != 0
+#error TSCH_LOG_BINARY_BUF_SIZE must be power of two
+#endif
+
+/* Header, link, the longest message, and checksum */
+#define RECORD_MAX_LEN (8 + 8 + sizeof(((struct tsch_log_t *)0)->message) + 1)
+
+struct record {
+  uint8_t buf[RECORD_MAX_LEN];
+  uint8_t len;
+};
+
+/* The ring of binary records. Producers encode a record on their stack,
+ * reserve its bytes by moving log_reserve, copy it, and the last producer
+ * to finish moves the head: a record interrupted by the slot operation is
+ * published along with the records of the slot operation, in ring order.
+ * Only tsch_log_process_pending moves the tail: streaming the records
+ * never blocks the slot operation. The indices are free-running. */
+static uint8_t log_ring[TSCH_LOG_BINARY_BUF_SIZE];
+static volatile uint16_t log_head;
+static volatile uint16_t log_reserve;
+static volatile uint16_t log_tail;
+/* Producers between reserve and publish */
+static volatile uint8_t log_writers;
+static int log_dropped = 0;
+static int log_active = 0;
+
+/* The neighbors the records refer to by index */
+static linkaddr_t log_nbrs[TSCH_LOG_BINARY_NBRS];
+static uint8_t log_nbrs_count;
+static uint8_t log_nbrs_next;
+static uint8_t log_self_announced;
+
+/*---------------------------------------------------------------------------*/
+static void
+put_u8(struct record *r, uint8_t value)
+{
+  r->buf[r->len++] = value;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_u16(struct record *r, uint16_t value)
+{
+  put_u8(r, value & 0xff);
+  put_u8(r, value >> 8);
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_start(struct record *r, uint8_t type_flags, const struct tsch_asn_t *asn)
+{
+  r->len = 0;
+  put_u8(r, TSCH_LOG_RECORD_MAGIC);
+  put_u8(r, 0); /* Length, set by record_finish */
+  put_u8(r, type_flags);
+  put_u16(r, asn->ls4b & 0xffff);
+  put_u16(r, asn->ls4b >> 16);
+  put_u8(r, asn->ms1b);
+}
+/*---------------------------------------------------------------------------*/
+/* Set the length of a record and append its checksum */
+static void
+record_finish(struct record *r)
+{
+  uint8_t i;
+  uint8_t sum = 0;
+
+  r->buf[1] = r->len + 1;
+  for(i = 1; i < r->len; i++) {
+    sum += r->buf[i];
+  }
+  put_u8(r, sum);
+}
+/*---------------------------------------------------------------------------*/
+/* Reserve len bytes of the ring. To be called in a critical section,
+ * and followed by record_publish if successful. */
+static int
+record_reserve(uint8_t len, uint16_t *pos)
+{
+  if(TSCH_LOG_BINARY_BUF_SIZE - (uint16_t)(log_reserve - log_tail) < len) {
+    log_dropped++;
+    return 0;
+  }
+  *pos = log_reserve;
+  log_reserve += len;
+  log_writers++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Copy a finished record to the bytes reserved for it, and publish the
+ * records once no producer is copying anymore */
+static void
+record_publish(const struct record *r, uint16_t pos)
+{
+  uint8_t i;
+  int_master_status_t status;
+
+  for(i = 0; i < r->len; i++) {
+    log_ring[(uint16_t)(pos + i) & (TSCH_LOG_BINARY_BUF_SIZE - 1)] = r->buf[i];
+  }
+
+  status = critical_enter();
+  if(--log_writers == 0) {
+    log_head = log_reserve;
+  }
+  critical_exit(status);
+}
+/*---------------------------------------------------------------------------*/
+/* Add a finished record to the ring */
+static int
+record_commit(const struct record *r)
+{
+  uint16_t pos;
+  int ret;
+  int_master_status_t status;
+
+  status = critical_enter();
+  ret = record_reserve(r->len, &pos);
+  critical_exit(status);
+
+  if(ret) {
+    record_publish(r, pos);
+  }
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static void
+announce_start(struct record *r, uint8_t index, const linkaddr_t *addr,
+               const struct tsch_asn_t *asn)
+{
+  uint8_t i;
+
+  record_start(r, TSCH_LOG_RECORD_NBR, asn);
+  put_u8(r, index);
+  put_u8(r, LINKADDR_SIZE);
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    put_u8(r, addr->u8[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The index of a neighbor, or TSCH_LOG_NBR_NONE. To be called in a
+ * critical section. */
+static uint8_t
+find_nbr_index(const linkaddr_t *addr)
+{
+  uint8_t i;
+
+  for(i = 0; i < log_nbrs_count; i++) {
+    if(linkaddr_cmp(&log_nbrs[i], addr)) {
+      return i;
+    }
+  }
+  return TSCH_LOG_NBR_NONE;
+}
+/*---------------------------------------------------------------------------*/
+/* Get the index of a neighbor. The first time, a neighbor record maps
+ * the index to the address. */
+static uint8_t
+get_nbr_index(const linkaddr_t *addr, const struct tsch_asn_t *asn)
+{
+  struct record r;
+  uint16_t pos;
+  uint8_t index;
+  int is_new = 0;
+  int_master_status_t status;
+
+  if(linkaddr_cmp(addr, &linkaddr_null)) {
+    return TSCH_LOG_NBR_NONE;
+  }
+
+  status = critical_enter();
+  index = find_nbr_index(addr);
+  critical_exit(status);
+  if(index != TSCH_LOG_NBR_NONE) {
+    return index;
+  }
+
+  /* The index is set once known */
+  announce_start(&r, TSCH_LOG_NBR_NONE, addr, asn);
+
+  /* Another producer may have added the neighbor in the meantime. The
+   * neighbor record is reserved along with the index, so that it comes
+   * before any record using the index. */
+  status = critical_enter();
+  index = find_nbr_index(addr);
+  if(index == TSCH_LOG_NBR_NONE && record_reserve(r.len + 1, &pos)) {
+    /* Take a new index, or reuse the oldest one */
+    index = log_nbrs_next;
+    linkaddr_copy(&log_nbrs[index], addr);
+    log_nbrs_next = (index + 1) % TSCH_LOG_BINARY_NBRS;
+    if(log_nbrs_count < TSCH_LOG_BINARY_NBRS) {
+      log_nbrs_count++;
+    }
+    is_new = 1;
+  }
+  critical_exit(status);
+
+  if(is_new) {
+    /* The index follows the 8-byte header */
+    r.buf[8] = index;
+    record_finish(&r);
+    record_publish(&r, pos);
+  }
+  return index;
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_record(uint16_t pos, uint8_t len)
+{
+  uint8_t i;
+
+#if TSCH_LOG_BINARY_HEX
+  printf("TSCHB:");
+  for(i = 0; i < len; i++) {
+    printf("%02x", log_ring[(uint16_t)(pos + i) & (TSCH_LOG_BINARY_BUF_SIZE - 1)]);
+  }
+  printf("\n");
+#else /* TSCH_LOG_BINARY_HEX */
+  for(i = 0; i < len; i++) {
+    putchar(log_ring[(uint16_t)(pos + i) & (TSCH_LOG_BINARY_BUF_SIZE - 1)]);
+  }
+#endif /* TSCH_LOG_BINARY_HEX */
+}
+/*---------------------------------------------------------------------------*/
+/* Stream pending records */
+void
+tsch_log_process_pending(void)
+{
+  static int last_log_dropped = 0;
+  uint16_t head = log_head;
+
+  if(log_dropped != last_log_dropped) {
+    printf("[WARN: TSCH-LOG  ] logs dropped %u\n", log_dropped);
+    last_log_dropped = log_dropped;
+  }
+  while(log_tail != head) {
+    uint8_t len = log_ring[(uint16_t)(log_tail + 1) & (TSCH_LOG_BINARY_BUF_SIZE - 1)];
+    write_record(log_tail, len);
+    log_tail += len;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Prepare a new log. Returns 1 if logging is active */
+int
+tsch_log_prepare_record(struct tsch_log_t *log)
+{
+  if(log_active == 0) {
+    return 0;
+  }
+  log->asn = tsch_current_asn;
+  log->link = current_link;
+  log->burst_count = tsch_current_burst_count;
+  log->channel = tsch_current_channel;
+  log->channel_offset = tsch_current_channel_offset;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Encode a log and add it to the ring */
+void
+tsch_log_commit_record(const struct tsch_log_t *log)
+{
+  struct record r;
+  struct tsch_slotframe *sf;
+  uint8_t type;
+  uint8_t nbr_index = TSCH_LOG_NBR_NONE;
+
+  /* Logs from outside the slot operation may be interrupted by it: the
+   * record is encoded on the stack, and only the ring and the neighbor
+   * indices are updated in critical sections */
+  if(!log_self_announced) {
+    announce_start(&r, TSCH_LOG_NBR_SELF, &linkaddr_node_addr, &log->asn);
+    record_finish(&r);
+    log_self_announced = record_commit(&r);
+  }
+
+  switch(log->type) {
+    case tsch_log_tx:
+      type = TSCH_LOG_RECORD_TX
+        | (log->tx.is_data ? TSCH_LOG_RECORD_FLAG_DATA : 0)
+        | (log->tx.drift_used ? TSCH_LOG_RECORD_FLAG_DRIFT : 0);
+      if(!linkaddr_cmp(&log->tx.dest, &linkaddr_null)) {
+        type |= TSCH_LOG_RECORD_FLAG_UNICAST;
+      }
+      nbr_index = get_nbr_index(&log->tx.dest, &log->asn);
+      break;
+    case tsch_log_rx:
+      type = TSCH_LOG_RECORD_RX
+        | (log->rx.is_unicast ? TSCH_LOG_RECORD_FLAG_UNICAST : 0)
+        | (log->rx.is_data ? TSCH_LOG_RECORD_FLAG_DATA : 0)
+        | (log->rx.drift_used ? TSCH_LOG_RECORD_FLAG_DRIFT : 0);
+      nbr_index = get_nbr_index(&log->rx.src, &log->asn);
+      break;
+    default:
+      type = TSCH_LOG_RECORD_MESSAGE;
+      break;
+  }
+
+  record_start(&r, type, &log->asn);
+  if(log->link == NULL) {
+    put_u8(&r, 0xff);
+    put_u16(&r, 0);
+    put_u16(&r, 0);
+  } else {
+    sf = tsch_schedule_get_slotframe_by_handle(log->link->slotframe_handle);
+    put_u8(&r, log->link->slotframe_handle);
+    put_u16(&r, sf ? sf->size.val : 0);
+    put_u16(&r, log->link->timeslot);
+  }
+  put_u8(&r, log->burst_count);
+  put_u8(&r, log->channel_offset);
+  put_u8(&r, log->channel);
+
+  switch(log->type) {
+    case tsch_log_tx:
+      put_u8(&r, nbr_index);
+      put_u8(&r, log->tx.seqno);
+      put_u8(&r, log->tx.datalen);
+      put_u8(&r, log->tx.sec_level);
+      put_u8(&r, log->tx.mac_tx_status);
+      put_u8(&r, log->tx.num_tx);
+      put_u16(&r, log->tx.drift);
+      put_u16(&r, 0);
+      break;
+    case tsch_log_rx:
+      put_u8(&r, nbr_index);
+      put_u8(&r, log->rx.seqno);
+      put_u8(&r, log->rx.datalen);
+      put_u8(&r, log->rx.sec_level);
+      put_u8(&r, 0);
+      put_u8(&r, 0);
+      put_u16(&r, log->rx.drift);
+      put_u16(&r, log->rx.estimated_drift);
+      break;
+    default: {
+      uint8_t i;
+      for(i = 0; i < sizeof(log->message) && log->message[i] != '\0'; i++) {
+        put_u8(&r, log->message[i]);
+      }
+      break;
+    }
+  }
+  record_finish(&r);
+  record_commit(&r);
+
+  process_poll(&tsch_pending_events_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Initialize log module */
+void
+tsch_log_init(void)
+{
+  if(log_active == 0) {
+    log_head = log_reserve = log_tail = 0;
+    log_writers = 0;
+    /* Start over with the neighbor indices, the decoder may have missed them */
+    log_nbrs_count = 0;
+    log_nbrs_next = 0;
+    log_self_announced = 0;
+    log_active = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Stop log module */
+void
+tsch_log_stop(void)
+{
+  if(log_active == 1) {
+    tsch_log_process_pending();
+    log_active = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+#else /* TSCH_LOG_BINARY */
+
 /* Check if TSCH_LOG_QUEUE_LEN is a power of two */
 #if (TSCH_LOG_QUEUE_LEN & (TSCH_LOG_QUEUE_LEN - 1)) != 0
 #error TSCH_LOG_QUEUE_LEN must be power of two
@@ -176,5 +553,6 @@ tsch_log_stop(void)
   }
 }
 
+#endif /* TSCH_LOG_BINARY */
 #endif /* TSCH_LOG_PER_SLOT */
 /** @} */
@@ -62,6 +62,63 @@
 #define TSCH_LOG_QUEUE_LEN 8
 #endif /* TSCH_LOG_CONF_QUEUE_LEN */
 
+/* Store the logs as compact binary records, and stream them raw rather than
+ * formatting them. tools/log-decode/tsch-log-decode.py renders them on the host. */
+#ifdef TSCH_LOG_CONF_BINARY
+#define TSCH_LOG_BINARY TSCH_LOG_CONF_BINARY
+#else /* TSCH_LOG_CONF_BINARY */
+#define TSCH_LOG_BINARY 0
+#endif /* TSCH_LOG_CONF_BINARY */
+
+/* The size of the binary record ring, in bytes. Must be a power of two.
+ * Tx and Rx records take 27 bytes. Replaces TSCH_LOG_QUEUE_LEN. */
+#ifdef TSCH_LOG_CONF_BINARY_BUF_SIZE
+#define TSCH_LOG_BINARY_BUF_SIZE TSCH_LOG_CONF_BINARY_BUF_SIZE
+#else /* TSCH_LOG_CONF_BINARY_BUF_SIZE */
+#define TSCH_LOG_BINARY_BUF_SIZE 512
+#endif /* TSCH_LOG_CONF_BINARY_BUF_SIZE */
+
+/* Binary records refer to neighbors by index. The number of neighbors the
+ * log keeps an index for; the oldest index is reused when they are all taken. */
+#ifdef TSCH_LOG_CONF_BINARY_NBRS
+#define TSCH_LOG_BINARY_NBRS TSCH_LOG_CONF_BINARY_NBRS
+#else /* TSCH_LOG_CONF_BINARY_NBRS */
+#define TSCH_LOG_BINARY_NBRS 16
+#endif /* TSCH_LOG_CONF_BINARY_NBRS */
+
+/* Print the binary records as "TSCHB:<hex>" lines rather than raw, for
+ * consoles that only handle text, e.g. Cooja */
+#ifdef TSCH_LOG_CONF_BINARY_HEX
+#define TSCH_LOG_BINARY_HEX TSCH_LOG_CONF_BINARY_HEX
+#else /* TSCH_LOG_CONF_BINARY_HEX */
+#define TSCH_LOG_BINARY_HEX 0
+#endif /* TSCH_LOG_CONF_BINARY_HEX */
+
+/* Binary record format, little endian. Each record starts with
+ * TSCH_LOG_RECORD_MAGIC and its total length, and ends with the sum of
+ * all bytes from the length on, modulo 256. The header is:
+ *   magic, len, type | flags, ASN (4 bytes ls4b, 1 byte ms1b)
+ * Tx, Rx and message records continue with the link:
+ *   slotframe handle (0xff if no link), slotframe size (2),
+ *   timeslot (2), burst count, channel offset, channel
+ * Tx and Rx records then hold:
+ *   neighbor index, seqno, datalen, security level,
+ *   MAC Tx status, number of transmissions, drift (2), estimated drift (2)
+ * Message records hold the text, neighbor records map an index to an address:
+ *   index, address length, address */
+#define TSCH_LOG_RECORD_MAGIC         0xa5
+#define TSCH_LOG_RECORD_TYPE_MASK     0x07
+#define TSCH_LOG_RECORD_TX            0
+#define TSCH_LOG_RECORD_RX            1
+#define TSCH_LOG_RECORD_MESSAGE       2
+#define TSCH_LOG_RECORD_NBR           3
+#define TSCH_LOG_RECORD_FLAG_UNICAST  0x08
+#define TSCH_LOG_RECORD_FLAG_DATA     0x10
+#define TSCH_LOG_RECORD_FLAG_DRIFT    0x20
+/* Neighbor index of the node itself, and of no neighbor */
+#define TSCH_LOG_NBR_SELF             0xfe
+#define TSCH_LOG_NBR_NONE             0xff
+
 #if (TSCH_LOG_PER_SLOT == 0)
 
 #define tsch_log_init()
@@ -112,6 +169,19 @@ struct tsch_log_t {
 
 /********** Functions *********/
 
+#if TSCH_LOG_BINARY
+/**
+ * \brief Prepare a new log, to be added as a binary record
+ * \param log The log to fill in with the current ASN and link
+ * \return 1 if logging is active, 0 otherwise
+ */
+int tsch_log_prepare_record(struct tsch_log_t *log);
+/**
+ * \brief Encode a log as a binary record and add it to the ring
+ * \param log The log to add
+ */
+void tsch_log_commit_record(const struct tsch_log_t *log);
+#else /* TSCH_LOG_BINARY */
 /**
  * \brief Prepare addition of a new log.
  * \return A pointer to log structure if success, NULL otherwise
@@ -121,6 +191,7 @@ struct tsch_log_t *tsch_log_prepare_add(void);
  * \brief Actually add the previously prepared log
  */
 void tsch_log_commit(void);
+#endif /* TSCH_LOG_BINARY */
 /**
  * \brief Initialize log module
  */
@@ -136,6 +207,19 @@ void tsch_log_stop(void);
 
 /************ Macros **********/
 
+#if TSCH_LOG_BINARY
+/** \brief Use this macro to add a log to the queue (will be encoded right
+ * away, and streamed later, after leaving interrupt context) */
+#define TSCH_LOG_ADD(log_type, init_code) do { \
+    struct tsch_log_t log_entry; \
+    struct tsch_log_t *log = &log_entry; \
+    if(tsch_log_prepare_record(log)) { \
+      log->type = (log_type); \
+      init_code; \
+      tsch_log_commit_record(log); \
+    } \
+} while(0);
+#else /* TSCH_LOG_BINARY */
 /** \brief Use this macro to add a log to the queue (will be printed out
  * later, after leaving interrupt context) */
 #define TSCH_LOG_ADD(log_type, init_code) do { \
@@ -146,6 +230,7 @@ void tsch_log_stop(void);
       tsch_log_commit(); \
     } \
 } while(0);
+#endif /* TSCH_LOG_BINARY */
 
 #endif /* (TSCH_LOG_PER_SLOT == 0) */
 
@@ -189,10 +189,14 @@ tsch_packet_parse_eack(const uint8_t *buf, int buf_size,
   }
 
   if(ies != NULL) {
-    memset(ies, 0, sizeof(struct ieee802154_ies));
+    ies->ie_time_correction = 0;
+    ies->ie_is_nack = 0;
+    ies->ie_payload_ie_offset = 0;
   }
 
   if(frame->fcf.ie_list_present) {
+    struct frame802154e_ie_iterator it;
+    struct frame802154e_ie ie;
     int mic_len = 0;
 #if LLSEC802154_ENABLED
     /* Check if there is space for the security MIC (if any) */
@@ -201,15 +205,27 @@ tsch_packet_parse_eack(const uint8_t *buf, int buf_size,
       return 0;
     }
 #endif /* LLSEC802154_ENABLED */
-    /* Parse information elements. We need to substract the MIC length, as the exact payload len is needed while parsing */
-    if((ret = frame802154e_parse_information_elements(buf + curr_len, buf_size - curr_len - mic_len, ies)) == -1) {
+    /* Walk the information elements, decoding only the time correction.
+     * We need to substract the MIC length, as the exact payload len is
+     * needed while parsing */
+    frame802154e_ie_iterator_init(&it, buf + curr_len,
+                                  buf_size - curr_len - mic_len);
+    while((ret = frame802154e_ie_next(&it, &ie)) > 0) {
+      if(ies != NULL) {
+        frame802154e_ie_read_time_correction(&ie, &ies->ie_time_correction,
+                                             &ies->ie_is_nack);
+      }
+    }
+    if(ret < 0) {
       return 0;
     }
-    curr_len += ret;
-  }
-
-  if(hdr_len != NULL) {
-    *hdr_len += ies->ie_payload_ie_offset;
+    curr_len += it.offset;
+    if(ies != NULL) {
+      ies->ie_payload_ie_offset = it.header_len;
+    }
+    if(hdr_len != NULL) {
+      *hdr_len += it.header_len;
+    }
   }
 
   return curr_len;
@@ -220,7 +236,7 @@ int
 tsch_packet_create_eb(uint8_t *hdr_len, uint8_t *tsch_sync_ie_offset)
 {
   struct ieee802154_ies ies;
-  uint8_t *p;
+  struct frame802154e_ie_builder builder;
   int ie_len;
   const uint16_t payload_ie_hdr_len = 2;
 
@@ -270,68 +286,31 @@ tsch_packet_create_eb(uint8_t *hdr_len, uint8_t *tsch_sync_ie_offset)
   }
 #endif /* TSCH_PACKET_EB_WITH_SLOTFRAME_AND_LINK */
 
-  p = packetbuf_dataptr();
-
-  ie_len = frame80215e_create_ie_tsch_synchronization(p,
-                                                      packetbuf_remaininglen(),
-                                                      &ies);
-  if(ie_len < 0) {
-    return -1;
-  }
-  p += ie_len;
-  packetbuf_set_datalen(packetbuf_datalen() + ie_len);
-
-  ie_len = frame80215e_create_ie_tsch_timeslot(p,
-                                               packetbuf_remaininglen(),
-                                               &ies);
-  if(ie_len < 0) {
-    return -1;
-  }
-  p += ie_len;
-  packetbuf_set_datalen(packetbuf_datalen() + ie_len);
-
-  ie_len = frame80215e_create_ie_tsch_channel_hopping_sequence(p,
-                                                               packetbuf_remaininglen(),
-                                                               &ies);
-  if(ie_len < 0) {
-    return -1;
-  }
-  p += ie_len;
-  packetbuf_set_datalen(packetbuf_datalen() + ie_len);
-
-  ie_len = frame80215e_create_ie_tsch_slotframe_and_link(p,
-                                                         packetbuf_remaininglen(),
-                                                         &ies);
-  if(ie_len < 0) {
+  /* Write the IEs in place, nested in a MLME payload IE */
+  frame802154e_ie_builder_init(&builder, packetbuf_dataptr(),
+                               packetbuf_remaininglen());
+  if(frame802154e_ie_builder_begin_mlme(&builder) < 0
+     || frame802154e_ie_builder_add(&builder,
+          frame80215e_create_ie_tsch_synchronization, &ies) < 0
+     || frame802154e_ie_builder_add(&builder,
+          frame80215e_create_ie_tsch_timeslot, &ies) < 0
+     || frame802154e_ie_builder_add(&builder,
+          frame80215e_create_ie_tsch_channel_hopping_sequence, &ies) < 0
+     || frame802154e_ie_builder_add(&builder,
+          frame80215e_create_ie_tsch_slotframe_and_link, &ies) < 0
+     || frame802154e_ie_builder_end_mlme(&builder) < 0) {
     return -1;
   }
-  p += ie_len;
-  packetbuf_set_datalen(packetbuf_datalen() + ie_len);
 
 #if 0
   /* Payload IE list termination: optional */
-  ie_len = frame80215e_create_ie_payload_list_termination(p,
-                                                          packetbuf_remaininglen(),
-                                                          &ies);
-  if(ie_len < 0) {
+  if(frame802154e_ie_builder_add(&builder,
+       frame80215e_create_ie_payload_list_termination, &ies) < 0) {
     return -1;
   }
-  p += ie_len;
-  packetbuf_set_datalen(packetbuf_datalen() + ie_len);
 #endif
 
-  ies.ie_mlme_len = packetbuf_datalen();
-
-  /* make room for Payload IE header */
-  memmove((uint8_t *)packetbuf_dataptr() + payload_ie_hdr_len,
-          packetbuf_dataptr(), packetbuf_datalen());
-  packetbuf_set_datalen(packetbuf_datalen() + payload_ie_hdr_len);
-  ie_len = frame80215e_create_ie_mlme(packetbuf_dataptr(),
-                                      packetbuf_remaininglen(),
-                                      &ies);
-  if(ie_len < 0) {
-    return -1;
-  }
+  packetbuf_set_datalen(builder.len);
 
   /* allocate space for Header Termination IE, the size of which is 2 octets */
   packetbuf_hdralloc(2);
@@ -382,13 +361,15 @@ tsch_packet_update_eb(uint8_t *buf, int buf_size, uint8_t tsch_sync_ie_offset)
   return frame80215e_create_ie_tsch_synchronization(buf+tsch_sync_ie_offset, buf_size-tsch_sync_ie_offset, &ies) != -1;
 }
 /*---------------------------------------------------------------------------*/
-/* Parse a IEEE 802.15.4e TSCH Enhanced Beacon (EB) */
+/* Parse the header of a IEEE 802.15.4e TSCH Enhanced Beacon (EB) */
 int
-tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
-                     frame802154_t *frame, struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic)
+tsch_packet_parse_eb_header(const uint8_t *buf, int buf_size,
+                            frame802154_t *frame,
+                            struct frame802154e_ie_iterator *it,
+                            int frame_without_mic)
 {
-  uint8_t curr_len = 0;
   int ret;
+  int mic_len = 0;
 
   if(frame == NULL || buf_size < 0) {
     return 0;
@@ -413,6 +394,41 @@ tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
     return 0;
   }
 
+  if(!frame->fcf.ie_list_present) {
+    /* No IEs to walk */
+    frame802154e_ie_iterator_init(it, buf + ret, 0);
+    return ret;
+  }
+
+  /* Calculate space needed for the security MIC, if any, before attempting to parse IEs */
+#if LLSEC802154_ENABLED
+  if(!frame_without_mic) {
+    mic_len = tsch_security_mic_len(frame);
+    if(buf_size < ret + mic_len) {
+      return 0;
+    }
+  }
+#endif /* LLSEC802154_ENABLED */
+
+  /* We need to substract the MIC length, as the exact payload len is needed while parsing */
+  frame802154e_ie_iterator_init(it, buf + ret, buf_size - ret - mic_len);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+/* Parse a IEEE 802.15.4e TSCH Enhanced Beacon (EB) */
+int
+tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
+                     frame802154_t *frame, struct ieee802154_ies *ies, uint8_t *hdr_len, int frame_without_mic)
+{
+  struct frame802154e_ie_iterator it;
+  uint8_t curr_len = 0;
+  int ret;
+
+  if((ret = tsch_packet_parse_eb_header(buf, buf_size, frame, &it,
+                                        frame_without_mic)) == 0) {
+    return 0;
+  }
+
   if(hdr_len != NULL) {
     *hdr_len = ret;
   }
@@ -423,27 +439,15 @@ tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
     ies->ie_join_priority = 0xff; /* Use max value in case the Beacon does not include a join priority */
   }
   if(frame->fcf.ie_list_present) {
-    /* Calculate space needed for the security MIC, if any, before attempting to parse IEs */
-    int mic_len = 0;
-#if LLSEC802154_ENABLED
-    if(!frame_without_mic) {
-      mic_len = tsch_security_mic_len(frame);
-      if(buf_size < curr_len + mic_len) {
-        return 0;
-      }
-    }
-#endif /* LLSEC802154_ENABLED */
-
-    /* Parse information elements. We need to substract the MIC length, as the exact payload len is needed while parsing */
-    if((ret = frame802154e_parse_information_elements(buf + curr_len, buf_size - curr_len - mic_len, ies)) == -1) {
+    /* Parse information elements */
+    if((ret = frame802154e_parse_information_elements(it.buf, it.size, ies)) == -1) {
       LOG_ERR("! parse_eb: failed to parse IEs\n");
       return 0;
     }
     curr_len += ret;
-  }
-
-  if(hdr_len != NULL) {
-    *hdr_len += ies->ie_payload_ie_offset;
+    if(hdr_len != NULL) {
+      *hdr_len += ies->ie_payload_ie_offset;
+    }
   }
 
   return curr_len;
@@ -101,6 +101,19 @@ int tsch_packet_update_eb(uint8_t *buf, int buf_size, uint8_t tsch_sync_ie_offse
 int tsch_packet_parse_eb(const uint8_t *buf, int buf_size,
     frame802154_t *frame, struct ieee802154_ies *ies,
     uint8_t *hdrlen, int frame_without_mic);
+/**
+ * \brief Parse the header of an EB, up to its IEs, and set up an iterator
+ * over the IEs, so that only the IEs of interest get decoded
+ * \param buf The buffer where to parse the EB from
+ * \param buf_size The buffer size
+ * \param frame The frame structure where to store parsed fields
+ * \param it The iterator to initialize, over the IEs of the EB
+ * \param frame_without_mic When set, the security MIC will not be parsed
+ * \return The length of the header, before the IEs, or 0 if the frame is not a valid EB
+ */
+int tsch_packet_parse_eb_header(const uint8_t *buf, int buf_size,
+    frame802154_t *frame, struct frame802154e_ie_iterator *it,
+    int frame_without_mic);
 /**
  * \brief Set frame pending bit in a packet (whose header was already build)
  * \param buf The buffer where the packet resides
@@ -75,12 +75,43 @@ NBR_TABLE(struct tsch_neighbor, tsch_neighbors);
 struct tsch_neighbor *n_broadcast;
 struct tsch_neighbor *n_eb;
 
+/* The neighbor last served on a shared link, for round-robin */
+static struct tsch_neighbor *last_served_nbr;
+/* Set from the slot operation when it skips packets past their max age */
+static volatile uint8_t stale_packets;
+
+/*---------------------------------------------------------------------------*/
+/* Priority class of the packet in packetbuf */
+static uint8_t
+packetbuf_class(void)
+{
+  return MIN(packetbuf_attr(PACKETBUF_ATTR_PRIORITY), TSCH_QUEUE_PRIORITY_CLASSES - 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Has the packet been queued for longer than its max age? */
+static int
+packet_is_stale(const struct tsch_packet *p)
+{
+  return p->max_age != 0
+    && (int32_t)TSCH_ASN_DIFF(tsch_current_asn, p->enqueue_asn) > p->max_age;
+}
+/*---------------------------------------------------------------------------*/
+#if TSCH_WITH_SIXTOP
+/* Is the packet a 6P message? Among unicast data frames, only 6P ones
+ * carry payload IEs */
+static int
+packet_is_sixtop(const struct tsch_packet *p)
+{
+  return queuebuf_attr(p->qb, PACKETBUF_ATTR_MAC_METADATA) != 0;
+}
+#endif /* TSCH_WITH_SIXTOP */
 /*---------------------------------------------------------------------------*/
 /* Add a TSCH neighbor */
 struct tsch_neighbor *
 tsch_queue_add_nbr(const linkaddr_t *addr)
 {
   struct tsch_neighbor *n = NULL;
+  int c;
   /* If we have an entry for this neighbor already, we simply update it */
   n = tsch_queue_get_nbr(addr);
   if(n == NULL) {
@@ -94,10 +125,13 @@ tsch_queue_add_nbr(const linkaddr_t *addr)
         nbr_table_lock(tsch_neighbors, n);
         /* Initialize neighbor entry */
         memset(n, 0, sizeof(struct tsch_neighbor));
-        ringbufindex_init(&n->tx_ringbuf, TSCH_QUEUE_NUM_PER_NEIGHBOR);
+        for(c = 0; c < TSCH_QUEUE_PRIORITY_CLASSES; c++) {
+          ringbufindex_init(&n->tx_ringbuf[c], TSCH_QUEUE_NUM_PER_NEIGHBOR);
+        }
         n->is_broadcast = linkaddr_cmp(addr, &tsch_eb_address)
           || linkaddr_cmp(addr, &tsch_broadcast_address);
         tsch_queue_backoff_reset(n);
+        tsch_stats_on_neighbor_added(n);
       }
       tsch_release_lock();
     }
@@ -105,6 +139,20 @@ tsch_queue_add_nbr(const linkaddr_t *addr)
   return n;
 }
 /*---------------------------------------------------------------------------*/
+/* Get the first TSCH neighbor */
+struct tsch_neighbor *
+tsch_queue_first_nbr(void)
+{
+  return (struct tsch_neighbor *)nbr_table_head(tsch_neighbors);
+}
+/*---------------------------------------------------------------------------*/
+/* Get the TSCH neighbor that follows a given one */
+struct tsch_neighbor *
+tsch_queue_next_nbr(struct tsch_neighbor *n)
+{
+  return (struct tsch_neighbor *)nbr_table_next(tsch_neighbors, n);
+}
+/*---------------------------------------------------------------------------*/
 /* Get a TSCH neighbor */
 struct tsch_neighbor *
 tsch_queue_get_nbr(const linkaddr_t *addr)
@@ -212,7 +260,9 @@ tsch_queue_remove_nbr(struct tsch_neighbor *n)
 {
   if(n != NULL) {
     if(tsch_get_lock()) {
-
+      if(last_served_nbr == n) {
+        last_served_nbr = NULL;
+      }
       tsch_release_lock();
 
       /* Flush queue */
@@ -232,6 +282,7 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
   struct tsch_neighbor *n = NULL;
   int16_t put_index = -1;
   struct tsch_packet *p = NULL;
+  uint8_t class = packetbuf_class();
 
 #ifdef TSCH_CALLBACK_PACKET_READY
   /* The scheduler provides a callback which sets the timeslot and other attributes */
@@ -245,7 +296,7 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      put_index = ringbufindex_peek_put(&n->tx_ringbuf);
+      put_index = ringbufindex_peek_put(&n->tx_ringbuf[class]);
       if(put_index != -1) {
         p = memb_alloc(&packet_memb);
         if(p != NULL) {
@@ -257,11 +308,13 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
             p->ret = MAC_TX_DEFERRED;
             p->transmissions = 0;
             p->max_transmissions = max_transmissions;
+            p->max_age = TSCH_QUEUE_MAX_AGE;
+            p->enqueue_asn = tsch_current_asn;
             /* Add to ringbuf (actual add committed through atomic operation) */
-            n->tx_array[put_index] = p;
-            ringbufindex_put(&n->tx_ringbuf);
-            LOG_DBG("packet is added put_index %u, packet %p\n",
-                   put_index, p);
+            n->tx_array[class][put_index] = p;
+            ringbufindex_put(&n->tx_ringbuf[class]);
+            LOG_DBG("packet is added class %u put_index %u, packet %p\n",
+                   class, put_index, p);
             return p;
           } else {
             memb_free(&packet_memb, p);
@@ -286,29 +339,51 @@ int
 tsch_queue_nbr_packet_count(const struct tsch_neighbor *n)
 {
   if(n != NULL) {
-    return ringbufindex_elements(&n->tx_ringbuf);
+    int count = 0;
+    int c;
+    for(c = 0; c < TSCH_QUEUE_PRIORITY_CLASSES; c++) {
+      count += ringbufindex_elements(&n->tx_ringbuf[c]);
+    }
+    return count;
   }
   return -1;
 }
 /*---------------------------------------------------------------------------*/
-/* Remove first packet from a neighbor queue */
+/* Remove first packet from the highest non-empty class of a neighbor queue */
 struct tsch_packet *
 tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n)
 {
   if(!tsch_is_locked()) {
     if(n != NULL) {
-      /* Get and remove packet from ringbuf (remove committed through an atomic operation */
-      int16_t get_index = ringbufindex_get(&n->tx_ringbuf);
-      if(get_index != -1) {
-        return n->tx_array[get_index];
-      } else {
-        return NULL;
+      int c;
+      for(c = TSCH_QUEUE_PRIORITY_CLASSES - 1; c >= 0; c--) {
+        /* Get and remove packet from ringbuf (remove committed through an atomic operation */
+        int16_t get_index = ringbufindex_get(&n->tx_ringbuf[c]);
+        if(get_index != -1) {
+          return n->tx_array[c][get_index];
+        }
       }
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Remove a given packet from the head of its class queue. A packet of a higher
+ * class may have been queued since p was picked for transmission */
+static void
+remove_packet(struct tsch_neighbor *n, const struct tsch_packet *p)
+{
+  int c;
+  for(c = TSCH_QUEUE_PRIORITY_CLASSES - 1; c >= 0; c--) {
+    int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf[c]);
+    if(get_index != -1 && n->tx_array[c][get_index] == p) {
+      ringbufindex_get(&n->tx_ringbuf[c]);
+      tsch_stats_on_packet_dequeued(TSCH_ASN_DIFF(tsch_current_asn, p->enqueue_asn));
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* Free a packet */
 void
 tsch_queue_free_packet(struct tsch_packet *p)
@@ -330,7 +405,7 @@ tsch_queue_packet_sent(struct tsch_neighbor *n, struct tsch_packet *p,
 
   if(mac_tx_status == MAC_TX_OK) {
     /* Successful transmission */
-    tsch_queue_remove_packet_from_queue(n);
+    remove_packet(n, p);
     in_queue = 0;
 
     /* Update CSMA state in the unicast case */
@@ -345,7 +420,7 @@ tsch_queue_packet_sent(struct tsch_neighbor *n, struct tsch_packet *p,
     /* Failed transmission */
     if(p->transmissions >= p->max_transmissions) {
       /* Drop packet */
-      tsch_queue_remove_packet_from_queue(n);
+      remove_packet(n, p);
       in_queue = 0;
     }
     /* Update CSMA state in the unicast case */
@@ -404,37 +479,92 @@ tsch_queue_free_unused_neighbors(void)
 int
 tsch_queue_is_empty(const struct tsch_neighbor *n)
 {
-  return !tsch_is_locked() && n != NULL && ringbufindex_empty(&n->tx_ringbuf);
+  int c;
+  if(tsch_is_locked() || n == NULL) {
+    return 0;
+  }
+  for(c = 0; c < TSCH_QUEUE_PRIORITY_CLASSES; c++) {
+    if(!ringbufindex_empty(&n->tx_ringbuf[c])) {
+      return 0;
+    }
+  }
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
-/* Returns the first packet from a neighbor queue */
-struct tsch_packet *
-tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, struct tsch_link *link)
+/* Returns the head packet of the highest class that can be sent on a link,
+ * and writes its class in *class. With bound_only, only packets meant for
+ * this very link are considered: 6P messages on a shared link, and packets
+ * the link selector assigned to its slotframe */
+static struct tsch_packet *
+get_packet_for_nbr(const struct tsch_neighbor *n, struct tsch_link *link,
+                   int *class, int bound_only)
 {
-  if(!tsch_is_locked()) {
-    int is_shared_link = link != NULL && link->link_options & LINK_OPTION_SHARED;
-    if(n != NULL) {
-      int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf);
-      if(get_index != -1 &&
-          !(is_shared_link && !tsch_queue_backoff_expired(n))) {    /* If this is a shared link,
-                                                                    make sure the backoff has expired */
+  int is_shared_link = link != NULL && link->link_options & LINK_OPTION_SHARED;
+  int c;
+
+  /* If this is a shared link, make sure the backoff has expired */
+  if(n == NULL || (is_shared_link && !tsch_queue_backoff_expired(n))) {
+    return NULL;
+  }
+
+  for(c = TSCH_QUEUE_PRIORITY_CLASSES - 1; c >= 0; c--) {
+    int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf[c]);
+    if(get_index != -1) {
+      struct tsch_packet *p = n->tx_array[c][get_index];
+      int is_bound = 0;
+      if(packet_is_stale(p)) {
+        /* Do not spend a slot on it, have tsch_queue_drop_stale_packets drop it */
+        stale_packets = 1;
+        process_poll(&tsch_pending_events_process);
+        continue;
+      }
 #if TSCH_WITH_LINK_SELECTOR
-        int packet_attr_slotframe = queuebuf_attr(n->tx_array[get_index]->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
-        int packet_attr_timeslot = queuebuf_attr(n->tx_array[get_index]->qb, PACKETBUF_ATTR_TSCH_TIMESLOT);
+      int packet_attr_slotframe = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
+      int packet_attr_timeslot = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_TIMESLOT);
+      /* A link to the neighbor itself takes any of its packets */
+      if(n->is_broadcast
+         || !linkaddr_cmp(&link->addr, tsch_queue_get_nbr_address(n))) {
         if(packet_attr_slotframe != 0xffff && packet_attr_slotframe != link->slotframe_handle) {
-          return NULL;
+          continue;
         }
         if(packet_attr_timeslot != 0xffff && packet_attr_timeslot != link->timeslot) {
-          return NULL;
+          continue;
         }
+      }
+      is_bound = packet_attr_slotframe == link->slotframe_handle;
 #endif
-        return n->tx_array[get_index];
+#if TSCH_WITH_SIXTOP
+      if(!n->is_broadcast && link != NULL && packet_is_sixtop(p)) {
+        if(!is_shared_link) {
+          /* 6P messages go on shared links only, as the dedicated links to
+           * the peer may be the very cells being negotiated */
+          continue;
+        }
+        is_bound = 1;
+      }
+#endif /* TSCH_WITH_SIXTOP */
+      if(bound_only && !is_bound) {
+        continue;
       }
+      if(class != NULL) {
+        *class = c;
+      }
+      return p;
     }
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the first packet from a neighbor queue */
+struct tsch_packet *
+tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, struct tsch_link *link)
+{
+  if(!tsch_is_locked()) {
+    return get_packet_for_nbr(n, link, NULL, 0);
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 /* Returns the head packet from a neighbor queue (from neighbor address) */
 struct tsch_packet *
 tsch_queue_get_packet_for_dest_addr(const linkaddr_t *addr, struct tsch_link *link)
@@ -446,30 +576,129 @@ tsch_queue_get_packet_for_dest_addr(const linkaddr_t *addr, struct tsch_link *li
 }
 /*---------------------------------------------------------------------------*/
 /* Returns the head packet of any neighbor queue with zero backoff counter.
+ * Serves the highest class first, and neighbors in turn within a class.
  * Writes pointer to the neighbor in *n */
 struct tsch_packet *
 tsch_queue_get_unicast_packet_for_any(struct tsch_neighbor **n, struct tsch_link *link)
 {
   if(!tsch_is_locked()) {
-    struct tsch_neighbor *curr_nbr = (struct tsch_neighbor *)nbr_table_head(tsch_neighbors);
-    struct tsch_packet *p = NULL;
+    struct tsch_neighbor *first_nbr = NULL;
+    struct tsch_neighbor *curr_nbr;
+    struct tsch_neighbor *best_nbr = NULL;
+    struct tsch_packet *best_p = NULL;
+    int best_class = -1;
+
+    /* Start right after the neighbor served last */
+    if(last_served_nbr != NULL) {
+      first_nbr = (struct tsch_neighbor *)nbr_table_next(tsch_neighbors, last_served_nbr);
+    }
+    if(first_nbr == NULL) {
+      first_nbr = (struct tsch_neighbor *)nbr_table_head(tsch_neighbors);
+    }
+
+    curr_nbr = first_nbr;
     while(curr_nbr != NULL) {
+#if TSCH_WITH_LINK_SELECTOR || TSCH_WITH_SIXTOP
+      if(!curr_nbr->is_broadcast) {
+        /* Look up for non-broadcast neighbors we do not have a tx link to,
+         * and for packets meant for this link to the others */
+#else
       if(!curr_nbr->is_broadcast && curr_nbr->tx_links_count == 0) {
         /* Only look up for non-broadcast neighbors we do not have a tx link to */
-        p = tsch_queue_get_packet_for_nbr(curr_nbr, link);
-        if(p != NULL) {
-          if(n != NULL) {
-            *n = curr_nbr;
+#endif
+        int class;
+        struct tsch_packet *p = get_packet_for_nbr(curr_nbr, link, &class,
+                                                   curr_nbr->tx_links_count > 0);
+        if(p != NULL && class > best_class
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+           /* Pass over a neighbor whose packet is deferred, rather than
+            * count it as served */
+           && !tsch_is_packet_deferred(link, p, curr_nbr)
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
+           ) {
+          best_p = p;
+          best_nbr = curr_nbr;
+          best_class = class;
+          if(class == TSCH_QUEUE_PRIORITY_CLASSES - 1) {
+            break;
           }
-          return p;
         }
       }
       curr_nbr = (struct tsch_neighbor *)nbr_table_next(tsch_neighbors, curr_nbr);
+      if(curr_nbr == NULL) {
+        curr_nbr = (struct tsch_neighbor *)nbr_table_head(tsch_neighbors);
+      }
+      if(curr_nbr == first_nbr) {
+        break;
+      }
+    }
+
+    if(best_p != NULL) {
+      last_served_nbr = best_nbr;
+      if(n != NULL) {
+        *n = best_nbr;
+      }
+    }
+    return best_p;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Removes the head packet of a neighbor queue if it is past its max age.
+ * Called with the lock held, i.e., while no slot operation is running */
+static struct tsch_packet *
+remove_stale_packet(void)
+{
+  struct tsch_neighbor *n = (struct tsch_neighbor *)nbr_table_head(tsch_neighbors);
+  while(n != NULL) {
+    int c;
+    for(c = 0; c < TSCH_QUEUE_PRIORITY_CLASSES; c++) {
+      int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf[c]);
+      if(get_index != -1) {
+        struct tsch_packet *p = n->tx_array[c][get_index];
+        if(packet_is_stale(p)) {
+          ringbufindex_get(&n->tx_ringbuf[c]);
+          return p;
+        }
+      }
     }
+    n = (struct tsch_neighbor *)nbr_table_next(tsch_neighbors, n);
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Drop the packets skipped by the slot operation for being past their max age */
+void
+tsch_queue_drop_stale_packets(void)
+{
+  while(stale_packets) {
+    struct tsch_packet *p = NULL;
+
+    if(!tsch_get_lock()) {
+      return;
+    }
+    p = remove_stale_packet();
+    if(p == NULL) {
+      stale_packets = 0;
+    }
+    tsch_release_lock();
+
+    if(p != NULL) {
+      /* Put packet into packetbuf for packet_sent callback */
+      queuebuf_to_packetbuf(p->qb);
+      LOG_WARN("! dropping stale packet to ");
+      LOG_WARN_LLADDR(packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+      LOG_WARN_(", seqno %u, tx %d\n",
+                packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO), p->transmissions);
+      tsch_stats_on_stale_packet_drop();
+      /* Set return status for packet_sent callback */
+      p->ret = MAC_TX_ERR;
+      mac_call_sent_callback(p->sent, p->ptr, p->ret, p->transmissions);
+      tsch_queue_free_packet(p);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* May the neighbor transmit over a shared link? */
 int
 tsch_queue_backoff_expired(const struct tsch_neighbor *n)
@@ -500,7 +729,8 @@ tsch_queue_backoff_inc(struct tsch_neighbor *n)
   n->backoff_window++;
 }
 /*---------------------------------------------------------------------------*/
-/* Decrement backoff window for all queues directed at dest_addr */
+/* Decrement backoff window for all queues directed at dest_addr. Neighbors
+ * without a shared Tx link of their own send on the broadcast shared links */
 void
 tsch_queue_update_all_backoff_windows(const linkaddr_t *dest_addr)
 {
@@ -509,7 +739,7 @@ tsch_queue_update_all_backoff_windows(const linkaddr_t *dest_addr)
     struct tsch_neighbor *n = (struct tsch_neighbor *)nbr_table_head(tsch_neighbors);
     while(n != NULL) {
       if(n->backoff_window != 0 /* Is the queue in backoff state? */
-         && ((n->tx_links_count == 0 && is_broadcast)
+         && ((n->tx_links_count == n->dedicated_tx_links_count && is_broadcast)
              || (n->tx_links_count > 0 && linkaddr_cmp(dest_addr, tsch_queue_get_nbr_address(n))))) {
         n->backoff_window--;
       }
@@ -524,6 +754,8 @@ tsch_queue_init(void)
 {
   nbr_table_register(tsch_neighbors, NULL);
   memb_init(&packet_memb);
+  last_served_nbr = NULL;
+  stale_packets = 0;
   /* Add virtual EB and the broadcast neighbors */
   n_eb = tsch_queue_add_nbr(&tsch_eb_address);
   n_broadcast = tsch_queue_add_nbr(&tsch_broadcast_address);
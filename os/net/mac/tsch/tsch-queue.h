@@ -60,6 +60,17 @@ extern struct tsch_neighbor *n_eb;
  * \param addr The link-layer address of the neighbor to be added
  */
 struct tsch_neighbor *tsch_queue_add_nbr(const linkaddr_t *addr);
+/**
+ * \brief Get the first TSCH neighbor, to iterate over all neighbors
+ * \return A pointer to the neighbor queue, NULL if there is none
+ */
+struct tsch_neighbor *tsch_queue_first_nbr(void);
+/**
+ * \brief Get the TSCH neighbor that follows a given one
+ * \param n The current neighbor
+ * \return A pointer to the next neighbor queue, NULL if n is the last one
+ */
+struct tsch_neighbor *tsch_queue_next_nbr(struct tsch_neighbor *n);
 /**
  * \brief Get a TSCH neighbor
  * \param addr The link-layer address of the neighbor we are looking for
@@ -83,6 +94,8 @@ linkaddr_t *tsch_queue_get_nbr_address(const struct tsch_neighbor *);
 int tsch_queue_update_time_source(const linkaddr_t *new_addr);
 /**
  * \brief Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic)
+ * The packet goes to the queue of its priority class (see TSCH_QUEUE_PRIORITY_CLASSES).
+ * Its max age is set to TSCH_QUEUE_MAX_AGE; the caller may change it.
  * \param addr The address of the targetted neighbor, &tsch_broadcast_address for broadcast
  * \param max_transmissions The number of MAC retries
  * \param sent The MAC packet sent callback
@@ -153,11 +166,18 @@ struct tsch_packet *tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n,
 struct tsch_packet *tsch_queue_get_packet_for_dest_addr(const linkaddr_t *addr, struct tsch_link *link);
 /**
  * \brief Gets the head packet of any neighbor queue with zero backoff counter.
+ * Packets of higher priority classes come first; among neighbors with packets
+ * of the same class, the neighbors are served in turn.
  * \param n A pointer where to store the neighbor queue to be used for Tx
  * \param link The link to be used for Tx
  * \return The packet if any, else NULL
  */
 struct tsch_packet *tsch_queue_get_unicast_packet_for_any(struct tsch_neighbor **n, struct tsch_link *link);
+/**
+ * \brief Drop the packets that the slot operation skipped for being queued for
+ * longer than their max age. Called from the TSCH pending events process.
+ */
+void tsch_queue_drop_stale_packets(void);
 /**
  * \brief Is the neighbor backoff timer expired?
  * \param n The neighbor queue
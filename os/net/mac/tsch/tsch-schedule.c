@@ -68,6 +68,110 @@ MEMB(slotframe_memb, struct tsch_slotframe, TSCH_SCHEDULE_MAX_SLOTFRAMES);
 /* List of slotframes (each slotframe holds its own list of links) */
 LIST(slotframe_list);
 
+#if TSCH_SCHEDULE_LINK_INDEX
+/* All links, sorted by slotframe handle, then by timeslot. The links that
+ * share a slotframe and a timeslot are in the order they were added, which
+ * is also their order in the list of the slotframe. */
+static struct tsch_link *link_index[TSCH_SCHEDULE_MAX_LINKS];
+static uint16_t link_index_len;
+
+/* Returns the position of the first link after (handle, timeslot), or at
+ * it if !after */
+static uint16_t
+link_index_search(uint16_t handle, uint16_t timeslot, int after)
+{
+  uint16_t low = 0;
+  uint16_t high = link_index_len;
+
+  while(low < high) {
+    uint16_t mid = (low + high) / 2;
+    struct tsch_link *l = link_index[mid];
+    if(l->slotframe_handle < handle
+       || (l->slotframe_handle == handle
+           && (l->timeslot < timeslot || (after && l->timeslot == timeslot)))) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+/*---------------------------------------------------------------------------*/
+static void
+link_index_add(struct tsch_link *l)
+{
+  /* After the links already at this timeslot */
+  uint16_t i = link_index_search(l->slotframe_handle, l->timeslot, 1);
+
+  memmove(&link_index[i + 1], &link_index[i],
+          (link_index_len - i) * sizeof(link_index[0]));
+  link_index[i] = l;
+  link_index_len++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+link_index_remove(struct tsch_link *l)
+{
+  uint16_t i = link_index_search(l->slotframe_handle, l->timeslot, 0);
+
+  while(i < link_index_len && link_index[i] != l) {
+    i++;
+  }
+  if(i < link_index_len) {
+    link_index_len--;
+    memmove(&link_index[i], &link_index[i + 1],
+            (link_index_len - i) * sizeof(link_index[0]));
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The candidates for the next active link of a slotframe are its links at
+ * the first timeslot after the current one, wrapping around. The other
+ * links are further away, they can never be selected, nor be the backup. */
+static struct tsch_link *
+first_candidate(struct tsch_slotframe *sf, uint16_t timeslot, uint16_t *pos)
+{
+  uint16_t i = link_index_search(sf->handle, timeslot, 1);
+
+  if(i == link_index_len || link_index[i]->slotframe_handle != sf->handle) {
+    i = link_index_search(sf->handle, 0, 0);
+    if(i == link_index_len || link_index[i]->slotframe_handle != sf->handle) {
+      return NULL;
+    }
+  }
+  *pos = i;
+  return link_index[i];
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+next_candidate(struct tsch_link *l, uint16_t *pos)
+{
+  struct tsch_link *next;
+
+  if(++*pos < link_index_len) {
+    next = link_index[*pos];
+    if(next->slotframe_handle == l->slotframe_handle
+       && next->timeslot == l->timeslot) {
+      return next;
+    }
+  }
+  return NULL;
+}
+#else /* TSCH_SCHEDULE_LINK_INDEX */
+/* All the links of the slotframe are candidates */
+static struct tsch_link *
+first_candidate(struct tsch_slotframe *sf, uint16_t timeslot, uint16_t *pos)
+{
+  return list_head(sf->links_list);
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+next_candidate(struct tsch_link *l, uint16_t *pos)
+{
+  return list_item_next(l);
+}
+#endif /* TSCH_SCHEDULE_LINK_INDEX */
+/*---------------------------------------------------------------------------*/
+
 /* Adds and returns a slotframe (NULL if failure) */
 struct tsch_slotframe *
 tsch_schedule_add_slotframe(uint16_t handle, uint16_t size)
@@ -256,6 +360,9 @@ tsch_schedule_add_link(struct tsch_slotframe *slotframe,
           address = &linkaddr_null;
         }
         linkaddr_copy(&l->addr, address);
+#if TSCH_SCHEDULE_LINK_INDEX
+        link_index_add(l);
+#endif /* TSCH_SCHEDULE_LINK_INDEX */
 
         LOG_INFO("add_link sf=%u opt=%s type=%s ts=%u ch=%u addr=",
                  slotframe->handle,
@@ -309,6 +416,9 @@ tsch_schedule_remove_link(struct tsch_slotframe *slotframe, struct tsch_link *l)
       LOG_INFO_("\n");
 
       list_remove(slotframe->links_list, l);
+#if TSCH_SCHEDULE_LINK_INDEX
+      link_index_remove(l);
+#endif /* TSCH_SCHEDULE_LINK_INDEX */
       memb_free(&link_memb, l);
 
       /* Release the lock before we update the neighbor (will take the lock) */
@@ -390,8 +500,8 @@ default_tsch_link_comparator(struct tsch_link *a, struct tsch_link *b)
   if(!linkaddr_cmp(&a->addr, &b->addr)) {
     struct tsch_neighbor *an = tsch_queue_get_nbr(&a->addr);
     struct tsch_neighbor *bn = tsch_queue_get_nbr(&b->addr);
-    int a_packet_count = an ? ringbufindex_elements(&an->tx_ringbuf) : 0;
-    int b_packet_count = bn ? ringbufindex_elements(&bn->tx_ringbuf) : 0;
+    int a_packet_count = an ? tsch_queue_nbr_packet_count(an) : 0;
+    int b_packet_count = bn ? tsch_queue_nbr_packet_count(bn) : 0;
     /* Compare the number of packets in the queue */
     return a_packet_count >= b_packet_count ? a : b;
   }
@@ -418,7 +528,8 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
     while(sf != NULL) {
       /* Get timeslot from ASN, given the slotframe length */
       uint16_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
-      struct tsch_link *l = list_head(sf->links_list);
+      uint16_t pos = 0;
+      struct tsch_link *l = first_candidate(sf, timeslot, &pos);
       while(l != NULL) {
         uint16_t time_to_timeslot =
           l->timeslot > timeslot ?
@@ -467,7 +578,7 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
           }
         }
 
-        l = list_item_next(l);
+        l = next_candidate(l, &pos);
       }
       sf = list_item_next(sf);
     }
@@ -489,6 +600,9 @@ tsch_schedule_init(void)
     memb_init(&link_memb);
     memb_init(&slotframe_memb);
     list_init(slotframe_list);
+#if TSCH_SCHEDULE_LINK_INDEX
+    link_index_len = 0;
+#endif /* TSCH_SCHEDULE_LINK_INDEX */
     tsch_release_lock();
     return 1;
   } else {
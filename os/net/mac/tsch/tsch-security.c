@@ -142,7 +142,7 @@ tsch_security_secure_frame(uint8_t *hdr, uint8_t *outbuf,
   uint8_t with_encryption;
   uint8_t mic_len;
   uint8_t nonce[16];
-  struct ieee802154_ies ies;
+  int ie_hdr_len;
 
   uint8_t a_len;
   uint8_t m_len;
@@ -156,11 +156,12 @@ tsch_security_secure_frame(uint8_t *hdr, uint8_t *outbuf,
     return 0;
   }
 
-  memset(&ies, 0, sizeof(ies));
-  if(frame802154e_parse_information_elements(hdr + hdrlen, datalen, &ies) > 0) {
+  ie_hdr_len = frame.fcf.ie_list_present ?
+    frame802154e_ie_header_len(hdr + hdrlen, datalen) : 0;
+  if(ie_hdr_len > 0) {
     /* put Header IEs into the header part which is not encrypted */
-    hdrlen += ies.ie_payload_ie_offset;
-    datalen -= ies.ie_payload_ie_offset;
+    hdrlen += ie_hdr_len;
+    datalen -= ie_hdr_len;
   }
 
   if(!frame.fcf.security_enabled) {
@@ -216,7 +217,7 @@ tsch_security_parse_frame(const uint8_t *hdr, int hdrlen, int datalen,
   uint8_t nonce[16];
   uint8_t a_len;
   uint8_t m_len;
-  struct ieee802154_ies ies;
+  int ie_hdr_len;
 
   if(frame == NULL || hdr == NULL || hdrlen < 0 || datalen < 0) {
     return 0;
@@ -242,11 +243,13 @@ tsch_security_parse_frame(const uint8_t *hdr, int hdrlen, int datalen,
     return 0;
   }
 
-  memset(&ies, 0, sizeof(ies));
-  (void)frame802154e_parse_information_elements(hdr + hdrlen, datalen, &ies);
-  /* put Header IEs into the header part which is not encrypted */
-  hdrlen += ies.ie_payload_ie_offset;
-  datalen -= ies.ie_payload_ie_offset;
+  ie_hdr_len = frame->fcf.ie_list_present ?
+    frame802154e_ie_header_len(hdr + hdrlen, datalen) : 0;
+  if(ie_hdr_len > 0) {
+    /* put Header IEs into the header part which is not encrypted */
+    hdrlen += ie_hdr_len;
+    datalen -= ie_hdr_len;
+  }
 
   tsch_security_init_nonce(nonce, sender, asn);
 
@@ -53,6 +53,7 @@
 #include "net/mac/framer/framer-802154.h"
 #include "net/mac/tsch/tsch.h"
 #include "sys/critical.h"
+#include "sys/trace.h"
 
 #include "sys/log.h"
 /* TSCH debug macros, i.e. to set LEDs or GPIOs on various TSCH
@@ -244,8 +245,11 @@ tsch_get_channel_offset(struct tsch_link *link, struct tsch_packet *p)
 #if TSCH_WITH_LINK_SELECTOR
   if(p != NULL) {
     uint16_t packet_channel_offset = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_CHANNEL_OFFSET);
-    if(packet_channel_offset != 0xffff) {
-      /* The schedule specifies a channel offset for this one; use it */
+    uint16_t packet_slotframe = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
+    if(packet_channel_offset != 0xffff
+       && (packet_slotframe == 0xffff || packet_slotframe == link->slotframe_handle)) {
+      /* The schedule specifies a channel offset for this one, on the links
+       * it was assigned to; use it */
       return packet_channel_offset;
     }
   }
@@ -335,6 +339,21 @@ tsch_schedule_slot_operation(struct rtimer *tm, rtimer_clock_t ref_time, rtimer_
     } \
   } while(0);
 /*---------------------------------------------------------------------------*/
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+/* Should the packet wait for a later slot of the link, as the channel of this
+ * one is persistently bad for the neighbor? Bursts stay on their channel. */
+int
+tsch_is_packet_deferred(struct tsch_link *link, struct tsch_packet *p,
+                        struct tsch_neighbor *n)
+{
+  if(p == NULL || burst_link_scheduled) {
+    return 0;
+  }
+  return tsch_stats_skip_channel(n,
+      tsch_calculate_channel(&tsch_current_asn, tsch_get_channel_offset(link, p)));
+}
+/*---------------------------------------------------------------------------*/
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
 /* Get EB, broadcast or unicast packet to be sent, and target neighbor. */
 static struct tsch_packet *
 get_packet_and_neighbor_for_link(struct tsch_link *link, struct tsch_neighbor **target_neighbor)
@@ -356,7 +375,13 @@ get_packet_and_neighbor_for_link(struct tsch_link *link, struct tsch_neighbor **
         /* Get neighbor queue associated to the link and get packet from it */
         n = tsch_queue_get_nbr(&link->addr);
         p = tsch_queue_get_packet_for_nbr(n, link);
-        /* if it is a broadcast slot and there were no broadcast packets, pick any unicast packet */
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+        if(tsch_is_packet_deferred(link, p, n)) {
+          p = NULL;
+        }
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
+        /* if it is a broadcast slot and there were no broadcast packets, pick any unicast packet.
+         * The neighbors whose packet is deferred are passed over */
         if(p == NULL && n == n_broadcast) {
           p = tsch_queue_get_unicast_packet_for_any(&n, link);
         }
@@ -709,15 +734,26 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
 
     /* The packet was dequeued, add it to dequeued_ringbuf for later processing */
     if(in_queue == 0) {
+      TRACE_ASYNC_END(FRAME, queuebuf_attr(current_packet->qb, PACKETBUF_ATTR_TRACE_ID),
+                      mac_tx_status);
       dequeued_array[dequeued_index] = current_packet;
       ringbufindex_put(&dequeued_ringbuf);
     }
 
-    /* If this is an unicast packet to timesource, update stats */
+    /* If this is an unicast packet to timesource, or to any neighbor with
+     * per-neighbor stats, update stats */
+#if TSCH_STATS_PER_NEIGHBOR
+    if(current_neighbor != NULL && !current_neighbor->is_broadcast) {
+#else /* TSCH_STATS_PER_NEIGHBOR */
     if(current_neighbor != NULL && current_neighbor->is_time_source) {
+#endif /* TSCH_STATS_PER_NEIGHBOR */
       tsch_stats_tx_packet(current_neighbor, mac_tx_status, tsch_current_channel);
     }
 
+#ifdef TSCH_CALLBACK_TX_DONE
+    TSCH_CALLBACK_TX_DONE(current_link, current_neighbor, mac_tx_status);
+#endif
+
     /* Log every tx attempt */
     TSCH_LOG_ADD(tsch_log_tx,
         log->tx.mac_tx_status = mac_tx_status;
@@ -1054,11 +1090,16 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
            * 3. post tx callback
            **/
           static struct pt slot_tx_pt;
+          TRACE_BEGIN(TSCH_TX_SLOT, current_packet->qb == NULL ? 0 :
+                      queuebuf_attr(current_packet->qb, PACKETBUF_ATTR_TRACE_ID));
           PT_SPAWN(&slot_operation_pt, &slot_tx_pt, tsch_tx_slot(&slot_tx_pt, t));
+          TRACE_END(TSCH_TX_SLOT, current_packet->ret);
         } else {
           /* Listen */
           static struct pt slot_rx_pt;
+          TRACE_BEGIN(TSCH_RX_SLOT, tsch_current_channel);
           PT_SPAWN(&slot_operation_pt, &slot_rx_pt, tsch_rx_slot(&slot_rx_pt, t));
+          TRACE_END(TSCH_RX_SLOT, 0);
         }
       } else {
         /* Make sure to end the burst in cast, for some reason, we were
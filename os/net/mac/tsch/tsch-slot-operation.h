@@ -93,6 +93,18 @@ void tsch_slot_operation_sync(rtimer_clock_t next_slot_start,
  * Start actual slot operation
  */
 void tsch_slot_operation_start(void);
+/**
+ * Tells whether a packet should wait for a later slot of the link, as the
+ * channel of the current slot is persistently bad for the neighbor
+ * (TSCH_STATS_CONF_SKIP_BAD_CHANNELS)
+ *
+ * \param link The link of the current slot
+ * \param p The packet, or NULL
+ * \param n The neighbor the packet is for
+ * \return 1 if the packet should be deferred, 0 otherwise
+ */
+int tsch_is_packet_deferred(struct tsch_link *link, struct tsch_packet *p,
+                            struct tsch_neighbor *n);
 
 #endif /* __TSCH_SLOT_OPERATION_H__ */
 /** @} */
@@ -49,7 +49,9 @@
 /*---------------------------------------------------------------------------*/
 
 struct tsch_global_stats tsch_stats;
+#if !TSCH_STATS_PER_NEIGHBOR
 struct tsch_neighbor_stats tsch_neighbor_stats;
+#endif /* !TSCH_STATS_PER_NEIGHBOR */
 
 /* Called every TSCH_STATS_DECAY_INTERVAL ticks */
 static struct ctimer periodic_timer;
@@ -75,30 +77,112 @@ tsch_stats_init(void)
   ctimer_set(&periodic_timer, TSCH_STATS_DECAY_INTERVAL / 10, periodic, NULL);
 }
 /*---------------------------------------------------------------------------*/
-void
-tsch_stats_reset_neighbor_stats(void)
+static void
+reset_stats(struct tsch_neighbor_stats *stats)
 {
   int i;
   struct tsch_channel_stats *ch_stats;
 
-  ch_stats = tsch_neighbor_stats.channel_stats;
+  ch_stats = stats->channel_stats;
   for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
     ch_stats[i].rssi = TSCH_STATS_DEFAULT_RSSI;
     ch_stats[i].lqi = TSCH_STATS_DEFAULT_LQI;
     ch_stats[i].p_tx_success = TSCH_STATS_DEFAULT_P_TX;
   }
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+  stats->bad_channel_skips = 0;
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
+}
+/*---------------------------------------------------------------------------*/
+static void
+decay_stats(struct tsch_neighbor_stats *stats)
+{
+  int i;
+  struct tsch_channel_stats *ch_stats;
+
+  ch_stats = stats->channel_stats;
+  for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
+    /* decay Rx stats */
+    TSCH_STATS_EWMA_UPDATE(ch_stats[i].rssi, TSCH_STATS_DEFAULT_RSSI);
+    TSCH_STATS_EWMA_UPDATE(ch_stats[i].lqi, TSCH_STATS_DEFAULT_LQI);
+    /* decay Tx stats */
+    TSCH_STATS_EWMA_UPDATE(ch_stats[i].p_tx_success, TSCH_STATS_DEFAULT_P_TX);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_stats_reset_neighbor_stats(void)
+{
+#if !TSCH_STATS_PER_NEIGHBOR
+  /* The stats are about the time source, whichever neighbor it is */
+  reset_stats(&tsch_neighbor_stats);
+#endif /* !TSCH_STATS_PER_NEIGHBOR */
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_stats_on_neighbor_added(struct tsch_neighbor *n)
+{
+#if TSCH_STATS_PER_NEIGHBOR
+  reset_stats(&n->stats);
+#endif /* TSCH_STATS_PER_NEIGHBOR */
 }
 /*---------------------------------------------------------------------------*/
 struct tsch_neighbor_stats *
 tsch_stats_get_from_neighbor(struct tsch_neighbor *n)
 {
+#if TSCH_STATS_PER_NEIGHBOR
+  /* No link statistics for the virtual broadcast and EB neighbors */
+  if(n != NULL && !n->is_broadcast) {
+    return &n->stats;
+  }
+#else /* TSCH_STATS_PER_NEIGHBOR */
   /* Due to RAM limitations, this module only collects neighbor stats about the time source */
   if(n != NULL && n->is_time_source) {
     return &tsch_neighbor_stats;
   }
+#endif /* TSCH_STATS_PER_NEIGHBOR */
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+static int
+is_bad_channel(const struct tsch_neighbor_stats *stats, uint8_t channel)
+{
+  uint8_t index = tsch_stats_channel_to_index(channel);
+  return index < TSCH_STATS_NUM_CHANNELS
+    && stats->channel_stats[index].p_tx_success < TSCH_STATS_BAD_CHANNEL_P_TX;
+}
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
+/*---------------------------------------------------------------------------*/
+int
+tsch_stats_skip_channel(struct tsch_neighbor *n, uint8_t channel)
+{
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+  int i;
+  struct tsch_neighbor_stats *stats;
+
+  stats = tsch_stats_get_from_neighbor(n);
+  if(stats == NULL || !is_bad_channel(stats, channel)) {
+    return 0;
+  }
+
+  if(stats->bad_channel_skips >= TSCH_STATS_BAD_CHANNEL_MAX_SKIPS) {
+    /* Probe the bad channel; the outcome updates its P_tx */
+    stats->bad_channel_skips = 0;
+    return 0;
+  }
+
+  /* Only defer if the hopping sequence has a better channel to offer */
+  for(i = 0; i < tsch_hopping_sequence_length.val; ++i) {
+    if(!is_bad_channel(stats, tsch_hopping_sequence[i])) {
+      stats->bad_channel_skips++;
+      return 1;
+    }
+  }
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 void
 tsch_stats_tx_packet(struct tsch_neighbor *n, uint8_t mac_status, uint8_t channel)
 {
@@ -137,6 +221,25 @@ tsch_stats_on_time_synchronization(int32_t sync_error)
 }
 /*---------------------------------------------------------------------------*/
 void
+tsch_stats_on_packet_dequeued(uint32_t queue_delay)
+{
+  uint8_t bin = 0;
+
+  /* Logarithmic bins: the bin index is the number of significant bits */
+  while(queue_delay != 0 && bin < TSCH_STATS_QUEUE_DELAY_BINS - 1) {
+    queue_delay >>= 1;
+    bin++;
+  }
+  tsch_stats.queue_delay[bin]++;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_stats_on_stale_packet_drop(void)
+{
+  tsch_stats.num_stale_drops++;
+}
+/*---------------------------------------------------------------------------*/
+void
 tsch_stats_sample_rssi(void)
 {
 #if TSCH_STATS_SAMPLE_NOISE_RSSI
@@ -193,7 +296,7 @@ periodic(void *ptr)
 {
   int i;
   struct tsch_neighbor *timesource;
-  struct tsch_channel_stats *stats = tsch_neighbor_stats.channel_stats;
+  struct tsch_neighbor_stats *timesource_stats;
 
 #if TSCH_STATS_SAMPLE_NOISE_RSSI
   LOG_DBG("Noise RSSI:\n");
@@ -206,8 +309,16 @@ periodic(void *ptr)
   }
 #endif
 
+  LOG_DBG("Queue delay, %u stale drops:\n", tsch_stats.num_stale_drops);
+  for(i = 0; i < TSCH_STATS_QUEUE_DELAY_BINS - 1; ++i) {
+    LOG_DBG("  < %lu slots: %u\n", 1ul << i, tsch_stats.queue_delay[i]);
+  }
+  LOG_DBG("  more: %u\n", tsch_stats.queue_delay[i]);
+
   timesource = tsch_queue_get_time_source();
-  if(timesource != NULL) {
+  timesource_stats = tsch_stats_get_from_neighbor(timesource);
+  if(timesource_stats != NULL) {
+    struct tsch_channel_stats *stats = timesource_stats->channel_stats;
     LOG_DBG("Time source neighbor:\n");
 
     for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
@@ -221,13 +332,18 @@ periodic(void *ptr)
   }
 
   /* Do not decay the periodic global stats, as they are updated independely of packet rate */
-  for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
-    /* decay Rx stats */
-    TSCH_STATS_EWMA_UPDATE(stats[i].rssi, TSCH_STATS_DEFAULT_RSSI);
-    TSCH_STATS_EWMA_UPDATE(stats[i].lqi, TSCH_STATS_DEFAULT_LQI);
-    /* decay Tx stats */
-    TSCH_STATS_EWMA_UPDATE(stats[i].p_tx_success, TSCH_STATS_DEFAULT_P_TX);
+#if TSCH_STATS_PER_NEIGHBOR
+  {
+    struct tsch_neighbor *n;
+    for(n = tsch_queue_first_nbr(); n != NULL; n = tsch_queue_next_nbr(n)) {
+      if(!n->is_broadcast) {
+        decay_stats(&n->stats);
+      }
+    }
   }
+#else /* TSCH_STATS_PER_NEIGHBOR */
+  decay_stats(&tsch_neighbor_stats);
+#endif /* TSCH_STATS_PER_NEIGHBOR */
 
   ctimer_set(&periodic_timer, TSCH_STATS_DECAY_INTERVAL, periodic, NULL);
 }
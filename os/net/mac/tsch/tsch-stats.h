@@ -47,7 +47,6 @@
 #include "contiki.h"
 #include "net/linkaddr.h"
 #include "net/mac/tsch/tsch-conf.h"
-#include "net/mac/tsch/tsch-queue.h"
 
 /************ Constants ***********/
 
@@ -109,6 +108,61 @@
 #define TSCH_STATS_FIRST_CHANNEL 11
 #endif
 
+/*
+ * The number of bins of the queueing delay histogram. Bin 0 counts the
+ * packets sent in the timeslot they were queued in, bin i > 0 those that
+ * waited [2^(i-1); 2^i) timeslots. The last bin also counts longer delays.
+ */
+#ifdef TSCH_STATS_CONF_QUEUE_DELAY_BINS
+#define TSCH_STATS_QUEUE_DELAY_BINS TSCH_STATS_CONF_QUEUE_DELAY_BINS
+#else
+#define TSCH_STATS_QUEUE_DELAY_BINS 8
+#endif
+
+/*
+ * Collect the per-channel link statistics for all neighbors, not only for
+ * the time source. Costs sizeof(struct tsch_neighbor_stats) per neighbor.
+ */
+#ifdef TSCH_STATS_CONF_PER_NEIGHBOR
+#define TSCH_STATS_PER_NEIGHBOR TSCH_STATS_CONF_PER_NEIGHBOR
+#else
+#define TSCH_STATS_PER_NEIGHBOR 0
+#endif
+
+/*
+ * Defer unicast transmissions to a neighbor in the slots that fall on a
+ * channel that is persistently bad for it. The packet then waits for the
+ * next slot of the link, on another channel of the hopping sequence.
+ * Nothing changes for the receiver, which simply sees an idle slot.
+ */
+#ifdef TSCH_STATS_CONF_SKIP_BAD_CHANNELS
+#define TSCH_STATS_SKIP_BAD_CHANNELS TSCH_STATS_CONF_SKIP_BAD_CHANNELS
+#else
+#define TSCH_STATS_SKIP_BAD_CHANNELS 0
+#endif
+
+/*
+ * A channel is bad for a neighbor if its P_tx EWMA is less than this.
+ * Starting from the default P_tx, it takes four failures in a row.
+ */
+#ifdef TSCH_STATS_CONF_BAD_CHANNEL_P_TX
+#define TSCH_STATS_BAD_CHANNEL_P_TX TSCH_STATS_CONF_BAD_CHANNEL_P_TX
+#else
+/* < 33% success */
+#define TSCH_STATS_BAD_CHANNEL_P_TX ((tsch_stat_t)(TSCH_STATS_BINARY_SCALING_FACTOR / 3))
+#endif
+
+/*
+ * After this many deferred transmissions to a neighbor, transmit on a bad
+ * channel anyway. This probes whether the channel has recovered, and ensures
+ * progress for links whose slotframe always falls on bad channels.
+ */
+#ifdef TSCH_STATS_CONF_BAD_CHANNEL_MAX_SKIPS
+#define TSCH_STATS_BAD_CHANNEL_MAX_SKIPS TSCH_STATS_CONF_BAD_CHANNEL_MAX_SKIPS
+#else
+#define TSCH_STATS_BAD_CHANNEL_MAX_SKIPS 8
+#endif
+
 /* Internal: the scaling of the various stats */
 #define TSCH_STATS_RSSI_SCALING_FACTOR    -16
 #define TSCH_STATS_LQI_SCALING_FACTOR      16
@@ -143,6 +197,10 @@ struct tsch_global_stats {
   uint32_t max_sync_error;
   /* number of disassociations */
   uint16_t num_disassociations;
+  /* number of packets dropped for waiting longer than their max age */
+  uint16_t num_stale_drops;
+  /* histogram of the time spent by packets in their queue */
+  uint16_t queue_delay[TSCH_STATS_QUEUE_DELAY_BINS];
 #if TSCH_STATS_SAMPLE_NOISE_RSSI
   /* per-channel noise estimates */
   tsch_stat_t noise_rssi[TSCH_STATS_NUM_CHANNELS];
@@ -162,6 +220,10 @@ struct tsch_channel_stats {
 
 struct tsch_neighbor_stats {
   struct tsch_channel_stats channel_stats[TSCH_STATS_NUM_CHANNELS];
+#if TSCH_STATS_SKIP_BAD_CHANNELS
+  /* transmissions deferred since the last one on a bad channel */
+  uint8_t bad_channel_skips;
+#endif /* TSCH_STATS_SKIP_BAD_CHANNELS */
 };
 
 struct tsch_neighbor; /* Forward declaration */
@@ -174,8 +236,10 @@ struct tsch_neighbor; /* Forward declaration */
 /* Statistics for the local node */
 extern struct tsch_global_stats tsch_stats;
 
+#if !TSCH_STATS_PER_NEIGHBOR
 /* For the timesource neighbor */
 extern struct tsch_neighbor_stats tsch_neighbor_stats;
+#endif /* !TSCH_STATS_PER_NEIGHBOR */
 
 
 /************ Functions ***********/
@@ -188,21 +252,34 @@ void tsch_stats_rx_packet(struct tsch_neighbor *, int8_t rssi, uint8_t lqi, uint
 
 void tsch_stats_on_time_synchronization(int32_t sync_error);
 
+void tsch_stats_on_packet_dequeued(uint32_t queue_delay);
+
+void tsch_stats_on_stale_packet_drop(void);
+
 void tsch_stats_sample_rssi(void);
 
 struct tsch_neighbor_stats *tsch_stats_get_from_neighbor(struct tsch_neighbor *);
 
 void tsch_stats_reset_neighbor_stats(void);
 
+void tsch_stats_on_neighbor_added(struct tsch_neighbor *);
+
+/* Should a transmission to the neighbor on this channel be deferred? */
+int tsch_stats_skip_channel(struct tsch_neighbor *, uint8_t channel);
+
 #else /* TSCH_STATS_ON */
 
 #define tsch_stats_init()
 #define tsch_stats_tx_packet(n, mac_status, channel)
 #define tsch_stats_rx_packet(n, rssi, lqi, channel)
 #define tsch_stats_on_time_synchronization(sync_error)
+#define tsch_stats_on_packet_dequeued(queue_delay)
+#define tsch_stats_on_stale_packet_drop()
 #define tsch_stats_sample_rssi()
 #define tsch_stats_get_from_neighbor(neighbor) NULL
 #define tsch_stats_reset_neighbor_stats()
+#define tsch_stats_on_neighbor_added(neighbor)
+#define tsch_stats_skip_channel(neighbor, channel) 0
 
 #endif /* TSCH_STATS_ON */
 
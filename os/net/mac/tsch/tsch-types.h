@@ -47,6 +47,7 @@
 #include "net/mac/tsch/tsch-asn.h"
 #include "lib/list.h"
 #include "lib/ringbufindex.h"
+#include "net/mac/tsch/tsch-stats.h"
 
 /********** Data types **********/
 
@@ -103,6 +104,8 @@ struct tsch_packet {
   uint8_t ret; /* status -- MAC return code */
   uint8_t header_len; /* length of header and header IEs (needed for link-layer security) */
   uint8_t tsch_sync_ie_offset; /* Offset within the frame used for quick update of EB ASN and join priority */
+  uint16_t max_age; /* #timeslots after enqueue_asn past which the packet is dropped, 0 for no limit */
+  struct tsch_asn_t enqueue_asn; /* ASN at which the packet was queued */
 };
 
 /** \brief TSCH neighbor information */
@@ -114,11 +117,15 @@ struct tsch_neighbor {
   uint8_t last_backoff_window; /* Last CSMA backoff window */
   uint8_t tx_links_count; /* How many links do we have to this neighbor? */
   uint8_t dedicated_tx_links_count; /* How many dedicated links do we have to this neighbor? */
-  /* Array for the ringbuf. Contains pointers to packets.
-   * Its size must be a power of two to allow for atomic put */
-  struct tsch_packet *tx_array[TSCH_QUEUE_NUM_PER_NEIGHBOR];
-  /* Circular buffer of pointers to packet. */
-  struct ringbufindex tx_ringbuf;
+  /* Arrays for the ringbufs, one per priority class. Contain pointers to packets.
+   * Their size must be a power of two to allow for atomic put */
+  struct tsch_packet *tx_array[TSCH_QUEUE_PRIORITY_CLASSES][TSCH_QUEUE_NUM_PER_NEIGHBOR];
+  /* Circular buffers of pointers to packet, one per priority class (highest last). */
+  struct ringbufindex tx_ringbuf[TSCH_QUEUE_PRIORITY_CLASSES];
+#if TSCH_STATS_ON && TSCH_STATS_PER_NEIGHBOR
+  /* Per-channel statistics of the link to this neighbor */
+  struct tsch_neighbor_stats stats;
+#endif /* TSCH_STATS_ON && TSCH_STATS_PER_NEIGHBOR */
 };
 
 /** \brief TSCH timeslot timing elements. Used to index timeslot timing
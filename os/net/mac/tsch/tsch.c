@@ -390,10 +390,39 @@ eb_input(struct input_packet *current_input)
   frame802154_t frame;
   /* Verify incoming EB (does its ASN match our Rx time?),
    * and update our join priority. */
-  struct ieee802154_ies eb_ies;
+  struct frame802154e_ie_iterator it;
+  struct frame802154e_ie ie;
+  struct tsch_asn_t eb_asn;
+  uint8_t eb_join_priority = 0xff; /* In case the EB does not include it */
+  uint8_t hopping_sequence_id = 0;
+  const uint8_t *hopping_sequence = NULL;
+  uint16_t hopping_sequence_len = 0;
+  int has_sync_ie = 0;
+  int ret;
+
+  if(tsch_packet_parse_eb_header(current_input->payload, current_input->len,
+                                 &frame, &it, 1) == 0) {
+    return;
+  }
+
+  /* Decode only the IEs needed here, in place */
+  TSCH_ASN_INIT(eb_asn, 0, 0);
+  while((ret = frame802154e_ie_next(&it, &ie)) > 0) {
+    if(frame802154e_ie_read_tsch_synchronization(&ie, &eb_asn,
+                                                 &eb_join_priority) == 0) {
+      has_sync_ie = 1;
+    } else {
+      frame802154e_ie_read_tsch_channel_hopping_sequence(&ie,
+          &hopping_sequence_id, &hopping_sequence, &hopping_sequence_len);
+    }
+  }
+
+  if(ret == 0 && !has_sync_ie) {
+    LOG_WARN("! EB without a valid synchronization IE, dropping\n");
+    return;
+  }
 
-  if(tsch_packet_parse_eb(current_input->payload, current_input->len,
-                          &frame, &eb_ies, NULL, 1)) {
+  if(ret == 0) {
     /* PAN ID check and authentication done at rx time */
 
     /* Got an EB from a different neighbor than our time source, keep enough data
@@ -402,7 +431,7 @@ eb_input(struct input_packet *current_input)
     linkaddr_t *ts_addr = tsch_queue_get_nbr_address(ts);
     if(ts_addr == NULL || !linkaddr_cmp(&last_eb_nbr_addr, ts_addr)) {
       linkaddr_copy(&last_eb_nbr_addr, (linkaddr_t *)&frame.src_addr);
-      last_eb_nbr_jp = eb_ies.ie_join_priority;
+      last_eb_nbr_jp = eb_join_priority;
     }
 
 #if TSCH_AUTOSELECT_TIME_SOURCE
@@ -414,7 +443,7 @@ eb_input(struct input_packet *current_input)
       }
       if(stat != NULL) {
         stat->rx_count++;
-        stat->jp = eb_ies.ie_join_priority;
+        stat->jp = eb_join_priority;
         best_neighbor_eb_count = MAX(best_neighbor_eb_count, stat->rx_count);
       }
       /* Select best time source */
@@ -441,41 +470,41 @@ eb_input(struct input_packet *current_input)
     /* Did the EB come from our time source? */
     if(ts_addr != NULL && linkaddr_cmp((linkaddr_t *)&frame.src_addr, ts_addr)) {
       /* Check for ASN drift */
-      int32_t asn_diff = TSCH_ASN_DIFF(current_input->rx_asn, eb_ies.ie_asn);
+      int32_t asn_diff = TSCH_ASN_DIFF(current_input->rx_asn, eb_asn);
       if(asn_diff != 0) {
         /* We disagree with our time source's ASN -- leave the network */
         LOG_WARN("! ASN drifted by %ld, leaving the network\n", asn_diff);
         tsch_disassociate();
       }
 
-      if(eb_ies.ie_join_priority >= TSCH_MAX_JOIN_PRIORITY) {
+      if(eb_join_priority >= TSCH_MAX_JOIN_PRIORITY) {
         /* Join priority unacceptable. Leave network. */
         LOG_WARN("! EB JP too high %u, leaving the network\n",
-               eb_ies.ie_join_priority);
+               eb_join_priority);
         tsch_disassociate();
       } else {
 #if TSCH_AUTOSELECT_TIME_SOURCE
         /* Update join priority */
-        if(tsch_join_priority != eb_ies.ie_join_priority + 1) {
+        if(tsch_join_priority != eb_join_priority + 1) {
           LOG_INFO("update JP from EB %u -> %u\n",
-                 tsch_join_priority, eb_ies.ie_join_priority + 1);
-          tsch_join_priority = eb_ies.ie_join_priority + 1;
+                 tsch_join_priority, eb_join_priority + 1);
+          tsch_join_priority = eb_join_priority + 1;
         }
 #endif /* TSCH_AUTOSELECT_TIME_SOURCE */
       }
 
       /* TSCH hopping sequence */
-      if(eb_ies.ie_channel_hopping_sequence_id != 0) {
-        if(eb_ies.ie_hopping_sequence_len != tsch_hopping_sequence_length.val
-            || memcmp((uint8_t *)tsch_hopping_sequence, eb_ies.ie_hopping_sequence_list, tsch_hopping_sequence_length.val)) {
-          if(eb_ies.ie_hopping_sequence_len <= sizeof(tsch_hopping_sequence)) {
-            memcpy((uint8_t *)tsch_hopping_sequence, eb_ies.ie_hopping_sequence_list,
-                   eb_ies.ie_hopping_sequence_len);
-            TSCH_ASN_DIVISOR_INIT(tsch_hopping_sequence_length, eb_ies.ie_hopping_sequence_len);
+      if(hopping_sequence_id != 0 && hopping_sequence != NULL) {
+        if(hopping_sequence_len != tsch_hopping_sequence_length.val
+            || memcmp((uint8_t *)tsch_hopping_sequence, hopping_sequence, tsch_hopping_sequence_length.val)) {
+          if(hopping_sequence_len <= sizeof(tsch_hopping_sequence)) {
+            memcpy((uint8_t *)tsch_hopping_sequence, hopping_sequence,
+                   hopping_sequence_len);
+            TSCH_ASN_DIVISOR_INIT(tsch_hopping_sequence_length, hopping_sequence_len);
 
             LOG_WARN("Updating TSCH hopping sequence from EB\n");
           } else {
-            LOG_WARN("TSCH:! parse_eb: hopping sequence too long (%u)\n", eb_ies.ie_hopping_sequence_len);
+            LOG_WARN("TSCH:! parse_eb: hopping sequence too long (%u)\n", hopping_sequence_len);
           }
         }
       }
@@ -953,6 +982,7 @@ PROCESS_THREAD(tsch_pending_events_process, ev, data)
     PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
     tsch_rx_process_pending();
     tsch_tx_process_pending();
+    tsch_queue_drop_stale_packets();
     tsch_log_process_pending();
     tsch_keepalive_process_pending();
 #ifdef TSCH_CALLBACK_SELECT_CHANNELS
@@ -106,6 +106,14 @@ frequency hopping for enhanced reliability.
 
 #endif /* BUILD_WITH_ORCHESTRA */
 
+#if BUILD_WITH_MSF
+
+#ifndef TSCH_CALLBACK_TX_DONE
+#define TSCH_CALLBACK_TX_DONE msf_callback_tx_done
+#endif /* TSCH_CALLBACK_TX_DONE */
+
+#endif /* BUILD_WITH_MSF */
+
 /* Called by TSCH when joining a network */
 #ifdef TSCH_CALLBACK_JOINING_NETWORK
 void TSCH_CALLBACK_JOINING_NETWORK();
@@ -143,6 +151,14 @@ void TSCH_CALLBACK_NEW_TIME_SOURCE(const struct tsch_neighbor *old, const struct
 int TSCH_CALLBACK_PACKET_READY(void);
 #endif
 
+/* Called by TSCH from interrupt after every transmission,
+ * with the link used and the MAC status */
+#ifdef TSCH_CALLBACK_TX_DONE
+struct tsch_link;
+struct tsch_neighbor;
+void TSCH_CALLBACK_TX_DONE(struct tsch_link *link, struct tsch_neighbor *n, uint8_t mac_tx_status);
+#endif
+
 /***** External Variables *****/
 
 /* Are we coordinator of the TSCH network? */
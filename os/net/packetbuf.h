@@ -57,6 +57,7 @@
 #include "net/mac/llsec802154.h"
 #include "net/mac/csma/csma-security.h"
 #include "net/mac/tsch/tsch-conf.h"
+#include "sys/trace.h"
 
 /**
  * \brief      The size of the packetbuf, in bytes
@@ -209,6 +210,11 @@ struct packetbuf_addr {
 #define PACKETBUF_ATTR_PACKET_TYPE_STREAM_END 3
 #define PACKETBUF_ATTR_PACKET_TYPE_TIMESTAMP 4
 
+/* Values of PACKETBUF_ATTR_PRIORITY: higher values are sent first. The
+   MAC layer caps the value to the number of classes it supports */
+#define PACKETBUF_PRIORITY_DEFAULT           0
+#define PACKETBUF_PRIORITY_CONTROL           3
+
 enum {
   PACKETBUF_ATTR_NONE,
 
@@ -224,6 +230,10 @@ enum {
   PACKETBUF_ATTR_MAC_METADATA,
   PACKETBUF_ATTR_MAC_NO_SRC_ADDR,
   PACKETBUF_ATTR_MAC_NO_DEST_ADDR,
+  PACKETBUF_ATTR_PRIORITY,
+#if TRACE_ENABLED
+  PACKETBUF_ATTR_TRACE_ID,
+#endif /* TRACE_ENABLED */
 #if TSCH_WITH_LINK_SELECTOR
   PACKETBUF_ATTR_TSCH_SLOTFRAME,
   PACKETBUF_ATTR_TSCH_TIMESLOT,
@@ -232,6 +242,7 @@ enum {
 
   /* Scope 1 attributes: used between two neighbors only. */
   PACKETBUF_ATTR_FRAME_TYPE,
+  PACKETBUF_ATTR_PENDING,
 #if LLSEC802154_USES_AUX_HEADER
   PACKETBUF_ATTR_SECURITY_LEVEL,
 #endif /* LLSEC802154_USES_AUX_HEADER */
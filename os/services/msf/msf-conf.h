@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup msf
+ * @{
+ */
+/**
+ * \file
+ *         MSF configuration. The defaults are the values recommended
+ *         by RFC 9033.
+ */
+
+#ifndef MSF_CONF_H_
+#define MSF_CONF_H_
+
+/* The SFID of MSF, as assigned by IANA */
+#ifdef MSF_CONF_SFID
+#define MSF_SFID                          MSF_CONF_SFID
+#else /* MSF_CONF_SFID */
+#define MSF_SFID                          0
+#endif /* MSF_CONF_SFID */
+
+/* The handle of the slotframe holding the negotiated cells. The 6TiSCH
+ * minimal slotframe, which carries the 6P traffic, has handle 0. Pick
+ * a free handle when running alongside Orchestra. */
+#ifdef MSF_CONF_SLOTFRAME_HANDLE
+#define MSF_SLOTFRAME_HANDLE              MSF_CONF_SLOTFRAME_HANDLE
+#else /* MSF_CONF_SLOTFRAME_HANDLE */
+#define MSF_SLOTFRAME_HANDLE              1
+#endif /* MSF_CONF_SLOTFRAME_HANDLE */
+
+/* The length of the slotframe holding the negotiated cells */
+#ifdef MSF_CONF_SLOTFRAME_LENGTH
+#define MSF_SLOTFRAME_LENGTH              MSF_CONF_SLOTFRAME_LENGTH
+#else /* MSF_CONF_SLOTFRAME_LENGTH */
+#define MSF_SLOTFRAME_LENGTH              101
+#endif /* MSF_CONF_SLOTFRAME_LENGTH */
+
+/* The number of channel offsets negotiated cells are spread over */
+#ifdef MSF_CONF_NUM_CH_OFFSET
+#define MSF_NUM_CH_OFFSET                 MSF_CONF_NUM_CH_OFFSET
+#else /* MSF_CONF_NUM_CH_OFFSET */
+#define MSF_NUM_CH_OFFSET                 16
+#endif /* MSF_CONF_NUM_CH_OFFSET */
+
+/* The maximum number of negotiated Tx cells to the preferred parent */
+#ifdef MSF_CONF_MAX_TX_CELLS
+#define MSF_MAX_TX_CELLS                  MSF_CONF_MAX_TX_CELLS
+#else /* MSF_CONF_MAX_TX_CELLS */
+#define MSF_MAX_TX_CELLS                  8
+#endif /* MSF_CONF_MAX_TX_CELLS */
+
+/* The number of candidate cells proposed in ADD and RELOCATE requests */
+#ifdef MSF_CONF_CELL_LIST_LEN
+#define MSF_CELL_LIST_LEN                 MSF_CONF_CELL_LIST_LEN
+#else /* MSF_CONF_CELL_LIST_LEN */
+#define MSF_CELL_LIST_LEN                 5
+#endif /* MSF_CONF_CELL_LIST_LEN */
+
+/* The number of elapsed Tx cells after which the cell usage is evaluated */
+#ifdef MSF_CONF_MAX_NUM_CELLS
+#define MSF_MAX_NUM_CELLS                 MSF_CONF_MAX_NUM_CELLS
+#else /* MSF_CONF_MAX_NUM_CELLS */
+#define MSF_MAX_NUM_CELLS                 100
+#endif /* MSF_CONF_MAX_NUM_CELLS */
+
+/* A cell is added when more than this percentage of the Tx cells were used */
+#ifdef MSF_CONF_LIM_NUMCELLSUSED_HIGH
+#define MSF_LIM_NUMCELLSUSED_HIGH         MSF_CONF_LIM_NUMCELLSUSED_HIGH
+#else /* MSF_CONF_LIM_NUMCELLSUSED_HIGH */
+#define MSF_LIM_NUMCELLSUSED_HIGH         75
+#endif /* MSF_CONF_LIM_NUMCELLSUSED_HIGH */
+
+/* A cell is deleted when less than this percentage of the Tx cells were used */
+#ifdef MSF_CONF_LIM_NUMCELLSUSED_LOW
+#define MSF_LIM_NUMCELLSUSED_LOW          MSF_CONF_LIM_NUMCELLSUSED_LOW
+#else /* MSF_CONF_LIM_NUMCELLSUSED_LOW */
+#define MSF_LIM_NUMCELLSUSED_LOW          25
+#endif /* MSF_CONF_LIM_NUMCELLSUSED_LOW */
+
+/* The per-cell Tx and ACK counters are halved when NumTx reaches this value */
+#ifdef MSF_CONF_MAX_NUMTX
+#define MSF_MAX_NUMTX                     MSF_CONF_MAX_NUMTX
+#else /* MSF_CONF_MAX_NUMTX */
+#define MSF_MAX_NUMTX                     255
+#endif /* MSF_CONF_MAX_NUMTX */
+
+/* The minimum NumTx of a cell before its PDR is trusted */
+#ifdef MSF_CONF_MIN_NUMTX
+#define MSF_MIN_NUMTX                     MSF_CONF_MIN_NUMTX
+#else /* MSF_CONF_MIN_NUMTX */
+#define MSF_MIN_NUMTX                     32
+#endif /* MSF_CONF_MIN_NUMTX */
+
+/* A cell is relocated when its PDR is below this percentage of the best
+ * PDR to the parent: that of the best cell, or the one from link-stats */
+#ifdef MSF_CONF_RELOCATE_PDRTHRES
+#define MSF_RELOCATE_PDRTHRES             MSF_CONF_RELOCATE_PDRTHRES
+#else /* MSF_CONF_RELOCATE_PDRTHRES */
+#define MSF_RELOCATE_PDRTHRES             50
+#endif /* MSF_CONF_RELOCATE_PDRTHRES */
+
+/* The period of the collision housekeeping */
+#ifdef MSF_CONF_HOUSEKEEPINGCOLLISION_PERIOD
+#define MSF_HOUSEKEEPINGCOLLISION_PERIOD  MSF_CONF_HOUSEKEEPINGCOLLISION_PERIOD
+#else /* MSF_CONF_HOUSEKEEPINGCOLLISION_PERIOD */
+#define MSF_HOUSEKEEPINGCOLLISION_PERIOD  (60 * CLOCK_SECOND)
+#endif /* MSF_CONF_HOUSEKEEPINGCOLLISION_PERIOD */
+
+/* How often the parent and the cell usage are checked */
+#ifdef MSF_CONF_CHECK_INTERVAL
+#define MSF_CHECK_INTERVAL                MSF_CONF_CHECK_INTERVAL
+#else /* MSF_CONF_CHECK_INTERVAL */
+#define MSF_CHECK_INTERVAL                CLOCK_SECOND
+#endif /* MSF_CONF_CHECK_INTERVAL */
+
+/* The 6P transaction timeout. 6P requests and responses go through the
+ * shared minimal cell, so this must cover several of its retransmissions */
+#ifdef MSF_CONF_TIMEOUT
+#define MSF_TIMEOUT                       MSF_CONF_TIMEOUT
+#else /* MSF_CONF_TIMEOUT */
+#define MSF_TIMEOUT                       (30 * CLOCK_SECOND)
+#endif /* MSF_CONF_TIMEOUT */
+
+/* The maximum random wait before retrying a failed 6P request */
+#ifdef MSF_CONF_MAX_RETRY_DELAY
+#define MSF_MAX_RETRY_DELAY               MSF_CONF_MAX_RETRY_DELAY
+#else /* MSF_CONF_MAX_RETRY_DELAY */
+#define MSF_MAX_RETRY_DELAY               (10 * CLOCK_SECOND)
+#endif /* MSF_CONF_MAX_RETRY_DELAY */
+
+#endif /* MSF_CONF_H_ */
+/** @} */
@@ -0,0 +1,892 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup msf
+ * @{
+ */
+/**
+ * \file
+ *         6TiSCH Minimal Scheduling Function (RFC 9033)
+ */
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "net/mac/mac.h"
+#include "net/link-stats.h"
+#include "net/mac/tsch/tsch.h"
+#include "net/mac/tsch/sixtop/sixtop.h"
+#include "net/mac/tsch/sixtop/sixp.h"
+#include "net/mac/tsch/sixtop/sixp-pkt.h"
+#include "msf.h"
+
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "MSF"
+#define LOG_LEVEL  LOG_LEVEL_6TOP
+
+/* A cell is encoded as a 2-byte slotOffset and a 2-byte channelOffset */
+#define CELL_LEN sizeof(sixp_pkt_cell_t)
+/* Metadata, CellOptions and NumCells */
+#define REQ_HDR_LEN (sizeof(sixp_pkt_metadata_t) + \
+                     sizeof(sixp_pkt_cell_options_t) + \
+                     sizeof(sixp_pkt_num_cells_t))
+
+/* A negotiated Tx cell to the parent, with the counters used to detect
+ * collisions. Pointed to by the data field of its link. */
+struct msf_cell {
+  struct tsch_link *link;
+  uint16_t num_tx;
+  uint16_t num_tx_ack;
+};
+
+static struct msf_cell tx_cells[MSF_MAX_TX_CELLS];
+static uint8_t num_tx_cells;
+static struct tsch_slotframe *sf_msf;
+static struct ctimer check_timer;
+
+/* The preferred parent, and a former peer we owe a CLEAR */
+static linkaddr_t parent_addr;
+static linkaddr_t clear_addr;
+
+/* NumCellsUsed is counted from interrupt. NumCellsElapsed is derived
+ * from the ASN: Tx cells elapse once per slotframe. */
+static volatile uint16_t num_cells_used;
+static uint16_t num_cells_elapsed;
+static struct tsch_asn_t elapsed_asn;
+
+/* The 6P request in progress, if any */
+static sixp_pkt_cmd_t req_cmd = SIXP_PKT_CMD_UNAVAILABLE;
+static linkaddr_t req_peer;
+static uint8_t req_storage[REQ_HDR_LEN + (1 + MSF_CELL_LIST_LEN) * CELL_LEN];
+static const uint8_t *req_cand_list;
+static uint16_t req_cand_list_len;
+static struct timer backoff_timer;
+static struct timer housekeeping_timer;
+
+/* The successful 6P response being sent, applied once it is ACKed */
+static sixp_pkt_cmd_t res_cmd = SIXP_PKT_CMD_UNAVAILABLE;
+static linkaddr_t res_peer;
+static uint8_t res_storage[MSF_CELL_LIST_LEN * CELL_LEN];
+static uint16_t res_len;
+static uint8_t res_rel_storage[MSF_CELL_LIST_LEN * CELL_LEN];
+
+static void input_handler(sixp_pkt_type_t type, sixp_pkt_code_t code,
+                          const uint8_t *body, uint16_t body_len,
+                          const linkaddr_t *src_addr);
+static void timeout_handler(sixp_pkt_cmd_t cmd, const linkaddr_t *peer_addr);
+static void error_handler(sixp_error_t err, sixp_pkt_cmd_t cmd,
+                          uint8_t seqno, const linkaddr_t *peer_addr);
+
+static const sixtop_sf_t msf = {
+  MSF_SFID,
+  MSF_TIMEOUT,
+  NULL,
+  input_handler,
+  timeout_handler,
+  error_handler,
+};
+/*---------------------------------------------------------------------------*/
+static void
+write_cell(uint8_t *buf, uint16_t timeslot, uint16_t channel_offset)
+{
+  buf[0] = timeslot & 0xff;
+  buf[1] = timeslot >> 8;
+  buf[2] = channel_offset & 0xff;
+  buf[3] = channel_offset >> 8;
+}
+/*---------------------------------------------------------------------------*/
+static void
+read_cell(const uint8_t *buf, uint16_t *timeslot, uint16_t *channel_offset)
+{
+  *timeslot = buf[0] | (buf[1] << 8);
+  *channel_offset = buf[2] | (buf[3] << 8);
+}
+/*---------------------------------------------------------------------------*/
+static int
+cell_list_contains(const uint8_t *list, uint16_t list_len, const uint8_t *cell)
+{
+  uint16_t i;
+
+  for(i = 0; i + CELL_LEN <= list_len; i += CELL_LEN) {
+    if(memcmp(&list[i], cell, CELL_LEN) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* A node can only do one thing per timeslot: a cell is available when
+ * no slotframe has a link at its timeslot, whatever the channel offset.
+ * This holds for the slotframes whose length divides the MSF one, as
+ * their links come back at the same offsets of every MSF slotframe.
+ * The links of the other slotframes meet every MSF timeslot now and
+ * then; these collisions are left to the link selection of TSCH. */
+static int
+timeslot_is_free(uint16_t timeslot)
+{
+  struct tsch_slotframe *sf;
+  struct tsch_link *l;
+
+  if(timeslot == 0 || timeslot >= MSF_SLOTFRAME_LENGTH) {
+    /* Slot offset 0 is reserved for the minimal cell */
+    return 0;
+  }
+  for(sf = tsch_schedule_slotframe_head(); sf != NULL;
+      sf = tsch_schedule_slotframe_next(sf)) {
+    if(sf->size.val == 0 || MSF_SLOTFRAME_LENGTH % sf->size.val != 0) {
+      continue;
+    }
+    for(l = list_head(sf->links_list); l != NULL; l = list_item_next(l)) {
+      if(l->timeslot == timeslot % sf->size.val) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+find_link(const linkaddr_t *peer_addr, uint8_t link_options,
+          uint16_t timeslot, uint16_t channel_offset)
+{
+  struct tsch_link *l;
+
+  for(l = list_head(sf_msf->links_list); l != NULL; l = list_item_next(l)) {
+    if(l->timeslot == timeslot && l->channel_offset == channel_offset
+       && l->link_options == link_options
+       && linkaddr_cmp(&l->addr, peer_addr)) {
+      return l;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Fold the Tx cells elapsed so far into NumCellsElapsed. Called before
+ * the number of Tx cells changes. */
+static void
+update_num_cells_elapsed(void)
+{
+  uint32_t num_slotframes;
+
+  num_slotframes = TSCH_ASN_DIFF(tsch_current_asn, elapsed_asn) / MSF_SLOTFRAME_LENGTH;
+  num_cells_elapsed = MIN(MSF_MAX_NUM_CELLS,
+                          num_cells_elapsed + num_slotframes * num_tx_cells);
+  TSCH_ASN_INC(elapsed_asn, num_slotframes * MSF_SLOTFRAME_LENGTH);
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset_counters(void)
+{
+  if(tsch_get_lock()) {
+    num_cells_used = 0;
+    elapsed_asn = tsch_current_asn;
+    tsch_release_lock();
+  }
+  num_cells_elapsed = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+add_tx_cell(uint16_t timeslot, uint16_t channel_offset)
+{
+  struct tsch_link *l;
+  int i;
+
+  for(i = 0; i < MSF_MAX_TX_CELLS; i++) {
+    if(tx_cells[i].link == NULL) {
+      break;
+    }
+  }
+  if(i == MSF_MAX_TX_CELLS) {
+    return 0;
+  }
+
+  update_num_cells_elapsed();
+  l = tsch_schedule_add_link(sf_msf, LINK_OPTION_TX, LINK_TYPE_NORMAL,
+                             &parent_addr, timeslot, channel_offset, 0);
+  if(l == NULL) {
+    return 0;
+  }
+  tx_cells[i].link = l;
+  tx_cells[i].num_tx = 0;
+  tx_cells[i].num_tx_ack = 0;
+  l->data = &tx_cells[i];
+  num_tx_cells++;
+  LOG_INFO("add Tx cell [%u, %u] to ", timeslot, channel_offset);
+  LOG_INFO_LLADDR(&parent_addr);
+  LOG_INFO_(", %u cells\n", num_tx_cells);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_link(struct tsch_link *l)
+{
+  struct msf_cell *cell = l->data;
+
+  LOG_INFO("remove %s cell [%u, %u] with ",
+           (l->link_options & LINK_OPTION_TX) ? "Tx" : "Rx",
+           l->timeslot, l->channel_offset);
+  LOG_INFO_LLADDR(&l->addr);
+  LOG_INFO_("\n");
+  if(cell != NULL) {
+    update_num_cells_elapsed();
+    cell->link = NULL;
+    num_tx_cells--;
+  }
+  tsch_schedule_remove_link(sf_msf, l);
+}
+/*---------------------------------------------------------------------------*/
+/* Remove all the cells negotiated with a neighbor */
+static void
+remove_cells(const linkaddr_t *peer_addr)
+{
+  struct tsch_link *l;
+  struct tsch_link *next;
+
+  for(l = list_head(sf_msf->links_list); l != NULL; l = next) {
+    next = list_item_next(l);
+    if(linkaddr_cmp(&l->addr, peer_addr)) {
+      remove_link(l);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Fill a cell list with up to num_cells random available cells */
+static uint16_t
+build_cand_cell_list(uint8_t *buf, uint16_t num_cells)
+{
+  uint16_t len = 0;
+  uint16_t tries;
+  uint8_t cell[CELL_LEN];
+
+  for(tries = 0; len < num_cells * CELL_LEN && tries < MSF_SLOTFRAME_LENGTH;
+      tries++) {
+    uint16_t timeslot = 1 + random_rand() % (MSF_SLOTFRAME_LENGTH - 1);
+    if(timeslot_is_free(timeslot)) {
+      write_cell(cell, timeslot, random_rand() % MSF_NUM_CH_OFFSET);
+      /* A cell list must not hold the same slot offset twice */
+      if(!cell_list_contains(buf, len, cell)) {
+        memcpy(&buf[len], cell, CELL_LEN);
+        len += CELL_LEN;
+      }
+    }
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+end_request(int failed)
+{
+  req_cmd = SIXP_PKT_CMD_UNAVAILABLE;
+  if(failed) {
+    timer_set(&backoff_timer, random_rand() % MSF_MAX_RETRY_DELAY);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+request_sent(void *arg, uint16_t arg_len, const linkaddr_t *dest_addr,
+             sixp_output_status_t status)
+{
+  if(status != SIXP_OUTPUT_STATUS_SUCCESS
+     && req_cmd != SIXP_PKT_CMD_UNAVAILABLE
+     && linkaddr_cmp(dest_addr, &req_peer)) {
+    LOG_WARN("request %u not sent, status %u\n", req_cmd, status);
+    end_request(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_request(sixp_pkt_cmd_t cmd, const linkaddr_t *peer_addr,
+             uint8_t num_cells, uint16_t body_len)
+{
+  sixp_pkt_code_t code = (sixp_pkt_code_t)(uint8_t)cmd;
+
+  if(sixp_pkt_set_metadata(SIXP_PKT_TYPE_REQUEST, code, 0,
+                           req_storage, sizeof(req_storage)) < 0
+     || (cmd != SIXP_PKT_CMD_CLEAR
+         && (sixp_pkt_set_cell_options(SIXP_PKT_TYPE_REQUEST, code,
+                                       SIXP_PKT_CELL_OPTION_TX,
+                                       req_storage, sizeof(req_storage)) < 0
+             || sixp_pkt_set_num_cells(SIXP_PKT_TYPE_REQUEST, code, num_cells,
+                                       req_storage, sizeof(req_storage)) < 0))) {
+    LOG_ERR("failed to build request %u\n", cmd);
+    return;
+  }
+
+  req_cmd = cmd;
+  linkaddr_copy(&req_peer, peer_addr);
+  if(sixp_output(SIXP_PKT_TYPE_REQUEST, code, MSF_SFID,
+                 req_storage, body_len, peer_addr,
+                 request_sent, NULL, 0) < 0) {
+    LOG_WARN("failed to send request %u to ", cmd);
+    LOG_WARN_LLADDR(peer_addr);
+    LOG_WARN_("\n");
+    end_request(1);
+    return;
+  }
+  LOG_INFO("send request %u for %u cells to ", cmd, num_cells);
+  LOG_INFO_LLADDR(peer_addr);
+  LOG_INFO_("\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_add_request(void)
+{
+  uint16_t len;
+
+  len = build_cand_cell_list(&req_storage[REQ_HDR_LEN], MSF_CELL_LIST_LEN);
+  if(len == 0) {
+    LOG_WARN("no available cell to add\n");
+    end_request(1);
+    return;
+  }
+  req_cand_list = &req_storage[REQ_HDR_LEN];
+  req_cand_list_len = len;
+  send_request(SIXP_PKT_CMD_ADD, &parent_addr, 1, REQ_HDR_LEN + len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_delete_request(void)
+{
+  struct msf_cell *victim = NULL;
+  int i;
+
+  /* Delete the cell with the fewest transmissions */
+  for(i = 0; i < MSF_MAX_TX_CELLS; i++) {
+    if(tx_cells[i].link != NULL
+       && (victim == NULL || tx_cells[i].num_tx < victim->num_tx)) {
+      victim = &tx_cells[i];
+    }
+  }
+  if(victim == NULL) {
+    return;
+  }
+  write_cell(&req_storage[REQ_HDR_LEN],
+             victim->link->timeslot, victim->link->channel_offset);
+  req_cand_list = &req_storage[REQ_HDR_LEN];
+  req_cand_list_len = CELL_LEN;
+  send_request(SIXP_PKT_CMD_DELETE, &parent_addr, 1, REQ_HDR_LEN + CELL_LEN);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_relocate_request(const struct msf_cell *cell)
+{
+  uint16_t len;
+
+  write_cell(&req_storage[REQ_HDR_LEN],
+             cell->link->timeslot, cell->link->channel_offset);
+  len = build_cand_cell_list(&req_storage[REQ_HDR_LEN + CELL_LEN],
+                             MSF_CELL_LIST_LEN);
+  if(len == 0) {
+    LOG_WARN("no available cell to relocate to\n");
+    return;
+  }
+  req_cand_list = &req_storage[REQ_HDR_LEN + CELL_LEN];
+  req_cand_list_len = len;
+  send_request(SIXP_PKT_CMD_RELOCATE, &parent_addr, 1,
+               REQ_HDR_LEN + CELL_LEN + len);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+cell_pdr(const struct msf_cell *cell)
+{
+  if(cell->num_tx == 0) {
+    return 0;
+  }
+  return (uint32_t)cell->num_tx_ack * 100 / cell->num_tx;
+}
+/*---------------------------------------------------------------------------*/
+/* Relocate the worst Tx cell if its PDR is much lower than the best one
+ * we know for the parent */
+static void
+housekeeping(void)
+{
+  const struct link_stats *stats;
+  struct msf_cell *worst = NULL;
+  uint8_t best_pdr = 0;
+  int i;
+
+  for(i = 0; i < MSF_MAX_TX_CELLS; i++) {
+    struct msf_cell *cell = &tx_cells[i];
+    if(cell->link == NULL || cell->num_tx < MSF_MIN_NUMTX) {
+      continue;
+    }
+    best_pdr = MAX(best_pdr, cell_pdr(cell));
+    if(worst == NULL || cell_pdr(cell) < cell_pdr(worst)) {
+      worst = cell;
+    }
+  }
+
+  /* The link ETX covers every transmission to the parent: a reference
+   * even when there is a single Tx cell to compare with */
+  stats = link_stats_from_lladdr(&parent_addr);
+  if(stats != NULL && stats->etx > 0 && link_stats_is_fresh(stats)) {
+    best_pdr = MAX(best_pdr,
+                   MIN(100, 100 * LINK_STATS_ETX_DIVISOR / stats->etx));
+  }
+
+  if(worst != NULL
+     && cell_pdr(worst) < (uint16_t)best_pdr * MSF_RELOCATE_PDRTHRES / 100) {
+    LOG_INFO("relocate cell [%u, %u], PDR %u%%, best %u%%\n",
+             worst->link->timeslot, worst->link->channel_offset,
+             cell_pdr(worst), best_pdr);
+    send_relocate_request(worst);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_parent(const linkaddr_t *new_parent)
+{
+  if(!linkaddr_cmp(&parent_addr, &linkaddr_null)) {
+    /* Our cells with the former parent are useless now */
+    remove_cells(&parent_addr);
+    linkaddr_copy(&clear_addr, &parent_addr);
+  }
+  LOG_INFO("new parent ");
+  LOG_INFO_LLADDR(new_parent);
+  LOG_INFO_("\n");
+  linkaddr_copy(&parent_addr, new_parent);
+  reset_counters();
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(void *ptr)
+{
+  struct tsch_neighbor *n;
+  const linkaddr_t *new_parent;
+  uint16_t used;
+  int i;
+
+  ctimer_reset(&check_timer);
+
+  if(!tsch_is_associated) {
+    return;
+  }
+
+  if(tsch_schedule_get_slotframe_by_handle(MSF_SLOTFRAME_HANDLE) != sf_msf) {
+    /* The schedule was reset, e.g. from an EB: start over */
+    sf_msf = tsch_schedule_add_slotframe(MSF_SLOTFRAME_HANDLE,
+                                         MSF_SLOTFRAME_LENGTH);
+    for(i = 0; i < MSF_MAX_TX_CELLS; i++) {
+      tx_cells[i].link = NULL;
+    }
+    num_tx_cells = 0;
+    linkaddr_copy(&parent_addr, &linkaddr_null);
+    if(sf_msf == NULL) {
+      return;
+    }
+  }
+
+  /* Follow the time source, which is the RPL preferred parent */
+  n = tsch_queue_get_time_source();
+  new_parent = n != NULL ? tsch_queue_get_nbr_address(n) : &linkaddr_null;
+  if(!linkaddr_cmp(new_parent, &parent_addr)) {
+    set_parent(new_parent);
+  }
+
+  if(req_cmd != SIXP_PKT_CMD_UNAVAILABLE || !timer_expired(&backoff_timer)) {
+    /* A request is in progress, or we are backing off */
+    return;
+  }
+
+  if(!linkaddr_cmp(&clear_addr, &linkaddr_null)) {
+    /* Best effort: the former peer may be gone */
+    send_request(SIXP_PKT_CMD_CLEAR, &clear_addr, 0,
+                 sizeof(sixp_pkt_metadata_t));
+    linkaddr_copy(&clear_addr, &linkaddr_null);
+    return;
+  }
+
+  if(linkaddr_cmp(&parent_addr, &linkaddr_null)) {
+    return;
+  }
+
+  if(num_tx_cells == 0) {
+    /* A node always keeps at least one negotiated Tx cell to its parent */
+    send_add_request();
+    return;
+  }
+
+  if(!tsch_get_lock()) {
+    return;
+  }
+  update_num_cells_elapsed();
+  used = num_cells_used;
+  tsch_release_lock();
+  if(num_cells_elapsed >= MSF_MAX_NUM_CELLS) {
+    used = MIN(used, num_cells_elapsed);
+    LOG_DBG("%u/%u cells used\n", used, num_cells_elapsed);
+    if(used > (uint32_t)num_cells_elapsed * MSF_LIM_NUMCELLSUSED_HIGH / 100) {
+      if(num_tx_cells < MSF_MAX_TX_CELLS) {
+        send_add_request();
+      }
+    } else if(used < (uint32_t)num_cells_elapsed * MSF_LIM_NUMCELLSUSED_LOW / 100) {
+      if(num_tx_cells > 1) {
+        send_delete_request();
+      }
+    }
+    reset_counters();
+    if(req_cmd != SIXP_PKT_CMD_UNAVAILABLE) {
+      return;
+    }
+  }
+
+  if(timer_expired(&housekeeping_timer)) {
+    timer_set(&housekeeping_timer, MSF_HOUSEKEEPINGCOLLISION_PERIOD);
+    housekeeping();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+response_input(sixp_pkt_rc_t rc, const uint8_t *body, uint16_t body_len,
+               const linkaddr_t *peer_addr)
+{
+  const uint8_t *cell_list;
+  sixp_pkt_offset_t cell_list_len;
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  struct tsch_link *l;
+  int failed = 0;
+
+  if(req_cmd == SIXP_PKT_CMD_UNAVAILABLE || !linkaddr_cmp(peer_addr, &req_peer)) {
+    return;
+  }
+
+  LOG_INFO("response %u to request %u from ", rc, req_cmd);
+  LOG_INFO_LLADDR(peer_addr);
+  LOG_INFO_("\n");
+
+  if(rc == SIXP_PKT_RC_SUCCESS) {
+    if(body_len == 0
+       || sixp_pkt_get_cell_list(SIXP_PKT_TYPE_RESPONSE,
+                                 (sixp_pkt_code_t)(uint8_t)rc,
+                                 &cell_list, &cell_list_len,
+                                 body, body_len) < 0) {
+      cell_list_len = 0;
+    }
+    /* Apply only the cells we proposed, to the parent we proposed them to */
+    if(cell_list_len > CELL_LEN
+       || (cell_list_len > 0
+           && !cell_list_contains(req_cand_list, req_cand_list_len, cell_list))
+       || !linkaddr_cmp(peer_addr, &parent_addr)) {
+      cell_list_len = 0;
+    }
+    switch(req_cmd) {
+      case SIXP_PKT_CMD_ADD:
+        if(cell_list_len == 0) {
+          /* The parent had none of our candidate cells available */
+          failed = 1;
+        } else {
+          read_cell(cell_list, &timeslot, &channel_offset);
+          add_tx_cell(timeslot, channel_offset);
+        }
+        break;
+      case SIXP_PKT_CMD_DELETE:
+        if(cell_list_len > 0) {
+          read_cell(cell_list, &timeslot, &channel_offset);
+          if((l = find_link(&parent_addr, LINK_OPTION_TX,
+                            timeslot, channel_offset)) != NULL) {
+            remove_link(l);
+          }
+        }
+        break;
+      case SIXP_PKT_CMD_RELOCATE:
+        if(cell_list_len == 0) {
+          failed = 1;
+        } else {
+          read_cell(&req_storage[REQ_HDR_LEN], &timeslot, &channel_offset);
+          if((l = find_link(&parent_addr, LINK_OPTION_TX,
+                            timeslot, channel_offset)) != NULL) {
+            remove_link(l);
+          }
+          read_cell(cell_list, &timeslot, &channel_offset);
+          add_tx_cell(timeslot, channel_offset);
+        }
+        break;
+      default:
+        break;
+    }
+  } else if(rc == SIXP_PKT_RC_ERR_SEQNUM || rc == SIXP_PKT_RC_ERR_CELLLIST) {
+    /* Our schedules disagree: start over with this neighbor */
+    LOG_WARN("schedule inconsistency with ");
+    LOG_WARN_LLADDR(peer_addr);
+    LOG_WARN_("\n");
+    remove_cells(peer_addr);
+    if(req_cmd != SIXP_PKT_CMD_CLEAR) {
+      linkaddr_copy(&clear_addr, peer_addr);
+    }
+  } else {
+    /* RC_ERR_BUSY, RC_ERR_LOCKED, RC_ERR, RC_RESET: try again later */
+    failed = 1;
+  }
+  end_request(failed);
+}
+/*---------------------------------------------------------------------------*/
+static void
+response_sent(void *arg, uint16_t arg_len, const linkaddr_t *dest_addr,
+              sixp_output_status_t status)
+{
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  struct tsch_link *l;
+  uint16_t i;
+
+  if(res_cmd == SIXP_PKT_CMD_UNAVAILABLE || !linkaddr_cmp(dest_addr, &res_peer)) {
+    return;
+  }
+
+  if(status == SIXP_OUTPUT_STATUS_SUCCESS) {
+    for(i = 0; i < res_len; i += CELL_LEN) {
+      if(res_cmd == SIXP_PKT_CMD_DELETE || res_cmd == SIXP_PKT_CMD_RELOCATE) {
+        read_cell(res_cmd == SIXP_PKT_CMD_DELETE ?
+                  &res_storage[i] : &res_rel_storage[i],
+                  &timeslot, &channel_offset);
+        if((l = find_link(&res_peer, LINK_OPTION_RX,
+                          timeslot, channel_offset)) != NULL) {
+          remove_link(l);
+        }
+      }
+      if(res_cmd == SIXP_PKT_CMD_ADD || res_cmd == SIXP_PKT_CMD_RELOCATE) {
+        read_cell(&res_storage[i], &timeslot, &channel_offset);
+        LOG_INFO("add Rx cell [%u, %u] from ", timeslot, channel_offset);
+        LOG_INFO_LLADDR(&res_peer);
+        LOG_INFO_("\n");
+        tsch_schedule_add_link(sf_msf, LINK_OPTION_RX, LINK_TYPE_NORMAL,
+                               &res_peer, timeslot, channel_offset, 0);
+      }
+    }
+  }
+  res_cmd = SIXP_PKT_CMD_UNAVAILABLE;
+}
+/*---------------------------------------------------------------------------*/
+/* Build the response to an ADD, DELETE or RELOCATE request in
+ * res_storage. Cells are Tx from the requester, thus Rx on our side. */
+static sixp_pkt_rc_t
+parse_request(sixp_pkt_cmd_t cmd, const uint8_t *body, uint16_t body_len,
+              const linkaddr_t *peer_addr)
+{
+  sixp_pkt_code_t code = (sixp_pkt_code_t)(uint8_t)cmd;
+  sixp_pkt_cell_options_t cell_options;
+  sixp_pkt_num_cells_t num_cells;
+  const uint8_t *cell_list;
+  sixp_pkt_offset_t cell_list_len;
+  const uint8_t *rel_cell_list = NULL;
+  sixp_pkt_offset_t rel_cell_list_len = 0;
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  uint16_t i;
+
+  if(sixp_pkt_get_cell_options(SIXP_PKT_TYPE_REQUEST, code, &cell_options,
+                               body, body_len) < 0
+     || sixp_pkt_get_num_cells(SIXP_PKT_TYPE_REQUEST, code, &num_cells,
+                               body, body_len) < 0) {
+    return SIXP_PKT_RC_ERR;
+  }
+  if(cell_options != SIXP_PKT_CELL_OPTION_TX) {
+    /* MSF only negotiates dedicated Tx cells */
+    return SIXP_PKT_RC_ERR;
+  }
+  num_cells = MIN(num_cells, MSF_CELL_LIST_LEN);
+
+  if(cmd == SIXP_PKT_CMD_RELOCATE) {
+    if(sixp_pkt_get_rel_cell_list(SIXP_PKT_TYPE_REQUEST, code,
+                                  &rel_cell_list, &rel_cell_list_len,
+                                  body, body_len) < 0
+       || sixp_pkt_get_cand_cell_list(SIXP_PKT_TYPE_REQUEST, code,
+                                      &cell_list, &cell_list_len,
+                                      body, body_len) < 0) {
+      return SIXP_PKT_RC_ERR;
+    }
+    rel_cell_list_len = MIN(rel_cell_list_len, num_cells * CELL_LEN);
+    for(i = 0; i < rel_cell_list_len; i += CELL_LEN) {
+      read_cell(&rel_cell_list[i], &timeslot, &channel_offset);
+      if(find_link(peer_addr, LINK_OPTION_RX, timeslot, channel_offset) == NULL) {
+        return SIXP_PKT_RC_ERR_CELLLIST;
+      }
+    }
+  } else if(sixp_pkt_get_cell_list(SIXP_PKT_TYPE_REQUEST, code,
+                                   &cell_list, &cell_list_len,
+                                   body, body_len) < 0) {
+    return SIXP_PKT_RC_ERR;
+  }
+
+  res_len = 0;
+  for(i = 0; i < cell_list_len && res_len < num_cells * CELL_LEN;
+      i += CELL_LEN) {
+    read_cell(&cell_list[i], &timeslot, &channel_offset);
+    if(cmd == SIXP_PKT_CMD_DELETE) {
+      if(find_link(peer_addr, LINK_OPTION_RX, timeslot, channel_offset) == NULL) {
+        return SIXP_PKT_RC_ERR_CELLLIST;
+      }
+    } else if(!timeslot_is_free(timeslot)
+              || cell_list_contains(res_storage, res_len, &cell_list[i])) {
+      continue;
+    }
+    memcpy(&res_storage[res_len], &cell_list[i], CELL_LEN);
+    res_len += CELL_LEN;
+  }
+  if(cmd == SIXP_PKT_CMD_RELOCATE) {
+    /* The first cells of RelCellList move to the cells we picked */
+    memcpy(res_rel_storage, rel_cell_list, res_len);
+  }
+  return SIXP_PKT_RC_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+static void
+request_input(sixp_pkt_cmd_t cmd, const uint8_t *body, uint16_t body_len,
+              const linkaddr_t *peer_addr)
+{
+  sixp_pkt_rc_t rc;
+
+  LOG_INFO("request %u from ", cmd);
+  LOG_INFO_LLADDR(peer_addr);
+  LOG_INFO_("\n");
+
+  switch(cmd) {
+    case SIXP_PKT_CMD_ADD:
+    case SIXP_PKT_CMD_DELETE:
+    case SIXP_PKT_CMD_RELOCATE:
+      if(res_cmd != SIXP_PKT_CMD_UNAVAILABLE) {
+        /* Still waiting for the ACK of a response to apply */
+        rc = SIXP_PKT_RC_ERR_BUSY;
+      } else {
+        rc = parse_request(cmd, body, body_len, peer_addr);
+      }
+      break;
+    case SIXP_PKT_CMD_CLEAR:
+      /* Cells are removed whatever happens to the response */
+      remove_cells(peer_addr);
+      rc = SIXP_PKT_RC_SUCCESS;
+      break;
+    default:
+      rc = SIXP_PKT_RC_ERR;
+      break;
+  }
+
+  if(rc != SIXP_PKT_RC_SUCCESS || cmd == SIXP_PKT_CMD_CLEAR) {
+    /* Nothing to apply once the response is sent */
+    if(sixp_output(SIXP_PKT_TYPE_RESPONSE, (sixp_pkt_code_t)(uint8_t)rc,
+                   MSF_SFID, NULL, 0, peer_addr, NULL, NULL, 0) < 0) {
+      LOG_ERR("failed to send response %u\n", rc);
+    }
+    return;
+  }
+
+  res_cmd = cmd;
+  linkaddr_copy(&res_peer, peer_addr);
+  if(sixp_output(SIXP_PKT_TYPE_RESPONSE, (sixp_pkt_code_t)(uint8_t)rc,
+                 MSF_SFID, res_storage, res_len, peer_addr,
+                 response_sent, NULL, 0) < 0) {
+    LOG_ERR("failed to send response %u\n", rc);
+    res_cmd = SIXP_PKT_CMD_UNAVAILABLE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+input_handler(sixp_pkt_type_t type, sixp_pkt_code_t code,
+              const uint8_t *body, uint16_t body_len,
+              const linkaddr_t *src_addr)
+{
+  if(sf_msf == NULL) {
+    return;
+  }
+  if(type == SIXP_PKT_TYPE_REQUEST) {
+    request_input(code.cmd, body, body_len, src_addr);
+  } else if(type == SIXP_PKT_TYPE_RESPONSE) {
+    response_input(code.rc, body, body_len, src_addr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+timeout_handler(sixp_pkt_cmd_t cmd, const linkaddr_t *peer_addr)
+{
+  LOG_WARN("timeout of command %u with ", cmd);
+  LOG_WARN_LLADDR(peer_addr);
+  LOG_WARN_("\n");
+  if(req_cmd != SIXP_PKT_CMD_UNAVAILABLE && linkaddr_cmp(peer_addr, &req_peer)) {
+    end_request(1);
+  }
+  if(res_cmd != SIXP_PKT_CMD_UNAVAILABLE && linkaddr_cmp(peer_addr, &res_peer)) {
+    res_cmd = SIXP_PKT_CMD_UNAVAILABLE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+error_handler(sixp_error_t err, sixp_pkt_cmd_t cmd, uint8_t seqno,
+              const linkaddr_t *peer_addr)
+{
+  LOG_WARN("error %u on command %u with ", err, cmd);
+  LOG_WARN_LLADDR(peer_addr);
+  LOG_WARN_("\n");
+  if(err == SIXP_ERROR_SCHEDULE_INCONSISTENCY && sf_msf != NULL) {
+    remove_cells(peer_addr);
+    linkaddr_copy(&clear_addr, peer_addr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+msf_callback_tx_done(struct tsch_link *link, struct tsch_neighbor *n,
+                     uint8_t mac_tx_status)
+{
+  struct msf_cell *cell;
+
+  if(link == NULL || link->slotframe_handle != MSF_SLOTFRAME_HANDLE
+     || (cell = link->data) == NULL) {
+    return;
+  }
+  num_cells_used++;
+  if(cell->num_tx >= MSF_MAX_NUMTX) {
+    cell->num_tx /= 2;
+    cell->num_tx_ack /= 2;
+  }
+  cell->num_tx++;
+  if(mac_tx_status == MAC_TX_OK) {
+    cell->num_tx_ack++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+msf_init(void)
+{
+  sf_msf = tsch_schedule_add_slotframe(MSF_SLOTFRAME_HANDLE,
+                                       MSF_SLOTFRAME_LENGTH);
+  if(sf_msf == NULL) {
+    LOG_ERR("failed to add slotframe %u\n", MSF_SLOTFRAME_HANDLE);
+  }
+  if(sixtop_add_sf(&msf) < 0) {
+    LOG_ERR("failed to register with 6top\n");
+    return;
+  }
+  timer_set(&housekeeping_timer, MSF_HOUSEKEEPINGCOLLISION_PERIOD);
+  ctimer_set(&check_timer, MSF_CHECK_INTERVAL, check, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
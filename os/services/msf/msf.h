@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup sixtop
+ * @{
+ */
+/**
+ * \defgroup msf 6TiSCH Minimal Scheduling Function
+ *
+ * An implementation of MSF (RFC 9033) on top of 6top (RFC 8480). MSF
+ * negotiates dedicated Tx cells with the preferred parent, the TSCH
+ * time source, adding and deleting cells as the traffic varies and
+ * relocating cells that suffer from collisions.
+ *
+ * To use it, add $(CONTIKI_NG_MAC_DIR)/tsch/sixtop and
+ * $(CONTIKI_NG_SERVICES_DIR)/msf to MODULES.
+ * @{
+ */
+/**
+ * \file
+ *         MSF header file
+ */
+
+#ifndef MSF_H_
+#define MSF_H_
+
+#include "net/mac/tsch/tsch.h"
+#include "msf-conf.h"
+
+/**
+ * \brief Initialize MSF: create its slotframe, register it with 6top
+ * and start monitoring the cells to the preferred parent
+ */
+void msf_init(void);
+
+/**
+ * \brief Count a transmission for the NumCellsUsed counter and the
+ * per-cell PDR. Called by TSCH from interrupt after every Tx slot.
+ * Set with #define TSCH_CALLBACK_TX_DONE msf_callback_tx_done
+ * \param link The link the frame was sent on
+ * \param n The neighbor the frame was sent to
+ * \param mac_tx_status The MAC status of the transmission
+ */
+void msf_callback_tx_done(struct tsch_link *link, struct tsch_neighbor *n,
+                          uint8_t mac_tx_status);
+
+#endif /* MSF_H_ */
+/** @} */
+/** @} */
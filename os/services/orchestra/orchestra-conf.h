@@ -49,6 +49,12 @@
 #define ORCHESTRA_RULES { &eb_per_time_source, \
                           &unicast_per_neighbor_rpl_ns, \
                           &default_common }
+/* Example configuration with extra cells for backlogged links. The adaptive
+ * rule must come before the unicast rule whose traffic it offloads: */
+/* #define ORCHESTRA_RULES { &eb_per_time_source, \
+                             &unicast_adaptive, \
+                             &unicast_per_neighbor_rpl_ns, \
+                             &default_common } */
 /* Example configuration for RPL storing mode: */
 /* #define ORCHESTRA_RULES { &eb_per_time_source, \
                              &unicast_per_neighbor_rpl_storing, \
@@ -142,4 +148,36 @@
 #define ORCHESTRA_UNICAST_MAX_CHANNEL_OFFSET       255
 #endif
 
+/* The adaptive unicast rule: length of its slotframe, which carries the extra
+ * cells of all links */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_PERIOD
+#define ORCHESTRA_ADAPTIVE_PERIOD                 ORCHESTRA_CONF_ADAPTIVE_PERIOD
+#else /* ORCHESTRA_CONF_ADAPTIVE_PERIOD */
+#define ORCHESTRA_ADAPTIVE_PERIOD                 23
+#endif /* ORCHESTRA_CONF_ADAPTIVE_PERIOD */
+
+/* The adaptive unicast rule: maximum number of extra cells per link and slotframe */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS
+#define ORCHESTRA_ADAPTIVE_MAX_CELLS              ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS
+#else /* ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS */
+#define ORCHESTRA_ADAPTIVE_MAX_CELLS              3
+#endif /* ORCHESTRA_CONF_ADAPTIVE_MAX_CELLS */
+
+/* The adaptive unicast rule: one extra Tx cell per this many packets queued
+ * for a neighbor */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_BACKLOG_PER_CELL
+#define ORCHESTRA_ADAPTIVE_BACKLOG_PER_CELL       ORCHESTRA_CONF_ADAPTIVE_BACKLOG_PER_CELL
+#else /* ORCHESTRA_CONF_ADAPTIVE_BACKLOG_PER_CELL */
+#define ORCHESTRA_ADAPTIVE_BACKLOG_PER_CELL       2
+#endif /* ORCHESTRA_CONF_ADAPTIVE_BACKLOG_PER_CELL */
+
+/* The adaptive unicast rule: how long a receiver keeps listening to the extra
+ * cells of a neighbor after its last frame with the frame pending bit set.
+ * Senders only bind packets to extra cells during the first half of it. */
+#ifdef ORCHESTRA_CONF_ADAPTIVE_HOLD_TIME
+#define ORCHESTRA_ADAPTIVE_HOLD_TIME              ORCHESTRA_CONF_ADAPTIVE_HOLD_TIME
+#else /* ORCHESTRA_CONF_ADAPTIVE_HOLD_TIME */
+#define ORCHESTRA_ADAPTIVE_HOLD_TIME              (4 * CLOCK_SECOND)
+#endif /* ORCHESTRA_CONF_ADAPTIVE_HOLD_TIME */
+
 #endif /* __ORCHESTRA_CONF_H__ */
@@ -81,5 +81,7 @@ struct orchestra_rule default_common = {
   select_packet,
   NULL,
   NULL,
+  NULL,
+  NULL,
   "default common",
 };
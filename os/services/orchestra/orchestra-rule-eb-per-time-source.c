@@ -123,5 +123,7 @@ struct orchestra_rule eb_per_time_source = {
   select_packet,
   NULL,
   NULL,
+  NULL,
+  NULL,
   "EB per time source",
 };
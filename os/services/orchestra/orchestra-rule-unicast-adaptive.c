@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Orchestra: a slotframe with extra unicast cells for backlogged links.
+ *         Complements one of the unicast rules, placed before it in ORCHESTRA_RULES,
+ *         and works without any negotiation:
+ *         For each link from a sender S to a receiver R, extra cell i is at
+ *             timeslot (hash2(S, R) + i * ORCHESTRA_ADAPTIVE_PERIOD / ORCHESTRA_ADAPTIVE_MAX_CELLS)
+ *         Senders install Tx cells to a neighbor as its queue grows, one per
+ *             ORCHESTRA_ADAPTIVE_BACKLOG_PER_CELL packets, and remove them once it drains.
+ *             New packets go to the extra cells. As the cells are links to the neighbor
+ *             itself, TSCH sends the packets queued earlier through them as well, and
+ *             still serves those on the cells of the regular unicast rule.
+ *         A sender with a backlog sets the frame pending bit (see TSCH_BURST_MAX_LEN).
+ *             Receivers listen to all the extra cells of a neighbor for
+ *             ORCHESTRA_ADAPTIVE_HOLD_TIME after such a frame, senders use them only
+ *             during the first half of it.
+ *         Nodes that forward more traffic, close to the root, thus get more capacity.
+ */
+
+#include "contiki.h"
+#include "orchestra.h"
+#include "net/packetbuf.h"
+#include "net/nbr-table.h"
+
+#include "sys/log.h"
+#define LOG_MODULE "Orchestra"
+#define LOG_LEVEL  LOG_LEVEL_MAC
+
+struct adaptive_nbr {
+  /* Extra cells to and from the neighbor */
+  struct tsch_link *tx_links[ORCHESTRA_ADAPTIVE_MAX_CELLS];
+  struct tsch_link *rx_links[ORCHESTRA_ADAPTIVE_MAX_CELLS];
+  /* Running while the neighbor is known to listen to our extra cells */
+  struct timer tx_timer;
+  /* Running while we listen to the extra cells of the neighbor */
+  struct timer rx_timer;
+  uint8_t num_tx_links;
+  uint8_t rx_active;
+};
+
+NBR_TABLE(struct adaptive_nbr, adaptive_nbrs);
+
+static uint16_t slotframe_handle = 0;
+static struct tsch_slotframe *sf_adaptive;
+static struct ctimer expiry_timer;
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get_cell_timeslot(const linkaddr_t *from, const linkaddr_t *to, int i)
+{
+  return (ORCHESTRA_LINKADDR_HASH2(from, to)
+          + i * (ORCHESTRA_ADAPTIVE_PERIOD / ORCHESTRA_ADAPTIVE_MAX_CELLS))
+    % ORCHESTRA_ADAPTIVE_PERIOD;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get_cell_channel_offset(const linkaddr_t *from, const linkaddr_t *to)
+{
+  if(ORCHESTRA_UNICAST_MAX_CHANNEL_OFFSET >= ORCHESTRA_UNICAST_MIN_CHANNEL_OFFSET) {
+    return ORCHESTRA_LINKADDR_HASH2(from, to) % (ORCHESTRA_UNICAST_MAX_CHANNEL_OFFSET - ORCHESTRA_UNICAST_MIN_CHANNEL_OFFSET + 1)
+        + ORCHESTRA_UNICAST_MIN_CHANNEL_OFFSET;
+  } else {
+    return 0xffff;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_tx_links(struct adaptive_nbr *nbr, const linkaddr_t *addr, int num)
+{
+  while(nbr->num_tx_links < num) {
+    int i = nbr->num_tx_links;
+    nbr->tx_links[i] = tsch_schedule_add_link(sf_adaptive,
+        LINK_OPTION_TX, LINK_TYPE_NORMAL, addr,
+        get_cell_timeslot(&linkaddr_node_addr, addr, i),
+        get_cell_channel_offset(&linkaddr_node_addr, addr), 0);
+    if(nbr->tx_links[i] == NULL) {
+      break;
+    }
+    nbr->num_tx_links++;
+  }
+  while(nbr->num_tx_links > num) {
+    nbr->num_tx_links--;
+    tsch_schedule_remove_link(sf_adaptive, nbr->tx_links[nbr->num_tx_links]);
+    nbr->tx_links[nbr->num_tx_links] = NULL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_rx_links(struct adaptive_nbr *nbr, const linkaddr_t *addr, int active)
+{
+  int i;
+
+  if(active == nbr->rx_active) {
+    return;
+  }
+  LOG_DBG("adaptive: %s extra cells from ", active ? "add" : "remove");
+  LOG_DBG_LLADDR(addr);
+  LOG_DBG_("\n");
+  for(i = 0; i < ORCHESTRA_ADAPTIVE_MAX_CELLS; i++) {
+    if(active) {
+      nbr->rx_links[i] = tsch_schedule_add_link(sf_adaptive,
+          LINK_OPTION_RX, LINK_TYPE_NORMAL, addr,
+          get_cell_timeslot(addr, &linkaddr_node_addr, i),
+          get_cell_channel_offset(addr, &linkaddr_node_addr), 0);
+    } else if(nbr->rx_links[i] != NULL) {
+      tsch_schedule_remove_link(sf_adaptive, nbr->rx_links[i]);
+      nbr->rx_links[i] = NULL;
+    }
+  }
+  nbr->rx_active = active;
+}
+/*---------------------------------------------------------------------------*/
+/* Number of extra Tx cells to a neighbor with a given backlog */
+static int
+get_num_tx_links(int backlog)
+{
+  if(backlog == 0) {
+    return 0;
+  }
+  return MAX(1, MIN(ORCHESTRA_ADAPTIVE_MAX_CELLS,
+                    backlog / ORCHESTRA_ADAPTIVE_BACKLOG_PER_CELL));
+}
+/*---------------------------------------------------------------------------*/
+static int
+get_backlog(const linkaddr_t *addr)
+{
+  struct tsch_neighbor *n = tsch_queue_get_nbr(addr);
+  return n != NULL ? tsch_queue_nbr_packet_count(n) : 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+expiry(void *ptr)
+{
+  struct adaptive_nbr *nbr;
+
+  /* Stop listening to neighbors whose backlog is gone */
+  for(nbr = nbr_table_head(adaptive_nbrs); nbr != NULL;
+      nbr = nbr_table_next(adaptive_nbrs, nbr)) {
+    if(nbr->rx_active && timer_expired(&nbr->rx_timer)) {
+      set_rx_links(nbr, nbr_table_get_lladdr(adaptive_nbrs, nbr), 0);
+    }
+  }
+  ctimer_reset(&expiry_timer);
+}
+/*---------------------------------------------------------------------------*/
+static void
+nbr_removed(void *item)
+{
+  struct adaptive_nbr *nbr = item;
+
+  set_tx_links(nbr, NULL, 0);
+  set_rx_links(nbr, nbr_table_get_lladdr(adaptive_nbrs, nbr), 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_received(void)
+{
+  const linkaddr_t *src = packetbuf_addr(PACKETBUF_ADDR_SENDER);
+  struct adaptive_nbr *nbr;
+
+  /* A unicast frame with the frame pending bit: the sender has a backlog */
+  if(!packetbuf_attr(PACKETBUF_ATTR_PENDING)
+     || !linkaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &linkaddr_node_addr)) {
+    return;
+  }
+  nbr = nbr_table_get_from_lladdr(adaptive_nbrs, src);
+  if(nbr == NULL) {
+    nbr = nbr_table_add_lladdr(adaptive_nbrs, src, NBR_TABLE_REASON_MAC, NULL);
+    if(nbr == NULL) {
+      return;
+    }
+  }
+  timer_set(&nbr->rx_timer, ORCHESTRA_ADAPTIVE_HOLD_TIME);
+  set_rx_links(nbr, src, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_sent(int mac_status)
+{
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  struct adaptive_nbr *nbr;
+  int backlog;
+
+  if(packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) != FRAME802154_DATAFRAME
+     || linkaddr_cmp(dest, &linkaddr_null)) {
+    return;
+  }
+  backlog = get_backlog(dest);
+  nbr = nbr_table_get_from_lladdr(adaptive_nbrs, dest);
+  if(nbr == NULL) {
+    if(mac_status != MAC_TX_OK || backlog == 0) {
+      return;
+    }
+    nbr = nbr_table_add_lladdr(adaptive_nbrs, dest, NBR_TABLE_REASON_MAC, NULL);
+    if(nbr == NULL) {
+      return;
+    }
+  }
+
+  if(mac_status == MAC_TX_OK && backlog > 0) {
+    /* More packets were queued: the frame had the pending bit set, and
+     * the neighbor now listens to our extra cells */
+    timer_set(&nbr->tx_timer, ORCHESTRA_ADAPTIVE_HOLD_TIME / 2);
+  }
+  if(backlog == 0) {
+    /* No packet is bound to the extra cells any more */
+    set_tx_links(nbr, dest, 0);
+  } else if(get_num_tx_links(backlog) < nbr->num_tx_links) {
+    set_tx_links(nbr, dest, get_num_tx_links(backlog));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+select_packet(uint16_t *slotframe, uint16_t *timeslot, uint16_t *channel_offset)
+{
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  struct adaptive_nbr *nbr;
+  int backlog;
+
+  if(TSCH_BURST_MAX_LEN == 0
+     || packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) != FRAME802154_DATAFRAME
+     || linkaddr_cmp(dest, &linkaddr_null)
+     || (nbr = nbr_table_get_from_lladdr(adaptive_nbrs, dest)) == NULL
+     || timer_expired(&nbr->tx_timer)) {
+    return 0;
+  }
+
+  /* Packets already queued, plus this one */
+  backlog = get_backlog(dest) + 1;
+  if(backlog <= 1) {
+    /* The regular unicast cell is enough */
+    return 0;
+  }
+  if(get_num_tx_links(backlog) > nbr->num_tx_links) {
+    set_tx_links(nbr, dest, get_num_tx_links(backlog));
+  }
+  if(nbr->num_tx_links == 0) {
+    return 0;
+  }
+
+  /* Any of our extra cells to the neighbor */
+  if(slotframe != NULL) {
+    *slotframe = slotframe_handle;
+  }
+  if(timeslot != NULL) {
+    *timeslot = 0xffff;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(uint16_t sf_handle)
+{
+  slotframe_handle = sf_handle;
+  sf_adaptive = tsch_schedule_add_slotframe(slotframe_handle, ORCHESTRA_ADAPTIVE_PERIOD);
+  nbr_table_register(adaptive_nbrs, nbr_removed);
+  ctimer_set(&expiry_timer, ORCHESTRA_ADAPTIVE_HOLD_TIME / 4, expiry, NULL);
+}
+/*---------------------------------------------------------------------------*/
+struct orchestra_rule unicast_adaptive = {
+  init,
+  NULL,
+  select_packet,
+  NULL,
+  NULL,
+  packet_received,
+  packet_sent,
+  "unicast adaptive",
+};
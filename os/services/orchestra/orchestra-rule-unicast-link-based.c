@@ -204,6 +204,8 @@ struct orchestra_rule unicast_per_neighbor_link_based = {
   select_packet,
   child_added,
   child_removed,
+  NULL,
+  NULL,
   "unicast per neighbor link based",
 };
 
@@ -131,5 +131,7 @@ struct orchestra_rule unicast_per_neighbor_rpl_ns = {
   select_packet,
   child_added,
   child_removed,
+  NULL,
+  NULL,
   "unicast per neighbor non-storing",
 };
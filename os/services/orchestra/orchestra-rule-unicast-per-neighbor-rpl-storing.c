@@ -239,6 +239,8 @@ struct orchestra_rule unicast_per_neighbor_rpl_storing = {
   select_packet,
   child_added,
   child_removed,
+  NULL,
+  NULL,
   "unicast per neighbor storing",
 };
 
@@ -48,6 +48,8 @@ struct orchestra_rule {
   int  (* select_packet)(uint16_t *slotframe, uint16_t *timeslot, uint16_t *channel_offset);
   void (* child_added)(const linkaddr_t *addr);
   void (* child_removed)(const linkaddr_t *addr);
+  void (* packet_received)(void);
+  void (* packet_sent)(int mac_status);
   const char *name;
 };
 
@@ -56,6 +58,7 @@ extern struct orchestra_rule unicast_per_neighbor_rpl_storing;
 extern struct orchestra_rule unicast_per_neighbor_rpl_ns;
 extern struct orchestra_rule unicast_per_neighbor_link_based;
 extern struct orchestra_rule default_common;
+extern struct orchestra_rule unicast_adaptive;
 
 extern linkaddr_t orchestra_parent_linkaddr;
 extern int orchestra_parent_knows_us;
@@ -124,6 +124,44 @@ int strncasecmp(const char *s1, const char *s2, size_t n);
 #define RESOLV_SUPPORTS_RECORD_EXPIRATION 1
 #endif
 
+/* How long a name that could not be resolved is cached, when the
+   server did not say (RFC 2308), and at most */
+#ifdef RESOLV_CONF_NEGATIVE_TTL
+#define RESOLV_NEGATIVE_TTL RESOLV_CONF_NEGATIVE_TTL
+#else
+#define RESOLV_NEGATIVE_TTL 30
+#endif
+
+#ifdef RESOLV_CONF_MAX_NEGATIVE_TTL
+#define RESOLV_MAX_NEGATIVE_TTL RESOLV_CONF_MAX_NEGATIVE_TTL
+#else
+#define RESOLV_MAX_NEGATIVE_TTL 300
+#endif
+
+/* For how long after its expiration an address is still returned by
+   resolv_lookup(), while it is refreshed in the background or if its
+   refresh failed (RFC 8767) */
+#ifdef RESOLV_CONF_STALE_TIME
+#define RESOLV_STALE_TIME RESOLV_CONF_STALE_TIME
+#else
+#define RESOLV_STALE_TIME 60
+#endif
+
+/* How long to wait before querying again a name whose refresh failed,
+   while its expired address is served (RFC 8767, section 4) */
+#ifdef RESOLV_CONF_STALE_RETRY_TIME
+#define RESOLV_STALE_RETRY_TIME RESOLV_CONF_STALE_RETRY_TIME
+#else
+#define RESOLV_STALE_RETRY_TIME 30
+#endif
+
+/* The number of hash buckets used to look up names */
+#ifdef RESOLV_CONF_HASH_SIZE
+#define RESOLV_HASH_SIZE RESOLV_CONF_HASH_SIZE
+#else
+#define RESOLV_HASH_SIZE 8
+#endif
+
 #if RESOLV_CONF_SUPPORTS_MDNS && !RESOLV_VERIFY_ANSWER_NAMES
 #error RESOLV_CONF_SUPPORTS_MDNS cannot be set without RESOLV_CONF_VERIFY_ANSWER_NAMES
 #endif
@@ -144,6 +182,7 @@ int strncasecmp(const char *s1, const char *s2, size_t n);
 
 #define DNS_TYPE_A      1
 #define DNS_TYPE_CNAME  5
+#define DNS_TYPE_SOA    6
 #define DNS_TYPE_PTR   12
 #define DNS_TYPE_MX    15
 #define DNS_TYPE_TXT   16
@@ -214,10 +253,20 @@ struct namemap {
   uint8_t seqno;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
   unsigned long expiration;
+  /** When the periodic check queries the name again, if it was looked
+      up since its answer or its last refresh failed */
+  unsigned long refresh;
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
   uip_ipaddr_t ipaddr;
   uint8_t err;
   uint8_t server;
+  /** Non-zero if ipaddr is the previous answer, being refreshed, or
+      served after its refresh failed */
+  uint8_t stale;
+  /** Non-zero if the name was looked up since its answer */
+  uint8_t used;
+  /** The next entry of the hash chain, plus one, or 0 */
+  uint8_t next;
 #if RESOLV_CONF_SUPPORTS_MDNS
   int is_mdns:1, is_probe:1;
 #endif
@@ -230,19 +279,34 @@ struct namemap {
 #define RESOLV_ENTRIES UIP_CONF_RESOLV_ENTRIES
 #endif /* UIP_CONF_RESOLV_ENTRIES */
 
+#if RESOLV_ENTRIES > 127
+#error Too large RESOLV_ENTRIES set.
+#endif
+
 static struct namemap names[RESOLV_ENTRIES];
 
+/* The first entry of each hash chain, plus one, or 0 */
+static uint8_t names_hash[RESOLV_HASH_SIZE];
+
+#if RESOLV_CONF_STATS
+struct resolv_stats resolv_stats;
+#endif /* RESOLV_CONF_STATS */
+
 static uint8_t seqno;
 
 static struct uip_udp_conn *resolv_conn = NULL;
 
 static struct etimer retry;
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+static struct etimer refresh_timer;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
 process_event_t resolv_event_found;
 
 PROCESS(resolv_process, "DNS resolver");
 
 static void resolv_found(char *name, uip_ipaddr_t * ipaddr);
+static void start_refresh(struct namemap *nameptr);
 
 /** \internal The DNS question message structure. */
 struct dns_question {
@@ -377,6 +441,11 @@ skip_name(unsigned char *query)
 
   LOG_DBG("skip name: ");
 
+  if(*query == 0) {
+    /* The root name */
+    return query + 1;
+  }
+
   do {
     n = *query;
     if(n & 0xc0) {
@@ -398,6 +467,106 @@ skip_name(unsigned char *query)
   return query + 1;
 }
 /*---------------------------------------------------------------------------*/
+/** \internal
+ * The hash bucket of a name. Names are compared regardless of case.
+ */
+static uint8_t
+name_hash(const char *name)
+{
+  uint16_t h = 0;
+
+  while(*name) {
+    h = h * 31 + tolower((unsigned int)*name++);
+  }
+  return h % RESOLV_HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Finds the entry of a name, if any.
+ */
+static struct namemap *
+namemap_lookup(const char *name)
+{
+  uint8_t i;
+
+  for(i = names_hash[name_hash(name)]; i != 0; i = names[i - 1].next) {
+    if(strcasecmp(names[i - 1].name, name) == 0) {
+      return &names[i - 1];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Adds an entry to the hash chain of its name.
+ */
+static void
+namemap_link(struct namemap *namemapptr)
+{
+  uint8_t h = name_hash(namemapptr->name);
+
+  namemapptr->next = names_hash[h];
+  names_hash[h] = namemapptr - names + 1;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Removes an entry from the hash chain of its name, before the entry
+ * is given another name.
+ */
+static void
+namemap_unlink(struct namemap *namemapptr)
+{
+  uint8_t *ip;
+
+  for(ip = &names_hash[name_hash(namemapptr->name)]; *ip != 0;
+      ip = &names[*ip - 1].next) {
+    if(&names[*ip - 1] == namemapptr) {
+      *ip = namemapptr->next;
+      break;
+    }
+  }
+  namemapptr->next = 0;
+}
+/*---------------------------------------------------------------------------*/
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+/** \internal
+ * Returns how long a negative answer can be cached: the minimum of the
+ * TTL and the MINIMUM field of the SOA record of the authority
+ * section, if any (RFC 2308, section 5).
+ */
+static unsigned long
+negative_ttl(unsigned char *queryptr, uint8_t nanswers, uint8_t nauthrr)
+{
+  const unsigned char *end = (unsigned char *)uip_appdata + uip_datalen();
+  unsigned long ttl, minimum;
+  uint16_t len;
+
+  /* Skip the answers, usually none */
+  nauthrr += nanswers;
+  for(; nauthrr > 0; nauthrr--) {
+    queryptr = skip_name(queryptr);
+    if(queryptr + 10 > end) {
+      break;
+    }
+    len = (queryptr[8] << 8) | queryptr[9];
+    if(nanswers > 0) {
+      nanswers--;
+    } else if(((queryptr[0] << 8) | queryptr[1]) == DNS_TYPE_SOA &&
+              len >= 20 && queryptr + 10 + len <= end) {
+      ttl = ((unsigned long)queryptr[4] << 24) |
+        ((unsigned long)queryptr[5] << 16) | (queryptr[6] << 8) | queryptr[7];
+      queryptr += 10 + len - 4;
+      minimum = ((unsigned long)queryptr[0] << 24) |
+        ((unsigned long)queryptr[1] << 16) | (queryptr[2] << 8) | queryptr[3];
+      ttl = MIN(ttl, minimum);
+      return MIN(ttl, RESOLV_MAX_NEGATIVE_TTL);
+    }
+    queryptr += 10 + len;
+  }
+  return RESOLV_NEGATIVE_TTL;
+}
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+/*---------------------------------------------------------------------------*/
 /** \internal
  */
 static unsigned char *
@@ -576,9 +745,62 @@ try_next_server(struct namemap *namemapptr)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+/** \internal
+ * Sets the refresh timer to the next time the periodic check has a
+ * name to query again.
+ */
+static void
+schedule_refresh(void)
+{
+  unsigned long now = clock_seconds();
+  unsigned long next = 0;
+  uint8_t i;
+
+  for(i = 0; i < RESOLV_ENTRIES; ++i) {
+    if(names[i].state == STATE_DONE && names[i].refresh > now &&
+       (next == 0 || names[i].refresh < next)) {
+      next = names[i].refresh;
+    }
+  }
+  if(next != 0) {
+    etimer_set(&refresh_timer, (next - now) * CLOCK_SECOND);
+  } else {
+    etimer_stop(&refresh_timer);
+  }
+}
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Ends a query that got no usable answer. If the name had an address,
+ * it is still served until RESOLV_STALE_TIME after its expiration, and
+ * queried again every RESOLV_STALE_RETRY_TIME (RFC 8767).
+ */
+static void
+query_failed(struct namemap *namemapptr)
+{
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  if(namemapptr->stale &&
+     clock_seconds() <= namemapptr->expiration + RESOLV_STALE_TIME) {
+    LOG_DBG("Refresh of \"%s\" failed, serving it stale.\n",
+            namemapptr->name);
+    namemapptr->state = STATE_DONE;
+    namemapptr->refresh = clock_seconds() + RESOLV_STALE_RETRY_TIME;
+    schedule_refresh();
+    resolv_found(namemapptr->name, &namemapptr->ipaddr);
+    return;
+  }
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  /* STATE_ERROR basically means "not found". */
+  namemapptr->state = STATE_ERROR;
+  namemapptr->stale = 0;
+  resolv_found(namemapptr->name, NULL);
+}
+/*---------------------------------------------------------------------------*/
 /** \internal
  * Runs through the list of names to see if there are any that have
- * not yet been queried and, if so, sends out a query.
+ * not yet been queried and, if so, sends out a query. Names that are
+ * due for a refresh are queried again.
  */
 static void
 check_entries(void)
@@ -593,6 +815,18 @@ check_entries(void)
 
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     namemapptr = &names[i];
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+    if(namemapptr->state == STATE_DONE &&
+       clock_seconds() >= namemapptr->refresh) {
+      if(clock_seconds() > namemapptr->expiration + RESOLV_STALE_TIME) {
+        /* Too late, the address is not served any more */
+        namemapptr->stale = 0;
+      } else if(namemapptr->used || namemapptr->stale) {
+        /* Query the name again, its address is served meanwhile */
+        start_refresh(namemapptr);
+      }
+    }
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
     if(namemapptr->state == STATE_NEW || namemapptr->state == STATE_ASKING) {
       etimer_set(&retry, CLOCK_SECOND / 4);
       if(namemapptr->state == STATE_ASKING) {
@@ -608,15 +842,14 @@ check_entries(void)
             /* Try the next server (if possible) before failing. Otherwise
                simply mark the entry as failed. */
             if(try_next_server(namemapptr) == 0) {
-              /* STATE_ERROR basically means "not found". */
-              namemapptr->state = STATE_ERROR;
-
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-              /* Keep the "not found" error valid for 30 seconds */
-              namemapptr->expiration = clock_seconds() + 30;
+              /* Keep the "not found" error valid for a while. A stale
+                 address keeps its own expiration. */
+              if(!namemapptr->stale) {
+                namemapptr->expiration = clock_seconds() + RESOLV_NEGATIVE_TTL;
+              }
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
-              resolv_found(namemapptr->name, NULL);
+              query_failed(namemapptr);
               continue;
             }
           }
@@ -653,6 +886,7 @@ check_entries(void)
 #else /* RESOLV_CONF_SUPPORTS_MDNS */
       hdr->flags1 = DNS_FLAG1_RD;
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
+      RESOLV_STAT(resolv_stats.queries++);
       hdr->numquestions = UIP_HTONS(1);
       query = (unsigned char *)uip_appdata + sizeof(*hdr);
       query = encode_name(query, namemapptr->name);
@@ -827,8 +1061,14 @@ newdata(void)
 
 /** ANSWER HANDLING SECTION **************************************************/
 
-  if(nanswers == 0) {
-    /* Skip responses with no answers. */
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(nanswers == 0 &&
+     (is_request || UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT))) {
+#else /* RESOLV_CONF_SUPPORTS_MDNS */
+  if(nanswers == 0 && is_request) {
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+    /* Skip responses with no answers. Unicast DNS responses with no
+     * answers are negative answers to our questions. */
     return;
   }
 
@@ -865,14 +1105,17 @@ newdata(void)
     namemapptr->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    /* If we remain in the error state, keep it cached for 30 seconds. */
-    namemapptr->expiration = clock_seconds() + 30;
+    /* If we remain in the error state, keep it cached for as long as
+       the server says. A stale address keeps its own expiration. */
+    if(!namemapptr->stale) {
+      namemapptr->expiration = clock_seconds() +
+        negative_ttl(queryptr, nanswers, (uint8_t)uip_ntohs(hdr->numauthrr));
+    }
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
     /* Check for error. If so, call callback to inform. */
     if(namemapptr->err != 0) {
-      namemapptr->state = STATE_ERROR;
-      resolv_found(namemapptr->name, NULL);
+      query_failed(namemapptr);
       return;
     }
   }
@@ -916,48 +1159,46 @@ newdata(void)
 #if RESOLV_CONF_SUPPORTS_MDNS
     if(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
        hdr->id == 0) {
-      int8_t available_i = RESOLV_ENTRIES;
+      static char mdns_name[RESOLV_CONF_MAX_DOMAIN_NAME_SIZE + 1];
 
       LOG_DBG("MDNS query.\n");
 
       /* For MDNS, we need to actually look up the name we
        * are looking for.
        */
-      for(i = 0; i < RESOLV_ENTRIES; ++i) {
-        namemapptr = &names[i];
-        if(dns_name_isequal(queryptr, namemapptr->name, uip_appdata)) {
-          break;
-        }
-        if((namemapptr->state == STATE_UNUSED)
+      if(!decode_name(queryptr, mdns_name, uip_appdata)) {
+        LOG_DBG("MDNS name too big to cache.\n");
+        namemapptr = NULL;
+        goto skip_to_next_answer;
+      }
+      namemapptr = namemap_lookup(mdns_name);
+      if(namemapptr == NULL) {
+        LOG_DBG("Unsolicited MDNS response.\n");
+        for(i = 0; i < RESOLV_ENTRIES; ++i) {
+          namemapptr = &names[i];
+          if((namemapptr->state == STATE_UNUSED)
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-          || (namemapptr->state == STATE_DONE && clock_seconds() > namemapptr->expiration)
+            || (namemapptr->state == STATE_DONE && clock_seconds() > namemapptr->expiration)
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        ) {
-          available_i = i;
+          ) {
+            break;
+          }
         }
-      }
-      if(i == RESOLV_ENTRIES) {
-        LOG_DBG("Unsolicited MDNS response.\n");
-        i = available_i;
-        namemapptr = &names[i];
-        if(!decode_name(queryptr, namemapptr->name, uip_appdata)) {
-          LOG_DBG("MDNS name too big to cache.\n");
+        if(i == RESOLV_ENTRIES) {
+          LOG_DBG
+            ("Not enough room to keep track of unsolicited MDNS answer.\n");
+
+          if(strcasecmp(mdns_name, resolv_hostname) == 0) {
+            /* Oh snap, they say they are us! We had better report them... */
+            resolv_found(resolv_hostname, (uip_ipaddr_t *) ans->ipaddr);
+          }
           namemapptr = NULL;
           goto skip_to_next_answer;
         }
+        namemap_unlink(namemapptr);
+        strcpy(namemapptr->name, mdns_name);
+        namemap_link(namemapptr);
       }
-      if(i == RESOLV_ENTRIES) {
-        LOG_DBG
-          ("Not enough room to keep track of unsolicited MDNS answer.\n");
-
-        if(dns_name_isequal(queryptr, resolv_hostname, uip_appdata)) {
-          /* Oh snap, they say they are us! We had better report them... */
-          resolv_found(resolv_hostname, (uip_ipaddr_t *) ans->ipaddr);
-        }
-        namemapptr = NULL;
-        goto skip_to_next_answer;
-      }
-      namemapptr = &names[i];
 
     } else
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
@@ -978,12 +1219,17 @@ newdata(void)
     LOG_DBG("Answer for \"%s\" is usable.\n", namemapptr->name);
 
     namemapptr->state = STATE_DONE;
+    namemapptr->stale = 0;
+    namemapptr->used = 0;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
     namemapptr->expiration = (uint32_t) uip_ntohs(ans->ttl[0]) << 16 |
         (uint32_t) uip_ntohs(ans->ttl[1]);
     LOG_DBG("Expires in %lu seconds\n", namemapptr->expiration); 
 
     namemapptr->expiration += clock_seconds();
+    /* Refreshed when it expires, if it was looked up by then */
+    namemapptr->refresh = namemapptr->expiration;
+    schedule_refresh();
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
     uip_ipaddr_copy(&namemapptr->ipaddr, (uip_ipaddr_t *) ans->ipaddr);
@@ -1008,6 +1254,9 @@ newdata(void)
     if(try_next_server(namemapptr)) {
       namemapptr->state = STATE_ASKING;
       process_post(&resolv_process, PROCESS_EVENT_TIMER, NULL);
+    } else {
+      /* No server knows the answer */
+      query_failed(namemapptr);
     }
   }
 
@@ -1094,6 +1343,7 @@ PROCESS_THREAD(resolv_process, ev, data)
   PROCESS_BEGIN();
 
   memset(names, 0, sizeof(names));
+  memset(names_hash, 0, sizeof(names_hash));
 
   resolv_event_found = process_alloc_event();
 
@@ -1189,6 +1439,26 @@ remove_trailing_dots(const char *name) {
 #define remove_trailing_dots(x) (x)
 #endif /* RESOLV_AUTO_REMOVE_TRAILING_DOTS */
 /*---------------------------------------------------------------------------*/
+/** \internal
+ * Queries again a name that has an entry. Its current address, if
+ * any, is kept and can be served while the query runs.
+ */
+static void
+start_refresh(struct namemap *nameptr)
+{
+  LOG_DBG("Refreshing \"%s\".\n", nameptr->name);
+
+  nameptr->stale = (nameptr->state == STATE_DONE);
+  nameptr->state = STATE_NEW;
+  nameptr->err = 0;
+  nameptr->server = 0;
+  nameptr->seqno = seqno;
+  ++seqno;
+
+  /* Force check_entires() to run on our process. */
+  process_post(&resolv_process, PROCESS_EVENT_TIMER, 0);
+}
+/*---------------------------------------------------------------------------*/
 /**
  * Queues a name so that a question for the name will be sent out.
  *
@@ -1210,11 +1480,20 @@ resolv_query(const char *name)
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
 
+  nameptr = namemap_lookup(name);
+  if(nameptr != NULL) {
+    if(nameptr->state == STATE_NEW || nameptr->state == STATE_ASKING) {
+      /* A query for this name is already running */
+      LOG_DBG("Query for \"%s\" already running.\n", name);
+      RESOLV_STAT(resolv_stats.duplicates++);
+      return;
+    }
+    start_refresh(nameptr);
+    return;
+  }
+
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     nameptr = &names[i];
-    if(0 == strcasecmp(nameptr->name, name)) {
-      break;
-    }
     if((nameptr->state == STATE_UNUSED)
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
       || (nameptr->state == STATE_DONE && clock_seconds() > nameptr->expiration)
@@ -1228,16 +1507,16 @@ resolv_query(const char *name)
     }
   }
 
-  if(i == RESOLV_ENTRIES) {
-    i = lseqi;
-    nameptr = &names[i];
-  }
+  i = lseqi;
+  nameptr = &names[i];
 
   LOG_DBG("Starting query for \"%s\".\n", name);
 
+  namemap_unlink(nameptr);
   memset(nameptr, 0, sizeof(*nameptr));
 
   strncpy(nameptr->name, name, sizeof(nameptr->name) - 1);
+  namemap_link(nameptr);
   nameptr->state = STATE_NEW;
   nameptr->seqno = seqno;
   ++seqno;
@@ -1278,8 +1557,6 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
 {
   resolv_status_t ret = RESOLV_STATUS_UNCACHED;
 
-  uint8_t i;
-
   struct namemap *nameptr;
 
   /* Remove trailing dots, if present. */
@@ -1297,42 +1574,60 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
   }
 #endif /* UIP_CONF_LOOPBACK_INTERFACE */
 
-  /* Walk through the list to see if the name is in there. */
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    nameptr = &names[i];
-
-    if(strcasecmp(name, nameptr->name) == 0) {
-      switch (nameptr->state) {
-      case STATE_DONE:
-        ret = RESOLV_STATUS_CACHED;
+  nameptr = namemap_lookup(name);
+  if(nameptr != NULL) {
+    switch (nameptr->state) {
+    case STATE_DONE:
+      ret = RESOLV_STATUS_CACHED;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
+      if(clock_seconds() > nameptr->expiration) {
+        if((nameptr->used || nameptr->stale) &&
+           clock_seconds() <= nameptr->expiration + RESOLV_STALE_TIME) {
+          /* Serve the expired address, the periodic check refreshes
+             it */
+          RESOLV_STAT(resolv_stats.stale_hits++);
+        } else {
           ret = RESOLV_STATUS_EXPIRED;
         }
+      }
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
-      case STATE_NEW:
-      case STATE_ASKING:
-        ret = RESOLV_STATUS_RESOLVING;
-        break;
-      /* Almost certainly a not-found error from server */
-      case STATE_ERROR:
-        ret = RESOLV_STATUS_NOT_FOUND;
+      if(ret == RESOLV_STATUS_CACHED) {
+        nameptr->used = 1;
+      }
+      break;
+    case STATE_NEW:
+    case STATE_ASKING:
+      ret = RESOLV_STATUS_RESOLVING;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_UNCACHED;
-        }
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
+      if(nameptr->stale &&
+         clock_seconds() <= nameptr->expiration + RESOLV_STALE_TIME) {
+        RESOLV_STAT(resolv_stats.stale_hits++);
+        ret = RESOLV_STATUS_CACHED;
       }
-
-      if(ipaddr) {
-        *ipaddr = &nameptr->ipaddr;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+      break;
+    /* Almost certainly a not-found error from server */
+    case STATE_ERROR:
+      ret = RESOLV_STATUS_NOT_FOUND;
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+      if(clock_seconds() > nameptr->expiration) {
+        ret = RESOLV_STATUS_UNCACHED;
       }
-
-      /* Break out of for loop. */
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
       break;
     }
+
+    if(ipaddr) {
+      *ipaddr = &nameptr->ipaddr;
+    }
+  }
+
+  if(ret == RESOLV_STATUS_CACHED) {
+    RESOLV_STAT(resolv_stats.hits++);
+  } else if(ret == RESOLV_STATUS_NOT_FOUND) {
+    RESOLV_STAT(resolv_stats.negative_hits++);
+  } else {
+    RESOLV_STAT(resolv_stats.misses++);
   }
 
 #if LOG_LEVEL == LOG_LEVEL_DBG
@@ -90,6 +90,35 @@ enum {
 
 typedef uint8_t resolv_status_t;
 
+#ifndef RESOLV_CONF_STATS
+#define RESOLV_CONF_STATS 0
+#endif /* RESOLV_CONF_STATS */
+
+#if RESOLV_CONF_STATS
+/** Statistics of the resolver cache */
+struct resolv_stats {
+  /** Lookups of a usable address, stale ones included */
+  uint16_t hits;
+  /** Lookups served with an expired address, while it is refreshed or
+      after its refresh failed */
+  uint16_t stale_hits;
+  /** Lookups of a name known not to exist */
+  uint16_t negative_hits;
+  /** Lookups of an unknown or expired name, or of a name being resolved */
+  uint16_t misses;
+  /** Questions sent */
+  uint16_t queries;
+  /** Queries for a name whose query was already running */
+  uint16_t duplicates;
+};
+
+extern struct resolv_stats resolv_stats;
+
+#define RESOLV_STAT(code) (code)
+#else
+#define RESOLV_STAT(code)
+#endif /* RESOLV_CONF_STATS */
+
 /* Functions. */
 resolv_status_t resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr);
 
@@ -75,9 +75,19 @@
 #define LOG_WITH_ANNOTATE 0
 #endif /* LOG_CONF_WITH_ANNOTATE */
 
-/* Custom output function -- default is printf */
+/* Record logs as binary entries in a ring buffer, formatted later by a
+ * low-priority process (see sys/log-deferred.h). Disabled by default */
+#ifdef LOG_CONF_DEFERRED
+#define LOG_DEFERRED LOG_CONF_DEFERRED
+#else /* LOG_CONF_DEFERRED */
+#define LOG_DEFERRED 0
+#endif /* LOG_CONF_DEFERRED */
+
+/* Custom output function -- default is printf, or the deferred backend */
 #ifdef LOG_CONF_OUTPUT
 #define LOG_OUTPUT(...) LOG_CONF_OUTPUT(__VA_ARGS__)
+#elif LOG_DEFERRED
+#define LOG_OUTPUT(...) log_deferred_output(__VA_ARGS__)
 #else /* LOG_CONF_OUTPUT */
 #define LOG_OUTPUT(...) printf(__VA_ARGS__)
 #endif /* LOG_CONF_OUTPUT */
@@ -93,7 +103,8 @@
  * Custom output function to prefix logs with level and module.
  *
  * This will only be called when LOG_CONF_WITH_MODULE_PREFIX is enabled and
- * all implementations should be based on LOG_OUTPUT.
+ * all implementations should be based on LOG_OUTPUT. It is not used by the
+ * deferred backend, which always prints the default prefix.
  *
  * \param level     The log level
  * \param levelstr  The log level as string
@@ -0,0 +1,816 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \addtogroup log
+ * @{ */
+
+/**
+ * \file
+ *         Deferred logging backend: binary records in a ring buffer,
+ *         formatted by a process
+ *
+ *         A record starts with an 8-byte header: total length, type,
+ *         flags (level, prefix, location, truncated), one padding byte
+ *         and the 32-bit clock_time() at which it was logged. A message
+ *         record then holds the offset of its format string, the offset
+ *         of the module name when prefixed, the offset of the file name
+ *         and the line when located, and the arguments in the order of
+ *         the format string: 4 bytes for int conversions and stars,
+ *         8 bytes for long, size_t, pointer and floating-point
+ *         conversions, and a length byte followed by the characters for
+ *         %s. All fields are in the byte order of the node.
+ */
+
+#include "contiki.h"
+#include "sys/log.h"
+#include "sys/int-master.h"
+#include "net/ipv6/uiplib.h"
+#include "deployment/deployment.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef CONTIKI_TARGET_NATIVE
+#include <stdlib.h>
+#endif /* CONTIKI_TARGET_NATIVE */
+
+#if LOG_DEFERRED
+
+#if LOG_DEFERRED_BUF_SIZE > 0xffff
+#error "LOG_DEFERRED_CONF_BUF_SIZE must fit in 16 bits"
+#endif
+
+#if LOG_DEFERRED_RECORD_MAX > 0xff || LOG_DEFERRED_RECORD_MAX < 32
+#error "LOG_DEFERRED_CONF_RECORD_MAX must be between 32 and 255"
+#endif
+
+#if LOG_DEFERRED_RECORD_MAX > LOG_DEFERRED_BUF_SIZE
+#error "LOG_DEFERRED_CONF_RECORD_MAX must not exceed LOG_DEFERRED_CONF_BUF_SIZE"
+#endif
+
+/* Record header */
+#define REC_LEN         0
+#define REC_TYPE        1
+#define REC_FLAGS       2
+#define REC_TIME        4
+#define REC_HDR_LEN     8
+
+#define FLAG_LEVEL      0x07
+#define FLAG_PREFIX     0x08
+#define FLAG_LOC        0x10
+#define FLAG_TRUNCATED  0x20
+
+/* Length byte of a NULL %s argument */
+#define STR_NULL        0xff
+
+/* Argument classes of a conversion */
+#define ARG_INT         0
+#define ARG_WIDE        1
+#define ARG_PTR         2
+#define ARG_DOUBLE      3
+#define ARG_STR         4
+#define ARG_NONE        5
+
+/* Length modifiers */
+#define MOD_NONE        0
+#define MOD_L           1
+#define MOD_LL          2
+#define MOD_Z           3
+#define MOD_J           4
+#define MOD_T           5
+#define MOD_LD          6
+
+struct conversion {
+  int8_t stars;       /* Number of '*' in width and precision */
+  int8_t star_prec;   /* Non-zero if the precision is a '*' */
+  int16_t precision;  /* Explicit precision, or -1 */
+  uint8_t modifier;
+  uint8_t arg;
+};
+
+struct record {
+  uint8_t len;
+  uint8_t buf[LOG_DEFERRED_RECORD_MAX];
+};
+
+const char log_deferred_base[] = "";
+
+static uint8_t ring[LOG_DEFERRED_BUF_SIZE];
+static uint16_t ring_head;
+static uint16_t ring_tail;
+static uint16_t ring_used;
+static unsigned long dropped;
+static unsigned long dropped_reported;
+
+PROCESS(log_deferred_process, "Deferred log");
+/*---------------------------------------------------------------------------*/
+static int32_t
+string_offset(const char *s)
+{
+  return (int32_t)((uintptr_t)s - (uintptr_t)log_deferred_base);
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the conversion starting at the '%' pointed to by p, and returns a
+   pointer to the character following it, or NULL if it is malformed */
+static const char *
+parse_conversion(const char *p, struct conversion *c)
+{
+  c->stars = 0;
+  c->star_prec = 0;
+  c->precision = -1;
+  c->modifier = MOD_NONE;
+
+  for(p++; *p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0'; p++);
+  if(*p == '*') {
+    c->stars++;
+    p++;
+  }
+  for(; *p >= '0' && *p <= '9'; p++);
+  if(*p == '.') {
+    p++;
+    if(*p == '*') {
+      c->stars++;
+      c->star_prec = 1;
+      p++;
+    } else {
+      for(c->precision = 0; *p >= '0' && *p <= '9'; p++) {
+        c->precision = c->precision * 10 + *p - '0';
+      }
+    }
+  }
+
+  switch(*p) {
+  case 'h':
+    p += p[1] == 'h' ? 2 : 1;
+    break;
+  case 'l':
+    if(p[1] == 'l') {
+      c->modifier = MOD_LL;
+      p++;
+    } else {
+      c->modifier = MOD_L;
+    }
+    p++;
+    break;
+  case 'z':
+    c->modifier = MOD_Z;
+    p++;
+    break;
+  case 'j':
+    c->modifier = MOD_J;
+    p++;
+    break;
+  case 't':
+    c->modifier = MOD_T;
+    p++;
+    break;
+  case 'L':
+    c->modifier = MOD_LD;
+    p++;
+    break;
+  }
+
+  switch(*p) {
+  case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+    c->arg = c->modifier == MOD_NONE ? ARG_INT : ARG_WIDE;
+    break;
+  case 'c':
+    c->arg = ARG_INT;
+    break;
+  case 'p':
+    c->arg = ARG_PTR;
+    break;
+  case 's':
+    c->arg = ARG_STR;
+    break;
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+  case 'a': case 'A':
+    c->arg = ARG_DOUBLE;
+    break;
+  default:
+    return NULL;
+  }
+  return p + 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+put(struct record *r, const void *data, uint8_t len)
+{
+  if(r->len + len > LOG_DEFERRED_RECORD_MAX) {
+    r->buf[REC_FLAGS] |= FLAG_TRUNCATED;
+    return 0;
+  }
+  memcpy(&r->buf[r->len], data, len);
+  r->len += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_start(struct record *r, uint8_t type, uint8_t flags)
+{
+  uint32_t now = (uint32_t)clock_time();
+
+  r->buf[REC_TYPE] = type;
+  r->buf[REC_FLAGS] = flags;
+  r->buf[REC_FLAGS + 1] = 0;
+  memcpy(&r->buf[REC_TIME], &now, sizeof(now));
+  r->len = REC_HDR_LEN;
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_commit(struct record *r)
+{
+  int_master_status_t status;
+  uint16_t first;
+
+  r->buf[REC_LEN] = r->len;
+
+  status = int_master_read_and_disable();
+  if(ring_used + r->len > LOG_DEFERRED_BUF_SIZE) {
+    dropped++;
+  } else {
+    first = MIN(r->len, LOG_DEFERRED_BUF_SIZE - ring_head);
+    memcpy(&ring[ring_head], r->buf, first);
+    memcpy(ring, r->buf + first, r->len - first);
+    ring_head = (ring_head + r->len) % LOG_DEFERRED_BUF_SIZE;
+    ring_used += r->len;
+  }
+  int_master_status_set(status);
+
+  process_poll(&log_deferred_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Copies the oldest record out of the ring, returns 0 if there is none */
+static int
+record_pop(struct record *r)
+{
+  int_master_status_t status;
+  uint16_t first;
+  int ret = 0;
+
+  status = int_master_read_and_disable();
+  if(ring_used > 0) {
+    r->len = ring[ring_tail];
+    first = MIN(r->len, LOG_DEFERRED_BUF_SIZE - ring_tail);
+    memcpy(r->buf, &ring[ring_tail], first);
+    memcpy(r->buf + first, ring, r->len - first);
+    ring_tail = (ring_tail + r->len) % LOG_DEFERRED_BUF_SIZE;
+    ring_used -= r->len;
+    ret = 1;
+  }
+  int_master_status_set(status);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_args(struct record *r, const char *fmt, va_list ap)
+{
+  struct conversion c;
+  const char *p;
+  int32_t i32;
+  int32_t star;
+  uint64_t u64;
+  double d;
+  const char *s;
+  uint8_t len;
+  int limit;
+  int i;
+
+  for(p = fmt; (p = strchr(p, '%')) != NULL;) {
+    if(p[1] == '%') {
+      p += 2;
+      continue;
+    }
+    p = parse_conversion(p, &c);
+    if(p == NULL) {
+      return;
+    }
+
+    star = -1;
+    for(i = 0; i < c.stars; i++) {
+      star = va_arg(ap, int);
+      put(r, &star, sizeof(star));
+    }
+
+    switch(c.arg) {
+    case ARG_INT:
+      i32 = va_arg(ap, int);
+      put(r, &i32, sizeof(i32));
+      break;
+    case ARG_WIDE:
+      switch(c.modifier) {
+      case MOD_LL:
+        u64 = (uint64_t)va_arg(ap, long long);
+        break;
+      case MOD_Z:
+        u64 = (uint64_t)va_arg(ap, size_t);
+        break;
+      case MOD_J:
+        u64 = (uint64_t)va_arg(ap, intmax_t);
+        break;
+      case MOD_T:
+        u64 = (uint64_t)va_arg(ap, ptrdiff_t);
+        break;
+      default:
+        u64 = (uint64_t)va_arg(ap, long);
+        break;
+      }
+      put(r, &u64, sizeof(u64));
+      break;
+    case ARG_PTR:
+      u64 = (uintptr_t)va_arg(ap, void *);
+      put(r, &u64, sizeof(u64));
+      break;
+    case ARG_DOUBLE:
+      if(c.modifier == MOD_LD) {
+        d = (double)va_arg(ap, long double);
+      } else {
+        d = va_arg(ap, double);
+      }
+      put(r, &d, sizeof(d));
+      break;
+    case ARG_STR:
+      s = va_arg(ap, const char *);
+      if(s == NULL) {
+        len = STR_NULL;
+        put(r, &len, 1);
+        break;
+      }
+      /* The string may not be terminated if a precision is given */
+      limit = c.star_prec ? star : c.precision;
+      if(limit < 0 || limit > LOG_DEFERRED_STR_MAX) {
+        limit = LOG_DEFERRED_STR_MAX;
+      }
+      for(len = 0; len < limit && s[len] != '\0'; len++);
+      if(put(r, &len, 1)) {
+        put(r, s, len);
+      }
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_message(int newline, int level, const char *module,
+               const char *file, int line, const char *fmt, va_list ap)
+{
+  struct record r;
+  uint8_t flags = level & FLAG_LEVEL;
+  int32_t offset;
+  uint16_t u16;
+
+  if(newline && module != NULL) {
+    flags |= FLAG_PREFIX;
+    if(file != NULL) {
+      flags |= FLAG_LOC;
+    }
+  }
+  record_start(&r, LOG_DEFERRED_MSG, flags);
+
+  offset = string_offset(fmt);
+  put(&r, &offset, sizeof(offset));
+  if(flags & FLAG_PREFIX) {
+    offset = string_offset(module);
+    put(&r, &offset, sizeof(offset));
+  }
+  if(flags & FLAG_LOC) {
+    offset = string_offset(file);
+    put(&r, &offset, sizeof(offset));
+    u16 = line;
+    put(&r, &u16, sizeof(u16));
+  }
+  record_args(&r, fmt, ap);
+  record_commit(&r);
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_log(int newline, int level, const char *module,
+                 const char *file, int line, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  record_message(newline, level, module, file, line, fmt, ap);
+  va_end(ap);
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_output(const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  record_message(0, 0, NULL, NULL, 0, fmt, ap);
+  va_end(ap);
+}
+/*---------------------------------------------------------------------------*/
+#if NETSTACK_CONF_WITH_IPV6
+void
+log_deferred_6addr(const uip_ipaddr_t *ipaddr, int compact)
+{
+  struct record r;
+
+  record_start(&r, compact ? LOG_DEFERRED_6ADDR_COMPACT : LOG_DEFERRED_6ADDR,
+               0);
+  if(ipaddr != NULL) {
+    put(&r, ipaddr, sizeof(uip_ipaddr_t));
+  }
+  record_commit(&r);
+}
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_lladdr(const linkaddr_t *lladdr, int compact)
+{
+  struct record r;
+
+  record_start(&r, compact ? LOG_DEFERRED_LLADDR_COMPACT : LOG_DEFERRED_LLADDR,
+               0);
+  if(lladdr != NULL) {
+    put(&r, lladdr, sizeof(linkaddr_t));
+  }
+  record_commit(&r);
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_bytes(const void *data, size_t length)
+{
+  struct record r;
+
+  record_start(&r, LOG_DEFERRED_BYTES, 0);
+  if(length > LOG_DEFERRED_STR_MAX) {
+    r.buf[REC_FLAGS] |= FLAG_TRUNCATED;
+    length = LOG_DEFERRED_STR_MAX;
+  }
+  put(&r, data, length);
+  record_commit(&r);
+}
+/*---------------------------------------------------------------------------*/
+#if LOG_DEFERRED_BINARY
+static void
+print_record(const struct record *r)
+{
+  uint8_t i;
+
+  LOG_DEFERRED_PRINT("LOGB:");
+  for(i = 0; i < r->len; i++) {
+    LOG_DEFERRED_PRINT("%02x", r->buf[i]);
+  }
+  LOG_DEFERRED_PRINT("\n");
+}
+#else /* LOG_DEFERRED_BINARY */
+static const char *
+string_at(int32_t offset)
+{
+  return (const char *)((uintptr_t)log_deferred_base + offset);
+}
+/*---------------------------------------------------------------------------*/
+static int
+get(const struct record *r, uint8_t *pos, void *data, uint8_t len)
+{
+  if(*pos + len > r->len) {
+    return 0;
+  }
+  memcpy(data, &r->buf[*pos], len);
+  *pos += len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_prefix(const struct record *r, uint8_t *pos)
+{
+  static const char *const level_str[] = {
+    "PRI", "ERR", "WARN", "INFO", "DBG"
+  };
+  static const char *const level_color[] = {
+    LOG_COLOR_PRI, LOG_COLOR_ERR, LOG_COLOR_WARN, LOG_COLOR_INFO,
+    LOG_COLOR_DBG
+  };
+  uint8_t level = r->buf[REC_FLAGS] & FLAG_LEVEL;
+  int32_t offset;
+  uint16_t line;
+
+  if(level > LOG_LEVEL_DBG) {
+    level = 0;
+  }
+  if(!get(r, pos, &offset, sizeof(offset))) {
+    return;
+  }
+  if(LOG_WITH_COLOR) {
+    LOG_DEFERRED_PRINT("%s", level_color[level]);
+  }
+  if(LOG_WITH_MODULE_PREFIX) {
+    LOG_DEFERRED_PRINT("[%-4s: %-10s] ", level_str[level], string_at(offset));
+  }
+  if((r->buf[REC_FLAGS] & FLAG_LOC) &&
+     get(r, pos, &offset, sizeof(offset)) && get(r, pos, &line, sizeof(line))) {
+    LOG_DEFERRED_PRINT("[%s: %u] ", string_at(offset), line);
+  }
+  if(LOG_WITH_COLOR) {
+    LOG_DEFERRED_PRINT(LOG_COLOR_RESET);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Prints the conversion [start, end) with the next argument of the record.
+   Returns 0 if the record has no more arguments */
+static int
+print_conversion(const struct record *r, uint8_t *pos,
+                 const char *start, const char *end,
+                 const struct conversion *c)
+{
+  char spec[24];
+  char str[LOG_DEFERRED_STR_MAX + 1];
+  size_t n = 0;
+  int32_t i32;
+  uint64_t u64;
+  double d;
+  uint8_t len;
+
+  for(; start < end && n < sizeof(spec) - 12; start++) {
+    if(*start == '*') {
+      if(!get(r, pos, &i32, sizeof(i32))) {
+        return 0;
+      }
+      n += snprintf(&spec[n], sizeof(spec) - n, "%ld", (long)i32);
+    } else {
+      spec[n++] = *start;
+    }
+  }
+  if(start != end) {
+    /* Conversion too long to be rebuilt */
+    return 0;
+  }
+  spec[n] = '\0';
+
+  switch(c->arg) {
+  case ARG_INT:
+    if(!get(r, pos, &i32, sizeof(i32))) {
+      return 0;
+    }
+    LOG_DEFERRED_PRINT(spec, (int)i32);
+    break;
+  case ARG_WIDE:
+    if(!get(r, pos, &u64, sizeof(u64))) {
+      return 0;
+    }
+    switch(c->modifier) {
+    case MOD_LL:
+      LOG_DEFERRED_PRINT(spec, (long long)u64);
+      break;
+    case MOD_Z:
+      LOG_DEFERRED_PRINT(spec, (size_t)u64);
+      break;
+    case MOD_J:
+      LOG_DEFERRED_PRINT(spec, (intmax_t)u64);
+      break;
+    case MOD_T:
+      LOG_DEFERRED_PRINT(spec, (ptrdiff_t)u64);
+      break;
+    default:
+      LOG_DEFERRED_PRINT(spec, (long)u64);
+      break;
+    }
+    break;
+  case ARG_PTR:
+    if(!get(r, pos, &u64, sizeof(u64))) {
+      return 0;
+    }
+    LOG_DEFERRED_PRINT(spec, (void *)(uintptr_t)u64);
+    break;
+  case ARG_DOUBLE:
+    if(!get(r, pos, &d, sizeof(d))) {
+      return 0;
+    }
+    if(c->modifier == MOD_LD) {
+      LOG_DEFERRED_PRINT(spec, (long double)d);
+    } else {
+      LOG_DEFERRED_PRINT(spec, d);
+    }
+    break;
+  case ARG_STR:
+    if(!get(r, pos, &len, sizeof(len))) {
+      return 0;
+    }
+    if(len == STR_NULL) {
+      LOG_DEFERRED_PRINT(spec, "(null)");
+      break;
+    }
+    if(len > LOG_DEFERRED_STR_MAX || !get(r, pos, str, len)) {
+      return 0;
+    }
+    str[len] = '\0';
+    LOG_DEFERRED_PRINT(spec, str);
+    break;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_message(const struct record *r)
+{
+  struct conversion c;
+  uint8_t pos = REC_HDR_LEN;
+  int32_t offset;
+  const char *p;
+  const char *q;
+
+  if(!get(r, &pos, &offset, sizeof(offset))) {
+    return;
+  }
+  p = string_at(offset);
+  if(r->buf[REC_FLAGS] & FLAG_PREFIX) {
+    print_prefix(r, &pos);
+  }
+
+  while(*p != '\0') {
+    q = strchr(p, '%');
+    if(q == NULL) {
+      LOG_DEFERRED_PRINT("%s", p);
+      break;
+    }
+    if(q > p) {
+      LOG_DEFERRED_PRINT("%.*s", (int)(q - p), p);
+    }
+    if(q[1] == '%') {
+      LOG_DEFERRED_PRINT("%%");
+      p = q + 2;
+      continue;
+    }
+    p = parse_conversion(q, &c);
+    if(p == NULL) {
+      LOG_DEFERRED_PRINT("%s", q);
+      break;
+    }
+    if(!print_conversion(r, &pos, q, p, &c)) {
+      /* The arguments did not fit in the record */
+      LOG_DEFERRED_PRINT("[...]\n");
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_lladdr(const struct record *r)
+{
+  linkaddr_t lladdr;
+  uint8_t pos = REC_HDR_LEN;
+  unsigned int i;
+
+  if(!get(r, &pos, &lladdr, sizeof(lladdr))) {
+    LOG_DEFERRED_PRINT(r->buf[REC_TYPE] == LOG_DEFERRED_LLADDR ?
+                       "(NULL LL addr)" : "LL-NULL");
+    return;
+  }
+  if(r->buf[REC_TYPE] == LOG_DEFERRED_LLADDR) {
+    for(i = 0; i < LINKADDR_SIZE; i++) {
+      if(i > 0 && i % 2 == 0) {
+        LOG_DEFERRED_PRINT(".");
+      }
+      LOG_DEFERRED_PRINT("%02x", lladdr.u8[i]);
+    }
+  } else if(linkaddr_cmp(&lladdr, &linkaddr_null)) {
+    LOG_DEFERRED_PRINT("LL-NULL");
+  } else {
+#if BUILD_WITH_DEPLOYMENT
+    LOG_DEFERRED_PRINT("LL-%04u", deployment_id_from_lladdr(&lladdr));
+#else /* BUILD_WITH_DEPLOYMENT */
+#if LINKADDR_SIZE == 8
+    LOG_DEFERRED_PRINT("LL-%04x", UIP_HTONS(lladdr.u16[LINKADDR_SIZE/2-1]));
+#elif LINKADDR_SIZE == 2
+    LOG_DEFERRED_PRINT("LL-%04x", UIP_HTONS(lladdr.u16));
+#endif
+#endif /* BUILD_WITH_DEPLOYMENT */
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_record(const struct record *r)
+{
+  uint8_t i;
+#if NETSTACK_CONF_WITH_IPV6
+  uip_ipaddr_t ipaddr;
+  char buf[UIPLIB_IPV6_MAX_STR_LEN];
+  uint8_t pos = REC_HDR_LEN;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+  switch(r->buf[REC_TYPE]) {
+  case LOG_DEFERRED_MSG:
+    print_message(r);
+    break;
+#if NETSTACK_CONF_WITH_IPV6
+  case LOG_DEFERRED_6ADDR:
+  case LOG_DEFERRED_6ADDR_COMPACT:
+    if(!get(r, &pos, &ipaddr, sizeof(ipaddr))) {
+      log_6addr_compact_snprint(buf, sizeof(buf), NULL);
+    } else if(r->buf[REC_TYPE] == LOG_DEFERRED_6ADDR) {
+      uiplib_ipaddr_snprint(buf, sizeof(buf), &ipaddr);
+    } else {
+      log_6addr_compact_snprint(buf, sizeof(buf), &ipaddr);
+    }
+    LOG_DEFERRED_PRINT("%s", buf);
+    break;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+  case LOG_DEFERRED_LLADDR:
+  case LOG_DEFERRED_LLADDR_COMPACT:
+    print_lladdr(r);
+    break;
+  case LOG_DEFERRED_BYTES:
+    for(i = REC_HDR_LEN; i < r->len; i++) {
+      LOG_DEFERRED_PRINT("%02x", r->buf[i]);
+    }
+    if(r->buf[REC_FLAGS] & FLAG_TRUNCATED) {
+      LOG_DEFERRED_PRINT("..");
+    }
+    break;
+  }
+}
+#endif /* LOG_DEFERRED_BINARY */
+/*---------------------------------------------------------------------------*/
+/* Formats up to max records, returns non-zero if some are left */
+static int
+drain(unsigned max)
+{
+  struct record r;
+  unsigned long lost;
+
+  lost = dropped - dropped_reported;
+  if(lost > 0) {
+    dropped_reported += lost;
+    LOG_DEFERRED_PRINT("[WARN: Log       ] %lu records dropped\n", lost);
+  }
+  while(max > 0 && record_pop(&r)) {
+    print_record(&r);
+    max--;
+  }
+  return ring_used > 0;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(log_deferred_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    if(drain(LOG_DEFERRED_BATCH)) {
+      /* Let the other processes run before the next batch */
+      process_poll(PROCESS_CURRENT());
+    }
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_init(void)
+{
+  if(!process_is_running(&log_deferred_process)) {
+    process_start(&log_deferred_process, NULL);
+#ifdef CONTIKI_TARGET_NATIVE
+    /* Do not lose the last records when the process exits */
+    atexit(log_deferred_flush);
+#endif /* CONTIKI_TARGET_NATIVE */
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+log_deferred_flush(void)
+{
+  while(drain(LOG_DEFERRED_BATCH));
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+log_deferred_dropped(void)
+{
+  return dropped;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* LOG_DEFERRED */
+
+/** @} */
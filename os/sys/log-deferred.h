@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \addtogroup log
+ * @{ */
+
+/**
+ * \file
+ *         Header file for the deferred logging backend
+ *
+ *         With LOG_CONF_DEFERRED enabled, the LOG_* macros no longer
+ *         format on the spot. Each call appends a compact binary record
+ *         (format string reference, timestamp, raw arguments) to a ring
+ *         buffer, and the deferred log process formats the records later,
+ *         when the system is idle. With LOG_DEFERRED_CONF_BINARY, the
+ *         process only dumps the records in hex, and the formatting is
+ *         done on the host by tools/log-decode.
+ *
+ *         Format strings and module names are referenced by their offset
+ *         to log_deferred_base, so they must be string literals. %s
+ *         arguments are copied, up to LOG_DEFERRED_STR_MAX bytes.
+ */
+
+#ifndef LOG_DEFERRED_H_
+#define LOG_DEFERRED_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#if NETSTACK_CONF_WITH_IPV6
+#include "net/ipv6/uip.h"
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+#include <stddef.h>
+
+/* Size of the ring buffer holding the records, in bytes */
+#ifdef LOG_DEFERRED_CONF_BUF_SIZE
+#define LOG_DEFERRED_BUF_SIZE LOG_DEFERRED_CONF_BUF_SIZE
+#else /* LOG_DEFERRED_CONF_BUF_SIZE */
+#define LOG_DEFERRED_BUF_SIZE 1024
+#endif /* LOG_DEFERRED_CONF_BUF_SIZE */
+
+/* Maximum size of a record. The arguments that do not fit are left out */
+#ifdef LOG_DEFERRED_CONF_RECORD_MAX
+#define LOG_DEFERRED_RECORD_MAX LOG_DEFERRED_CONF_RECORD_MAX
+#else /* LOG_DEFERRED_CONF_RECORD_MAX */
+#define LOG_DEFERRED_RECORD_MAX 96
+#endif /* LOG_DEFERRED_CONF_RECORD_MAX */
+
+/* Maximum number of bytes copied for a %s argument or a LOG_BYTES call */
+#ifdef LOG_DEFERRED_CONF_STR_MAX
+#define LOG_DEFERRED_STR_MAX LOG_DEFERRED_CONF_STR_MAX
+#else /* LOG_DEFERRED_CONF_STR_MAX */
+#define LOG_DEFERRED_STR_MAX 32
+#endif /* LOG_DEFERRED_CONF_STR_MAX */
+
+/* Number of records formatted each time the deferred log process runs */
+#ifdef LOG_DEFERRED_CONF_BATCH
+#define LOG_DEFERRED_BATCH LOG_DEFERRED_CONF_BATCH
+#else /* LOG_DEFERRED_CONF_BATCH */
+#define LOG_DEFERRED_BATCH 8
+#endif /* LOG_DEFERRED_CONF_BATCH */
+
+/* Dump the records as "LOGB:<hex>" lines for tools/log-decode instead of
+ * formatting them on the node */
+#ifdef LOG_DEFERRED_CONF_BINARY
+#define LOG_DEFERRED_BINARY LOG_DEFERRED_CONF_BINARY
+#else /* LOG_DEFERRED_CONF_BINARY */
+#define LOG_DEFERRED_BINARY 0
+#endif /* LOG_DEFERRED_CONF_BINARY */
+
+/* Output function used by the deferred log process -- default is printf */
+#ifdef LOG_DEFERRED_CONF_PRINT
+#define LOG_DEFERRED_PRINT(...) LOG_DEFERRED_CONF_PRINT(__VA_ARGS__)
+#else /* LOG_DEFERRED_CONF_PRINT */
+#define LOG_DEFERRED_PRINT(...) printf(__VA_ARGS__)
+#endif /* LOG_DEFERRED_CONF_PRINT */
+
+/* Record types */
+#define LOG_DEFERRED_MSG             0
+#define LOG_DEFERRED_6ADDR           1
+#define LOG_DEFERRED_6ADDR_COMPACT   2
+#define LOG_DEFERRED_LLADDR          3
+#define LOG_DEFERRED_LLADDR_COMPACT  4
+#define LOG_DEFERRED_BYTES           5
+
+/* Anchor of the string offsets stored in the records */
+extern const char log_deferred_base[];
+
+PROCESS_NAME(log_deferred_process);
+
+/**
+ * Initializes the ring buffer and starts the deferred log process
+ */
+void log_deferred_init(void);
+
+/**
+ * Records a log message
+ * \param newline Non-zero if the message starts a new line, i.e. gets the
+ * level and module prefix
+ * \param level The log level
+ * \param module The module string descriptor
+ * \param file The file name to log with the message, or NULL
+ * \param line The line number to log with the message
+ * \param fmt The printf-style format string
+*/
+void log_deferred_log(int newline, int level, const char *module,
+                      const char *file, int line, const char *fmt, ...)
+  __attribute__((format(printf, 6, 7)));
+
+/**
+ * Records a log message without prefix, as LOG_OUTPUT would print it
+ * \param fmt The printf-style format string
+*/
+void log_deferred_output(const char *fmt, ...)
+  __attribute__((format(printf, 1, 2)));
+
+#if NETSTACK_CONF_WITH_IPV6
+/**
+ * Records an IPv6 address, formatted later as log_6addr or
+ * log_6addr_compact
+ * \param ipaddr The IPv6 address
+ * \param compact Non-zero for the compact format
+*/
+void log_deferred_6addr(const uip_ipaddr_t *ipaddr, int compact);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+/**
+ * Records a link-layer address, formatted later as log_lladdr or
+ * log_lladdr_compact
+ * \param lladdr The link-layer address
+ * \param compact Non-zero for the compact format
+*/
+void log_deferred_lladdr(const linkaddr_t *lladdr, int compact);
+
+/**
+ * Records a byte array, logged later as hex characters. At most
+ * LOG_DEFERRED_STR_MAX bytes are kept.
+ * \param data The byte array
+ * \param length The length of the byte array
+*/
+void log_deferred_bytes(const void *data, size_t length);
+
+/**
+ * Formats all the pending records now, e.g. before a reset
+*/
+void log_deferred_flush(void);
+
+/**
+ * Returns the number of records dropped since boot because the ring
+ * buffer was full
+*/
+unsigned long log_deferred_dropped(void);
+
+#endif /* LOG_DEFERRED_H_ */
+
+/** @} */
@@ -57,6 +57,9 @@
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip.h"
 #endif /* NETSTACK_CONF_WITH_IPV6 */
+#if LOG_DEFERRED
+#include "sys/log-deferred.h"
+#endif /* LOG_DEFERRED */
 
 /* The different log levels available */
 #define LOG_LEVEL_NONE         0 /* No log */
@@ -136,6 +139,18 @@ extern struct log_module all_modules[];
 
 /* Main log function */
 
+#if LOG_DEFERRED
+
+#define LOG(newline, level, levelstr, levelcolor, ...) do {  \
+                            if(level <= (LOG_LEVEL)) { \
+                              log_deferred_log(newline, level, LOG_MODULE, \
+                                               LOG_WITH_LOC ? __FILE__ : NULL, \
+                                               __LINE__, __VA_ARGS__); \
+                            } \
+                          } while (0)
+
+#else /* LOG_DEFERRED */
+
 #define LOG(newline, level, levelstr, levelcolor, ...) do {  \
                             if(level <= (LOG_LEVEL)) { \
                               if(newline) { \
@@ -156,6 +171,8 @@ extern struct log_module all_modules[];
                             } \
                           } while (0)
 
+#endif /* LOG_DEFERRED */
+
 /* For Cooja annotations */
 #define LOG_ANNOTATE(...) do {  \
                             if(LOG_WITH_ANNOTATE) { \
@@ -163,6 +180,29 @@ extern struct log_module all_modules[];
                             } \
                         } while (0)
 
+#if LOG_DEFERRED
+
+/* Addresses and byte arrays are recorded raw, and formatted later */
+#define LOG_LLADDR(level, lladdr) do {  \
+                            if(level <= (LOG_LEVEL)) { \
+                              log_deferred_lladdr(lladdr, LOG_WITH_COMPACT_ADDR); \
+                            } \
+                        } while (0)
+
+#define LOG_6ADDR(level, ipaddr) do {  \
+                           if(level <= (LOG_LEVEL)) { \
+                             log_deferred_6addr(ipaddr, LOG_WITH_COMPACT_ADDR); \
+                           } \
+                         } while (0)
+
+#define LOG_BYTES(level, data, length) do {  \
+                           if(level <= (LOG_LEVEL)) { \
+                             log_deferred_bytes(data, length); \
+                           } \
+                         } while (0)
+
+#else /* LOG_DEFERRED */
+
 /* Link-layer address */
 #define LOG_LLADDR(level, lladdr) do {  \
                             if(level <= (LOG_LEVEL)) { \
@@ -191,6 +231,8 @@ extern struct log_module all_modules[];
                            } \
                          } while (0)
 
+#endif /* LOG_DEFERRED */
+
 /* More compact versions of LOG macros */
 #define LOG_PRINT(...)         LOG(1, 0, "PRI", LOG_COLOR_PRI, __VA_ARGS__)
 #define LOG_ERR(...)           LOG(1, LOG_LEVEL_ERR, "ERR", LOG_COLOR_ERR, __VA_ARGS__)
@@ -47,6 +47,7 @@
 
 #include "contiki.h"
 #include "sys/process.h"
+#include "sys/trace.h"
 
 /*
  * Pointer to the currently running process structure.
@@ -187,7 +188,9 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event %d\n", PROCESS_NAME_STRING(p), ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+    TRACE_BEGIN(PROCESS, p);
     ret = p->thread(&p->pt, ev, data);
+    TRACE_END(PROCESS, ev);
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \addtogroup trace
+ * @{ */
+
+/**
+ * \file
+ *         Trace points: event ring buffer and Chrome trace-event export
+ */
+
+#include "contiki.h"
+#include "sys/trace.h"
+#include "sys/int-master.h"
+#include "sys/node-id.h"
+#include "net/packetbuf.h"
+
+#ifdef CONTIKI_TARGET_NATIVE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif /* CONTIKI_TARGET_NATIVE */
+
+#if TRACE_ENABLED
+
+#define TRACE_POINT_DESC(id, cat, name, track, arg, end_arg) \
+  { cat, name, arg, end_arg, track },
+const struct trace_point trace_points[] = {
+  TRACE_POINTS(TRACE_POINT_DESC)
+};
+
+static struct trace_event events[TRACE_BUF_SIZE];
+static uint16_t events_head;
+static uint16_t events_count;
+static unsigned long overwritten;
+
+static uint16_t last_id;
+static uint16_t current_packet;
+/*---------------------------------------------------------------------------*/
+void
+trace_event(uint8_t point, char phase, uint16_t id, uintptr_t arg)
+{
+  int_master_status_t status;
+  struct trace_event *ev;
+
+  if(id == 0 && (phase == TRACE_PHASE_ASYNC_BEGIN ||
+                 phase == TRACE_PHASE_ASYNC_STEP ||
+                 phase == TRACE_PHASE_ASYNC_END)) {
+    return;
+  }
+
+  status = int_master_read_and_disable();
+  ev = &events[events_head];
+  events_head = (events_head + 1) % TRACE_BUF_SIZE;
+  if(events_count < TRACE_BUF_SIZE) {
+    events_count++;
+  } else {
+    overwritten++;
+  }
+  ev->time = TRACE_NOW();
+  ev->arg = arg;
+  ev->id = id;
+  ev->point = point;
+  ev->phase = phase;
+  int_master_status_set(status);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+new_id(void)
+{
+  /* 0 means no id */
+  if(++last_id == 0) {
+    last_id = 1;
+  }
+  return last_id;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+trace_packet_new(void)
+{
+  current_packet = new_id();
+  return current_packet;
+}
+/*---------------------------------------------------------------------------*/
+void
+trace_frame_begin(void)
+{
+  uint16_t id = new_id();
+
+  packetbuf_set_attr(PACKETBUF_ATTR_TRACE_ID, id);
+  TRACE_ASYNC_BEGIN(FRAME, id, current_packet);
+}
+/*---------------------------------------------------------------------------*/
+int
+trace_read(struct trace_event *ev)
+{
+  int_master_status_t status;
+  int ret = 0;
+
+  status = int_master_read_and_disable();
+  if(events_count > 0) {
+    *ev = events[(events_head + TRACE_BUF_SIZE - events_count) % TRACE_BUF_SIZE];
+    events_count--;
+    ret = 1;
+  }
+  int_master_status_set(status);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+trace_overwritten(void)
+{
+  return overwritten;
+}
+/*---------------------------------------------------------------------------*/
+#ifdef CONTIKI_TARGET_NATIVE
+trace_time_t
+trace_native_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (trace_time_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_string(FILE *f, const char *s)
+{
+  fputc('"', f);
+  for(; *s != '\0'; s++) {
+    if(*s == '"' || *s == '\\') {
+      fputc('\\', f);
+    }
+    fputc(*s, f);
+  }
+  fputc('"', f);
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_json(void)
+{
+  const char *path = getenv("CONTIKI_NG_TRACE");
+  const struct trace_point *tp;
+  struct trace_event ev;
+  trace_time_t last = 0;
+  uint64_t ts = 0;
+  const char *arg;
+  int first = 1;
+  FILE *f;
+
+  if(path == NULL) {
+    path = TRACE_NATIVE_FILE;
+  }
+  f = fopen(path, "w");
+  if(f == NULL) {
+    perror(path);
+    return;
+  }
+
+  fprintf(f, "{\"traceEvents\":[\n");
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+          "\"args\":{\"name\":\"node %u\"}},\n", node_id, node_id);
+  fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+          "\"args\":{\"name\":\"main\"}},\n", node_id, TRACE_TRACK_MAIN);
+  fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+          "\"args\":{\"name\":\"tsch\"}}", node_id, TRACE_TRACK_TSCH);
+
+  while(trace_read(&ev)) {
+    if(ev.point >= TRACE_POINT_COUNT) {
+      continue;
+    }
+    tp = &trace_points[ev.point];
+
+    /* Unwrap the timestamps, which are in order */
+    if(first) {
+      first = 0;
+    } else {
+      ts += (trace_time_t)(ev.time - last);
+    }
+    last = ev.time;
+
+    fprintf(f, ",\n{\"name\":");
+    write_string(f, tp->name);
+    fprintf(f, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%lu.%03lu,"
+            "\"pid\":%u,\"tid\":%u",
+            tp->category, ev.phase,
+            (unsigned long)(ts * 1000000 / TRACE_SECOND),
+            (unsigned long)((ts * 1000000 % TRACE_SECOND) * 1000 / TRACE_SECOND),
+            node_id, tp->track);
+    if(ev.id != 0) {
+      fprintf(f, ",\"id\":%u", ev.id);
+    }
+    if(ev.phase == TRACE_PHASE_INSTANT) {
+      fprintf(f, ",\"s\":\"t\"");
+    }
+
+    arg = ev.phase == TRACE_PHASE_END || ev.phase == TRACE_PHASE_ASYNC_END ?
+      tp->end_arg : tp->arg;
+    if(arg != NULL) {
+      fprintf(f, ",\"args\":{\"%s\":", arg);
+      if(ev.point == TRACE_PROCESS && ev.phase == TRACE_PHASE_BEGIN) {
+        write_string(f, PROCESS_NAME_STRING((struct process *)ev.arg));
+      } else {
+        fprintf(f, "%lu", (unsigned long)ev.arg);
+      }
+      fprintf(f, "}");
+    }
+    fprintf(f, "}");
+  }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":"
+          "{\"overwritten\":%lu}}\n", overwritten);
+  fclose(f);
+}
+#endif /* CONTIKI_TARGET_NATIVE */
+/*---------------------------------------------------------------------------*/
+void
+trace_init(void)
+{
+  events_head = 0;
+  events_count = 0;
+#ifdef CONTIKI_TARGET_NATIVE
+  atexit(write_json);
+#endif /* CONTIKI_TARGET_NATIVE */
+}
+/*---------------------------------------------------------------------------*/
+#endif /* TRACE_ENABLED */
+
+/** @} */
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \addtogroup sys
+ * @{ */
+
+/**
+ * \defgroup trace Trace points
+ * @{
+ *
+ * Lightweight trace points that record timestamped events in a ring
+ * buffer, to follow packets across the layers of the stack.
+ *
+ * The trace points are listed in a static registry, TRACE_POINTS. Each
+ * one is either a span (TRACE_BEGIN/TRACE_END, properly nested on its
+ * track), an instant event (TRACE_INSTANT), or part of an asynchronous
+ * span identified by an id (TRACE_ASYNC_BEGIN/STEP/END). Every frame that
+ * 6LoWPAN hands to the MAC layer gets such an id, stored in the
+ * PACKETBUF_ATTR_TRACE_ID attribute, so that its queueing and
+ * transmission can be followed until the MAC layer is done with it.
+ *
+ * On native, the buffer is written as Chrome trace-event JSON when the
+ * program exits, to the file named by the CONTIKI_NG_TRACE environment
+ * variable, or TRACE_NATIVE_FILE. The file can be opened in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing. Other platforms can read the
+ * events with trace_read().
+ *
+ * With TRACE_CONF_ENABLED unset, all the trace macros expand to nothing
+ * and their arguments are not evaluated.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "contiki.h"
+#include "sys/rtimer.h"
+
+#include <stdint.h>
+
+#ifdef TRACE_CONF_ENABLED
+#define TRACE_ENABLED TRACE_CONF_ENABLED
+#else /* TRACE_CONF_ENABLED */
+#define TRACE_ENABLED 0
+#endif /* TRACE_CONF_ENABLED */
+
+/* Number of events in the ring buffer. When full, the oldest events
+ * are overwritten */
+#ifdef TRACE_CONF_BUF_SIZE
+#define TRACE_BUF_SIZE TRACE_CONF_BUF_SIZE
+#else /* TRACE_CONF_BUF_SIZE */
+#define TRACE_BUF_SIZE 256
+#endif /* TRACE_CONF_BUF_SIZE */
+
+/* File the events are written to at exit on native */
+#ifdef TRACE_CONF_NATIVE_FILE
+#define TRACE_NATIVE_FILE TRACE_CONF_NATIVE_FILE
+#else /* TRACE_CONF_NATIVE_FILE */
+#define TRACE_NATIVE_FILE "trace.json"
+#endif /* TRACE_CONF_NATIVE_FILE */
+
+/* Timestamps are taken from the rtimer. The native rtimer only ticks
+ * every millisecond, so native uses the microsecond monotonic clock */
+#ifdef TRACE_CONF_NOW
+#define TRACE_NOW() TRACE_CONF_NOW()
+#define TRACE_SECOND TRACE_CONF_SECOND
+typedef uint32_t trace_time_t;
+#elif defined(CONTIKI_TARGET_NATIVE)
+#define TRACE_NOW() trace_native_now()
+#define TRACE_SECOND 1000000UL
+typedef uint32_t trace_time_t;
+trace_time_t trace_native_now(void);
+#else
+#define TRACE_NOW() RTIMER_NOW()
+#define TRACE_SECOND RTIMER_SECOND
+typedef rtimer_clock_t trace_time_t;
+#endif
+
+/* Tracks (threads in the trace viewer). Spans must be properly nested
+ * within a track */
+#define TRACE_TRACK_MAIN 1 /* Processes and the code they call */
+#define TRACE_TRACK_TSCH 2 /* TSCH slot operation, in rtimer interrupt */
+
+/*
+ * The registry of trace points. Each entry gives the identifier, the
+ * category, the name shown in the trace viewer, the track, and the names
+ * of the arguments of the begin (or instant) and end events. The events
+ * of an asynchronous span share the category of the span.
+ * Applications add their own points with TRACE_CONF_APP_POINTS(X), in
+ * the same format.
+ */
+#define TRACE_POINTS(X) \
+  X(PROCESS,           "sched",   "process",           TRACE_TRACK_MAIN, "process", "event") \
+  X(TCPIP_INPUT,       "tcpip",   "tcpip_input",       TRACE_TRACK_MAIN, "len",     NULL) \
+  X(TCPIP_OUTPUT,      "tcpip",   "tcpip_output",      TRACE_TRACK_MAIN, "packet",  "status") \
+  X(SICSLOWPAN_INPUT,  "6lowpan", "sicslowpan_input",  TRACE_TRACK_MAIN, "len",     NULL) \
+  X(SICSLOWPAN_OUTPUT, "6lowpan", "sicslowpan_output", TRACE_TRACK_MAIN, "len",     "status") \
+  X(FRAME,             "frame",   "frame",             TRACE_TRACK_MAIN, "packet",  "status") \
+  X(CSMA_QUEUED,       "frame",   "csma_queued",       TRACE_TRACK_MAIN, "queue",   NULL) \
+  X(CSMA_TX,           "mac",     "csma_tx",           TRACE_TRACK_MAIN, "frame",   "status") \
+  X(TSCH_TX_SLOT,      "tsch",    "tsch_tx_slot",      TRACE_TRACK_TSCH, "frame",   "status") \
+  X(TSCH_RX_SLOT,      "tsch",    "tsch_rx_slot",      TRACE_TRACK_TSCH, "channel", NULL) \
+  TRACE_APP_POINTS(X)
+
+#ifdef TRACE_CONF_APP_POINTS
+#define TRACE_APP_POINTS(X) TRACE_CONF_APP_POINTS(X)
+#else /* TRACE_CONF_APP_POINTS */
+#define TRACE_APP_POINTS(X)
+#endif /* TRACE_CONF_APP_POINTS */
+
+#define TRACE_POINT_ID(id, cat, name, track, arg, end_arg) TRACE_##id,
+enum {
+  TRACE_POINTS(TRACE_POINT_ID)
+  TRACE_POINT_COUNT
+};
+
+/* Event phases, as in the Chrome trace-event format */
+#define TRACE_PHASE_BEGIN       'B'
+#define TRACE_PHASE_END         'E'
+#define TRACE_PHASE_INSTANT     'i'
+#define TRACE_PHASE_ASYNC_BEGIN 'b'
+#define TRACE_PHASE_ASYNC_STEP  'n'
+#define TRACE_PHASE_ASYNC_END   'e'
+
+struct trace_point {
+  const char *category;
+  const char *name;
+  const char *arg;
+  const char *end_arg;
+  uint8_t track;
+};
+
+struct trace_event {
+  trace_time_t time;
+  uintptr_t arg;
+  uint16_t id;      /* Id of the asynchronous span, 0 for the others */
+  uint8_t point;
+  char phase;
+};
+
+extern const struct trace_point trace_points[];
+
+#if TRACE_ENABLED
+
+#define TRACE_BEGIN(point, arg) \
+  trace_event(TRACE_##point, TRACE_PHASE_BEGIN, 0, (uintptr_t)(arg))
+#define TRACE_END(point, arg) \
+  trace_event(TRACE_##point, TRACE_PHASE_END, 0, (uintptr_t)(arg))
+#define TRACE_INSTANT(point, arg) \
+  trace_event(TRACE_##point, TRACE_PHASE_INSTANT, 0, (uintptr_t)(arg))
+#define TRACE_ASYNC_BEGIN(point, id, arg) \
+  trace_event(TRACE_##point, TRACE_PHASE_ASYNC_BEGIN, id, (uintptr_t)(arg))
+#define TRACE_ASYNC_STEP(point, id, arg) \
+  trace_event(TRACE_##point, TRACE_PHASE_ASYNC_STEP, id, (uintptr_t)(arg))
+#define TRACE_ASYNC_END(point, id, arg) \
+  trace_event(TRACE_##point, TRACE_PHASE_ASYNC_END, id, (uintptr_t)(arg))
+
+/* Starts a new IP packet, and returns its id */
+#define TRACE_PACKET_NEW() trace_packet_new()
+/* Starts the asynchronous span of the frame in packetbuf */
+#define TRACE_FRAME_BEGIN() trace_frame_begin()
+
+/**
+ * Records an event. Safe to call from interrupt context. Asynchronous
+ * events with a zero id are ignored.
+ * \param point The trace point, TRACE_<id>
+ * \param phase The phase of the event, TRACE_PHASE_*
+ * \param id The id of the asynchronous span, 0 for other events
+ * \param arg The argument of the event
+ */
+void trace_event(uint8_t point, char phase, uint16_t id, uintptr_t arg);
+
+/**
+ * Allocates the id of a new IP packet, which becomes the current packet
+ * \return The id
+ */
+uint16_t trace_packet_new(void);
+
+/**
+ * Allocates an id for the frame in packetbuf, stores it in
+ * PACKETBUF_ATTR_TRACE_ID and records the beginning of its asynchronous
+ * span, with the current IP packet as argument
+ */
+void trace_frame_begin(void);
+
+#else /* TRACE_ENABLED */
+
+#define TRACE_BEGIN(point, arg)
+#define TRACE_END(point, arg)
+#define TRACE_INSTANT(point, arg)
+#define TRACE_ASYNC_BEGIN(point, id, arg)
+#define TRACE_ASYNC_STEP(point, id, arg)
+#define TRACE_ASYNC_END(point, id, arg)
+#define TRACE_PACKET_NEW() 0
+#define TRACE_FRAME_BEGIN()
+
+#endif /* TRACE_ENABLED */
+
+/**
+ * Initializes the trace buffer. On native, also registers the JSON dump
+ * at exit
+ */
+void trace_init(void);
+
+/**
+ * Removes the oldest event from the buffer
+ * \param ev Where to copy the event
+ * \return 1 if an event was copied, 0 if the buffer is empty
+ */
+int trace_read(struct trace_event *ev);
+
+/**
+ * Returns the number of events overwritten since boot because the buffer
+ * was full
+ */
+unsigned long trace_overwritten(void);
+
+#endif /* TRACE_H_ */
+
+/** @} */
+/** @} */
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Checks that the multicast duplicate cache drops the repetitions
+ *         of a datagram within its lifetime only: identical datagrams
+ *         spaced further apart, and distinct datagrams, all get through
+ */
+
+#include "contiki.h"
+#include "net/ipv6/uip.h"
+#include "net/ipv6/multicast/uip-mcast6-dup.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(test_process, "Multicast duplicate cache test");
+AUTOSTART_PROCESSES(&test_process);
+/*---------------------------------------------------------------------------*/
+#define DISTINCT_DATAGRAMS 64
+#define PAYLOAD_LEN 8
+/*---------------------------------------------------------------------------*/
+/* Builds a UDP datagram from fd00::<src> to ff03::fc in uip_buf, with a
+ * payload made of the given counter */
+static void
+datagram(uint8_t src, uint16_t counter)
+{
+  uint8_t *payload;
+
+  memset(uip_buf, 0, UIP_IPH_LEN + PAYLOAD_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = 64;
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfd00, 0, 0, 0, 0, 0, 0, src);
+  uip_ip6addr(&UIP_IP_BUF->destipaddr, 0xff03, 0, 0, 0, 0, 0, 0, 0xfc);
+  uipbuf_set_len_field(UIP_IP_BUF, PAYLOAD_LEN);
+
+  payload = UIP_IP_PAYLOAD(0);
+  payload[0] = counter >> 8;
+  payload[1] = counter & 0xff;
+
+  uip_len = UIP_IPH_LEN + PAYLOAD_LEN;
+  uip_ext_len = 0;
+  uip_last_proto = UIP_PROTO_UDP;
+}
+/*---------------------------------------------------------------------------*/
+/* Lets the fingerprints in the cache expire */
+static void
+wait_lifetime(void)
+{
+  clock_time_t start = clock_time();
+
+  while(clock_time() - start <= UIP_MCAST6_DUP_LIFETIME);
+}
+/*---------------------------------------------------------------------------*/
+void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_repeated, "Identical datagrams");
+UNIT_TEST(test_repeated)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  uip_mcast6_dup_init();
+
+  /* Repeated within the lifetime: dropped */
+  datagram(1, 0);
+  UNIT_TEST_ASSERT(uip_mcast6_dup_check() == 0);
+  datagram(1, 0);
+  UNIT_TEST_ASSERT(uip_mcast6_dup_check() == 1);
+
+  /* Repeated further apart than the lifetime: delivered every time */
+  for(i = 0; i < 3; i++) {
+    wait_lifetime();
+    datagram(1, 0);
+    UNIT_TEST_ASSERT(uip_mcast6_dup_check() == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_distinct, "Distinct datagrams");
+UNIT_TEST(test_distinct)
+{
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  uip_mcast6_dup_init();
+
+  /* More than the cache holds, with the same source and payloads that
+   * differ in less than 16 bits, which no CRC-16 collision can merge */
+  for(i = 0; i < DISTINCT_DATAGRAMS; i++) {
+    datagram(1, i);
+    UNIT_TEST_ASSERT(uip_mcast6_dup_check() == 0);
+  }
+
+  /* The same payload from other sources */
+  for(i = 2; i < 2 + UIP_MCAST6_DUP_ENTRIES; i++) {
+    datagram(i, 0);
+    UNIT_TEST_ASSERT(uip_mcast6_dup_check() == 0);
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_repeated);
+  UNIT_TEST_RUN(test_distinct);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
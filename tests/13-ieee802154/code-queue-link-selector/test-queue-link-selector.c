@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Packets the link selector bound to a shared slotframe, to a
+ *         neighbor we also have dedicated Tx links to, as with the extra
+ *         cells of the adaptive Orchestra rule
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "net/linkaddr.h"
+#include "net/mac/tsch/tsch.h"
+
+#include "unit-test/unit-test.h"
+#include "common.h"
+
+PROCESS(test_process, "TSCH queue link selector test");
+AUTOSTART_PROCESSES(&test_process);
+
+static linkaddr_t test_nbr_addr = {{ 0x01 }};
+#define TEST_PEER_ADDR &test_nbr_addr
+
+#define SHARED_SF_HANDLE   1
+#define SHARED_TIMESLOT    3
+#define EXTRA_SF_HANDLE    2
+#define EXTRA_TIMESLOT     5
+#define NUM_SHARED_PACKETS 3
+#define NUM_EXTRA_PACKETS  2
+
+static struct tsch_packet *
+add_packet(uint16_t slotframe, uint16_t timeslot)
+{
+  packetbuf_clear();
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, TEST_PEER_ADDR);
+  packetbuf_set_attr(PACKETBUF_ATTR_TSCH_SLOTFRAME, slotframe);
+  packetbuf_set_attr(PACKETBUF_ATTR_TSCH_TIMESLOT, timeslot);
+  packetbuf_set_attr(PACKETBUF_ATTR_TSCH_CHANNEL_OFFSET, 0xffff);
+  return tsch_queue_add_packet(TEST_PEER_ADDR, 1, NULL, NULL);
+}
+
+static void
+send_packet(struct tsch_neighbor *nbr, struct tsch_packet *packet,
+            struct tsch_link *link)
+{
+  tsch_queue_packet_sent(nbr, packet, link, MAC_TX_OK);
+  tsch_queue_free_packet(packet);
+}
+
+UNIT_TEST_REGISTER(test_bound_packets,
+                   "dedicated links to a neighbor do not block its bound packets");
+UNIT_TEST(test_bound_packets)
+{
+  struct tsch_slotframe *sf;
+  struct tsch_link *shared_link;
+  struct tsch_link *extra_link;
+  struct tsch_neighbor *nbr;
+  struct tsch_neighbor *any_nbr;
+  struct tsch_packet *packet;
+  int num_sent;
+  int i;
+
+  UNIT_TEST_BEGIN();
+
+  sf = tsch_schedule_add_slotframe(SHARED_SF_HANDLE, 7);
+  UNIT_TEST_ASSERT(sf != NULL);
+  shared_link = tsch_schedule_add_link(sf, LINK_OPTION_TX | LINK_OPTION_SHARED,
+                                       LINK_TYPE_NORMAL, &tsch_broadcast_address,
+                                       SHARED_TIMESLOT, 1, 1);
+  UNIT_TEST_ASSERT(shared_link != NULL);
+
+  sf = tsch_schedule_add_slotframe(EXTRA_SF_HANDLE, 11);
+  UNIT_TEST_ASSERT(sf != NULL);
+  extra_link = tsch_schedule_add_link(sf, LINK_OPTION_TX, LINK_TYPE_NORMAL,
+                                      TEST_PEER_ADDR, EXTRA_TIMESLOT, 2, 0);
+  UNIT_TEST_ASSERT(extra_link != NULL);
+
+  nbr = tsch_queue_get_nbr(TEST_PEER_ADDR);
+  UNIT_TEST_ASSERT(nbr != NULL);
+  UNIT_TEST_ASSERT(nbr->tx_links_count == 1);
+
+  /* Packets queued before the extra link, then packets bound to it */
+  for(i = 0; i < NUM_SHARED_PACKETS; i++) {
+    UNIT_TEST_ASSERT(add_packet(SHARED_SF_HANDLE, SHARED_TIMESLOT) != NULL);
+  }
+  for(i = 0; i < NUM_EXTRA_PACKETS; i++) {
+    UNIT_TEST_ASSERT(add_packet(EXTRA_SF_HANDLE, 0xffff) != NULL);
+  }
+
+  /* The head packet can go on both links */
+  packet = tsch_queue_get_unicast_packet_for_any(&any_nbr, shared_link);
+  UNIT_TEST_ASSERT(packet != NULL);
+  UNIT_TEST_ASSERT(any_nbr == nbr);
+  UNIT_TEST_ASSERT(tsch_queue_get_packet_for_nbr(nbr, extra_link) == packet);
+
+  /* Alternate between the two links, as their slots come: the shared link
+   * only takes the packets bound to it, the extra link takes any */
+  num_sent = 0;
+  for(i = 0; i < 2 * (NUM_SHARED_PACKETS + NUM_EXTRA_PACKETS)
+        && !tsch_queue_is_empty(nbr); i++) {
+    if(i % 2 == 0) {
+      packet = tsch_queue_get_unicast_packet_for_any(&any_nbr, shared_link);
+      if(packet == NULL) {
+        continue;
+      }
+      UNIT_TEST_ASSERT(queuebuf_attr(packet->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME)
+                       == SHARED_SF_HANDLE);
+      send_packet(nbr, packet, shared_link);
+    } else {
+      packet = tsch_queue_get_packet_for_nbr(nbr, extra_link);
+      UNIT_TEST_ASSERT(packet != NULL);
+      send_packet(nbr, packet, extra_link);
+    }
+    num_sent++;
+  }
+  UNIT_TEST_ASSERT(num_sent == NUM_SHARED_PACKETS + NUM_EXTRA_PACKETS);
+  UNIT_TEST_ASSERT(tsch_queue_is_empty(nbr));
+
+  UNIT_TEST_END();
+}
+
+PROCESS_THREAD(test_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+
+  tsch_set_coordinator(1);
+
+  etimer_set(&et, CLOCK_SECOND);
+  while(tsch_is_associated == 0) {
+    PROCESS_YIELD_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+  }
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_bound_packets);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}
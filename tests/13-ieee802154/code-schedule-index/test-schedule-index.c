@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Checks that the link index of the TSCH schedule selects the same
+ *         next active link, backup link and time offset as the linear scan
+ *         of every link it replaced
+ */
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "net/mac/tsch/tsch.h"
+#include "services/unit-test/unit-test.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+PROCESS(test_process, "TSCH schedule index test");
+AUTOSTART_PROCESSES(&test_process);
+/*---------------------------------------------------------------------------*/
+#define NBR_COUNT 4
+#define RANDOM_SCHEDULES 200
+#define ASNS_PER_SCHEDULE 200
+/*---------------------------------------------------------------------------*/
+/* Stubs for the parts of TSCH the schedule depends on */
+struct tsch_link *current_link;
+const linkaddr_t tsch_broadcast_address = { { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+const linkaddr_t tsch_eb_address = { { 0, 0, 0, 0, 0, 0, 0, 0 } };
+
+static struct tsch_neighbor nbrs[NBR_COUNT];
+static int nbr_packet_count[NBR_COUNT];
+
+int
+tsch_get_lock(void)
+{
+  return 1;
+}
+void
+tsch_release_lock(void)
+{
+}
+int
+tsch_is_locked(void)
+{
+  return 0;
+}
+struct tsch_neighbor *
+tsch_queue_get_nbr(const linkaddr_t *addr)
+{
+  if(addr->u8[0] == 0 && addr->u8[LINKADDR_SIZE - 1] < NBR_COUNT) {
+    return &nbrs[addr->u8[LINKADDR_SIZE - 1]];
+  }
+  return NULL;
+}
+struct tsch_neighbor *
+tsch_queue_add_nbr(const linkaddr_t *addr)
+{
+  return tsch_queue_get_nbr(addr);
+}
+int
+tsch_queue_nbr_packet_count(const struct tsch_neighbor *n)
+{
+  return nbr_packet_count[n - nbrs];
+}
+/*---------------------------------------------------------------------------*/
+/* The default link comparator and the linear scan over every link of every
+ * slotframe, as they were before the link index */
+static struct tsch_link *
+ref_link_comparator(struct tsch_link *a, struct tsch_link *b)
+{
+  if(!(a->link_options & LINK_OPTION_TX)) {
+    return a;
+  }
+  if(!linkaddr_cmp(&a->addr, &b->addr)) {
+    struct tsch_neighbor *an = tsch_queue_get_nbr(&a->addr);
+    struct tsch_neighbor *bn = tsch_queue_get_nbr(&b->addr);
+    int a_packet_count = an ? tsch_queue_nbr_packet_count(an) : 0;
+    int b_packet_count = bn ? tsch_queue_nbr_packet_count(bn) : 0;
+    return a_packet_count >= b_packet_count ? a : b;
+  }
+  return a;
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+ref_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset,
+                         struct tsch_link **backup_link)
+{
+  uint16_t time_to_curr_best = 0;
+  struct tsch_link *curr_best = NULL;
+  struct tsch_link *curr_backup = NULL;
+  struct tsch_slotframe *sf = tsch_schedule_slotframe_head();
+
+  while(sf != NULL) {
+    uint16_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
+    struct tsch_link *l = list_head(sf->links_list);
+    while(l != NULL) {
+      uint16_t time_to_timeslot =
+        l->timeslot > timeslot ?
+        l->timeslot - timeslot :
+        sf->size.val + l->timeslot - timeslot;
+      if(curr_best == NULL || time_to_timeslot < time_to_curr_best) {
+        time_to_curr_best = time_to_timeslot;
+        curr_best = l;
+        curr_backup = NULL;
+      } else if(time_to_timeslot == time_to_curr_best) {
+        struct tsch_link *new_best = NULL;
+        if((curr_best->link_options & LINK_OPTION_TX) == (l->link_options & LINK_OPTION_TX)) {
+          if(l->slotframe_handle != curr_best->slotframe_handle) {
+            if(l->slotframe_handle < curr_best->slotframe_handle) {
+              new_best = l;
+            }
+          } else {
+            new_best = ref_link_comparator(curr_best, l);
+          }
+        } else {
+          if(l->link_options & LINK_OPTION_TX) {
+            new_best = l;
+          }
+        }
+        if(curr_backup == NULL) {
+          if(new_best != l && (l->link_options & LINK_OPTION_RX)) {
+            curr_backup = l;
+          }
+          if(new_best != curr_best && (curr_best->link_options & LINK_OPTION_RX)) {
+            curr_backup = curr_best;
+          }
+        }
+        if(new_best != NULL) {
+          curr_best = new_best;
+        }
+      }
+      l = list_item_next(l);
+    }
+    sf = tsch_schedule_slotframe_next(sf);
+  }
+  *time_offset = time_to_curr_best;
+  *backup_link = curr_backup;
+  return curr_best;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the schedule and the reference agree at this ASN */
+static int
+same_next_active_link(uint32_t ls4b, uint8_t ms1b)
+{
+  struct tsch_asn_t asn;
+  struct tsch_link *link, *backup, *ref_link, *ref_backup;
+  uint16_t time_offset, ref_time_offset;
+
+  asn.ls4b = ls4b;
+  asn.ms1b = ms1b;
+  link = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  ref_link = ref_get_next_active_link(&asn, &ref_time_offset, &ref_backup);
+
+  if(link != ref_link || backup != ref_backup
+     || (link != NULL && time_offset != ref_time_offset)) {
+    printf("asn %02x.%08lx: link %d backup %d offset %u, expected %d %d %u\n",
+           ms1b, (unsigned long)ls4b,
+           link ? link->handle : -1, backup ? backup->handle : -1, time_offset,
+           ref_link ? ref_link->handle : -1, ref_backup ? ref_backup->handle : -1,
+           ref_time_offset);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+nbr_addr(linkaddr_t *addr, int i)
+{
+  linkaddr_copy(addr, &linkaddr_null);
+  addr->u8[LINKADDR_SIZE - 1] = i;
+}
+/*---------------------------------------------------------------------------*/
+void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_tx_first, "Tx link first");
+UNIT_TEST(test_tx_first)
+{
+  struct tsch_slotframe *sf0, *sf1;
+  struct tsch_link *rx, *tx, *link, *backup;
+  struct tsch_asn_t asn = { 10, 0 };
+  uint16_t time_offset;
+  linkaddr_t addr;
+
+  UNIT_TEST_BEGIN();
+
+  tsch_schedule_remove_all_slotframes();
+  nbr_addr(&addr, 1);
+  /* Both links are 2 slots after ASN 10; the Rx link has the lowest handle */
+  sf0 = tsch_schedule_add_slotframe(0, 4);
+  sf1 = tsch_schedule_add_slotframe(1, 6);
+  rx = tsch_schedule_add_link(sf0, LINK_OPTION_RX, LINK_TYPE_NORMAL,
+                              &tsch_broadcast_address, 0, 0, 0);
+  tx = tsch_schedule_add_link(sf1, LINK_OPTION_TX, LINK_TYPE_NORMAL,
+                              &addr, 0, 0, 0);
+  link = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  UNIT_TEST_ASSERT(link == tx);
+  UNIT_TEST_ASSERT(backup == rx);
+  UNIT_TEST_ASSERT(time_offset == 2);
+  UNIT_TEST_ASSERT(same_next_active_link(asn.ls4b, asn.ms1b));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_lowest_handle, "Lowest slotframe handle");
+UNIT_TEST(test_lowest_handle)
+{
+  struct tsch_slotframe *sf3, *sf1;
+  struct tsch_link *l3, *l1, *link, *backup;
+  struct tsch_asn_t asn = { 12, 0 };
+  uint16_t time_offset;
+
+  UNIT_TEST_BEGIN();
+
+  tsch_schedule_remove_all_slotframes();
+  /* Added with the highest handle first, both at ASN 14 */
+  sf3 = tsch_schedule_add_slotframe(3, 7);
+  sf1 = tsch_schedule_add_slotframe(1, 5);
+  l3 = tsch_schedule_add_link(sf3, LINK_OPTION_RX, LINK_TYPE_NORMAL,
+                              &tsch_broadcast_address, 0, 0, 0);
+  l1 = tsch_schedule_add_link(sf1, LINK_OPTION_RX, LINK_TYPE_NORMAL,
+                              &tsch_broadcast_address, 4, 0, 0);
+  link = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  UNIT_TEST_ASSERT(link == l1);
+  UNIT_TEST_ASSERT(backup == l3);
+  UNIT_TEST_ASSERT(time_offset == 2);
+  UNIT_TEST_ASSERT(same_next_active_link(asn.ls4b, asn.ms1b));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_comparator, "Link comparator in a timeslot");
+UNIT_TEST(test_comparator)
+{
+  struct tsch_slotframe *sf;
+  struct tsch_link *l1, *l2, *l3, *link, *backup;
+  struct tsch_asn_t asn = { 0, 0 };
+  uint16_t time_offset;
+  linkaddr_t addr;
+
+  UNIT_TEST_BEGIN();
+
+  tsch_schedule_remove_all_slotframes();
+  sf = tsch_schedule_add_slotframe(0, 8);
+  /* Three Tx links in timeslot 3, on different channel offsets */
+  nbr_addr(&addr, 1);
+  l1 = tsch_schedule_add_link(sf, LINK_OPTION_TX | LINK_OPTION_RX | LINK_OPTION_SHARED,
+                              LINK_TYPE_NORMAL, &addr, 3, 0, 0);
+  nbr_addr(&addr, 2);
+  l2 = tsch_schedule_add_link(sf, LINK_OPTION_TX, LINK_TYPE_NORMAL, &addr, 3, 1, 0);
+  nbr_addr(&addr, 3);
+  l3 = tsch_schedule_add_link(sf, LINK_OPTION_TX, LINK_TYPE_NORMAL, &addr, 3, 2, 0);
+
+  /* The neighbor with the most packets, the earliest link on a tie */
+  nbr_packet_count[1] = 1;
+  nbr_packet_count[2] = 3;
+  nbr_packet_count[3] = 3;
+  link = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  UNIT_TEST_ASSERT(link == l2);
+  UNIT_TEST_ASSERT(backup == l1);
+  UNIT_TEST_ASSERT(time_offset == 3);
+  UNIT_TEST_ASSERT(same_next_active_link(asn.ls4b, asn.ms1b));
+
+  nbr_packet_count[3] = 4;
+  link = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  UNIT_TEST_ASSERT(link == l3);
+  UNIT_TEST_ASSERT(same_next_active_link(asn.ls4b, asn.ms1b));
+
+  /* Removing the selected link falls back to the next one */
+  tsch_schedule_remove_link(sf, l3);
+  link = tsch_schedule_get_next_active_link(&asn, &time_offset, &backup);
+  UNIT_TEST_ASSERT(link == l2);
+  UNIT_TEST_ASSERT(same_next_active_link(asn.ls4b, asn.ms1b));
+
+  memset(nbr_packet_count, 0, sizeof(nbr_packet_count));
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+static const uint8_t link_options[] = {
+  LINK_OPTION_TX,
+  LINK_OPTION_RX,
+  LINK_OPTION_TX | LINK_OPTION_SHARED,
+  LINK_OPTION_TX | LINK_OPTION_RX | LINK_OPTION_SHARED,
+  LINK_OPTION_TX | LINK_OPTION_RX,
+};
+
+/* Fills the schedule with random slotframes, with several links per
+ * timeslot, then removes some of the links */
+static void
+random_schedule(void)
+{
+  int sf_count = 1 + random_rand() % TSCH_SCHEDULE_MAX_SLOTFRAMES;
+  int link_count = random_rand() % (TSCH_SCHEDULE_MAX_LINKS + 1);
+  struct tsch_slotframe *sf;
+  struct tsch_link *l;
+  linkaddr_t addr;
+  int i;
+
+  tsch_schedule_remove_all_slotframes();
+  for(i = 0; i < sf_count; i++) {
+    /* Small slotframes to have many links per timeslot */
+    tsch_schedule_add_slotframe(random_rand() % 8, 1 + random_rand() % 13);
+  }
+  for(i = 0; i < NBR_COUNT; i++) {
+    nbr_packet_count[i] = random_rand() % 3;
+  }
+
+  for(i = 0; i < link_count; i++) {
+    int n = random_rand() % sf_count;
+    for(sf = tsch_schedule_slotframe_head(); n > 0 && sf != NULL; n--) {
+      sf = tsch_schedule_slotframe_next(sf);
+    }
+    if(sf == NULL) {
+      /* A duplicate handle, the slotframe was not added */
+      sf = tsch_schedule_slotframe_head();
+    }
+    nbr_addr(&addr, random_rand() % NBR_COUNT);
+    tsch_schedule_add_link(sf, link_options[random_rand() % sizeof(link_options)],
+                           LINK_TYPE_NORMAL, &addr,
+                           random_rand() % sf->size.val, random_rand() % 4, 0);
+  }
+
+  for(sf = tsch_schedule_slotframe_head(); sf != NULL;
+      sf = tsch_schedule_slotframe_next(sf)) {
+    l = list_head(sf->links_list);
+    while(l != NULL) {
+      struct tsch_link *next = list_item_next(l);
+      if(random_rand() % 4 == 0) {
+        tsch_schedule_remove_link(sf, l);
+      }
+      l = next;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_random, "Random schedules");
+UNIT_TEST(test_random)
+{
+  int i, j;
+
+  UNIT_TEST_BEGIN();
+
+  random_init(0x5ced);
+  for(i = 0; i < RANDOM_SCHEDULES; i++) {
+    random_schedule();
+    for(j = 0; j < ASNS_PER_SCHEDULE; j++) {
+      uint32_t ls4b = ((uint32_t)random_rand() << 16) | random_rand();
+      UNIT_TEST_ASSERT(same_next_active_link(ls4b, random_rand() % 2));
+      /* And a few consecutive slots */
+      UNIT_TEST_ASSERT(same_next_active_link(j, 0));
+    }
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  tsch_schedule_init();
+
+  UNIT_TEST_RUN(test_tx_first);
+  UNIT_TEST_RUN(test_lowest_handle);
+  UNIT_TEST_RUN(test_comparator);
+  UNIT_TEST_RUN(test_random);
+
+  printf("=check-me= DONE\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+"""Decoder for the records of the deferred logging backend (os/sys/log-deferred).
+
+Build the firmware with LOG_CONF_DEFERRED=1 and LOG_DEFERRED_CONF_BINARY=1,
+and the node dumps its log records as "LOGB:<hex>" lines instead of
+formatting them. This script turns them back into the usual log output,
+using the firmware ELF file to resolve the format strings and module names.
+Other lines are passed through.
+
+usage: log-decode.py [-t] [-c clock-second] firmware.elf [log-file]
+"""
+
+import argparse
+import ipaddress
+import re
+import struct
+import sys
+
+# Record header
+REC_HDR_LEN = 8
+FLAG_LEVEL = 0x07
+FLAG_PREFIX = 0x08
+FLAG_LOC = 0x10
+FLAG_TRUNCATED = 0x20
+STR_NULL = 0xff
+
+# Record types
+MSG, ADDR6, ADDR6_COMPACT, LLADDR, LLADDR_COMPACT, BYTES = range(6)
+
+LEVEL_STR = ["PRI", "ERR", "WARN", "INFO", "DBG"]
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?"
+                        r"(hh|h|ll|l|z|j|t|L)?([diuxXocpsfFeEgGaA%])")
+
+
+class Elf:
+    """Just enough of an ELF reader to get strings out of the image"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        if self.is64:
+            shoff, = self.unpack("Q", 0x28)
+            shentsize, shnum = self.unpack("HH", 0x3a)
+        else:
+            shoff, = self.unpack("I", 0x20)
+            shentsize, shnum = self.unpack("HH", 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+            if self.is64:
+                (name, stype, flags, addr, offset, size, link,
+                 info, align, entsize) = self.unpack("IIQQQQIIQQ", off)
+            else:
+                (name, stype, flags, addr, offset, size, link,
+                 info, align, entsize) = self.unpack("IIIIIIIIII", off)
+            self.sections.append((stype, flags, addr, offset, size,
+                                  link, entsize))
+        self.base = self.symbol("log_deferred_base")
+
+    def unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def symbol(self, wanted):
+        for stype, _, _, offset, size, link, entsize in self.sections:
+            if stype != 2:  # SHT_SYMTAB
+                continue
+            strtab = self.sections[link][3]
+            for off in range(offset, offset + size, entsize):
+                if self.is64:
+                    name, _, _, _, value, _ = self.unpack("IBBHQQ", off)
+                else:
+                    name, value, _, _, _, _ = self.unpack("IIIBBH", off)
+                end = self.data.index(b"\0", strtab + name)
+                if self.data[strtab + name:end].decode() == wanted:
+                    return value
+        raise ValueError("symbol %s not found, is LOG_CONF_DEFERRED set?"
+                         % wanted)
+
+    def string(self, offset):
+        addr = self.base + offset
+        for stype, flags, start, file_off, size, _, _ in self.sections:
+            # Allocated sections with contents (not SHT_NOBITS)
+            if flags & 2 and stype != 8 and start <= addr < start + size:
+                pos = file_off + addr - start
+                end = self.data.index(b"\0", pos)
+                return self.data[pos:end].decode(errors="replace")
+        return "<unknown string %+d>" % offset
+
+
+class Record:
+    def __init__(self, elf, raw):
+        self.elf = elf
+        self.raw = raw
+        self.type = raw[1]
+        self.flags = raw[2]
+        self.time, = struct.unpack_from(elf.endian + "I", raw, 4)
+        self.pos = REC_HDR_LEN
+
+    def get(self, fmt):
+        fmt = self.elf.endian + fmt
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.raw):
+            raise IndexError
+        value = struct.unpack_from(fmt, self.raw, self.pos)
+        self.pos += size
+        return value[0]
+
+    def get_bytes(self, size):
+        if self.pos + size > len(self.raw):
+            raise IndexError
+        value = self.raw[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+
+def convert(record, elf, match):
+    flags, width, precision, modifier, conv = match.groups()
+    if conv == "%":
+        return "%"
+    if width == "*":
+        width = str(record.get("i"))
+    if precision == "*":
+        precision = str(record.get("i"))
+    spec = "%" + flags + (width or "")
+    if precision is not None:
+        spec += "." + precision
+
+    if conv == "s":
+        length = record.get("B")
+        if length == STR_NULL:
+            return (spec + "s") % "(null)"
+        return (spec + "s") % record.get_bytes(length).decode(errors="replace")
+    if conv in "fFeEgGaA":
+        value = record.get("d")
+        if conv in "aA":
+            return value.hex()
+        return (spec + conv) % value
+    if conv == "p":
+        value = record.get("Q")
+        return ("%" + flags + (width or "") + "s") % (
+            "0x%x" % value if value else "(nil)")
+
+    # Integer conversions: find the width of the argument on the node
+    if modifier in (None, "h", "hh") or conv == "c":
+        value = record.get("i")
+        bits = {"h": 16, "hh": 8}.get(modifier, 32)
+    else:
+        value = record.get("q")
+        bits = 64 if modifier in ("ll", "j") or elf.is64 else 32
+    value &= (1 << bits) - 1
+    if conv == "c":
+        return (spec + "c") % chr(value & 0xff)
+    if conv in "di":
+        if value >= 1 << (bits - 1):
+            value -= 1 << bits
+        conv = "d"
+    elif conv == "u":
+        conv = "d"
+    return (spec + conv) % value
+
+
+def decode_message(record, elf):
+    out = ""
+    fmt = elf.string(record.get("i"))
+    if record.flags & FLAG_PREFIX:
+        level = record.flags & FLAG_LEVEL
+        module = elf.string(record.get("i"))
+        out += "[%-4s: %-10s] " % (
+            LEVEL_STR[level] if level < len(LEVEL_STR) else "?", module)
+        if record.flags & FLAG_LOC:
+            out += "[%s: %u] " % (elf.string(record.get("i")), record.get("H"))
+    pos = 0
+    for match in CONVERSION.finditer(fmt):
+        out += fmt[pos:match.start()]
+        pos = match.end()
+        try:
+            out += convert(record, elf, match)
+        except IndexError:
+            return out + "[...]\n"
+    return out + fmt[pos:]
+
+
+def decode_6addr(record):
+    try:
+        addr = record.get_bytes(16)
+    except IndexError:
+        return "6A-NULL"
+    if record.type == ADDR6:
+        return str(ipaddress.IPv6Address(bytes(addr)))
+    if addr[0] == 0xff:
+        prefix = "6M"
+    elif addr[0] == 0xfe and addr[1] & 0xc0 == 0x80:
+        prefix = "6L"
+    else:
+        prefix = "6G"
+    return "%s-%04x" % (prefix, addr[14] << 8 | addr[15])
+
+
+def decode_lladdr(record):
+    addr = record.raw[REC_HDR_LEN:]
+    if record.type == LLADDR:
+        if not addr:
+            return "(NULL LL addr)"
+        return ".".join(addr[i:i + 2].hex() for i in range(0, len(addr), 2))
+    if not any(addr):
+        return "LL-NULL"
+    return "LL-%04x" % (addr[-2] << 8 | addr[-1])
+
+
+def decode(elf, raw, timestamps, clock_second):
+    record = Record(elf, raw)
+    if record.type == MSG:
+        text = decode_message(record, elf)
+    elif record.type in (ADDR6, ADDR6_COMPACT):
+        text = decode_6addr(record)
+    elif record.type in (LLADDR, LLADDR_COMPACT):
+        text = decode_lladdr(record)
+    elif record.type == BYTES:
+        text = raw[REC_HDR_LEN:].hex()
+        if record.flags & FLAG_TRUNCATED:
+            text += ".."
+    else:
+        text = "<unknown record type %u>\n" % record.type
+    if timestamps and record.flags & FLAG_PREFIX:
+        if clock_second:
+            text = "%10.3f %s" % (record.time / clock_second, text)
+        else:
+            text = "%10u %s" % (record.time, text)
+    return text
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode deferred log records (LOGB: lines)")
+    parser.add_argument("-t", "--timestamps", action="store_true",
+                        help="prefix each log line with its timestamp")
+    parser.add_argument("-c", "--clock-second", type=int, default=0,
+                        help="CLOCK_SECOND of the node, to print timestamps"
+                        " in seconds rather than ticks")
+    parser.add_argument("elf", help="firmware the log comes from")
+    parser.add_argument("log", nargs="?", help="log file (default: stdin)")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    log = open(args.log, errors="replace") if args.log else sys.stdin
+    for line in log:
+        idx = line.find("LOGB:")
+        if idx < 0:
+            sys.stdout.write(line)
+            continue
+        try:
+            raw = bytes.fromhex(line[idx + 5:].strip())
+        except ValueError:
+            sys.stdout.write(line)
+            continue
+        # Keep whatever the console prepended to the line, e.g. Cooja's
+        # timestamp and mote ID
+        sys.stdout.write(line[:idx] + decode(elf, raw, args.timestamps,
+                                             args.clock_second))
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Decoder for the binary TSCH per-slot log (os/net/mac/tsch/tsch-log.c).
+
+Build the firmware with TSCH_LOG_CONF_PER_SLOT=1 and TSCH_LOG_CONF_BINARY=1,
+and the node streams its TSCH logs as raw binary records, mixed with the
+regular text output. This script renders them like the text TSCH log.
+Other output is passed through. With TSCH_LOG_CONF_BINARY_HEX=1, the records
+come as "TSCHB:<hex>" lines, which are decoded as well.
+
+usage: tsch-log-decode.py [log-file]
+       e.g. serialdump -b115200 /dev/ttyUSB0 | tsch-log-decode.py
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0xa5
+HEX_TAG = b"TSCHB:"
+
+TYPE_MASK = 0x07
+TX, RX, MESSAGE, NBR = range(4)
+FLAG_UNICAST = 0x08
+FLAG_DATA = 0x10
+FLAG_DRIFT = 0x20
+
+NBR_SELF = 0xfe
+NBR_NONE = 0xff
+
+HDR_LEN = 8
+LINK_LEN = 8
+MIN_LEN = HDR_LEN + 1
+MAX_LEN = HDR_LEN + LINK_LEN + 48 + 1
+
+
+def checksum_ok(raw):
+    return sum(raw[1:-1]) & 0xff == raw[-1]
+
+
+class Decoder:
+    def __init__(self, out):
+        self.out = out
+        self.nbrs = {}
+
+    def lladdr(self, index):
+        if index == NBR_NONE:
+            return "LL-NULL"
+        addr = self.nbrs.get(index)
+        if addr is None:
+            return "LL-#%u" % index
+        return "LL-%04x" % (addr[-2] << 8 | addr[-1])
+
+    def record(self, raw):
+        rtype = raw[2] & TYPE_MASK
+        flags = raw[2]
+        asn_ls4b, asn_ms1b = struct.unpack_from("<IB", raw, 3)
+        body = raw[HDR_LEN:-1]
+
+        if rtype == NBR:
+            index, length = body[0], body[1]
+            self.nbrs[index] = bytes(body[2:2 + length])
+            return
+
+        handle, sf_size, timeslot, burst, choff, channel = struct.unpack_from(
+            "<BHHBBB", body)
+        if handle == 0xff:
+            out = "[INFO: TSCH-LOG  ] {asn %02x.%08x link-NULL} " % (
+                asn_ms1b, asn_ls4b)
+        else:
+            out = ("[INFO: TSCH-LOG  ] {asn %02x.%08x link %2u %3u %3u %2u %2u"
+                   " ch %2u} " % (asn_ms1b, asn_ls4b, handle, sf_size, burst,
+                                 timeslot + burst, choff, channel))
+        body = body[LINK_LEN:]
+
+        if rtype == MESSAGE:
+            out += body.decode(errors="replace")
+        elif rtype in (TX, RX):
+            (nbr, seqno, datalen, sec_level, status, num_tx, drift,
+             estimated_drift) = struct.unpack_from("<BBBBBBhh", body)
+            kind = "%s-%u-%u" % ("uc" if flags & FLAG_UNICAST else "bc",
+                                 1 if flags & FLAG_DATA else 0, sec_level)
+            if rtype == TX:
+                out += "%s tx %s->%s, len %3u, seq %3u, st %d %2d" % (
+                    kind, self.lladdr(NBR_SELF), self.lladdr(nbr),
+                    datalen, seqno, status, num_tx)
+            else:
+                dest = NBR_SELF if flags & FLAG_UNICAST else NBR_NONE
+                out += "%s rx %s->%s, len %3u, seq %3u, edr %3d" % (
+                    kind, self.lladdr(nbr), self.lladdr(dest),
+                    datalen, seqno, estimated_drift)
+            if flags & FLAG_DRIFT:
+                out += ", dr %3d" % drift
+        else:
+            out += "<unknown record type %u>" % rtype
+        self.out.write(out + "\n")
+
+    def text(self, line):
+        idx = line.find(HEX_TAG)
+        if idx >= 0:
+            try:
+                raw = bytes.fromhex(line[idx + len(HEX_TAG):].strip().decode())
+            except ValueError:
+                raw = b""
+            if len(raw) >= MIN_LEN and raw[0] == MAGIC \
+                    and raw[1] == len(raw) and checksum_ok(raw):
+                self.out.write(line[:idx].decode(errors="replace"))
+                self.record(raw)
+                return
+        self.out.write(line.decode(errors="replace"))
+
+    def feed(self, data, final=False):
+        """Decode what can be decoded, return the bytes left over"""
+        pos = 0
+        text_start = 0
+        while pos < len(data):
+            byte = data[pos]
+            if byte == ord("\n"):
+                self.text(data[text_start:pos + 1])
+                pos += 1
+                text_start = pos
+                continue
+            if byte != MAGIC:
+                pos += 1
+                continue
+            if pos + 1 >= len(data) and not final:
+                break
+            length = data[pos + 1] if pos + 1 < len(data) else 0
+            if MIN_LEN <= length <= MAX_LEN:
+                if pos + length > len(data):
+                    if not final:
+                        break
+                else:
+                    raw = data[pos:pos + length]
+                    if checksum_ok(raw):
+                        if pos > text_start:
+                            self.text(data[text_start:pos])
+                        self.record(raw)
+                        pos += length
+                        text_start = pos
+                        continue
+            # Not a record after all
+            pos += 1
+        if final:
+            if text_start < len(data):
+                self.text(data[text_start:])
+            return b""
+        # Keep the current line or record for the next round
+        return data[text_start:]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode binary TSCH per-slot log records")
+    parser.add_argument("log", nargs="?", help="log file (default: stdin)")
+    args = parser.parse_args()
+
+    log = open(args.log, "rb") if args.log else sys.stdin.buffer
+    decoder = Decoder(sys.stdout)
+    pending = b""
+    while True:
+        data = log.read1(4096) if hasattr(log, "read1") else log.read(4096)
+        if not data:
+            break
+        pending = decoder.feed(pending + data)
+        sys.stdout.flush()
+    decoder.feed(pending, final=True)
+
+
+if __name__ == "__main__":
+    main()